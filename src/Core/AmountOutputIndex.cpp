@@ -0,0 +1,175 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "AmountOutputIndex.hpp"
+#include "common/Invariant.hpp"
+#include "common/Math.hpp"
+#include "common/Varint.hpp"
+#include "seria/BinaryInputStream.hpp"
+#include "seria/BinaryOutputStream.hpp"
+
+using namespace cn;
+
+static const std::string AMOUNT_OUTPUT_PAGE_PREFIX = "o";
+static const std::string AMOUNT_OUTPUT_DINS_PREFIX = "d";
+
+// Record layout - public_key[32], unlock_block_or_timestamp[8], height[4], flags[1], spent[1], reserved[2]
+static const uint8_t FLAG_AUDITABLE = 1;
+static const uint8_t FLAG_HAS_DINS  = 2;
+
+template<typename T>
+static void write_le(uint8_t *data, T value) {
+	for (size_t i = 0; i != sizeof(T); ++i)
+		data[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+template<typename T>
+static T read_le(const uint8_t *data) {
+	T value = 0;
+	for (size_t i = 0; i != sizeof(T); ++i)
+		value |= static_cast<T>(data[i]) << (8 * i);
+	return value;
+}
+
+void AmountOutputIndex::encode(const Record &record, uint8_t *data) {
+	std::copy(std::begin(record.public_key.data), std::end(record.public_key.data), data);
+	write_le(data + 32, record.unlock_block_or_timestamp);
+	write_le(data + 40, record.height);
+	data[44] = (record.auditable ? FLAG_AUDITABLE : 0) | (record.has_dins ? FLAG_HAS_DINS : 0);
+	data[45] = record.spent;
+	data[46] = 0;
+	data[47] = 0;
+}
+
+void AmountOutputIndex::decode(const uint8_t *data, Record *record) {
+	std::copy(data, data + 32, record->public_key.data);
+	record->unlock_block_or_timestamp = read_le<BlockOrTimestamp>(data + 32);
+	record->height                    = read_le<Height>(data + 40);
+	record->auditable                 = (data[44] & FLAG_AUDITABLE) != 0;
+	record->has_dins                  = (data[44] & FLAG_HAS_DINS) != 0;
+	record->spent                     = data[45];
+}
+
+std::string AmountOutputIndex::page_key(Amount amount, size_t page) {
+	return AMOUNT_OUTPUT_PAGE_PREFIX + common::write_varint_sqlite4(amount) + common::write_varint_sqlite4(page);
+}
+
+// DBView is either platform::DB or platform::DB::ReadTxn
+template<typename DBView>
+static size_t read_size(const DBView &db, Amount amount) {
+	platform::DB::Cursor cur = db.rbegin(AMOUNT_OUTPUT_PAGE_PREFIX + common::write_varint_sqlite4(amount));
+	if (cur.end())
+		return 0;
+	const size_t page = common::integer_cast<size_t>(common::read_varint_sqlite4(cur.get_suffix()));
+	return page * AmountOutputIndex::PAGE_RECORDS + cur.get_value_array().size() / AmountOutputIndex::RECORD_SIZE;
+}
+
+size_t AmountOutputIndex::size(Amount amount) const {
+	auto it = m_sizes.find(amount);
+	if (it != m_sizes.end())
+		return it->second;
+	const size_t result = read_size(m_db, amount);
+	m_sizes[amount]     = result;
+	return result;
+}
+
+size_t AmountOutputIndex::size(const platform::DB::ReadTxn &txn, Amount amount) { return read_size(txn, amount); }
+
+size_t AmountOutputIndex::push(Amount amount, const Record &record) {
+	const size_t global_index = size(amount);
+	const auto key            = page_key(amount, global_index / PAGE_RECORDS);
+	BinaryArray page;
+	if (global_index % PAGE_RECORDS != 0)
+		invariant(m_db.get(key, page) && page.size() == (global_index % PAGE_RECORDS) * RECORD_SIZE,
+		    "AmountOutputIndex::push last page corrupted");
+	page.resize(page.size() + RECORD_SIZE);
+	encode(record, page.data() + page.size() - RECORD_SIZE);
+	m_db.put(key, page, false);
+	m_sizes[amount] = global_index + 1;
+	return global_index;
+}
+
+AmountOutputIndex::Record AmountOutputIndex::pop(Amount amount) {
+	const size_t count = size(amount);
+	invariant(count != 0, "AmountOutputIndex::pop underflow");
+	const size_t global_index = count - 1;
+	const auto key            = page_key(amount, global_index / PAGE_RECORDS);
+	BinaryArray page;
+	invariant(m_db.get(key, page) && page.size() == (global_index % PAGE_RECORDS + 1) * RECORD_SIZE,
+	    "AmountOutputIndex::pop last page corrupted");
+	Record result;
+	decode(page.data() + page.size() - RECORD_SIZE, &result);
+	page.resize(page.size() - RECORD_SIZE);
+	if (page.empty())
+		m_db.del(key, true);
+	else
+		m_db.put(key, page, false);
+	m_sizes[amount] = global_index;
+	return result;
+}
+
+template<typename DBView>
+bool AmountOutputIndex::read_record(const DBView &db, Amount amount, size_t global_index, Record *record) {
+	platform::DB::Value page;  // We decode directly from DB memory where possible
+	if (!db.get(page_key(amount, global_index / PAGE_RECORDS), page))
+		return false;
+	const size_t offset = (global_index % PAGE_RECORDS) * RECORD_SIZE;
+	if (offset + RECORD_SIZE > page.size())
+		return false;
+	decode(reinterpret_cast<const uint8_t *>(page.data()) + offset, record);
+	return true;
+}
+
+bool AmountOutputIndex::read(Amount amount, size_t global_index, Record *record) const {
+	return read_record(m_db, amount, global_index, record);
+}
+
+bool AmountOutputIndex::read(const platform::DB::ReadTxn &txn, Amount amount, size_t global_index, Record *record) {
+	return read_record(txn, amount, global_index, record);
+}
+
+void AmountOutputIndex::write(Amount amount, size_t global_index, const Record &record) {
+	const auto key = page_key(amount, global_index / PAGE_RECORDS);
+	BinaryArray page;
+	const size_t offset = (global_index % PAGE_RECORDS) * RECORD_SIZE;
+	invariant(m_db.get(key, page) && offset + RECORD_SIZE <= page.size(), "AmountOutputIndex::write no record");
+	encode(record, page.data() + offset);
+	m_db.put(key, page, false);
+}
+
+void AmountOutputIndex::read_dins(Amount amount, size_t global_index, std::vector<size_t> *dins) const {
+	auto key = AMOUNT_OUTPUT_DINS_PREFIX + common::write_varint_sqlite4(amount) +
+	           common::write_varint_sqlite4(global_index);
+	BinaryArray ba;
+	invariant(m_db.get(key, ba), "AmountOutputIndex::read_dins no dins");
+	seria::from_binary(*dins, ba);
+}
+
+void AmountOutputIndex::write_dins(Amount amount, size_t global_index, const std::vector<size_t> &dins) {
+	auto key = AMOUNT_OUTPUT_DINS_PREFIX + common::write_varint_sqlite4(amount) +
+	           common::write_varint_sqlite4(global_index);
+	if (dins.empty())
+		m_db.del(key, false);
+	else
+		m_db.put(key, seria::to_binary(dins), false);
+}
+
+void AmountOutputIndex::for_each_amount(std::function<void(Amount, size_t)> &&fun) const {
+	Amount previous_amount = 0;
+	size_t count           = 0;
+	for (platform::DB::Cursor cur = m_db.begin(AMOUNT_OUTPUT_PAGE_PREFIX); !cur.end(); cur.next()) {
+		const char *be = cur.get_suffix().data();
+		const char *en = be + cur.get_suffix().size();
+		auto amount    = common::read_varint_sqlite4(be, en);
+		auto page      = common::integer_cast<size_t>(common::read_varint_sqlite4(be, en));
+		if (count != 0 && amount != previous_amount) {
+			fun(previous_amount, count);
+			count = 0;
+		}
+		invariant(page * PAGE_RECORDS == count, "AmountOutputIndex missing page");
+		previous_amount = amount;
+		count += cur.get_value_array().size() / RECORD_SIZE;
+	}
+	if (count != 0)
+		fun(previous_amount, count);
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "CryptoNote.hpp"
+#include "platform/DB.hpp"
+
+namespace cn {
+
+// Outputs of each amount form an append-only array of fixed-width records addressed by global index.
+// Array is split into pages of PAGE_RECORDS records, each page is a single DB value, so reading an output
+// is one lookup in a small tree plus fixed-offset decoding, without seria. Records are stored in DB, so
+// they are committed and rolled back together with the rest of blockchain state.
+// Rarely present dins (inputs referencing output) are stored in a side table.
+class AmountOutputIndex {
+public:
+	struct Record {
+		BlockOrTimestamp unlock_block_or_timestamp = 0;
+		PublicKey public_key;
+		Height height  = 0;
+		bool auditable = false;
+		uint8_t spent  = 0;
+		bool has_dins  = false;  // dins are in side table
+	};
+	static constexpr size_t RECORD_SIZE  = 48;
+	static constexpr size_t PAGE_RECORDS = 32;  // Keeps page in a single LMDB node, without overflow pages
+
+	explicit AmountOutputIndex(platform::DB &db) : m_db(db) {}
+
+	size_t size(Amount) const;  // next global index
+	size_t push(Amount, const Record &);
+	Record pop(Amount);
+	bool read(Amount, size_t global_index, Record *) const;
+	void write(Amount, size_t global_index, const Record &);  // existing record
+
+	void read_dins(Amount, size_t global_index, std::vector<size_t> *) const;
+	void write_dins(Amount, size_t global_index, const std::vector<size_t> &);  // empty dins are erased
+
+	// For DB checks, fun gets amount and number of outputs
+	void for_each_amount(std::function<void(Amount, size_t)> &&fun) const;
+
+	// Uncached reads through read transaction, for RPC workers
+	static size_t size(const platform::DB::ReadTxn &, Amount);
+	static bool read(const platform::DB::ReadTxn &, Amount, size_t global_index, Record *);
+
+private:
+	platform::DB &m_db;
+	mutable std::unordered_map<Amount, size_t> m_sizes;
+	// Read from db on first use, write on modification
+
+	static std::string page_key(Amount, size_t page);
+	template<typename DBView>
+	static bool read_record(const DBView &, Amount, size_t global_index, Record *);
+	static void encode(const Record &, uint8_t *);
+	static void decode(const uint8_t *, Record *);
+};
+
+}  // namespace cn
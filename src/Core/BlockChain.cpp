@@ -19,7 +19,7 @@
 using namespace cn;
 using namespace platform;
 
-const std::string BlockChain::version_current = "6";
+const std::string BlockChain::version_current = "7";
 // We increment when making incompatible changes to indices.
 
 // We use suffixes so all keys related to the same block are close to each other in DB
@@ -35,9 +35,105 @@ static const std::string CHECKPOINT_PREFIX_LATEST = "CL";
 
 static const std::string CHILDREN_PREFIX = "x-ch/";
 static const std::string CD_TIPS_PREFIX  = "x-tips/";
+
+static const std::string BLOCK_FORMAT_KEY        = "$block_format";  // absent for uncompressed blocks
+static const std::string BLOCK_FORMAT_LZ         = "lz";
+static const std::string BLOCK_DICTIONARY_PREFIX = "$block_dictionary/";
 // We store bid->children counter, with counter=1 default (absent from index)
 // We store cumulative_difficulty->bid for bids with no children
 
+// DBView is either DB or DB::ReadTxn, so BlockChain and BlockChainReader read the same layout
+template<typename DBView>
+static bool read_chain_db(const DBView &db, Height height, Hash *bid) {
+	BinaryArray ba;
+	if (!db.get(TIP_CHAIN_PREFIX + common::write_varint_sqlite4(height), ba))
+		return false;
+	seria::from_binary(*bid, ba);
+	return true;
+}
+
+template<typename DBView>
+static bool read_header_db(const DBView &db, const Hash &bid, api::BlockHeader *header) {
+	BinaryArray rb;
+	auto key = HEADER_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + HEADER_SUFFIX;
+	if (!db.get(key, rb))
+		return false;
+	seria::from_binary(*header, rb);
+	return true;
+}
+
+// codec is nullptr for uncompressed format
+template<typename DBView>
+static bool read_block_db(const DBView &db, const BlockCodec *codec, const Hash &bid, StoredBlockData *block_data) {
+	auto key    = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
+	*block_data = StoredBlockData{};
+	if (!db.get(key, block_data->value))
+		return false;
+	if (!codec)
+		return true;
+	if (block_data->value.size() == 0)
+		throw std::runtime_error("Stored block is corrupted");
+	block_data->offset = 1;
+	const auto stored  = reinterpret_cast<const uint8_t *>(block_data->value.data());
+	if (stored[0] != BlockCodec::RAW)
+		block_data->decompressed = codec->decode(bid, stored, block_data->value.size());
+	return true;
+}
+
+template<typename DBView>
+static bool read_block_db(const DBView &db, const BlockCodec *codec, const Hash &bid, BinaryArray *block_data) {
+	if (!codec) {
+		auto key = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
+		return db.get(key, *block_data);
+	}
+	StoredBlockData stored;
+	if (!read_block_db(db, codec, bid, &stored))
+		return false;
+	block_data->assign(stored.data(), stored.data() + stored.size());
+	return true;
+}
+
+template<typename DBView>
+static Height read_timestamp_lower_bound_height(const DBView &db, Timestamp ts, Height tip_height) {
+	auto middle    = common::write_varint_sqlite4(ts);
+	DB::Cursor cur = db.begin(TIMESTAMP_BLOCK_PREFIX, middle);
+	if (cur.end())
+		return tip_height;
+	const char *be = cur.get_suffix().data();
+	const char *en = be + cur.get_suffix().size();
+	common::read_varint_sqlite4(be, en);  // We ignore result, auto actual_ts =
+	return common::integer_cast<Height>(common::read_varint_sqlite4(be, en));
+}
+
+// Chain is either BlockChain or BlockChainReader
+template<typename Chain>
+static std::vector<Hash> sync_headers_chain(
+    const Chain &chain, const std::vector<Hash> &locator, Height *start_height, size_t max_count) {
+	std::vector<Hash> result;
+	for (auto &&lit : locator) {
+		api::BlockHeader header;
+		if (!chain.get_header(lit, &header))
+			continue;
+		while (header.height != 0) {
+			Hash ha;
+			if (chain.get_chain(header.height, &ha) && ha == header.hash)
+				break;
+			const Hash previous_block_hash = header.previous_block_hash;
+			invariant(chain.get_header(previous_block_hash, &header),
+			    "Expected header was not found" + common::pod_to_hex(previous_block_hash));
+		}
+		Height min_height = header.height;
+		*start_height     = min_height;
+		for (; result.size() < max_count && min_height <= chain.get_tip_height(); min_height += 1) {
+			Hash ha;
+			invariant(chain.get_chain(min_height, &ha), "read_header_chain failed");
+			result.push_back(ha);
+		}
+		return result;
+	}
+	throw std::runtime_error("No common block found in get_sync_headers_chain");
+}
+
 Block::Block(const RawBlock &rb) {
 	BlockTemplate &bheader = header;
 	seria::from_binary(bheader, rb.block);
@@ -104,7 +200,11 @@ BlockChain::BlockChain(logging::ILogger &log, const Config &config, const Curren
     , m_archive(read_only || !config.is_archive, config.get_data_folder() + "/archive")
     , m_log(log, "BlockChainState")
     , m_config(config)
-    , m_currency(currency) {
+    , m_currency(currency)
+    , m_header_cache(config.header_cache_memory)
+    , m_block_codec(config)
+    , m_header_tip_window_size(
+          std::max<size_t>(currency.largest_window() * 2, config.header_cache_main_chain_headers)) {
 	invariant(CheckpointDifficulty{}.size() == currency.get_checkpoint_keys_count(), "");
 	std::string version;
 	if (!m_db.get("$version", version)) {
@@ -113,6 +213,21 @@ BlockChain::BlockChain(logging::ILogger &log, const Config &config, const Curren
 			throw std::runtime_error("Blockchain database format unknown version, please delete " + m_db.get_path());
 		version = version_current;
 		m_db.put("$version", version, false);
+		if (config.compress_blocks)
+			m_db.put(BLOCK_FORMAT_KEY, BLOCK_FORMAT_LZ, false);
+	}
+	std::string block_format;  // Before version check, internal import reads blocks kept in DB
+	if (m_db.get(BLOCK_FORMAT_KEY, block_format)) {
+		if (block_format != BLOCK_FORMAT_LZ)
+			throw std::runtime_error("Blockchain database block format unknown (" + block_format + "), please delete " +
+			                         m_db.get_path());
+		m_compress_blocks = true;
+		for (DB::Cursor cur = m_db.begin(BLOCK_DICTIONARY_PREFIX); !cur.end(); cur.next()) {
+			const auto id = common::integer_cast<size_t>(common::read_varint_sqlite4(cur.get_suffix()));
+			m_block_codec.add_dictionary(id, cur.get_value_array());
+		}
+		m_log(logging::INFO) << "BlockChain stores blocks compressed, dictionary count="
+		                     << m_block_codec.get_dictionary_count() << std::endl;
 	}
 	if (version != version_current)
 		return;  // BlockChainState will upgrade DB, we must not continue or risk crashing
@@ -123,6 +238,7 @@ BlockChain::BlockChain(logging::ILogger &log, const Config &config, const Curren
 		DB::Cursor cur2 = m_db.rbegin(TIP_CHAIN_PREFIX);
 		m_tip_height = cur2.end() ? -1 : common::integer_cast<Height>(common::read_varint_sqlite4(cur2.get_suffix()));
 		seria::from_binary(m_tip_bid, cur2.get_value_array());
+		m_committed_tip_bid         = m_tip_bid;
 		api::BlockHeader tip_header = read_header(m_tip_bid);
 		m_tip_cumulative_difficulty = tip_header.cumulative_difficulty;
 		m_header_tip_window.push_back(tip_header);
@@ -139,7 +255,7 @@ void BlockChain::db_commit() {
 	m_log(logging::INFO) << "BlockChain::db_commit started... tip_height=" << m_tip_height
 	                     << " m_header_cache.size=" << m_header_cache.size() << std::endl;
 	m_db.commit_db_txn();
-	m_header_cache.clear();  // Most simple cache policy ever
+	m_committed_tip_bid = m_tip_bid;
 	m_archive.db_commit();
 	m_log(logging::INFO) << "BlockChain::db_commit finished..." << std::endl;
 }
@@ -384,37 +500,12 @@ std::vector<HardCheckpoint> BlockChain::get_sparse_chain(Hash start, Hash end, H
 }
 
 Height BlockChain::get_timestamp_lower_bound_height(Timestamp ts) const {
-	auto middle    = common::write_varint_sqlite4(ts);
-	DB::Cursor cur = m_db.begin(TIMESTAMP_BLOCK_PREFIX, middle);
-	if (cur.end())
-		return m_tip_height;
-	const char *be = cur.get_suffix().data();
-	const char *en = be + cur.get_suffix().size();
-	common::read_varint_sqlite4(be, en);  // We ignore result, auto actual_ts =
-	return common::integer_cast<Height>(common::read_varint_sqlite4(be, en));
+	return read_timestamp_lower_bound_height(m_db, ts, m_tip_height);
 }
 
 std::vector<Hash> BlockChain::get_sync_headers_chain(
     const std::vector<Hash> &locator, Height *start_height, size_t max_count) const {
-	std::vector<Hash> result;
-	for (auto &&lit : locator) {
-		api::BlockHeader header;
-		if (!get_header(lit, &header))
-			continue;
-		while (header.height != 0) {
-			Hash ha;
-			if (get_chain(header.height, &ha) && ha == header.hash)
-				break;
-			header = read_header(header.previous_block_hash);
-		}
-		Height min_height = header.height;
-		*start_height     = min_height;
-		for (; result.size() < max_count && min_height <= m_tip_height; min_height += 1) {
-			result.push_back(read_chain(min_height));
-		}
-		return result;
-	}
-	throw std::runtime_error("No common block found in get_sync_headers_chain");
+	return sync_headers_chain(*this, locator, start_height, max_count);
 }
 
 struct APITransactionPos {
@@ -439,18 +530,19 @@ bool BlockChain::has_transaction(const Hash &tid) const {
 	return m_db.get(txkey, value);
 }
 
-bool BlockChain::get_transaction(
-    const Hash &tid, BinaryArray *binary_tx, Height *block_height, Hash *block_hash, size_t *index_in_block) const {
+template<typename DBView>
+static bool read_transaction_db(const DBView &db, const BlockCodec *codec, const Hash &tid, BinaryArray *binary_tx,
+    Height *block_height, Hash *block_hash, size_t *index_in_block) {
 	auto txkey = TRANSACTION_PREFIX + DB::to_binary_key(tid.data, sizeof(tid.data));
 	BinaryArray ba;
-	if (!m_db.get(txkey, ba))
+	if (!db.get(txkey, ba))
 		return false;
 	APITransactionPos tpos;
 	seria::from_binary(tpos, ba);
-	Hash bid = read_chain(tpos.height);
-	DB::Value block_val;
-	auto key = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
-	invariant(m_db.get(key, block_val), "block must be there if transaction is there");
+	Hash bid;
+	invariant(read_chain_db(db, tpos.height, &bid), "read_header_chain failed");
+	StoredBlockData block_val;
+	invariant(read_block_db(db, codec, bid, &block_val), "block must be there if transaction is there");
 	invariant(tpos.offset + tpos.size <= block_val.size(), "Transaction offset corrupted");
 	*block_hash     = bid;
 	*block_height   = tpos.height;
@@ -459,6 +551,11 @@ bool BlockChain::get_transaction(
 	return true;
 }
 
+bool BlockChain::get_transaction(
+    const Hash &tid, BinaryArray *binary_tx, Height *block_height, Hash *block_hash, size_t *index_in_block) const {
+	return read_transaction_db(m_db, get_block_codec(), tid, binary_tx, block_height, block_hash, index_in_block);
+}
+
 void BlockChain::redo_block(const Hash &bhash, const BinaryArray &block_data, const RawBlock &raw_block,
     const Block &block, const api::BlockHeader &info, const Hash &base_transaction_hash) {
 	redo_block(bhash, block, info);
@@ -511,13 +608,23 @@ void BlockChain::undo_block(const Hash &bhash, const RawBlock &, const Block &bl
 
 void BlockChain::store_block(const Hash &bid, const BinaryArray &block_data) {
 	auto key = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
-	m_db.put(key, block_data, true);
+	if (!m_compress_blocks) {
+		m_db.put(key, block_data, true);
+		return;
+	}
+	if (m_block_codec.add_sample(block_data)) {  // Dictionary is committed together with first block using it
+		BinaryArray dictionary_data;
+		const size_t id = m_block_codec.train(&dictionary_data);
+		m_db.put(BLOCK_DICTIONARY_PREFIX + common::write_varint_sqlite4(id), dictionary_data, true);
+		m_log(logging::INFO) << "BlockChain trained block dictionary id=" << id
+		                     << " size=" << dictionary_data.size() << std::endl;
+	}
+	m_db.put(key, m_block_codec.encode(block_data), true);
 }
 
 bool BlockChain::get_block(const Hash &bid, BinaryArray *block_data, RawBlock *raw_block) const {
 	BinaryArray rb;
-	auto key = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
-	if (!m_db.get(key, rb))
+	if (!read_block_db(m_db, get_block_codec(), bid, &rb))
 		return false;
 	if (raw_block)
 		seria::from_binary(*raw_block, rb);
@@ -525,6 +632,10 @@ bool BlockChain::get_block(const Hash &bid, BinaryArray *block_data, RawBlock *r
 	return true;
 }
 
+bool BlockChain::get_block_data(const Hash &bid, StoredBlockData *block_data) const {
+	return read_block_db(m_db, get_block_codec(), bid, block_data);
+}
+
 bool BlockChain::get_block(const Hash &bid, RawBlock *raw_block) const {
 	BinaryArray rb;
 	return get_block(bid, &rb, raw_block);
@@ -549,26 +660,17 @@ const api::BlockHeader *BlockChain::read_header_fast(const Hash &bid, Height hin
 	    hint >= get_tip_height() - m_header_tip_window.size() + 1) {
 		const auto &candidate = m_header_tip_window.at(m_header_tip_window.size() - 1 - (get_tip_height() - hint));
 		if (candidate.hash == bid) {
+			m_header_tip_window_hits += 1;
 			return &candidate;  // fastest lookup is in tip window
 		}
 	}
-	auto cit = m_header_cache.find(bid);
-	if (cit != m_header_cache.end()) {
-		return &cit->second;
-	}
+	if (auto cached = m_header_cache.find(bid))
+		return cached;
 	Hash bbid = bid;  // next lines can modify bid, because it can be reference to header inside cache
-	if (m_header_cache.size() > m_currency.largest_window() * 20) {
-		m_log(logging::INFO) << "BlockChain header cache reached max size and cleared" << std::endl;
-		m_header_cache.clear();  // very simple policy
-	}
-	BinaryArray rb;
-	auto key = HEADER_PREFIX + DB::to_binary_key(bbid.data, sizeof(bbid.data)) + HEADER_SUFFIX;
-	if (!m_db.get(key, rb))
-		return nullptr;
 	api::BlockHeader header;
-	seria::from_binary(header, rb);
-	cit = m_header_cache.insert(std::make_pair(bbid, std::move(header))).first;
-	return &cit->second;
+	if (!read_header_db(m_db, bbid, &header))
+		return nullptr;
+	return m_header_cache.insert(bbid, std::move(header));
 }
 
 bool BlockChain::get_header(const Hash &bid, api::BlockHeader *header, Height hint) const {
@@ -626,7 +728,7 @@ void BlockChain::push_chain(const api::BlockHeader &header) {
 	m_tip_bid                   = header.hash;
 	m_tip_cumulative_difficulty = header.cumulative_difficulty;
 	m_header_tip_window.push_back(header);
-	while (m_header_tip_window.size() > m_currency.largest_window() * 2)
+	while (m_header_tip_window.size() > m_header_tip_window_size)
 		m_header_tip_window.pop_front();
 	tip_changed();
 }
@@ -647,13 +749,7 @@ void BlockChain::pop_chain(const Hash &new_tip_bid) {
 }
 
 // After upgrading to future versions, remove version from index key
-bool BlockChain::get_chain(Height height, Hash *bid) const {
-	BinaryArray ba;
-	if (!m_db.get(TIP_CHAIN_PREFIX + common::write_varint_sqlite4(height), ba))
-		return false;
-	seria::from_binary(*bid, ba);
-	return true;
-}
+bool BlockChain::get_chain(Height height, Hash *bid) const { return read_chain_db(m_db, height, bid); }
 
 bool BlockChain::in_chain(Height height, Hash bid) const {
 	Hash ha;
@@ -670,6 +766,56 @@ Hash BlockChain::read_chain(Height height) const {
 	return ha;
 }
 
+BlockChainReader::BlockChainReader(const BlockChain &block_chain)
+    : m_currency(block_chain.get_currency())
+    , m_genesis_bid(block_chain.get_genesis_bid())
+    , m_block_codec(block_chain.get_block_codec())
+    , m_txn(block_chain.m_db) {
+	DB::Cursor cur = m_txn.rbegin(TIP_CHAIN_PREFIX);
+	invariant(!cur.end(), "BlockChainReader used before first DB commit");
+	const auto tip_height = common::integer_cast<Height>(common::read_varint_sqlite4(cur.get_suffix()));
+	Hash tip_bid;
+	seria::from_binary(tip_bid, cur.get_value_array());
+	invariant(read_header_db(m_txn, tip_bid, &m_tip) && m_tip.height == tip_height, "Committed tip header not found");
+}
+
+bool BlockChainReader::get_chain(Height height, Hash *bid) const { return read_chain_db(m_txn, height, bid); }
+
+bool BlockChainReader::in_chain(Height height, Hash bid) const {
+	Hash ha;
+	return get_chain(height, &ha) && ha == bid;
+}
+
+bool BlockChainReader::get_block(const Hash &bid, RawBlock *rb) const {
+	BinaryArray block_data;
+	if (!read_block_db(m_txn, m_block_codec, bid, &block_data))
+		return false;
+	seria::from_binary(*rb, block_data);
+	return true;
+}
+
+bool BlockChainReader::get_block_data(const Hash &bid, StoredBlockData *block_data) const {
+	return read_block_db(m_txn, m_block_codec, bid, block_data);
+}
+
+bool BlockChainReader::get_header(const Hash &bid, api::BlockHeader *info, Height) const {
+	return read_header_db(m_txn, bid, info);
+}
+
+bool BlockChainReader::get_transaction(
+    const Hash &tid, BinaryArray *binary_tx, Height *block_height, Hash *block_hash, size_t *index_in_block) const {
+	return read_transaction_db(m_txn, m_block_codec, tid, binary_tx, block_height, block_hash, index_in_block);
+}
+
+std::vector<Hash> BlockChainReader::get_sync_headers_chain(
+    const std::vector<Hash> &locator, Height *start_height, size_t max_count) const {
+	return sync_headers_chain(*this, locator, start_height, max_count);
+}
+
+Height BlockChainReader::get_timestamp_lower_bound_height(Timestamp ts) const {
+	return read_timestamp_lower_bound_height(m_txn, ts, m_tip.height);
+}
+
 void BlockChain::check_children_counter(CumulativeDifficulty cd, const Hash &bid, int value) {
 	auto key    = CHILDREN_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data));
 	auto cd_key = CD_TIPS_PREFIX + common::write_varint_sqlite4(cd.hi) + common::write_varint_sqlite4(cd.lo) +
@@ -895,6 +1041,11 @@ void BlockChain::start_internal_import() {
 		if ((erased + skipped) % 1000000 == 0)
 			m_log(logging::INFO) << "Processing " << (erased + skipped) / 1000000 << "/"
 			                     << (total_items + 999999) / 1000000 << " million DB records" << std::endl;
+		if (cur.get_suffix() == BLOCK_FORMAT_KEY || cur.get_suffix().find(BLOCK_DICTIONARY_PREFIX) == 0) {
+			cur.next();
+			skipped += 1;
+			continue;  // blocks we keep cannot be decoded without them
+		}
 		if (cur.get_suffix().find(BLOCK_PREFIX) == 0 &&
 		    cur.get_suffix().substr(cur.get_suffix().size() - BLOCK_SUFFIX.size()) == BLOCK_SUFFIX) {
 			Hash bid;
@@ -1205,7 +1356,18 @@ void BlockChain::build_blods() {
 }
 
 void BlockChain::fill_statistics(api::cnd::GetStatistics::Response &res) const {
-	res.checkpoints = get_latest_checkpoints();
+	res.checkpoints               = get_latest_checkpoints();
+	res.header_cache_count        = m_header_cache.size();
+	res.header_cache_memory_usage = m_header_cache.memory_usage();
+	res.header_cache_hits         = m_header_cache.get_hits();
+	res.header_cache_misses       = m_header_cache.get_misses();
+	res.header_cache_evictions    = m_header_cache.get_evictions();
+	res.header_tip_window_count   = m_header_tip_window.size();
+	res.header_tip_window_hits    = m_header_tip_window_hits;
+	res.block_dictionary_count    = m_block_codec.get_dictionary_count();
+	res.block_cache_memory_usage  = m_block_codec.memory_usage();
+	res.block_cache_hits          = m_block_codec.get_hits();
+	res.block_cache_misses        = m_block_codec.get_misses();
 
 	if (!m_currency.upgrade_desired_major_version)
 		return;
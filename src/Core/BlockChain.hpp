@@ -7,7 +7,10 @@
 #include <deque>
 #include <unordered_map>
 #include "Archive.hpp"
+#include "BlockCodec.hpp"
 #include "CryptoNote.hpp"
+#include "HeaderCache.hpp"
+#include "common/Nocopy.hpp"
 #include "logging/LoggerMessage.hpp"
 #include "platform/DB.hpp"
 #include "rpc_api.hpp"
@@ -68,6 +71,19 @@ private:
 	void prepare(const Currency &currency, crypto::CryptoNightContext *context);
 };
 
+// Block as stored in DB. Uncompressed block is zero-copy under LMDB (valid until next DB modification),
+// compressed block is decompressed into buffer shared with block cache
+struct StoredBlockData {
+	platform::DB::Value value;
+	size_t offset = 0;  // dictionary id byte of compressed format
+	std::shared_ptr<const BinaryArray> decompressed;
+
+	const char *data() const {
+		return decompressed ? reinterpret_cast<const char *>(decompressed->data()) : value.data() + offset;
+	}
+	size_t size() const { return decompressed ? decompressed->size() : value.size() - offset; }
+};
+
 class BlockChain {
 public:
 	typedef platform::DB DB;
@@ -95,6 +111,7 @@ public:
 	bool in_chain(Hash bid) const;
 	bool get_block(const Hash &bid, RawBlock *rb) const;
 	bool get_block(const Hash &bid, BinaryArray *block_data, RawBlock *rb) const;  // rb can be null here
+	bool get_block_data(const Hash &bid, StoredBlockData *block_data) const;
 	bool has_header(const Hash &bid) const { return read_header_fast(bid, 0) != nullptr; }
 	bool get_header(const Hash &bid, api::BlockHeader *info, Height hint = 0) const;
 	bool get_transaction(
@@ -118,7 +135,9 @@ public:
 	void test_print_tips() const;
 	bool test_prune_oldest();
 
-	void db_commit();
+	virtual void db_commit();
+	// Tip as seen by DB::ReadTxn, Hash{} until first commit
+	const Hash &get_committed_tip_bid() const { return m_committed_tip_bid; }
 
 	bool internal_import();  // import some existing blocks from inside DB
 	Height internal_import_known_height() const { return static_cast<Height>(m_internal_import_chain.size()); }
@@ -167,16 +186,24 @@ protected:
 	static const std::string version_current;
 
 private:
+	friend class BlockChainReader;
 	Hash m_tip_bid;
+	Hash m_committed_tip_bid;
 	CumulativeDifficulty m_tip_cumulative_difficulty{};
 	Height m_tip_height = -1;  // We use overflow to 0 to apply genesis block in constructor
 	void push_chain(const api::BlockHeader &header);
 	void pop_chain(const Hash &new_tip_bid);
 	Hash read_chain(Height height) const;
 
-	mutable std::unordered_map<Hash, api::BlockHeader> m_header_cache;
+	mutable HeaderCache m_header_cache;
+	BlockCodec m_block_codec;
+	bool m_compress_blocks = false;  // set from DB format, not from config
+	const BlockCodec *get_block_codec() const { return m_compress_blocks ? &m_block_codec : nullptr; }
 	std::deque<api::BlockHeader> m_header_tip_window;
-	// We cache recent headers for quick calculation in block windows
+	// Main chain headers by height, we need recent headers for quick calculation in block windows,
+	// and can keep more of them (config.header_cache_main_chain_headers) for RPC and sync
+	const size_t m_header_tip_window_size;
+	mutable size_t m_header_tip_window_hits = 0;
 	const api::BlockHeader *read_header_fast(const Hash &bid, Height hint) const;
 	api::BlockHeader read_header(const Hash &bid, Height hint = 0) const;
 
@@ -220,4 +247,45 @@ protected:
 	    uint8_t *major_cm, uint8_t *minor) const;
 };
 
+// Read-only view of blockchain as of last DB commit, for RPC worker threads. Owns DB read transaction, so
+// tip and everything read are consistent with each other. Reads go directly to DB, bypassing header cache
+// and tip window of BlockChain, which belong to the main thread.
+class BlockChainReader : private common::Nocopy {
+public:
+	typedef platform::DB DB;
+	typedef std::vector<std::vector<size_t>> BlockGlobalIndices;
+
+	explicit BlockChainReader(const BlockChain &);  // Tip is read inside transaction, not from BlockChain
+
+	const Currency &get_currency() const { return m_currency; }
+	const Hash &get_genesis_bid() const { return m_genesis_bid; }
+	Hash get_tip_bid() const { return m_tip.hash; }
+	Height get_tip_height() const { return m_tip.height; }
+	const api::BlockHeader &get_tip() const { return m_tip; }
+
+	bool get_chain(Height height, Hash *bid) const;
+	bool in_chain(Height height, Hash bid) const;
+	bool get_block(const Hash &bid, RawBlock *rb) const;
+	bool get_block_data(const Hash &bid, StoredBlockData *block_data) const;  // valid while reader exists
+	bool get_header(const Hash &bid, api::BlockHeader *info, Height hint = 0) const;
+	bool get_transaction(
+	    const Hash &tid, BinaryArray *binary_tx, Height *block_height, Hash *block_hash, size_t *index_in_block) const;
+	std::vector<Hash> get_sync_headers_chain(
+	    const std::vector<Hash> &sparse_chain, Height *start_height, size_t max_count) const;
+	Height get_timestamp_lower_bound_height(Timestamp) const;
+
+	// Implemented in BlockChainState.cpp, next to indices they read
+	bool read_block_output_global_indices(const Hash &bid, BlockGlobalIndices *) const;
+	bool read_block_output_global_indices(const Hash &bid, DB::Value *) const;
+	std::vector<api::Output> get_random_outputs(uint8_t block_major_version, Amount, size_t output_count, Height,
+	    Timestamp block_timestamp, Timestamp block_median_timestamp) const;
+
+private:
+	const Currency &m_currency;
+	const Hash m_genesis_bid;
+	const BlockCodec *const m_block_codec;  // nullptr for uncompressed format
+	DB::ReadTxn m_txn;
+	api::BlockHeader m_tip;
+};
+
 }  // namespace cn
@@ -4,6 +4,7 @@
 #include "BlockChainFileFormat.hpp"
 #include "BlockChainState.hpp"
 #include "common/Math.hpp"
+#include "crypto/hash.hpp"
 #include "platform/PathTools.hpp"
 #include "seria/BinaryInputStream.hpp"
 #include "seria/BinaryOutputStream.hpp"
@@ -46,8 +47,8 @@ LegacyBlockChainReader::~LegacyBlockChainReader() {
 		m_quit = true;
 		m_have_work.notify_all();
 	}
-	if (m_th.joinable())
-		m_th.join();
+	for (auto &&th : m_threads)
+		th.join();
 }
 
 void LegacyBlockChainReader::load_offsets() {
@@ -76,6 +77,7 @@ BinaryArray LegacyBlockChainReader::get_block_data_by_index(Height i) {
 		return BinaryArray{};
 	try {
 		size_t si = common::integer_cast<size_t>(m_offsets.at(i + 1) - m_offsets.at(i));
+		std::unique_lock<std::mutex> lock(m_file_mu);
 		m_items_file->seek(m_offsets.at(i), SEEK_SET);
 		BinaryArray data_cache(si);
 		m_items_file->read(reinterpret_cast<char *>(data_cache.data()), si);
@@ -89,6 +91,8 @@ const size_t MAX_PRELOAD_BLOCKS = 100;
 // const size_t MAX_PRELOAD_TOTAL_SIZE = 50 * 1024 * 1024;
 
 void LegacyBlockChainReader::thread_run() {
+	crypto::CryptoNightContext context;
+	const Height last_hard_checkpoint_height = m_currency.last_hard_checkpoint().height;
 	while (true) {
 		Height to_load = 0;
 		{
@@ -100,12 +104,15 @@ void LegacyBlockChainReader::thread_run() {
 				continue;
 			}
 			to_load = *m_blocks_to_load.begin();
+			m_blocks_to_load.erase(m_blocks_to_load.begin());
+			m_blocks_loading.insert(to_load);
 		}
 		BinaryArray rba = get_block_data_by_index(to_load);
-		PreparedBlock pb(std::move(rba), m_currency, nullptr);
+		// PoW is not checked in hard checkpoint zone, so we do not waste time on long hash there
+		PreparedBlock pb(std::move(rba), m_currency, to_load > last_hard_checkpoint_height ? &context : nullptr);
 		{
 			std::unique_lock<std::mutex> lock(m_mu);
-			m_blocks_to_load.erase(to_load);
+			m_blocks_loading.erase(to_load);
 			m_total_prepared_data_size += pb.block_data.size();
 			m_prepared_blocks[to_load] = std::move(pb);
 			m_prepared_blocks_ready.notify_all();
@@ -122,10 +129,13 @@ PreparedBlock LegacyBlockChainReader::get_prepared_block_by_index(Height height)
 	}
 	{
 		std::unique_lock<std::mutex> lock(m_mu);
-		if (!m_th.joinable())
-			m_th = std::thread(&LegacyBlockChainReader::thread_run, this);
-		for (Height i = height; i != height + MAX_PRELOAD_BLOCKS; ++i) {
-			if (m_prepared_blocks.count(i) == 0)
+		if (m_threads.empty()) {
+			const size_t thread_count = std::max<size_t>(2, 3 * std::thread::hardware_concurrency() / 4);
+			for (size_t i = 0; i != thread_count; ++i)
+				m_threads.emplace_back(&LegacyBlockChainReader::thread_run, this);
+		}
+		for (Height i = height; i != std::min<Height>(height + MAX_PRELOAD_BLOCKS, m_count); ++i) {
+			if (m_prepared_blocks.count(i) == 0 && m_blocks_loading.count(i) == 0)
 				m_blocks_to_load.insert(i);
 		}
 		m_have_work.notify_all();
@@ -173,6 +183,47 @@ bool LegacyBlockChainReader::import_blocks(BlockChainState *block_chain) {
 	return block_chain->get_tip_height() + 1 < get_block_count();  // Not finished
 }
 
+namespace {
+
+// Prints throughput every 10 seconds and each DB commit, import can be restarted from committed height
+class ImportProgress {
+	typedef std::chrono::steady_clock::time_point TimePoint;
+	const BlockChainState &block_chain;
+	const Height start_height;
+	const Height import_height;
+	const TimePoint start = std::chrono::steady_clock::now();
+	TimePoint last_report = start;
+	uint64_t total_bytes  = 0;
+	Hash committed_bid;
+
+public:
+	ImportProgress(const BlockChainState &block_chain, Height import_height)
+	    : block_chain(block_chain)
+	    , start_height(block_chain.get_tip_height())
+	    , import_height(import_height)
+	    , committed_bid(block_chain.get_committed_tip_bid()) {}
+	void on_block_added(size_t block_size) {
+		total_bytes += block_size;
+		if (block_chain.get_committed_tip_bid() != committed_bid) {
+			committed_bid = block_chain.get_committed_tip_bid();
+			std::cout << "Import committed at height " << block_chain.get_tip_height() << std::endl;
+		}
+		const auto now = std::chrono::steady_clock::now();
+		if (now - last_report < std::chrono::seconds(10))
+			return;
+		last_report            = now;
+		const double seconds   = std::chrono::duration<double>(now - start).count();
+		const double per_sec   = (block_chain.get_tip_height() - start_height) / seconds;
+		const Height remaining = import_height - block_chain.get_tip_height();
+		std::cout << "Imported height " << block_chain.get_tip_height() << "/" << import_height
+		          << " blocks/s=" << static_cast<uint64_t>(per_sec)
+		          << " MB/s=" << total_bytes / seconds / (1024 * 1024)
+		          << " ETA seconds=" << static_cast<uint64_t>(per_sec == 0 ? 0 : remaining / per_sec) << std::endl;
+	}
+};
+
+}  // anonymous namespace
+
 bool LegacyBlockChainReader::import_blockchain2(const std::string &index_file_name, const std::string &item_file_name,
     BlockChainState *block_chain, Height max_height) {
 	auto idea_start    = std::chrono::high_resolution_clock::now();
@@ -190,7 +241,7 @@ bool LegacyBlockChainReader::import_blockchain2(const std::string &index_file_na
 		}
 		std::cout << "Importing blocks up to height " << import_height << std::endl;
 		start_block = block_chain->get_tip_height();
-		//	api::BlockHeader prev_info;
+		ImportProgress progress(*block_chain, import_height);
 		while (block_chain->get_tip_height() < import_height) {
 			PreparedBlock pb = reader.get_prepared_block_by_index(block_chain->get_tip_height() + 1);
 			api::BlockHeader info;
@@ -200,19 +251,7 @@ bool LegacyBlockChainReader::import_blockchain2(const std::string &index_file_na
 				block_chain->db_commit();
 				return false;
 			}
-			//		if (block_chain->get_tip_height() % 50000 == 0)
-			//			block_chain->db_commit();
-			// ts_file << info.timestamp << "\t" << info.timestamp_median << "\t" <<
-			// info.timestamp_unlock << "\t"
-			//		        << int64_t(info.timestamp) -
-			// int64_t(prev_info.timestamp) << "\t"
-			//		        << int64_t(info.timestamp_median) -
-			// int64_t(prev_info.timestamp_median) << "\t"
-			//		        << int64_t(info.timestamp) -
-			// int64_t(info.timestamp_median) << std::endl;
-			//		prev_info = info;
-			//		if (block_chain->get_tip_height() == 1370000)  // 1370000
-			//			break;
+			progress.on_block_added(pb.block_data.size());
 		}
 	} catch (const std::exception &ex) {
 		std::cout << "Exception while importing blockchain file, what=" << common::what(ex) << std::endl;
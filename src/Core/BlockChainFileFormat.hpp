@@ -24,7 +24,9 @@ class LegacyBlockChainReader {
 	std::vector<uint64_t> m_offsets;  // we artifically add offset of the end of file
 	void load_offsets();
 
-	std::thread m_th;
+	// Blocks are read from file one by one, but parsed and hashed (above last hard checkpoint) by several threads
+	std::vector<std::thread> m_threads;
+	std::mutex m_file_mu;
 	std::mutex m_mu;
 	std::condition_variable m_have_work;
 	std::condition_variable m_prepared_blocks_ready;
@@ -32,6 +34,7 @@ class LegacyBlockChainReader {
 
 	std::map<Height, PreparedBlock> m_prepared_blocks;
 	std::set<Height> m_blocks_to_load;
+	std::set<Height> m_blocks_loading;
 	size_t m_total_prepared_data_size = 0;
 	void thread_run();
 
@@ -13,12 +13,12 @@
 #include "common/StringTools.hpp"
 #include "common/Varint.hpp"
 #include "crypto/crypto.hpp"
+#include "platform/PathTools.hpp"
 #include "platform/Time.hpp"
 #include "seria/BinaryInputStream.hpp"
 #include "seria/BinaryOutputStream.hpp"
 
 static const std::string KEYIMAGE_PREFIX             = "i";
-static const std::string AMOUNT_OUTPUT_PREFIX        = "a";
 static const std::string BLOCK_GLOBAL_INDICES_PREFIX = "b";
 static const std::string BLOCK_GLOBAL_INDICES_SUFFIX = "g";
 
@@ -42,15 +42,6 @@ void ser_members(IBlockChainState::UnlockTimePublickKeyHeightSpent &v, ISeria &s
 }
 }  // namespace seria
 
-BlockChainState::PoolTransaction::PoolTransaction(const Transaction &tx, const BinaryArray &binary_tx, Amount fee,
-    Timestamp timestamp, const Hash &newest_referenced_block)
-    : tx(tx)
-    , binary_tx(binary_tx)
-    , amount(get_tx_sum_outputs(tx))
-    , fee(fee)
-    , timestamp(timestamp)
-    , newest_referenced_block(newest_referenced_block) {}
-
 void BlockChainState::DeltaState::store_keyimage(const KeyImage &key_image, Height height) {
 	invariant(m_keyimages.insert(std::make_pair(key_image, height)).second, common::pod_to_hex(key_image));
 }
@@ -219,11 +210,15 @@ static Amount validate_semantic(const Currency &currency, uint8_t block_major_ve
 
 BlockChainState::BlockChainState(logging::ILogger &log, const Config &config, const Currency &currency, bool read_only)
     : BlockChain(log, config, currency, read_only)
-    , m_max_pool_size(config.max_pool_size)
-    , m_log_redo_block_timestamp(std::chrono::steady_clock::now()) {
+    , m_amount_outputs(m_db)
+    , m_memory_state_tx(config.max_pool_size)
+    , m_log_redo_block_timestamp(std::chrono::steady_clock::now())
+    , m_keyimage_filter_path(read_only ? std::string() : config.get_data_folder() + "/keyimage_filter.bin")
+    , m_sync_blocks_cache(config.sync_blocks_cache_memory) {
 	std::string version;
 	m_db.get("$version", version);
-	if (version == "B" || version == "1" || version == "2" || version == "3" || version == "4" || version == "5") {
+	if (version == "B" || version == "1" || version == "2" || version == "3" || version == "4" || version == "5" ||
+	    version == "6") {
 		start_internal_import();
 		version = version_current;
 		m_db.put("$version", version, false);
@@ -244,6 +239,7 @@ BlockChainState::BlockChainState(logging::ILogger &log, const Config &config, co
 		invariant(add_block(pb, &info, std::string()), "Genesis block failed to add");
 	}
 	BlockChainState::tip_changed();
+	build_keyimage_filter(true);
 	m_log(logging::INFO) << "BlockChainState::BlockChainState height=" << get_tip_height()
 	                     << " cumulative_difficulty=" << get_tip_cumulative_difficulty() << " bid=" << get_tip_bid()
 	                     << std::endl;
@@ -253,6 +249,69 @@ BlockChainState::BlockChainState(logging::ILogger &log, const Config &config, co
 	    cur2.end() ? 0 : common::integer_cast<size_t>(common::read_varint_sqlite4(cur2.get_suffix())) + 1;
 }
 
+void BlockChainState::db_commit() {
+	BlockChain::db_commit();
+	if (m_keyimage_filter_path.empty() || !m_keyimage_filter_valid)
+		return;
+	// Snapshot is consistent only with committed DB, so we save it here and not on exit
+	const auto now = std::chrono::steady_clock::now();
+	if (m_keyimage_filter_saved != std::chrono::steady_clock::time_point{} &&
+	    now - m_keyimage_filter_saved < std::chrono::seconds(m_config.keyimage_filter_save_period))
+		return;
+	BinaryArray data = m_keyimage_filter.save(get_tip_bid());
+	if (!platform::atomic_save_file(
+	        m_keyimage_filter_path, data.data(), data.size(), m_keyimage_filter_path + ".tmp"))
+		m_log(logging::WARNING) << "Failed to save key image filter to " << m_keyimage_filter_path << std::endl;
+	m_keyimage_filter_saved = now;
+}
+
+bool BlockChainState::load_keyimage_filter() {
+	BinaryArray data;
+	Hash snapshot_bid;
+	api::BlockHeader snapshot_header;
+	if (m_keyimage_filter_path.empty() || !platform::load_file(m_keyimage_filter_path, data) ||
+	    !m_keyimage_filter.load(data, &snapshot_bid) || !get_header(snapshot_bid, &snapshot_header) ||
+	    !in_chain(snapshot_header.height, snapshot_bid))
+		return false;
+	for (Height ha = snapshot_header.height + 1; ha <= get_tip_height(); ++ha) {
+		Hash bid;
+		RawBlock raw_block;
+		invariant(get_chain(ha, &bid) && get_block(bid, &raw_block), "");
+		Block block(raw_block);
+		for (const auto &tx : block.transactions)
+			for (const auto &input : tx.inputs)
+				if (input.type() == typeid(InputKey) &&
+				    !m_keyimage_filter.insert(boost::get<InputKey>(input).key_image))
+					return false;
+	}
+	if (snapshot_header.height == get_tip_height())
+		m_keyimage_filter_saved = std::chrono::steady_clock::now();
+	m_log(logging::INFO) << "Key image filter loaded, count=" << m_keyimage_filter.size()
+	                     << " blocks applied after snapshot=" << get_tip_height() - snapshot_header.height << std::endl;
+	return true;
+}
+
+void BlockChainState::build_keyimage_filter(bool allow_snapshot) {
+	m_keyimage_filter_valid = false;
+	m_keyimage_filter_saved = std::chrono::steady_clock::time_point{};
+	if (allow_snapshot && load_keyimage_filter()) {
+		m_keyimage_filter_valid = true;
+		return;
+	}
+	m_log(logging::INFO) << "Building key image filter, this can take a while..." << std::endl;
+	size_t count = 0;
+	for (DB::Cursor cur = m_db.begin(KEYIMAGE_PREFIX); !cur.end(); cur.next())
+		count += 1;
+	m_keyimage_filter = KeyImageFilter(count);
+	for (DB::Cursor cur = m_db.begin(KEYIMAGE_PREFIX); !cur.end(); cur.next()) {
+		KeyImage key_image;
+		DB::from_binary_key(cur.get_suffix(), 0, key_image.data, sizeof(key_image.data));
+		invariant(m_keyimage_filter.insert(key_image), "Key image filter overflow during build");
+	}
+	m_keyimage_filter_valid = true;
+	m_log(logging::INFO) << "Key image filter built, count=" << count << std::endl;
+}
+
 void BlockChainState::check_standalone_consensus(
     const PreparedBlock &pb, api::BlockHeader *info, const api::BlockHeader &prev_info, bool check_pow) const {
 	if (pb.error)  // Some semantic checks are in PreparedBlock::prepare
@@ -431,9 +490,34 @@ void BlockChainState::check_standalone_consensus(
 void BlockChainState::fill_statistics(api::cnd::GetStatistics::Response &res) const {
 	BlockChain::fill_statistics(res);
 	res.transaction_pool_count               = m_memory_state_tx.size();
-	res.transaction_pool_size                = m_memory_state_total_size;
-	res.transaction_pool_max_size            = m_max_pool_size;
+	res.transaction_pool_size                = m_memory_state_tx.total_size();
+	res.transaction_pool_max_size            = m_memory_state_tx.max_size();
+	res.transaction_pool_memory_usage        = m_memory_state_tx.memory_usage();
 	res.transaction_pool_lowest_fee_per_byte = minimum_pool_fee_per_byte(false);
+	res.keyimage_filter_count                = m_keyimage_filter.size();
+	res.keyimage_filter_memory_usage         = m_keyimage_filter.memory_usage();
+	res.keyimage_filter_lookups              = m_keyimage_filter_lookups;
+	res.keyimage_filter_false_positives      = m_keyimage_filter_false_positives;
+	const size_t negatives = m_keyimage_filter_lookups - m_keyimage_filter_true_positives;
+	res.keyimage_filter_false_positive_ppm =
+	    negatives == 0 ? 0 : static_cast<size_t>(uint64_t(m_keyimage_filter_false_positives) * 1000000 / negatives);
+	res.sync_blocks_cache_count         = m_sync_blocks_cache.size();
+	res.sync_blocks_cache_memory_usage  = m_sync_blocks_cache.memory_usage();
+	res.sync_blocks_cache_hits          = m_sync_blocks_cache.get_hits();
+	res.sync_blocks_cache_misses        = m_sync_blocks_cache.get_misses();
+	res.sync_blocks_cache_bytes_served  = m_sync_blocks_cache.get_bytes_served();
+	res.sync_blocks_cache_evictions     = m_sync_blocks_cache.get_evictions();
+	res.sync_blocks_cache_invalidations = m_sync_blocks_cache.get_invalidations();
+	const size_t lookups = m_sync_blocks_cache.get_hits() + m_sync_blocks_cache.get_misses();
+	res.sync_blocks_cache_hit_rate_ppm =
+	    lookups == 0 ? 0 : static_cast<size_t>(uint64_t(m_sync_blocks_cache.get_hits()) * 1000000 / lookups);
+	res.block_template_builds              = m_template_builds;
+	res.block_template_last_build_us       = m_template_last_build_us;
+	res.block_template_average_build_us    = m_template_builds == 0 ? 0 : m_template_total_build_us / m_template_builds;
+	res.block_template_max_build_us        = m_template_max_build_us;
+	res.block_template_candidates          = m_template_candidates.size();
+	res.block_template_pending             = m_template_pending.size();
+	res.block_template_redone_transactions = m_template_redone_transactions;
 }
 
 Timestamp BlockChainState::calculate_next_median_timestamp(const api::BlockHeader &prev_info) const {
@@ -468,13 +552,137 @@ size_t BlockChainState::calculate_next_median_block_capacity_vote(const api::Blo
 	return common::median_value(&last_blocks_sizes);
 }
 
+void BlockChainState::update_median_windows() {
+	const api::BlockHeader &tip = get_tip();
+	if (tip.hash == m_median_windows_tip_bid)
+		return;
+	if (tip.previous_block_hash == m_median_windows_tip_bid) {  // Also genesis, with empty windows
+		if (tip.height != 0)
+			m_timestamps_window.push_back(tip.timestamp);
+		m_sizes_window.push_back(tip.transactions_size);
+		m_capacity_votes_window.push_back(
+		    tip.block_capacity_vote, tip.major_version >= m_currency.amethyst_block_version);
+	} else if (tip.hash == m_median_windows_previous_bid) {
+		m_timestamps_window.pop_back();
+		m_sizes_window.pop_back();
+		m_capacity_votes_window.pop_back();
+	} else {
+		m_timestamps_window.clear();
+		m_sizes_window.clear();
+		m_capacity_votes_window.clear();
+	}
+	m_median_windows_tip_bid      = tip.hash;
+	m_median_windows_previous_bid = tip.previous_block_hash;
+
+	const Height timestamps_count = std::min(m_currency.timestamp_check_window(tip.major_version), tip.height);
+	const Height sizes_count      = std::min(m_currency.median_block_size_window, tip.height + 1);
+	const Height votes_count      = std::min(m_currency.block_capacity_vote_window, tip.height + 1);
+	while (m_timestamps_window.size() > timestamps_count)
+		m_timestamps_window.pop_front();
+	while (m_sizes_window.size() > sizes_count)
+		m_sizes_window.pop_front();
+	while (m_capacity_votes_window.size() > votes_count)
+		m_capacity_votes_window.pop_front();
+	// After undo, timestamp window change or on start we have to read older headers
+	auto read_chain_header = [&](Height height) -> api::BlockHeader {
+		Hash bid;
+		api::BlockHeader header;
+		invariant(get_chain(height, &bid) && get_header(bid, &header, height), "");
+		return header;
+	};
+	while (m_timestamps_window.size() < timestamps_count)
+		m_timestamps_window.push_front(read_chain_header(tip.height - m_timestamps_window.size()).timestamp);
+	while (m_sizes_window.size() < sizes_count)
+		m_sizes_window.push_front(read_chain_header(tip.height - m_sizes_window.size()).transactions_size);
+	while (m_capacity_votes_window.size() < votes_count) {
+		const api::BlockHeader header = read_chain_header(tip.height - m_capacity_votes_window.size());
+		m_capacity_votes_window.push_front(
+		    header.block_capacity_vote, header.major_version >= m_currency.amethyst_block_version);
+	}
+}
+
 void BlockChainState::tip_changed() {
-	m_next_median_timestamp           = calculate_next_median_timestamp(get_tip());
-	m_next_median_size                = calculate_next_median_size(get_tip());
-	m_next_median_block_capacity_vote = calculate_next_median_block_capacity_vote(get_tip());
+	update_median_windows();
+	m_next_median_timestamp =
+	    m_timestamps_window.size() >= m_currency.timestamp_check_window(get_tip().major_version)
+	        ? m_timestamps_window.median()
+	        : 0;
+	m_next_median_size                = m_sizes_window.median();
+	m_next_median_block_capacity_vote = m_capacity_votes_window.counted_size() == 0
+	                                        ? m_currency.block_capacity_vote_min
+	                                        : m_capacity_votes_window.median();
+	if (m_config.paranoid_checks) {
+		invariant(m_next_median_timestamp == calculate_next_median_timestamp(get_tip()), "");
+		invariant(m_next_median_size == calculate_next_median_size(get_tip()), "");
+		invariant(m_next_median_block_capacity_vote == calculate_next_median_block_capacity_vote(get_tip()), "");
+	}
 }
 
 void BlockChainState::create_mining_block_template(const Hash &parent_bid, const AccountAddress &adr,
+    const BinaryArray &extra_nonce, BlockTemplate *b, Difficulty *difficulty, Height *height,
+    size_t *reserved_back_offset) const {
+	const auto start = std::chrono::steady_clock::now();
+	build_mining_block_template(parent_bid, adr, extra_nonce, b, difficulty, height, reserved_back_offset);
+	const auto build_us = static_cast<size_t>(
+	    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	m_template_builds += 1;
+	m_template_last_build_us = build_us;
+	m_template_total_build_us += build_us;
+	m_template_max_build_us = std::max(m_template_max_build_us, build_us);
+}
+
+void BlockChainState::update_template_candidates(
+    uint8_t major_version, Height height, Timestamp block_timestamp, Timestamp block_median_timestamp) const {
+	// Redone transaction stays valid when height and timestamps grow (outputs only unlock), but signatures
+	// must be checked again when key image subgroup checking starts
+	const bool subgroup_checking_started = m_template_height < m_currency.key_image_subgroup_checking_height &&
+	                                       height >= m_currency.key_image_subgroup_checking_height;
+	if (major_version != m_template_major_version || height < m_template_height ||
+	    block_timestamp < m_template_timestamp || block_median_timestamp < m_template_median_timestamp ||
+	    subgroup_checking_started)
+		invalidate_template_candidates(subgroup_checking_started);
+	m_template_major_version    = major_version;
+	m_template_height           = height;
+	m_template_timestamp        = block_timestamp;
+	m_template_median_timestamp = block_median_timestamp;
+	if (m_template_pending.empty())
+		return;
+	// Pool has no conflicting key images, so all candidates fit into single block
+	DeltaState memory_state(height, block_timestamp, block_median_timestamp, this);
+	for (auto pit = m_template_pending.begin(); pit != m_template_pending.end();) {
+		auto tit = m_memory_state_tx.find(pit->first);
+		if (tit == m_memory_state_tx.end()) {
+			m_log(logging::ERROR) << "Transaction " << pit->first << " is in template index, but not in pool";
+			pit = m_template_pending.erase(pit);
+			continue;
+		}
+		BlockGlobalIndices global_indices;
+		Hash newest_referenced_bid;  // Non-null also turns on output checks without signatures
+		try {
+			redo_transaction(major_version, false, tit->second.get_transaction(), &memory_state, &global_indices,
+			    &newest_referenced_bid, pit->second);
+		} catch (const ConsensusError &ex) {
+			m_log(logging::ERROR) << "Transaction " << tit->first
+			                      << " is in pool, but could not be redone what=" << common::what(ex) << std::endl;
+			++pit;  // Will retry for next template
+			continue;
+		}
+		m_template_redone_transactions += 1;
+		m_template_candidates.insert(pit->first);
+		pit = m_template_pending.erase(pit);
+	}
+}
+
+void BlockChainState::invalidate_template_candidates(bool need_check_sigs) const {
+	for (const auto &tid : m_template_candidates)
+		m_template_pending[tid] = need_check_sigs;
+	m_template_candidates.clear();
+	if (need_check_sigs)
+		for (auto &pit : m_template_pending)
+			pit.second = true;
+}
+
+void BlockChainState::build_mining_block_template(const Hash &parent_bid, const AccountAddress &adr,
     const BinaryArray &extra_nonce, BlockTemplate *b, Difficulty *difficulty, Height *height,
     size_t *reserved_back_offset) const {
 	api::BlockHeader parent_info;
@@ -519,19 +727,23 @@ void BlockChainState::create_mining_block_template(const Hash &parent_bid, const
 		extra_add_merge_mining_tag(b->root_block.base_transaction.extra, TransactionExtraMergeMiningTag{});
 	}
 
-	b->previous_block_hash                = parent_bid;
-	const Timestamp next_median_timestamp = calculate_next_median_timestamp(parent_info);
-	b->root_block.timestamp               = std::max(platform::now_unix_timestamp(), next_median_timestamp);
-	b->timestamp                          = b->root_block.timestamp;
+	b->previous_block_hash   = parent_bid;
+	const bool parent_is_tip = parent_bid == get_tip_bid();  // Optimization for most common case
+	const Timestamp next_median_timestamp =
+	    parent_is_tip ? m_next_median_timestamp : calculate_next_median_timestamp(parent_info);
+	b->root_block.timestamp = std::max(platform::now_unix_timestamp(), next_median_timestamp);
+	b->timestamp            = b->root_block.timestamp;
 
 	size_t max_txs_size          = 0;
 	size_t effective_size_median = 0;
 
 	if (is_amethyst) {
-		const size_t next_median_block_capacity_vote = calculate_next_median_block_capacity_vote(parent_info);
+		const size_t next_median_block_capacity_vote =
+		    parent_is_tip ? m_next_median_block_capacity_vote : calculate_next_median_block_capacity_vote(parent_info);
 		max_txs_size = next_median_block_capacity_vote - m_currency.miner_tx_blob_reserved_size - extra_nonce.size();
 	} else {
-		const size_t next_median_size         = calculate_next_median_size(parent_info);
+		const size_t next_median_size =
+		    parent_is_tip ? m_next_median_size : calculate_next_median_size(parent_info);
 		const size_t next_minimum_size_median = m_currency.get_minimum_size_median(b->major_version);
 		effective_size_median                 = std::max(next_median_size, next_minimum_size_median);
 		const auto max_consensus_transactions_size =
@@ -539,36 +751,22 @@ void BlockChainState::create_mining_block_template(const Hash &parent_bid, const
 		max_txs_size = max_consensus_transactions_size - m_currency.miner_tx_blob_reserved_size - extra_nonce.size();
 	}
 
-	std::vector<Hash> pool_hashes;
-	for (auto &&msf : m_memory_state_fee_tx)
-		pool_hashes.push_back(msf.second);
+	update_template_candidates(b->major_version, *height, b->timestamp, next_median_timestamp);
 	size_t txs_size = 0;
 	Amount txs_fee  = 0;
-	DeltaState memory_state(*height, b->timestamp, next_median_timestamp, this);
 	//	Amount base_reward = m_currency.get_block_reward(
 	//	    b->major_version, *height, effective_size_median, 0, parent_info.already_generated_coins, 0);
 
-	for (; !pool_hashes.empty(); pool_hashes.pop_back()) {
-		auto tit = m_memory_state_tx.find(pool_hashes.back());
-		if (tit == m_memory_state_tx.end()) {
-			m_log(logging::ERROR) << "Transaction " << pool_hashes.back() << " is in pool index, but not in pool";
-			//			assert(false);
+	const auto &fee_index = m_memory_state_tx.get_fee_index();
+	for (auto fit = fee_index.rbegin(); fit != fee_index.rend(); ++fit) {
+		if (m_template_candidates.count(fit->second) == 0)
 			continue;
-		}
+		auto tit = m_memory_state_tx.find(fit->second);
+		invariant(tit != m_memory_state_tx.end(), "Memory pool corrupted");
 		const size_t tx_size = tit->second.binary_tx.size();
 		const Amount tx_fee  = tit->second.fee;
 		if (txs_size + tx_size > max_txs_size)
 			continue;
-		BlockGlobalIndices global_indices;
-		Height conflict_height = 0;
-		try {  // double-check that transcations can be added to block
-			redo_transaction(b->major_version, false, tit->second.tx, &memory_state, &global_indices, nullptr, true);
-		} catch (const ConsensusError &ex) {
-			m_log(logging::ERROR) << "Transaction " << tit->first
-			                      << " is in pool, but could not be redone what=" << common::what(ex)
-			                      << " Conflict height=" << conflict_height << std::endl;
-			continue;
-		}
 		if (!is_amethyst && txs_size + tx_size > effective_size_median)
 			continue;  // Effective median size will not grow anyway
 		txs_size += tx_size;
@@ -583,7 +781,7 @@ void BlockChainState::create_mining_block_template(const Hash &parent_bid, const
 		// Vote for larger blocks if pool is full of expensive transactions
 		Amount desired_fee_per_byte = 100;
 		size_t block_capacity_vote  = 0;
-		for (auto fit = m_memory_state_fee_tx.rbegin(); fit != m_memory_state_fee_tx.rend(); ++fit) {
+		for (auto fit = fee_index.rbegin(); fit != fee_index.rend(); ++fit) {
 			if (fit->first < desired_fee_per_byte)
 				break;
 			auto tit = m_memory_state_tx.find(fit->second);
@@ -692,34 +890,24 @@ void BlockChainState::clear_mining_transactions() const {
 }
 
 Amount BlockChainState::minimum_pool_fee_per_byte(bool zero_if_not_full, Hash *minimal_tid) const {
-	if (m_memory_state_fee_tx.empty()) {
-		if (minimal_tid)
-			*minimal_tid = Hash{};
-		return 0;
-	}
-	if (zero_if_not_full && m_memory_state_total_size < m_max_pool_size) {
-		if (minimal_tid)
-			*minimal_tid = Hash{};
-		return 0;
-	}
-	auto be = m_memory_state_fee_tx.begin();
-	if (minimal_tid)
-		*minimal_tid = be->second;
-	return be->first;
+	return m_memory_state_tx.minimum_fee_per_byte(zero_if_not_full, minimal_tid);
 }
 
 void BlockChainState::on_reorganization(
     const std::map<Hash, std::pair<Transaction, BinaryArray>> &undone_transactions, bool undone_blocks) {
+	if (m_lowest_undone_height != std::numeric_limits<Height>::max()) {
+		m_sync_blocks_cache.invalidate(m_lowest_undone_height);
+		m_lowest_undone_height = std::numeric_limits<Height>::max();
+	}
 	// TODO - remove/add only those transactions that could have their referenced output keys changed
 	if (undone_blocks) {
-		PoolTransMap old_memory_state_tx;
+		TransactionPool old_memory_state_tx(m_memory_state_tx.max_size());
 		std::swap(old_memory_state_tx, m_memory_state_tx);
-		m_memory_state_ki_tx.clear();
-		m_memory_state_fee_tx.clear();
-		m_memory_state_total_size = 0;
-		for (auto &&msf : old_memory_state_tx) {
+		m_template_candidates.clear();
+		m_template_pending.clear();
+		for (auto &&tit : old_memory_state_tx.get_sorted_by_hash()) {
 			try {
-				add_transaction(msf.first, msf.second.tx, msf.second.binary_tx, true, std::string());
+				add_transaction(tit->first, tit->second.get_transaction(), tit->second.binary_tx, true, std::string());
 			} catch (const std::exception &) {  // Just skip now invalid transactions
 			}
 		}
@@ -736,12 +924,13 @@ void BlockChainState::on_reorganization(
 std::vector<TransactionDesc> BlockChainState::sync_pool(
     const std::pair<Amount, Hash> &from, const std::pair<Amount, Hash> &to, size_t max_count) const {
 	std::vector<TransactionDesc> result;
-	auto sit = m_memory_state_fee_tx.lower_bound(from);
-	if (sit != m_memory_state_fee_tx.end()) {
+	const auto &fee_index = m_memory_state_tx.get_fee_index();
+	auto sit              = fee_index.lower_bound(from);
+	if (sit != fee_index.end()) {
 		if (*sit != from)
 			++sit;
 	}
-	while (sit != m_memory_state_fee_tx.begin()) {
+	while (sit != fee_index.begin()) {
 		--sit;
 		if (result.size() > max_count || *sit <= to)
 			break;
@@ -770,22 +959,23 @@ bool BlockChainState::add_transaction(const Hash &tid, const Transaction &tx, co
 	Hash minimal_tid;
 	Amount minimal_fee = minimum_pool_fee_per_byte(false, &minimal_tid);
 	// Invariant is if 1 byte of cheapest transaction fits, then all transaction fits
-	if (m_memory_state_total_size >= m_max_pool_size && my_fee_per_byte < minimal_fee)
+	const bool pool_full = m_memory_state_tx.total_size() >= m_memory_state_tx.max_size();
+	if (pool_full && my_fee_per_byte < minimal_fee)
 		return false;  // AddTransactionResult::INCREASE_FEE;
 	// Deterministic behaviour here and below so tx pools have tendency to stay the same
-	if (m_memory_state_total_size >= m_max_pool_size && my_fee_per_byte == minimal_fee && tid < minimal_tid)
+	if (pool_full && my_fee_per_byte == minimal_fee && tid < minimal_tid)
 		return false;  // AddTransactionResult::INCREASE_FEE;
 	for (const auto &input : tx.inputs) {
 		if (input.type() == typeid(InputKey)) {
 			const InputKey &in = boost::get<InputKey>(input);
-			auto tit           = m_memory_state_ki_tx.find(in.key_image);
-			if (tit == m_memory_state_ki_tx.end())
+			Hash other_tid;
+			if (!m_memory_state_tx.find_keyimage(in.key_image, &other_tid))
 				continue;
-			const PoolTransaction &other_tx = m_memory_state_tx.at(tit->second);
+			const PoolTransaction &other_tx = m_memory_state_tx.at(other_tid);
 			const Amount other_fee_per_byte = other_tx.fee_per_byte();
 			if (my_fee_per_byte < other_fee_per_byte)
 				return false;  // AddTransactionResult::INCREASE_FEE;
-			if (my_fee_per_byte == other_fee_per_byte && tid < tit->second)
+			if (my_fee_per_byte == other_fee_per_byte && tid < other_tid)
 				return false;  // AddTransactionResult::INCREASE_FEE;
 			break;  // Can displace another transaction from the pool, Will have to make heavy-lifting for this tx
 		}
@@ -823,59 +1013,38 @@ bool BlockChainState::add_transaction(const Hash &tid, const Transaction &tx, co
 	// space there
 	//	update_first_seen_timestamp(tid, unlock_timestamp);
 	for (auto &&ki : memory_state.get_keyimages()) {
-		auto tit = m_memory_state_ki_tx.find(ki.first);
-		if (tit == m_memory_state_ki_tx.end())
+		Hash other_tid;
+		if (!m_memory_state_tx.find_keyimage(ki.first, &other_tid))
 			continue;
-		const PoolTransaction &other_tx = m_memory_state_tx.at(tit->second);
+		const PoolTransaction &other_tx = m_memory_state_tx.at(other_tid);
 		const Amount other_fee_per_byte = other_tx.fee_per_byte();
 		if (my_fee_per_byte < other_fee_per_byte)
 			return false;  // AddTransactionResult::INCREASE_FEE;  // Never because checked above
-		if (my_fee_per_byte == other_fee_per_byte && tid < tit->second)
+		if (my_fee_per_byte == other_fee_per_byte && tid < other_tid)
 			return false;  // AddTransactionResult::INCREASE_FEE;  // Never because checked above
-		remove_from_pool(tit->second);
-	}
-	bool all_inserted = true;
-	for (auto &&ki : memory_state.get_keyimages()) {
-		if (!m_memory_state_ki_tx.insert(std::make_pair(ki.first, tid)).second)
-			all_inserted = false;
+		remove_from_pool(other_tid);
 	}
 	const auto now = platform::now_unix_timestamp();
-	if (!m_memory_state_tx
-	         .insert(std::make_pair(tid, PoolTransaction(tx, binary_tx, my_fee, now, newest_referenced_bid)))
-	         .second)
-		all_inserted = false;
-	if (!m_memory_state_fee_tx.insert(std::make_pair(my_fee_per_byte, tid)).second)
-		all_inserted = false;
-	// insert all before throw
-	invariant(all_inserted, "memory_state_fee_tx empty");
-	m_memory_state_total_size += my_size;
-	while (m_memory_state_total_size > m_max_pool_size) {
-		invariant(!m_memory_state_fee_tx.empty(), "memory_state_fee_tx empty");
-		//		auto &be = m_memory_state_fee_tx.begin()->second;
-		//		invariant(!be.empty(), "memory_state_fee_tx empty set");
-		Hash rhash                        = m_memory_state_fee_tx.begin()->second;
+	invariant(m_memory_state_tx.insert(tid, PoolTransaction(tx, binary_tx, my_fee, now, newest_referenced_bid)),
+	    "memory_state_tx insert failed");
+	const auto &fee_index = m_memory_state_tx.get_fee_index();
+	while (m_memory_state_tx.total_size() > m_memory_state_tx.max_size()) {
+		invariant(!fee_index.empty(), "memory_state_fee_tx empty");
+		Hash rhash                        = fee_index.begin()->second;
 		const PoolTransaction &minimal_tx = m_memory_state_tx.at(rhash);
-		if (m_memory_state_total_size < m_max_pool_size + minimal_tx.binary_tx.size())
+		if (m_memory_state_tx.total_size() < m_memory_state_tx.max_size() + minimal_tx.binary_tx.size())
 			break;  // Removing would diminish pool below max size
 		remove_from_pool(rhash);
 	}
-	auto min_size = m_memory_state_fee_tx.empty()
-	                    ? 0
-	                    : m_memory_state_tx.at(m_memory_state_fee_tx.begin()->second).binary_tx.size();
-	auto min_fee_per_byte = m_memory_state_fee_tx.empty() ? 0 : m_memory_state_fee_tx.begin()->first;
-	//	if( m_memory_state_total_size-min_size >= m_max_pool_size)
-	//		std::cout << "Aha" << std::endl;
+	auto min_size         = fee_index.empty() ? 0 : m_memory_state_tx.at(fee_index.begin()->second).binary_tx.size();
+	auto min_fee_per_byte = fee_index.empty() ? 0 : fee_index.begin()->first;
 	m_log(logging::INFO) << "Added transaction with hash=" << tid << " size=" << my_size << " fee=" << my_fee
 	                     << " fee/byte=" << my_fee_per_byte << " current_pool_size=("
-	                     << m_memory_state_total_size - min_size << "+" << min_size << ")=" << m_memory_state_total_size
-	                     << " count=" << m_memory_state_tx.size() << " min fee/byte=" << min_fee_per_byte << std::endl;
+	                     << m_memory_state_tx.total_size() - min_size << "+" << min_size
+	                     << ")=" << m_memory_state_tx.total_size() << " count=" << m_memory_state_tx.size()
+	                     << " min fee/byte=" << min_fee_per_byte << std::endl;
+	m_template_pending[tid] = !(m_config.paranoid_checks || check_sigs);
 	m_archive.add(Archive::TRANSACTION, binary_tx, tid, source_address);
-	//	for(auto && bb : m_memory_state_fee_tx)
-	//		for(auto ff : bb.second){
-	//			const PoolTransaction &other_tx = m_memory_state_tx.at(ff);
-	//			std::cout << "\t" << other_tx.fee_per_byte() << "\t" << other_tx.binary_tx.size() << "\t" <<
-	// common::pod_to_hex(ff) << std::endl;
-	//		}
 	m_tx_pool_version += 1;
 	return true;
 }
@@ -913,33 +1082,19 @@ void BlockChainState::remove_from_pool(Hash tid) {
 	auto tit = m_memory_state_tx.find(tid);
 	if (tit == m_memory_state_tx.end())
 		return;
-	bool all_erased       = true;
-	const Transaction &tx = tit->second.tx;
-	for (const auto &input : tx.inputs) {
-		if (input.type() == typeid(InputKey)) {
-			const InputKey &in = boost::get<InputKey>(input);
-			if (m_memory_state_ki_tx.erase(in.key_image) != 1)
-				all_erased = false;
-		}
-	}
-	const size_t my_size         = tit->second.binary_tx.size();
-	const Amount my_fee_per_byte = tit->second.fee_per_byte();
-	if (m_memory_state_fee_tx.erase(std::make_pair(my_fee_per_byte, tid)) != 1)
-		all_erased = false;
-	//	if (m_memory_state_fee_tx[my_fee_per_byte].empty())
-	//		m_memory_state_fee_tx.erase(my_fee_per_byte);
-	m_memory_state_total_size -= my_size;
-	m_memory_state_tx.erase(tit);
-	invariant(all_erased, "remove_memory_pool failed to erase everything");
+	const size_t my_size = tit->second.binary_tx.size();
+	m_memory_state_tx.erase(tid);
+	m_template_candidates.erase(tid);
+	m_template_pending.erase(tid);
 	// We do not increment m_tx_pool_version, because removing tx from pool is
 	// always followed by reset or increment
-	auto min_size = m_memory_state_fee_tx.empty()
-	                    ? 0
-	                    : m_memory_state_tx.at(m_memory_state_fee_tx.begin()->second).binary_tx.size();
-	auto min_fee_per_byte = m_memory_state_fee_tx.empty() ? 0 : m_memory_state_fee_tx.begin()->first;
+	const auto &fee_index = m_memory_state_tx.get_fee_index();
+	auto min_size         = fee_index.empty() ? 0 : m_memory_state_tx.at(fee_index.begin()->second).binary_tx.size();
+	auto min_fee_per_byte = fee_index.empty() ? 0 : fee_index.begin()->first;
 	m_log(logging::INFO) << "Removed transaction with hash=" << tid << " size=" << my_size << " current_pool_size=("
-	                     << m_memory_state_total_size - min_size << "+" << min_size << ")=" << m_memory_state_total_size
-	                     << " count=" << m_memory_state_tx.size() << " min fee/byte=" << min_fee_per_byte << std::endl;
+	                     << m_memory_state_tx.total_size() - min_size << "+" << min_size
+	                     << ")=" << m_memory_state_tx.total_size() << " count=" << m_memory_state_tx.size()
+	                     << " min fee/byte=" << min_fee_per_byte << std::endl;
 }
 
 // Called only on transactions which passed validate_semantic()
@@ -1075,14 +1230,21 @@ void BlockChainState::redo_block(const Hash &bhash, const Block &block, const ap
 	BlockGlobalIndices global_indices;
 	global_indices.reserve(block.transactions.size() + 1);
 	const bool check_sigs = m_config.paranoid_checks || !m_currency.is_in_hard_checkpoint_zone(info.height + 1);
-	if (check_sigs)
-		m_ring_checker.start_work(this, m_currency, block, info.height, info.timestamp, info.timestamp_median,
-		    info.height >= m_currency.key_image_subgroup_checking_height);
-	redo_block(block, info, &delta, &global_indices);
-	if (check_sigs) {
-		auto errors = m_ring_checker.move_errors();
-		if (!errors.empty())
-			throw errors.front();  // We report first error only
+	try {
+		if (check_sigs)
+			m_ring_checker.start_work(this, m_currency, bhash, block, info.height, info.timestamp,
+			    info.timestamp_median, info.height >= m_currency.key_image_subgroup_checking_height);
+		redo_block(block, info, &delta, &global_indices);
+		if (check_sigs) {
+			auto errors = m_ring_checker.move_errors();
+			if (!errors.empty())
+				throw errors.front();  // We report first error only
+		}
+	} catch (const ConsensusError &) {
+		// Speculative checks were queued for descendants of this block, they will never be applied
+		m_ring_checker.cancel_work();
+		m_ring_checker.cancel_speculative_work();
+		throw;
 	}
 	delta.apply(this);  // Will remove from pool by key_image
 	for (auto tit = block.transactions.begin(); tit != block.transactions.end(); ++tit) {
@@ -1112,6 +1274,9 @@ void BlockChainState::redo_block(const Hash &bhash, const Block &block, const ap
 }
 
 void BlockChainState::undo_block(const Hash &bhash, const Block &block, Height height) {
+	m_ring_checker.cancel_speculative_work();  // Speculation assumes chain only grows
+	m_lowest_undone_height = std::min(m_lowest_undone_height, height);
+	invalidate_template_candidates(true);  // Referenced outputs might change
 	auto now = std::chrono::steady_clock::now();
 	if (m_config.net != "main" ||
 	    std::chrono::duration_cast<std::chrono::milliseconds>(now - m_log_redo_block_timestamp).count() > 1000) {
@@ -1133,6 +1298,21 @@ void BlockChainState::undo_block(const Hash &bhash, const Block &block, Height h
 	m_db.del(key, true);
 }
 
+bool BlockChainState::wants_speculative_check(const Hash &bid, Height height) const {
+	if (m_config.ring_checker_pipeline_blocks == 0 || height <= get_tip_height() + 1)
+		return false;  // Next block is checked as usual
+	if (!m_config.paranoid_checks && m_currency.is_in_hard_checkpoint_zone(height + 1))
+		return false;
+	return !m_ring_checker.has_speculative_work(bid);
+}
+
+void BlockChainState::start_speculative_check(const Hash &bid, const Block &block, Height height) {
+	// height is expected height reported by peer, if it lied, fingerprints will not match and
+	// signatures will be checked again when block is applied
+	m_ring_checker.start_speculative_work(this, m_currency, bid, block,
+	    height >= m_currency.key_image_subgroup_checking_height, m_config.ring_checker_pipeline_blocks);
+}
+
 bool BlockChainState::read_block_output_global_indices(const Hash &bid, BlockGlobalIndices *indices) const {
 	BinaryArray rb;
 	auto key =
@@ -1143,11 +1323,37 @@ bool BlockChainState::read_block_output_global_indices(const Hash &bid, BlockGlo
 	return true;
 }
 
-std::vector<api::Output> BlockChainState::get_random_outputs(uint8_t block_major_version, Amount amount,
-    size_t output_count, Height confirmed_height, Timestamp block_timestamp, Timestamp block_median_timestamp) const {
+bool BlockChainState::read_block_output_global_indices(const Hash &bid, DB::Value *indices_data) const {
+	auto key =
+	    BLOCK_GLOBAL_INDICES_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_GLOBAL_INDICES_SUFFIX;
+	return m_db.get(key, *indices_data);
+}
+
+bool BlockChainReader::read_block_output_global_indices(const Hash &bid, BlockGlobalIndices *indices) const {
+	BinaryArray rb;
+	auto key =
+	    BLOCK_GLOBAL_INDICES_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_GLOBAL_INDICES_SUFFIX;
+	if (!m_txn.get(key, rb))
+		return false;
+	seria::from_binary(*indices, rb);
+	return true;
+}
+
+bool BlockChainReader::read_block_output_global_indices(const Hash &bid, DB::Value *indices_data) const {
+	auto key =
+	    BLOCK_GLOBAL_INDICES_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_GLOBAL_INDICES_SUFFIX;
+	return m_txn.get(key, *indices_data);
+}
+
+// ReadOutput is bool(size_t global_index, AmountOutputIndex::Record *), so that BlockChainState
+// and BlockChainReader select outputs the same way
+template<typename ReadOutput>
+static std::vector<api::Output> select_random_outputs(const Currency &currency, Height tip_height,
+    const size_t amount_output_count, ReadOutput &&read_output, uint8_t block_major_version, Amount amount,
+    size_t output_count, Height confirmed_height, Timestamp block_timestamp, Timestamp block_median_timestamp) {
 	std::vector<api::Output> result;
 	std::vector<api::Output> spent_result;
-	size_t total_count = next_global_index_for_amount(amount);
+	size_t total_count = amount_output_count;
 	// We might need better algorithm if we have lots of locked amounts
 	std::set<size_t> tried_or_added;
 	crypto::random_engine<uint64_t> generator;
@@ -1170,10 +1376,10 @@ std::vector<api::Output> BlockChainState::get_random_outputs(uint8_t block_major
 		}
 		if (!tried_or_added.insert(num).second)
 			continue;
-		UnlockTimePublickKeyHeightSpent unp;
-		invariant(read_amount_output(amount, num, &unp), "num < total_count not found");
+		AmountOutputIndex::Record unp;
+		invariant(read_output(num, &unp), "num < total_count not found");
 		if (unp.height > confirmed_height) {
-			if (confirmed_height + 128 < get_tip_height())
+			if (confirmed_height + 128 < tip_height)
 				total_count = num;
 			// heuristic - if confirmed_height is deep, the area under ditribution curve
 			// with height < confirmed_height might be very small, so we adjust total_count
@@ -1182,7 +1388,7 @@ std::vector<api::Output> BlockChainState::get_random_outputs(uint8_t block_major
 		}
 		if (unp.auditable)
 			continue;
-		if (!m_currency.is_transaction_unlocked(block_major_version, unp.unlock_block_or_timestamp, confirmed_height,
+		if (!currency.is_transaction_unlocked(block_major_version, unp.unlock_block_or_timestamp, confirmed_height,
 		        block_timestamp, block_median_timestamp))
 			continue;
 		if (unp.spent && spent_result.size() >= output_count)
@@ -1198,18 +1404,15 @@ std::vector<api::Output> BlockChainState::get_random_outputs(uint8_t block_major
 	if (result.size() < output_count) {
 		// Read the whole index.
 		size_t attempts = 0;
-		for (DB::Cursor cur = m_db.rbegin(AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount));
-		     result.size() < output_count && attempts < 10000 && !cur.end(); cur.next(), ++attempts) {  // TODO - 10000
-			const char *be        = cur.get_suffix().data();
-			const char *en        = be + cur.get_suffix().size();
-			uint32_t global_index = common::integer_cast<uint32_t>(common::read_varint_sqlite4(be, en));
+		for (size_t global_index = amount_output_count;
+		     result.size() < output_count && attempts < 10000 && global_index-- > 0; ++attempts) {  // TODO - 10000
 			if (tried_or_added.count(global_index) != 0)
 				continue;
-			UnlockTimePublickKeyHeightSpent unp;
-			seria::from_binary(unp, cur.get_value_array());
+			AmountOutputIndex::Record unp;
+			invariant(read_output(global_index, &unp), "global_index < total_count not found");
 			if (unp.auditable || unp.height > confirmed_height)
 				continue;
-			if (!m_currency.is_transaction_unlocked(block_major_version, unp.unlock_block_or_timestamp,
+			if (!currency.is_transaction_unlocked(block_major_version, unp.unlock_block_or_timestamp,
 			        confirmed_height, block_timestamp, block_median_timestamp))
 				continue;
 			if (unp.spent && spent_result.size() >= output_count)
@@ -1231,77 +1434,111 @@ std::vector<api::Output> BlockChainState::get_random_outputs(uint8_t block_major
 	return result;
 }
 
+std::vector<api::Output> BlockChainState::get_random_outputs(uint8_t block_major_version, Amount amount,
+    size_t output_count, Height confirmed_height, Timestamp block_timestamp, Timestamp block_median_timestamp) const {
+	return select_random_outputs(m_currency, get_tip_height(), next_global_index_for_amount(amount),
+	    [&](size_t global_index, AmountOutputIndex::Record *record) {
+		    return m_amount_outputs.read(amount, global_index, record);
+	    },
+	    block_major_version, amount, output_count, confirmed_height, block_timestamp, block_median_timestamp);
+}
+
+std::vector<api::Output> BlockChainReader::get_random_outputs(uint8_t block_major_version, Amount amount,
+    size_t output_count, Height confirmed_height, Timestamp block_timestamp, Timestamp block_median_timestamp) const {
+	return select_random_outputs(m_currency, get_tip_height(), AmountOutputIndex::size(m_txn, amount),
+	    [&](size_t global_index, AmountOutputIndex::Record *record) {
+		    return AmountOutputIndex::read(m_txn, amount, global_index, record);
+	    },
+	    block_major_version, amount, output_count, confirmed_height, block_timestamp, block_median_timestamp);
+}
+
 void BlockChainState::store_keyimage(const KeyImage &key_image, Height height) {
 	auto key = KEYIMAGE_PREFIX + DB::to_binary_key(key_image.data, sizeof(key_image.data));
 	m_db.put(key, seria::to_binary(height), true);
-	auto tit = m_memory_state_ki_tx.find(key_image);
-	if (tit == m_memory_state_ki_tx.end())
-		return;
-	remove_from_pool(tit->second);
+	if (!m_keyimage_filter.insert(key_image)) {
+		m_log(logging::INFO) << "Key image filter is full, rebuilding" << std::endl;
+		build_keyimage_filter(false);  // Key image is already in DB
+	}
+	Hash tid;
+	if (m_memory_state_tx.find_keyimage(key_image, &tid))
+		remove_from_pool(tid);
 }
 
 void BlockChainState::delete_keyimage(const KeyImage &key_image) {
 	auto key = KEYIMAGE_PREFIX + DB::to_binary_key(key_image.data, sizeof(key_image.data));
 	m_db.del(key, true);
+	m_keyimage_filter.erase(key_image);
 }
 
 bool BlockChainState::read_keyimage(const KeyImage &key_image, Height *height) const {
+	m_keyimage_filter_lookups += 1;
+	if (!m_keyimage_filter.may_contain(key_image))
+		return false;
 	auto key = KEYIMAGE_PREFIX + DB::to_binary_key(key_image.data, sizeof(key_image.data));
 	BinaryArray rb;
-	if (!m_db.get(key, rb))
+	if (!m_db.get(key, rb)) {
+		m_keyimage_filter_false_positives += 1;
 		return false;
+	}
+	m_keyimage_filter_true_positives += 1;
 	seria::from_binary(*height, rb);
 	return true;
 }
 
+static AmountOutputIndex::Record to_record(const IBlockChainState::UnlockTimePublickKeyHeightSpent &unp) {
+	AmountOutputIndex::Record record;
+	record.unlock_block_or_timestamp = unp.unlock_block_or_timestamp;
+	record.public_key                = unp.public_key;
+	record.height                    = unp.height;
+	record.auditable                 = unp.auditable;
+	record.spent                     = unp.spent;
+	record.has_dins                  = !unp.dins.empty();
+	return record;
+}
+
 size_t BlockChainState::push_amount_output(
     Amount amount, BlockOrTimestamp unlock_time, Height block_height, const PublicKey &pk, bool is_auditable) {
-	auto my_gi = next_global_index_for_amount(amount);
-	auto key   = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount) + common::write_varint_sqlite4(my_gi);
-	BinaryArray ba =
-	    seria::to_binary(UnlockTimePublickKeyHeightSpent{unlock_time, pk, block_height, is_auditable, false, {}});
-	m_db.put(key, ba, true);
-	m_next_gi_for_amount[amount] += 1;
-	return my_gi;
+	return m_amount_outputs.push(
+	    amount, to_record(UnlockTimePublickKeyHeightSpent{unlock_time, pk, block_height, is_auditable, false, {}}));
 }
 
 void BlockChainState::pop_amount_output(
     Amount amount, BlockOrTimestamp unlock_time, const PublicKey &pk, bool is_auditable) {
 	auto next_gi = next_global_index_for_amount(amount);
 	invariant(next_gi != 0, "BlockChainState::pop_amount_output underflow");
-	next_gi -= 1;
-	m_next_gi_for_amount[amount] -= 1;
-	auto key = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount) + common::write_varint_sqlite4(next_gi);
-
-	UnlockTimePublickKeyHeightSpent unp;
-	invariant(read_amount_output(amount, next_gi, &unp), "BlockChainState::pop_amount_output element does not exist");
-	invariant(!unp.spent && unp.unlock_block_or_timestamp == unlock_time && unp.public_key == pk &&
-	              unp.auditable == is_auditable,
+	const auto record = m_amount_outputs.pop(amount);
+	invariant(!record.spent && record.unlock_block_or_timestamp == unlock_time && record.public_key == pk &&
+	              record.auditable == is_auditable,
 	    "BlockChainState::pop_amount_output popping wrong element");
-	m_db.del(key, true);
+	if (record.has_dins)
+		m_amount_outputs.write_dins(amount, next_gi - 1, std::vector<size_t>{});
 }
 
-size_t BlockChainState::next_global_index_for_amount(Amount amount) const {
-	auto it = m_next_gi_for_amount.find(amount);
-	if (it != m_next_gi_for_amount.end())
-		return it->second;
-	std::string prefix = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount);
-	DB::Cursor cur2    = m_db.rbegin(prefix);
-	size_t alt_in = cur2.end() ? 0 : common::integer_cast<size_t>(common::read_varint_sqlite4(cur2.get_suffix())) + 1;
-	m_next_gi_for_amount[amount] = alt_in;
-	return alt_in;
-}
+size_t BlockChainState::next_global_index_for_amount(Amount amount) const { return m_amount_outputs.size(amount); }
 
 bool BlockChainState::read_amount_output(
     Amount amount, size_t global_index, UnlockTimePublickKeyHeightSpent *unp) const {
-	auto key = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount) + common::write_varint_sqlite4(global_index);
-	BinaryArray rb;
-	if (!m_db.get(key, rb))
+	AmountOutputIndex::Record record;
+	if (!m_amount_outputs.read(amount, global_index, &record))
 		return false;
-	seria::from_binary(*unp, rb);
+	unp->unlock_block_or_timestamp = record.unlock_block_or_timestamp;
+	unp->public_key                = record.public_key;
+	unp->height                    = record.height;
+	unp->auditable                 = record.auditable;
+	unp->spent                     = record.spent;
+	unp->dins.clear();
+	if (record.has_dins)
+		m_amount_outputs.read_dins(amount, global_index, &unp->dins);
 	return true;
 }
 
+void BlockChainState::update_amount_output(
+    Amount amount, size_t global_index, const UnlockTimePublickKeyHeightSpent &unp, bool dins_changed) {
+	m_amount_outputs.write(amount, global_index, to_record(unp));
+	if (dins_changed)
+		m_amount_outputs.write_dins(amount, global_index, unp.dins);
+}
+
 void BlockChainState::process_input(const Hash &tid, size_t iid, const InputKey &input) {
 	if (chain_reaction == 0)
 		return;
@@ -1333,9 +1570,7 @@ void BlockChainState::process_input(const Hash &tid, size_t iid, const InputKey
 	if (din.first.size() > 1)
 		for (size_t i = 0; i != din.first.size(); ++i) {
 			unspents[i].dins.push_back(input_index);
-			auto key = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(input.amount) +
-			           common::write_varint_sqlite4(din.first[i]);
-			m_db.put(key, seria::to_binary(unspents[i]), false);
+			update_amount_output(input.amount, din.first[i], unspents[i], true);
 		}
 	m_db.put(din_key, seria::to_binary(din), true);
 	if (din.first.size() == 1) {
@@ -1369,9 +1604,7 @@ void BlockChainState::unprocess_input(const InputKey &input) {
 			invariant(read_amount_output(input.amount, global_index, &unp), "");
 			invariant(!unp.dins.empty() && unp.dins.back() == input_index, "");
 			unp.dins.pop_back();
-			auto key = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(input.amount) +
-			           common::write_varint_sqlite4(global_index);
-			m_db.put(key, seria::to_binary(unp), false);
+			update_amount_output(input.amount, global_index, unp, true);
 		}
 	m_db.del(din_key, true);
 	if (din.first.size() == 1) {
@@ -1385,7 +1618,6 @@ void BlockChainState::spend_output(UnlockTimePublickKeyHeightSpent &&output, Amo
     size_t trigger_input_index, size_t level, bool spent) {
 	if (level > 2)
 		std::cout << "Sure spent level=" << level << " am:gi=" << amount << ":" << global_index << std::endl;
-	auto key = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount) + common::write_varint_sqlite4(global_index);
 	bool no_subgroup_check_aftermath =
 	    (amount == 6299999999000000 && global_index == 0) || (amount == 18899999999000000 && global_index == 0);
 	if (spent) {
@@ -1395,7 +1627,7 @@ void BlockChainState::spend_output(UnlockTimePublickKeyHeightSpent &&output, Amo
 		invariant(no_subgroup_check_aftermath || output.spent == 1, "");
 		output.spent -= 1;
 	}
-	m_db.put(key, seria::to_binary(output), false);
+	update_amount_output(amount, global_index, output, false);
 	if (spent && output.spent > 1)
 		return;
 	if (!spent && output.spent > 0)
@@ -1441,36 +1673,13 @@ void BlockChainState::spend_output(UnlockTimePublickKeyHeightSpent &&output, Amo
 }
 
 void BlockChainState::test_print_outputs() {
-	Amount previous_amount   = (Amount)-1;
-	size_t next_global_index = 0;
-	int total_counter        = 0;
+	size_t total_counter = 0;
 	std::map<Amount, size_t> coins;
-	for (DB::Cursor cur = m_db.begin(AMOUNT_OUTPUT_PREFIX); !cur.end(); cur.next()) {
-		const char *be      = cur.get_suffix().data();
-		const char *en      = be + cur.get_suffix().size();
-		auto amount         = common::read_varint_sqlite4(be, en);
-		size_t global_index = common::integer_cast<size_t>(common::read_varint_sqlite4(be, en));
-		if (be != en)
-			std::cout << "Excess value bytes for amount=" << amount << " index=" << global_index << std::endl;
-		if (amount != previous_amount) {
-			if (previous_amount != (Amount)-1) {
-				if (!coins.insert(std::make_pair(previous_amount, next_global_index)).second) {
-					std::cout << "Duplicate amount for previous_amount=" << previous_amount
-					          << " next_global_index=" << next_global_index << std::endl;
-				}
-			}
-			previous_amount   = amount;
-			next_global_index = 0;
-		}
-		if (global_index != next_global_index) {
-			std::cout << "Bad output index for amount=" << amount << " index=" << global_index << std::endl;
-		}
-		next_global_index += 1;
-		if (++total_counter % 2000000 == 0)
-			std::cout << "Working on amount=" << amount << " index=" << global_index << std::endl;
-	}
-	total_counter = 0;
-	std::cout << "Total coins=" << total_counter << " total stacks=" << coins.size() << std::endl;
+	m_amount_outputs.for_each_amount([&](Amount amount, size_t count) {
+		if (!coins.insert(std::make_pair(amount, count)).second)
+			std::cout << "Duplicate amount=" << amount << " count=" << count << std::endl;
+	});
+	std::cout << "Total stacks=" << coins.size() << std::endl;
 	for (auto &&co : coins) {
 		auto total_count = next_global_index_for_amount(co.first);
 		if (total_count != co.second)
@@ -1484,4 +1693,5 @@ void BlockChainState::test_print_outputs() {
 				std::cout << "Working on amount=" << co.first << " index=" << i << std::endl;
 		}
 	}
+	std::cout << "Total coins=" << total_counter << std::endl;
 }
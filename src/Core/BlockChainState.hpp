@@ -5,8 +5,13 @@
 
 #include <set>
 #include <unordered_map>
+#include "AmountOutputIndex.hpp"
 #include "BlockChain.hpp"
+#include "KeyImageFilter.hpp"
 #include "Multicore.hpp"
+#include "SyncBlocksCache.hpp"
+#include "TransactionPool.hpp"
+#include "common/SlidingMedian.hpp"
 #include "crypto/hash.hpp"
 
 namespace cn {
@@ -38,10 +43,18 @@ class BlockChainState : public BlockChain, private IBlockChainState {
 public:
 	BlockChainState(logging::ILogger &, const Config &, const Currency &, bool read_only);
 
+	void db_commit() override;  // also saves key image filter snapshot now and then
+
 	std::vector<api::Output> get_random_outputs(uint8_t block_major_version, Amount, size_t output_count, Height,
 	    Timestamp block_timestamp, Timestamp block_median_timestamp) const;
 	typedef std::vector<std::vector<size_t>> BlockGlobalIndices;
+	// Pipelined sync - queue signature checks for blocks which will be applied after current tip
+	bool wants_speculative_check(const Hash &bid, Height height) const;
+	void start_speculative_check(const Hash &bid, const Block &block, Height height);
 	bool read_block_output_global_indices(const Hash &bid, BlockGlobalIndices *) const;
+	bool read_block_output_global_indices(const Hash &bid, DB::Value *) const;  // serialized BlockGlobalIndices
+	// Invalidated on reorganization, Node builds and inserts chunks
+	SyncBlocksCache &get_sync_blocks_cache() { return m_sync_blocks_cache; }
 
 	Amount minimum_pool_fee_per_byte(bool zero_if_not_full, Hash *minimal_tid = nullptr) const;
 	bool add_transaction(const Hash &tid, const Transaction &, const BinaryArray &binary_tx, bool check_sigs,
@@ -49,20 +62,7 @@ public:
 	bool get_largest_referenced_height(const TransactionPrefix &tx, Height *block_height) const;
 
 	size_t get_tx_pool_version() const { return m_tx_pool_version; }
-	struct PoolTransaction {
-		Transaction tx;
-		BinaryArray binary_tx;
-		Amount amount;
-		Amount fee;
-		Timestamp timestamp;
-		Hash newest_referenced_block;
-
-		PoolTransaction(const Transaction &tx, const BinaryArray &binary_tx, Amount fee, Timestamp timestamp,
-		    const Hash &newest_referenced_block);
-		Amount fee_per_byte() const { return fee / binary_tx.size(); }
-	};
-	typedef std::map<Hash, PoolTransaction> PoolTransMap;
-	const PoolTransMap &get_memory_state_transactions() const { return m_memory_state_tx; }
+	const TransactionPool &get_memory_state_transactions() const { return m_memory_state_tx; }
 	std::vector<TransactionDesc> sync_pool(
 	    const std::pair<Amount, Hash> &from, const std::pair<Amount, Hash> &to, size_t max_count) const;
 
@@ -123,6 +123,8 @@ private:
 	void pop_amount_output(Amount, BlockOrTimestamp, const PublicKey &, bool is_auditable) override;
 	size_t next_global_index_for_amount(Amount) const override;
 	bool read_amount_output(Amount, size_t global_index, UnlockTimePublickKeyHeightSpent *) const override;
+	void update_amount_output(
+	    Amount, size_t global_index, const UnlockTimePublickKeyHeightSpent &, bool dins_changed);
 	void spend_output(UnlockTimePublickKeyHeightSpent &&, Amount, size_t global_index, size_t trigger_input_index,
 	    size_t level, bool spent);
 
@@ -134,23 +136,37 @@ private:
 
 	void undo_transaction(IBlockChainState *delta_state, Height, const Transaction &);
 
-	const size_t m_max_pool_size;
 	mutable crypto::CryptoNightContext m_hash_crypto_context;
-	mutable std::unordered_map<Amount, size_t> m_next_gi_for_amount;
-	// Read from db on first use, write on modification
+	AmountOutputIndex m_amount_outputs;
 
 	void remove_from_pool(Hash tid);
 
 	size_t m_tx_pool_version = 2;  // Incremented every time pool changes, reset to 2 on redo block. 2 is selected
 	                               // because wallet resets to 1, so after both reset pool versions do not equal
-	PoolTransMap m_memory_state_tx;
-	std::map<KeyImage, Hash> m_memory_state_ki_tx;
-	std::set<std::pair<Amount, Hash>> m_memory_state_fee_tx;
-	size_t m_memory_state_total_size = 0;
+	TransactionPool m_memory_state_tx;
 
 	mutable std::map<Hash, std::pair<BinaryArray, Height>> m_mining_transactions;
 	// We remember them for several blocks
 	void clear_mining_transactions() const;
+
+	// Pool transactions redone for next block, so template assembly is selection by fee only.
+	// Redone transactions stay valid while height and timestamps grow, invalidated on undo and version change
+	mutable std::set<Hash> m_template_candidates;
+	mutable std::map<Hash, bool> m_template_pending;  // not yet redone for template, value is need check_sigs
+	mutable uint8_t m_template_major_version      = 0;
+	mutable Height m_template_height              = 0;
+	mutable Timestamp m_template_timestamp        = 0;
+	mutable Timestamp m_template_median_timestamp = 0;
+	mutable size_t m_template_builds              = 0;
+	mutable size_t m_template_last_build_us       = 0;
+	mutable size_t m_template_total_build_us      = 0;
+	mutable size_t m_template_max_build_us        = 0;
+	mutable size_t m_template_redone_transactions = 0;
+	void update_template_candidates(
+	    uint8_t major_version, Height, Timestamp block_timestamp, Timestamp block_median_timestamp) const;
+	void invalidate_template_candidates(bool need_check_sigs) const;
+	void build_mining_block_template(const Hash &, const AccountAddress &, const BinaryArray &extra_nonce,
+	    BlockTemplate *, Difficulty *, Height *, size_t *) const;
 	size_t m_next_nz_input_index = 0;
 	void process_input(const Hash &tid, size_t iid, const InputKey &input);
 	void unprocess_input(const InputKey &input);
@@ -159,6 +175,13 @@ private:
 	size_t m_next_median_size                = 0;
 	size_t m_next_median_block_capacity_vote = 0;
 	void tip_changed() override;  // Updates values above
+	// Values of last blocks for medians above, moved with tip instead of reading whole windows on every block
+	common::SlidingMedian<Timestamp> m_timestamps_window;  // excludes genesis
+	common::SlidingMedian<size_t> m_sizes_window;
+	common::SlidingMedian<size_t> m_capacity_votes_window;  // blocks before amethyst are not counted
+	Hash m_median_windows_tip_bid;
+	Hash m_median_windows_previous_bid;
+	void update_median_windows();
 	void on_reorganization(
 	    const std::map<Hash, std::pair<Transaction, BinaryArray>> &undone_transactions, bool undone_blocks) override;
 	Timestamp calculate_next_median_timestamp(const api::BlockHeader &prev_info) const;
@@ -167,6 +190,19 @@ private:
 
 	RingCheckerMulticore m_ring_checker;
 	std::chrono::steady_clock::time_point m_log_redo_block_timestamp;
+
+	KeyImageFilter m_keyimage_filter;  // Most key images are not spent, so we check filter before DB
+	bool m_keyimage_filter_valid = false;
+	const std::string m_keyimage_filter_path;  // Empty if read only
+	std::chrono::steady_clock::time_point m_keyimage_filter_saved;  // Default if snapshot is not up to date
+	mutable size_t m_keyimage_filter_lookups         = 0;
+	mutable size_t m_keyimage_filter_true_positives  = 0;
+	mutable size_t m_keyimage_filter_false_positives = 0;
+	void build_keyimage_filter(bool allow_snapshot);
+	bool load_keyimage_filter();  // false if snapshot is missing, corrupted or not from main chain
+
+	SyncBlocksCache m_sync_blocks_cache;
+	Height m_lowest_undone_height = std::numeric_limits<Height>::max();  // since last on_reorganization
 };
 
 }  // namespace cn
@@ -0,0 +1,125 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "BlockCodec.hpp"
+#include "Config.hpp"
+#include "common/Invariant.hpp"
+#include "common/Varint.hpp"
+
+using namespace cn;
+
+BlockCodec::BlockCodec(const Config &config)
+    : m_dictionary_size(config.block_dictionary_size)
+    , m_training_size(config.block_dictionary_training_size)
+    , m_retrain_every(config.block_dictionary_retrain_every)
+    , m_memory_budget(config.block_cache_memory)
+    , m_dictionaries(1) {}
+
+void BlockCodec::add_dictionary(size_t id, BinaryArray &&data) {
+	invariant(id != RAW, "Block dictionary id 0 is reserved for uncompressed blocks");
+	auto dictionary = std::make_shared<const common::LZDictionary>(std::move(data));
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_dictionaries.size() <= id)
+		m_dictionaries.resize(id + 1);
+	m_dictionaries.at(id) = std::move(dictionary);
+	m_compressor.reset();
+}
+
+bool BlockCodec::add_sample(const BinaryArray &block_data) {
+	// Only main thread modifies m_dictionaries, so it can read them without lock
+	const bool first = m_dictionaries.size() == 1;
+	m_stored_since_dictionary += block_data.size();
+	if (first || m_stored_since_dictionary + m_training_size >= m_retrain_every) {
+		m_samples.push_back(block_data);
+		m_samples_size += block_data.size();
+	}
+	return m_samples_size >= m_training_size && (first || m_stored_since_dictionary >= m_retrain_every);
+}
+
+size_t BlockCodec::train(BinaryArray *dictionary_data) {
+	*dictionary_data = common::LZDictionary::train(m_samples, m_dictionary_size);
+	m_samples.clear();
+	m_samples_size            = 0;
+	m_stored_since_dictionary = 0;
+	const size_t id           = m_dictionaries.size();
+	add_dictionary(id, BinaryArray(*dictionary_data));
+	return id;
+}
+
+BinaryArray BlockCodec::encode(const BinaryArray &block_data) {
+	// Called from main thread only, same as add_dictionary, so no lock
+	const size_t id = m_dictionaries.size() - 1;
+	if (id != RAW) {
+		if (!m_compressor)
+			m_compressor = std::make_unique<common::LZCompressor>(*m_dictionaries.back());
+		const BinaryArray compressed = m_compressor->compress(block_data.data(), block_data.size());
+		BinaryArray result           = common::get_varint_data(id);
+		if (result.size() + compressed.size() < block_data.size() + 1) {
+			result.insert(result.end(), compressed.begin(), compressed.end());
+			return result;
+		}
+	}
+	BinaryArray result{RAW};
+	result.insert(result.end(), block_data.begin(), block_data.end());
+	return result;
+}
+
+std::shared_ptr<const BinaryArray> BlockCodec::decode(const Hash &bid, const uint8_t *stored, size_t size) const {
+	invariant(size != 0 && stored[0] != RAW, "BlockCodec::decode called for uncompressed block");
+	const uint8_t *data = stored;
+	const uint8_t *end  = stored + size;
+	size_t id           = 0;
+	if (common::read_varint(data, end, &id) <= 0)
+		throw std::runtime_error("Stored block has corrupted dictionary id");
+	std::shared_ptr<const common::LZDictionary> dictionary;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		auto cit = m_cache.find(bid);
+		if (cit != m_cache.end()) {
+			m_lru.splice(m_lru.begin(), m_lru, cit->second.lru_it);
+			m_hits += 1;
+			return cit->second.data;
+		}
+		m_misses += 1;
+		if (id >= m_dictionaries.size() || !m_dictionaries.at(id))
+			throw std::runtime_error("Stored block compressed with unknown dictionary " + std::to_string(id));
+		dictionary = m_dictionaries.at(id);
+	}
+	// Decompress without lock, so reader threads do not wait for each other
+	auto result =
+	    std::make_shared<const BinaryArray>(common::lz_decompress(data, static_cast<size_t>(end - data), *dictionary));
+	const size_t entry_size = result->size() + ENTRY_OVERHEAD;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (entry_size > m_memory_budget || m_cache.count(bid) != 0)
+		return result;
+	while (m_memory_usage + entry_size > m_memory_budget) {
+		auto eit = m_cache.find(m_lru.back());
+		m_memory_usage -= eit->second.data->size() + ENTRY_OVERHEAD;
+		m_cache.erase(eit);
+		m_lru.pop_back();
+	}
+	m_lru.push_front(bid);
+	m_cache[bid] = Entry{result, m_lru.begin()};
+	m_memory_usage += entry_size;
+	return result;
+}
+
+size_t BlockCodec::get_dictionary_count() const {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_dictionaries.size() - 1;
+}
+
+size_t BlockCodec::memory_usage() const {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_memory_usage;
+}
+
+size_t BlockCodec::get_hits() const {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_hits;
+}
+
+size_t BlockCodec::get_misses() const {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_misses;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "CryptoNote.hpp"
+#include "common/Compression.hpp"
+#include "common/Nocopy.hpp"
+
+namespace cn {
+
+class Config;
+
+// Compressed block storage format. Each stored block starts with varint id of dictionary it was compressed with,
+// 0 for blocks stored as is (before first dictionary is trained, or when compression does not help).
+// New dictionary is trained on recent blocks every block_dictionary_retrain_every bytes, owner stores it in DB
+// together with block being stored. Decompressed blocks are shared from LRU cache within memory budget.
+// Decoding is called from BlockChainReader threads, so dictionaries and cache are under lock.
+class BlockCodec : private common::Nocopy {
+public:
+	static constexpr size_t RAW = 0;
+
+	explicit BlockCodec(const Config &config);
+
+	void add_dictionary(size_t id, BinaryArray &&data);  // when loading from DB
+	bool add_sample(const BinaryArray &block_data);      // true when it is time to train new dictionary
+	size_t train(BinaryArray *dictionary_data);          // returns id of new dictionary
+	BinaryArray encode(const BinaryArray &block_data);
+	// Stored data includes dictionary id, which must not be RAW. Throws on corrupted data
+	std::shared_ptr<const BinaryArray> decode(const Hash &bid, const uint8_t *stored, size_t size) const;
+
+	size_t get_dictionary_count() const;
+	size_t memory_usage() const;  // estimate
+	size_t get_hits() const;
+	size_t get_misses() const;
+
+private:
+	const size_t m_dictionary_size;
+	const size_t m_training_size;
+	const size_t m_retrain_every;
+	const size_t m_memory_budget;
+
+	std::vector<BinaryArray> m_samples;  // main thread only
+	size_t m_samples_size            = 0;
+	size_t m_stored_since_dictionary = 0;
+	std::unique_ptr<common::LZCompressor> m_compressor;  // for last dictionary, main thread only
+
+	mutable std::mutex m_mutex;
+	std::vector<std::shared_ptr<const common::LZDictionary>> m_dictionaries;  // by id, [RAW] is empty
+	struct Entry {
+		std::shared_ptr<const BinaryArray> data;
+		std::list<Hash>::iterator lru_it;
+	};
+	static constexpr size_t ENTRY_OVERHEAD = sizeof(Entry) + 2 * sizeof(Hash) + 64;  // plus map and list nodes
+	mutable std::unordered_map<Hash, Entry> m_cache;
+	mutable std::list<Hash> m_lru;  // most recently used at front
+	mutable size_t m_memory_usage = 0;
+	mutable size_t m_hits         = 0;
+	mutable size_t m_misses       = 0;
+};
+
+}  // namespace cn
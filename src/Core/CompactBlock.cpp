@@ -0,0 +1,130 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "CompactBlock.hpp"
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include "CryptoNoteTools.hpp"
+#include "Currency.hpp"
+#include "common/Invariant.hpp"
+#include "common/Varint.hpp"
+#include "seria/BinaryInputStream.hpp"
+#include "seria/BinaryOutputStream.hpp"
+
+using namespace cn;
+
+static const size_t SHORT_ID_SIZE = p2p::RelayCompactBlock::Notify::SHORT_ID_SIZE;
+
+p2p::RelayCompactBlock::Notify CompactBlock::create(
+    const RawBlock &raw_block, const Hash &bid, Height height, uint64_t salt) {
+	BlockTemplate header;
+	seria::from_binary(header, raw_block.block);
+	p2p::RelayCompactBlock::Notify msg;
+	msg.salt = salt;
+	msg.short_ids.resize(header.transaction_hashes.size() * SHORT_ID_SIZE);
+	for (size_t i = 0; i != header.transaction_hashes.size(); ++i)
+		common::uint_le_to_bytes(msg.short_ids.data() + i * SHORT_ID_SIZE, SHORT_ID_SIZE,
+		    get_short_id(salt, header.transaction_hashes.at(i)));
+	msg.transactions_merkle_root = get_body_proxy_from_template(header).transactions_merkle_root;
+	header.transaction_hashes.clear();
+	msg.header                    = seria::to_binary(header);
+	msg.top_id                    = bid;
+	msg.current_blockchain_height = height;
+	return msg;
+}
+
+uint64_t CompactBlock::get_short_id(uint64_t salt, const Hash &tid) {
+	unsigned char data[8 + sizeof(tid.data)];
+	common::uint_le_to_bytes(data, 8, salt);
+	std::memcpy(data + 8, tid.data, sizeof(tid.data));
+	const Hash hash = crypto::cn_fast_hash(data, sizeof(data));
+	return common::uint_le_from_bytes<uint64_t>(hash.data, SHORT_ID_SIZE);
+}
+
+CompactBlock::CompactBlock(p2p::RelayCompactBlock::Notify &&msg)
+    : m_salt(msg.salt), m_bid(msg.top_id), m_height(msg.current_blockchain_height) {
+	seria::from_binary(m_header, msg.header);
+	if (!m_header.transaction_hashes.empty())
+		throw std::runtime_error("RelayCompactBlock header must not contain transaction hashes");
+	if (msg.short_ids.size() % SHORT_ID_SIZE != 0 ||
+	    msg.short_ids.size() / SHORT_ID_SIZE > p2p::RelayCompactBlock::Notify::MAX_TRANSACTION_COUNT)
+		throw std::runtime_error("RelayCompactBlock wrong short_ids size");
+	const size_t count = msg.short_ids.size() / SHORT_ID_SIZE;
+	m_short_ids.reserve(count);
+	for (size_t i = 0; i != count; ++i)
+		m_short_ids.push_back(
+		    common::uint_le_from_bytes<uint64_t>(msg.short_ids.data() + i * SHORT_ID_SIZE, SHORT_ID_SIZE));
+	m_body_proxy.transactions_merkle_root = msg.transactions_merkle_root;
+	m_body_proxy.transaction_count        = count + 1;  // with coinbase
+	if (cn::get_block_hash(m_header, m_body_proxy) != m_bid)
+		throw std::runtime_error("RelayCompactBlock lied about top_id");
+	m_tids.resize(count);
+	m_transactions.resize(count);
+	for (size_t i = 0; i != count; ++i)
+		m_missing.push_back(static_cast<uint32_t>(i));
+}
+
+void CompactBlock::fill_from_pool(const TransactionPool &pool) {
+	const size_t AMBIGUOUS = std::numeric_limits<size_t>::max();
+	std::unordered_map<uint64_t, size_t> positions;
+	for (auto i : m_missing) {
+		auto pit = positions.insert(std::make_pair(m_short_ids.at(i), size_t(i)));
+		if (!pit.second)
+			pit.first->second = AMBIGUOUS;
+	}
+	std::vector<std::pair<size_t, TransactionPool::Transactions::const_iterator>> found;
+	found.reserve(positions.size());
+	for (auto tit = pool.begin(); tit != pool.end(); ++tit) {
+		auto pit = positions.find(get_short_id(m_salt, tit->first));
+		if (pit == positions.end() || pit->second == AMBIGUOUS)
+			continue;
+		found.push_back(std::make_pair(pit->second, tit));
+	}
+	std::vector<size_t> match_count(m_short_ids.size());
+	for (const auto &fo : found)
+		match_count.at(fo.first) += 1;
+	std::vector<uint32_t> still_missing;
+	for (const auto &fo : found)
+		if (match_count.at(fo.first) == 1) {
+			m_tids.at(fo.first)         = fo.second->first;
+			m_transactions.at(fo.first) = fo.second->second.binary_tx;
+		}
+	for (auto i : m_missing)
+		if (match_count.at(i) != 1)
+			still_missing.push_back(i);
+	m_missing = std::move(still_missing);
+}
+
+bool CompactBlock::add_missing(const std::vector<BinaryArray> &transactions) {
+	if (transactions.size() != m_missing.size())
+		return false;
+	for (size_t j = 0; j != m_missing.size(); ++j) {
+		const size_t i = m_missing.at(j);
+		Transaction tx;
+		try {
+			seria::from_binary(tx, transactions.at(j));
+		} catch (const std::exception &) {
+			return false;
+		}
+		const Hash tid = get_transaction_hash(tx);
+		if (get_short_id(m_salt, tid) != m_short_ids.at(i))
+			return false;
+		m_tids.at(i)         = tid;
+		m_transactions.at(i) = transactions.at(j);
+	}
+	m_missing.clear();
+	return true;
+}
+
+bool CompactBlock::get_block(RawBlock *raw_block) const {
+	invariant(m_missing.empty(), "CompactBlock::get_block called with missing transactions");
+	BlockTemplate header      = m_header;
+	header.transaction_hashes = m_tids;
+	auto body_proxy           = get_body_proxy_from_template(header);
+	if (body_proxy.transactions_merkle_root != m_body_proxy.transactions_merkle_root)
+		return false;
+	raw_block->block        = seria::to_binary(header);
+	raw_block->transactions = m_transactions;
+	return true;
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <vector>
+#include "CryptoNote.hpp"
+#include "TransactionPool.hpp"
+#include "p2p/P2pProtocolDefinitions.hpp"
+
+namespace cn {
+
+// Block relayed as header with coinbase and short ids of other transactions. Receiver takes transactions from its
+// pool and asks peer only for the rest. Short id is first bytes of hash of salt and transaction hash, so it is
+// enough to tell pool transactions apart, but when it is not (different transaction with the same short id in pool),
+// reconstructed block hash differs from announced, and block is downloaded normally. Message carries merkle root
+// of transactions, so block hash is checked against top_id before any pool lookups.
+class CompactBlock {
+public:
+	static p2p::RelayCompactBlock::Notify create(
+	    const RawBlock &raw_block, const Hash &bid, Height height, uint64_t salt);
+	static uint64_t get_short_id(uint64_t salt, const Hash &tid);
+
+	// throws if message is malformed or header with merkle root does not hash to top_id
+	explicit CompactBlock(p2p::RelayCompactBlock::Notify &&msg);
+
+	const BlockTemplate &get_header() const { return m_header; }
+	const Hash &get_bid() const { return m_bid; }
+	Height get_height() const { return m_height; }
+	size_t get_transaction_count() const { return m_short_ids.size(); }
+
+	// Short ids matched by several pool transactions (or block transactions) stay missing
+	void fill_from_pool(const TransactionPool &pool);
+	const std::vector<uint32_t> &get_missing() const { return m_missing; }
+	// Transactions for get_missing() indexes, in the same order. False if they do not match short ids
+	bool add_missing(const std::vector<BinaryArray> &transactions);
+	// Call when nothing is missing. False if transactions do not match merkle root
+	bool get_block(RawBlock *raw_block) const;
+
+private:
+	BlockTemplate m_header;
+	BlockBodyProxy m_body_proxy;
+	uint64_t m_salt = 0;
+	std::vector<uint64_t> m_short_ids;
+	Hash m_bid;
+	Height m_height = 0;
+	std::vector<Hash> m_tids;
+	std::vector<BinaryArray> m_transactions;
+	std::vector<uint32_t> m_missing;
+};
+
+}  // namespace cn
@@ -86,6 +86,18 @@ Config::Config(common::CommandLine &cmd)
 	}
 	if (const char *pa = cmd.get("--p2p-external-port"))
 		p2p_external_port = boost::lexical_cast<uint16_t>(pa);
+	if (const char *pa = cmd.get("--rpc-worker-threads"))
+		rpc_worker_threads = boost::lexical_cast<size_t>(pa);
+	if (cmd.get_bool("--compress-blocks"))
+		compress_blocks = true;
+	if (cmd.get_bool("--p2p-no-block-ranges"))
+		p2p_block_ranges = false;
+	if (cmd.get_bool("--p2p-no-compact-blocks"))
+		p2p_compact_blocks = false;
+	if (const char *pa = cmd.get("--log-queue-size"))
+		log_queue_size = boost::lexical_cast<size_t>(pa);
+	if (cmd.get_bool("--log-drop-on-overflow"))
+		log_drop_on_overflow = true;
 	if (const char *pa = cmd.get("--walletd-bind-address")) {
 		if (!common::parse_ip_address_and_port(pa, &walletd_bind_ip, &walletd_bind_port))
 			throw std::runtime_error("Wrong address format " + std::string(pa) + ", should be ip:port");
@@ -57,6 +57,10 @@ public:
 	size_t db_commit_every_n_blocks         = 50000;
 	// This affects DB transaction size. TODO - sum size of blocks instead
 
+	Timestamp keyimage_filter_save_period = 3600;
+	// Key image filter snapshot is rewritten whole, so not on every commit. On start we add key images of blocks
+	// applied after snapshot was saved
+
 	std::string walletd_authorization;
 	uint16_t walletd_bind_port;
 	std::string walletd_bind_ip;
@@ -83,6 +87,10 @@ public:
 	Timestamp p2p_no_outgoing_message_ping_timeout         = 60 * 4;
 
 	size_t rpc_sync_blocks_max_count;
+	size_t rpc_worker_threads              = 0;
+	Timestamp db_commit_period_rpc_workers = 1;
+	// When not 0, read-only RPC methods are answered by worker threads from committed DB state. Blocks are
+	// still applied by main thread, which commits soon after tip changes so that workers see recent tip
 
 	Height p2p_outgoing_peer_max_lag = 5;
 	// if peer we are connected to is/starts lagging by 5 blocks or more, we will
@@ -98,6 +106,40 @@ public:
 	size_t download_broadcast_every_n_blocks     = 10000;
 	// During download, we send time sync commands periodically to inform other that
 	// they can now download more blocks from us
+	bool p2p_block_ranges            = true;
+	size_t download_range_max_blocks = 1000;
+	// With peers which also announce block ranges in handshake, contiguous blocks are requested in one message,
+	// and number of blocks requested from each peer adapts to its throughput and latency
+	bool p2p_compact_blocks = true;
+	// New blocks are relayed to V5 peers as header, coinbase and short transaction ids, they take the rest from pool
+	size_t ring_checker_pipeline_blocks = 16;
+	// Signatures of downloaded blocks are checked ahead while previous blocks are applied, 0 to disable
+	size_t header_cache_memory             = 64 * 1024 * 1024;
+	size_t header_cache_main_chain_headers = 0;
+	// Headers read from DB are cached within memory budget. Main chain headers near tip are kept in array
+	// indexed by height, its size is max of largest consensus window * 2 and header_cache_main_chain_headers
+	size_t sync_blocks_cache_memory = 64 * 1024 * 1024;
+	// Serialized binary sync_blocks chunks are shared between wallets within memory budget, 0 to disable
+	bool compress_blocks                  = false;
+	size_t block_dictionary_size          = 64 * 1024;
+	size_t block_dictionary_training_size = 4 * 1024 * 1024;
+	size_t block_dictionary_retrain_every = 256 * 1024 * 1024;
+	size_t block_cache_memory             = 16 * 1024 * 1024;
+	// Blockchain DB created with compress_blocks stores blocks compressed with dictionary trained on recently stored
+	// blocks, retrained every block_dictionary_retrain_every bytes. Existing DB keeps format it was created with.
+	// Decompressed blocks are cached within memory budget
+	size_t block_preparator_queue_size = 2000;
+	size_t max_prepared_blocks_memory  = 512 * 1024 * 1024;
+	float prepared_block_timeout       = 600.0f;
+	// Downloaded blocks wait for PoW check in bounded queue, when it is half full we stop requesting blocks.
+	// Prepared blocks not taken for too long (or over memory budget) are dropped and downloaded again
+	size_t block_preparator_hash_ways = 2;
+	// Each thread interleaves up to this number of PoW hashes (1..4). More ways hide more latency,
+	// but need 2 MB of cache per way, so on CPUs with small cache per core 1 or 2 is better
+	size_t log_queue_size     = 4096;
+	bool log_drop_on_overflow = false;
+	// Log files are written by background thread, each logging thread queues up to log_queue_size messages.
+	// When queue is full, logging thread waits, or message is dropped with log_drop_on_overflow. 0 to write directly
 
 	Timestamp wallet_sync_timestamp_granularity = 86400 * 30;
 	// Sending exact timestamp of wallet to public node allows tracking
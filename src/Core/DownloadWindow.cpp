@@ -0,0 +1,36 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "DownloadWindow.hpp"
+#include <algorithm>
+
+using namespace cn;
+
+DownloadWindow::DownloadWindow(size_t min_blocks, size_t max_blocks, size_t initial_blocks)
+    : m_min_blocks(std::max<size_t>(1, min_blocks))
+    , m_max_blocks(std::max(m_min_blocks, max_blocks))
+    , m_window(std::min(m_max_blocks, std::max(m_min_blocks, initial_blocks))) {}
+
+size_t DownloadWindow::get_batch() const { return std::max<size_t>(1, m_window / 4); }
+
+void DownloadWindow::on_response(
+    size_t block_count, size_t bytes, size_t delivered_at_send, TimePoint sent, TimePoint now) {
+	m_delivered += bytes;
+	if (block_count == 0)
+		return;
+	const bool first        = m_block_size == 0;
+	const double round_trip = std::max(1e-6, std::chrono::duration<double>(now - sent).count());
+	const double throughput = (m_delivered - delivered_at_send) / round_trip;
+	const double block_size = double(bytes) / block_count;
+	m_block_size            = first ? block_size : m_block_size + (block_size - m_block_size) / 8;
+	m_latency               = first ? round_trip : std::min(m_latency, round_trip);
+	// Jumps up at once, falls slowly, so we notice when peer or link becomes slower
+	m_throughput = throughput > m_throughput ? throughput : m_throughput - (m_throughput - throughput) / 16;
+
+	const double target = 2 * m_throughput * m_latency / m_block_size;
+	if (target > m_window)
+		m_window = static_cast<size_t>(std::min(target, double(m_window + std::max<size_t>(1, m_window / 2))));
+	else
+		m_window = static_cast<size_t>(std::max(target, double(m_window - m_window / 4)));
+	m_window = std::min(m_max_blocks, std::max(m_min_blocks, m_window));
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace cn {
+
+// Number of blocks we keep requested from single peer, adapted to measured throughput and latency of its responses.
+// Aims at twice the bandwidth-delay product, so peer has next request before it finishes answering previous one,
+// but does not take more blocks than it can deliver soon, leaving them to other peers.
+// Throughput sample is bytes delivered between sending request and receiving its response divided by that time,
+// it cannot exceed link speed, so we take the largest recent one. Latency is the smallest round trip ever seen,
+// because round trips of requests waiting behind others grow with window, and would make it grow further.
+class DownloadWindow {
+public:
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	DownloadWindow(size_t min_blocks, size_t max_blocks, size_t initial_blocks);
+
+	// delivered_at_send is get_delivered() when request was sent
+	void on_response(size_t block_count, size_t bytes, size_t delivered_at_send, TimePoint sent, TimePoint now);
+
+	size_t get_window() const { return m_window; }
+	size_t get_batch() const;                               // blocks per request, so several requests are in flight
+	size_t get_delivered() const { return m_delivered; }    // bytes
+	double get_throughput() const { return m_throughput; }  // bytes per second, 0 until first response
+	double get_latency() const { return m_latency; }        // seconds
+
+private:
+	size_t m_min_blocks;
+	size_t m_max_blocks;
+	size_t m_window;
+	size_t m_delivered  = 0;
+	double m_block_size = 0;  // average, 0 until first response
+	double m_throughput = 0;
+	double m_latency    = 0;
+};
+
+}  // namespace cn
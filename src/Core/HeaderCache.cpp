@@ -0,0 +1,92 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "HeaderCache.hpp"
+#include <algorithm>
+#include "common/Invariant.hpp"
+
+using namespace cn;
+
+HeaderCache::HeaderCache(size_t memory_budget)
+    : m_shard_capacity(std::max<size_t>(1, memory_budget / ENTRY_SIZE / SHARD_COUNT)) {
+	for (auto &shard : m_shards) {
+		shard.slots.reserve(m_shard_capacity);
+		shard.index.reserve(m_shard_capacity);
+	}
+}
+
+const api::BlockHeader *HeaderCache::find(const Hash &bid) {
+	Shard &shard = get_shard(bid);
+	auto iit     = shard.index.find(bid);
+	if (iit == shard.index.end()) {
+		m_misses += 1;
+		return nullptr;
+	}
+	m_hits += 1;
+	Slot &slot      = shard.slots.at(iit->second);
+	slot.referenced = true;
+	return &slot.header;
+}
+
+const api::BlockHeader *HeaderCache::insert(const Hash &bid, api::BlockHeader &&header) {
+	Shard &shard = get_shard(bid);
+	auto iit     = shard.index.find(bid);
+	if (iit != shard.index.end()) {
+		Slot &slot  = shard.slots.at(iit->second);
+		slot.header = std::move(header);
+		return &slot.header;
+	}
+	size_t pos = 0;
+	if (!shard.free_slots.empty()) {
+		pos = shard.free_slots.back();
+		shard.free_slots.pop_back();
+	} else if (shard.slots.size() < m_shard_capacity) {
+		pos = shard.slots.size();
+		shard.slots.emplace_back();
+	} else
+		pos = evict(shard);
+	Slot &slot      = shard.slots.at(pos);
+	slot.bid        = bid;
+	slot.header     = std::move(header);
+	slot.used       = true;
+	slot.referenced = false;  // must be hit once more to survive first pass of clock hand
+	shard.index.emplace(bid, pos);
+	return &slot.header;
+}
+
+void HeaderCache::erase(const Hash &bid) {
+	Shard &shard = get_shard(bid);
+	auto iit     = shard.index.find(bid);
+	if (iit == shard.index.end())
+		return;
+	Slot &slot  = shard.slots.at(iit->second);
+	slot.used   = false;
+	slot.header = api::BlockHeader{};
+	shard.free_slots.push_back(iit->second);
+	shard.index.erase(iit);
+}
+
+size_t HeaderCache::evict(Shard &shard) {
+	// Shard is full, so all slots are used, and we find victim in at most 2 full turns
+	while (true) {
+		Slot &slot       = shard.slots.at(shard.hand);
+		const size_t pos = shard.hand;
+		shard.hand       = (shard.hand + 1) % shard.slots.size();
+		invariant(slot.used, "Header cache free slot not in free list");
+		if (slot.referenced) {
+			slot.referenced = false;
+			continue;
+		}
+		shard.index.erase(slot.bid);
+		slot.used = false;
+		m_evictions += 1;
+		return pos;
+	}
+}
+
+size_t HeaderCache::size() const {
+	size_t result = 0;
+	for (const auto &shard : m_shards)
+		result += shard.index.size();
+	return result;
+}
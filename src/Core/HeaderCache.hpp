@@ -0,0 +1,58 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "CryptoNote.hpp"
+#include "rpc_api.hpp"
+
+namespace cn {
+
+// Bounded cache of block headers read from DB, replaces old policy of clearing everything on overflow.
+// Eviction is CLOCK (second chance), which approximates LRU without moving entries on every hit.
+// Cache is split into shards, each with slots and index preallocated for its part of memory budget,
+// so there are no rehashes of large table and eviction never touches more than one shard.
+// Returned pointers are valid until next insert or erase.
+class HeaderCache {
+public:
+	explicit HeaderCache(size_t memory_budget);
+
+	const api::BlockHeader *find(const Hash &bid);  // marks header as recently used
+	const api::BlockHeader *insert(const Hash &bid, api::BlockHeader &&header);
+	void erase(const Hash &bid);
+
+	size_t size() const;
+	size_t capacity() const { return m_shard_capacity * SHARD_COUNT; }
+	size_t memory_usage() const { return size() * ENTRY_SIZE; }  // estimate
+	size_t get_hits() const { return m_hits; }
+	size_t get_misses() const { return m_misses; }
+	size_t get_evictions() const { return m_evictions; }
+
+private:
+	static constexpr size_t SHARD_COUNT = 16;
+	struct Slot {
+		Hash bid;
+		api::BlockHeader header;
+		bool used       = false;
+		bool referenced = false;
+	};
+	static constexpr size_t ENTRY_SIZE = sizeof(Slot) + 64;  // plus index node
+	struct Shard {
+		std::vector<Slot> slots;
+		std::unordered_map<Hash, size_t> index;
+		std::vector<size_t> free_slots;
+		size_t hand = 0;  // CLOCK position
+	};
+	Shard m_shards[SHARD_COUNT];
+	size_t m_shard_capacity = 0;
+	size_t m_hits           = 0;
+	size_t m_misses         = 0;
+	size_t m_evictions      = 0;
+
+	Shard &get_shard(const Hash &bid) { return m_shards[bid.data[sizeof(bid.data) - 1] % SHARD_COUNT]; }
+	size_t evict(Shard &shard);  // returns freed slot
+};
+
+}  // namespace cn
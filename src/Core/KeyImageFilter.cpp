@@ -0,0 +1,158 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "KeyImageFilter.hpp"
+#include <cstring>
+#include "common/Invariant.hpp"
+#include "crypto/crypto.hpp"
+
+using namespace cn;
+
+static const char SNAPSHOT_MAGIC[] = "KIF1";
+
+static uint64_t mix64(uint64_t h) {  // splitmix64 finalizer
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+	return h;
+}
+
+static void append_uint64(BinaryArray &ba, uint64_t v) {
+	for (size_t i = 0; i != 8; ++i)
+		ba.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+static uint64_t read_uint64(const uint8_t *data) {
+	uint64_t v = 0;
+	for (size_t i = 0; i != 8; ++i)
+		v |= uint64_t(data[i]) << (8 * i);
+	return v;
+}
+
+KeyImageFilter::KeyImageFilter(size_t expected_count) : m_salt(crypto::rand<uint64_t>()) {
+	// We aim at 50% load, so that filter can grow 1.8x before rebuild
+	size_t bucket_count = 1 << 16;
+	while (bucket_count * BUCKET_SIZE < expected_count * 2)
+		bucket_count *= 2;
+	m_slots.resize(bucket_count * BUCKET_SIZE);
+	m_bucket_mask = bucket_count - 1;
+}
+
+void KeyImageFilter::get_position(const KeyImage &key_image, size_t *bucket, uint16_t *fingerprint) const {
+	uint64_t a = 0, b = 0;
+	memcpy(&a, key_image.data, sizeof(a));
+	memcpy(&b, key_image.data + sizeof(a), sizeof(b));
+	const uint64_t h = mix64(a ^ m_salt ^ mix64(b));
+	*bucket          = static_cast<size_t>(h) & m_bucket_mask;
+	*fingerprint     = static_cast<uint16_t>(h >> 48);
+	if (*fingerprint == 0)
+		*fingerprint = 1;
+}
+
+size_t KeyImageFilter::alt_bucket(size_t bucket, uint16_t fingerprint) const {
+	return (bucket ^ static_cast<size_t>(mix64(fingerprint))) & m_bucket_mask;
+}
+
+bool KeyImageFilter::insert_to_bucket(size_t bucket, uint16_t fingerprint) {
+	uint16_t *slots = m_slots.data() + bucket * BUCKET_SIZE;
+	for (size_t i = 0; i != BUCKET_SIZE; ++i)
+		if (slots[i] == 0) {
+			slots[i] = fingerprint;
+			return true;
+		}
+	return false;
+}
+
+bool KeyImageFilter::erase_from_bucket(size_t bucket, uint16_t fingerprint) {
+	uint16_t *slots = m_slots.data() + bucket * BUCKET_SIZE;
+	for (size_t i = 0; i != BUCKET_SIZE; ++i)
+		if (slots[i] == fingerprint) {
+			slots[i] = 0;
+			return true;
+		}
+	return false;
+}
+
+bool KeyImageFilter::bucket_contains(size_t bucket, uint16_t fingerprint) const {
+	const uint16_t *slots = m_slots.data() + bucket * BUCKET_SIZE;
+	for (size_t i = 0; i != BUCKET_SIZE; ++i)
+		if (slots[i] == fingerprint)
+			return true;
+	return false;
+}
+
+bool KeyImageFilter::insert(const KeyImage &key_image) {
+	size_t bucket        = 0;
+	uint16_t fingerprint = 0;
+	get_position(key_image, &bucket, &fingerprint);
+	m_count += 1;
+	if (insert_to_bucket(bucket, fingerprint))
+		return true;
+	bucket = alt_bucket(bucket, fingerprint);
+	for (size_t kick = 0; kick != MAX_KICKS; ++kick) {
+		if (insert_to_bucket(bucket, fingerprint))
+			return true;
+		// Evict pseudo-random victim and move it to its alternative bucket
+		uint16_t &victim = m_slots.at(bucket * BUCKET_SIZE + (mix64(m_salt + kick + bucket) % BUCKET_SIZE));
+		std::swap(victim, fingerprint);
+		bucket = alt_bucket(bucket, fingerprint);
+	}
+	return false;  // fingerprint was lost, so filter cannot be used any more
+}
+
+void KeyImageFilter::erase(const KeyImage &key_image) {
+	size_t bucket        = 0;
+	uint16_t fingerprint = 0;
+	get_position(key_image, &bucket, &fingerprint);
+	const bool erased =
+	    erase_from_bucket(bucket, fingerprint) || erase_from_bucket(alt_bucket(bucket, fingerprint), fingerprint);
+	invariant(erased, "Key image not in filter");
+	m_count -= 1;
+}
+
+bool KeyImageFilter::may_contain(const KeyImage &key_image) const {
+	size_t bucket        = 0;
+	uint16_t fingerprint = 0;
+	get_position(key_image, &bucket, &fingerprint);
+	return bucket_contains(bucket, fingerprint) || bucket_contains(alt_bucket(bucket, fingerprint), fingerprint);
+}
+
+BinaryArray KeyImageFilter::save(const Hash &tip_bid) const {
+	BinaryArray result;
+	result.reserve(4 + sizeof(tip_bid.data) + 3 * 8 + m_slots.size() * 2);
+	common::append(result, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 4);
+	common::append(result, std::begin(tip_bid.data), std::end(tip_bid.data));
+	append_uint64(result, m_salt);
+	append_uint64(result, m_count);
+	append_uint64(result, m_slots.size());
+	for (auto s : m_slots) {
+		result.push_back(static_cast<uint8_t>(s));
+		result.push_back(static_cast<uint8_t>(s >> 8));
+	}
+	return result;
+}
+
+bool KeyImageFilter::load(const BinaryArray &data, Hash *tip_bid) {
+	const size_t header_size = 4 + sizeof(tip_bid->data) + 3 * 8;
+	if (data.size() < header_size || memcmp(data.data(), SNAPSHOT_MAGIC, 4) != 0)
+		return false;
+	const uint8_t *header  = data.data() + 4 + sizeof(tip_bid->data);
+	const uint64_t salt    = read_uint64(header);
+	const uint64_t count   = read_uint64(header + 8);
+	const uint64_t slots   = read_uint64(header + 16);
+	const uint64_t buckets = slots / BUCKET_SIZE;
+	if (buckets == 0 || slots % BUCKET_SIZE != 0 || (buckets & (buckets - 1)) != 0 || count > slots ||
+	    data.size() != header_size + slots * 2)
+		return false;
+	m_slots.resize(static_cast<size_t>(slots));
+	const uint8_t *body = data.data() + header_size;
+	for (size_t i = 0; i != m_slots.size(); ++i)
+		m_slots[i] = static_cast<uint16_t>(body[2 * i] | (body[2 * i + 1] << 8));
+	m_bucket_mask = m_slots.size() / BUCKET_SIZE - 1;
+	m_count       = static_cast<size_t>(count);
+	m_salt        = salt;
+	memcpy(tip_bid->data, data.data() + 4, sizeof(tip_bid->data));
+	return true;
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <vector>
+#include "CryptoNote.hpp"
+
+namespace cn {
+
+// Approximate set of spent key images, so that common "not spent" answer does not touch DB.
+// Cuckoo filter with 4 x 16-bit fingerprints per bucket. Unlike Bloom filter it supports deletion,
+// which we need in undo_block. False positive rate is about 8 * load / 65536, positives must be
+// confirmed by DB lookup. Key images are chosen by their owners, so we hash them with random salt.
+class KeyImageFilter {
+public:
+	explicit KeyImageFilter(size_t expected_count = 0);
+
+	bool insert(const KeyImage &);  // false if filter is full and must be rebuilt with larger capacity
+	void erase(const KeyImage &);   // key image must have been inserted before
+	bool may_contain(const KeyImage &) const;
+
+	size_t size() const { return m_count; }
+	size_t capacity() const { return m_slots.size(); }
+	size_t memory_usage() const { return m_slots.capacity() * sizeof(uint16_t); }
+
+	// Snapshot is valid only for the state of blockchain it was saved at, we store tip so that caller can add
+	// key images of blocks applied after it
+	BinaryArray save(const Hash &tip_bid) const;
+	bool load(const BinaryArray &data, Hash *tip_bid);  // false on corruption
+
+private:
+	static constexpr size_t BUCKET_SIZE = 4;
+	static constexpr size_t MAX_KICKS   = 500;
+
+	std::vector<uint16_t> m_slots;  // 0 means empty
+	size_t m_bucket_mask = 0;
+	size_t m_count       = 0;
+	uint64_t m_salt      = 0;
+
+	void get_position(const KeyImage &, size_t *bucket, uint16_t *fingerprint) const;
+	size_t alt_bucket(size_t bucket, uint16_t fingerprint) const;
+	bool insert_to_bucket(size_t bucket, uint16_t fingerprint);
+	bool erase_from_bucket(size_t bucket, uint16_t fingerprint);
+	bool bucket_contains(size_t bucket, uint16_t fingerprint) const;
+};
+
+}  // namespace cn
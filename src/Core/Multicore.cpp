@@ -2,28 +2,37 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for details.
 
 #include "Multicore.hpp"
+#include <algorithm>
 #include "BlockChainState.hpp"
 #include "Config.hpp"
 #include "CryptoNoteTools.hpp"
 #include "Currency.hpp"
 #include "TransactionExtra.hpp"
 #include "crypto/crypto.hpp"
+#include "crypto/hash.hpp"
 #include "platform/Network.hpp"
 
 using namespace cn;
 
-BlockPreparatorMulticore::BlockPreparatorMulticore(const Currency &currency, platform::EventLoop *main_loop)
-    : currency(currency), main_loop(main_loop) {
-	auto th_count = std::max<size_t>(2, 3 * std::thread::hardware_concurrency() / 4);
+BlockPreparatorMulticore::BlockPreparatorMulticore(const Currency &currency, platform::EventLoop *main_loop,
+    size_t max_queue_size, size_t max_prepared_memory, std::chrono::seconds prepared_block_timeout, size_t hash_ways)
+    : currency(currency)
+    , max_queue_size(std::max<size_t>(1, max_queue_size))
+    , max_prepared_memory(max_prepared_memory)
+    , prepared_block_timeout(prepared_block_timeout)
+    , hash_ways(std::min<size_t>(SLOW_HASH_MAX_WAYS, std::max<size_t>(1, hash_ways)))
+    , thread_count(std::max<size_t>(2, 3 * std::thread::hardware_concurrency() / 4))
+    , main_loop(main_loop)
+    , work_ring(this->max_queue_size) {
 	// we use more energy but have the same speed when using hyperthreading
-	//	std::cout << "Starting multicore ring checker using " << th_count << "/" << std::thread::hardware_concurrency()
-	//	          << " cpus" << std::endl;
-	for (size_t i = 0; i != th_count; ++i)
+	//	std::cout << "Starting multicore block preparator using " << thread_count << "/"
+	//	          << std::thread::hardware_concurrency() << " cpus" << std::endl;
+	for (size_t i = 0; i != thread_count; ++i)
 		threads.emplace_back(&BlockPreparatorMulticore::thread_run, this);
 }
 BlockPreparatorMulticore::~BlockPreparatorMulticore() {
 	{
-		std::unique_lock<std::mutex> lock(mu);
+		std::unique_lock<std::mutex> lock(work_mu);
 		quit = true;
 		have_work.notify_all();
 	}
@@ -31,50 +40,200 @@ BlockPreparatorMulticore::~BlockPreparatorMulticore() {
 		th.join();
 }
 void BlockPreparatorMulticore::thread_run() {
-	crypto::CryptoNightContext ctx;
+	crypto::CryptoNightContext ctx(hash_ways);
+	std::vector<WorkItem> batch;
 	while (true) {
-		std::tuple<Hash, bool, RawBlock> local_work;
+		batch.clear();
 		{
-			std::unique_lock<std::mutex> lock(mu);
+			std::unique_lock<std::mutex> lock(work_mu);
 			if (quit)
 				return;
-			if (work.empty()) {
+			if (work_count == 0) {
 				have_work.wait(lock);
 				continue;
 			}
-			local_work = std::move(work.front());
-			work.pop_front();
+			// We interleave several PoW hashes only when there is enough work for all threads
+			const size_t batch_size = std::min(hash_ways, std::max<size_t>(1, work_count / thread_count));
+			for (size_t i = 0; i != batch_size; ++i) {
+				batch.push_back(std::move(work_ring.at(work_head)));
+				work_head = (work_head + 1) % work_ring.size();
+				work_count -= 1;
+			}
 		}
-		PreparedBlock pb(std::move(std::get<2>(local_work)), currency, std::get<1>(local_work) ? &ctx : nullptr);
+		std::vector<PreparedBlock> pbs;
+		std::vector<BinaryArray> hashing_data;
+		std::vector<size_t> hashing_indices;
+		for (auto &&item : batch) {
+			pbs.emplace_back(std::move(item.rb), currency, nullptr);
+			const PreparedBlock &pb = pbs.back();
+			if (item.check_pow && !pb.error) {
+				auto body_proxy = get_body_proxy_from_template(pb.block.header);
+				hashing_data.push_back(currency.get_block_long_hashing_data(pb.block.header, body_proxy));
+				hashing_indices.push_back(pbs.size() - 1);
+			}
+		}
+		if (!hashing_data.empty()) {
+			const void *data[SLOW_HASH_MAX_WAYS]{};
+			size_t lengths[SLOW_HASH_MAX_WAYS]{};
+			Hash hashes[SLOW_HASH_MAX_WAYS];
+			for (size_t i = 0; i != hashing_data.size(); ++i) {
+				data[i]    = hashing_data.at(i).data();
+				lengths[i] = hashing_data.at(i).size();
+			}
+			if (hashing_data.size() == 1)
+				hashes[0] = ctx.cn_slow_hash(data[0], lengths[0]);
+			else
+				ctx.cn_slow_hash_multi(data, lengths, hashes, hashing_data.size());
+			for (size_t i = 0; i != hashing_indices.size(); ++i)
+				pbs.at(hashing_indices.at(i)).long_block_hash = hashes[i];
+		}
+		const auto now = std::chrono::steady_clock::now();
 		{
-			std::unique_lock<std::mutex> lock(mu);
-			prepared_blocks[std::get<0>(local_work)] = std::move(pb);
-			main_loop->wake();  // so we start processing on_idle
-			                    //			prepared_blocks_ready.notify_all();
+			std::unique_lock<std::mutex> lock(result_mu);
+			for (size_t i = 0; i != batch.size(); ++i)
+				add_result(batch.at(i), std::move(pbs.at(i)), now);
+			evict_results(now);
 		}
+		{
+			// Only after result is visible, so has_block never misses block
+			std::unique_lock<std::mutex> lock(work_mu);
+			for (const auto &item : batch)
+				pending.erase(item.bid);
+		}
+		if (!wake_pending.exchange(true))
+			main_loop->wake();  // so we start processing on_idle
 	}
 }
 
-void BlockPreparatorMulticore::add_block(Hash bid, bool check_pow, RawBlock &&rb) {
-	std::unique_lock<std::mutex> lock(mu);
-	work.push_back(std::make_tuple(bid, check_pow, std::move(rb)));
-	have_work.notify_all();
+void BlockPreparatorMulticore::add_result(const WorkItem &item, PreparedBlock &&pb, TimePoint now) {
+	auto rit = result_index.find(item.bid);
+	if (rit != result_index.end())  // Same block downloaded twice
+		remove_result(rit);
+	size_t slot = result_slab.size();
+	if (free_results.empty())
+		result_slab.emplace_back();
+	else {
+		slot = free_results.back();
+		free_results.pop_back();
+	}
+	Result &result  = result_slab.at(slot);
+	result.pb       = std::move(pb);
+	result.size     = item.size;
+	result.finished = now;
+	result.lru_pos  = result_lru.insert(result_lru.end(), slot);
+	result_index.emplace(item.bid, slot);
+	result_memory += result.size;
+	const auto latency_us =
+	    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - item.added).count());
+	prepared_counter += 1;
+	total_latency_us += latency_us;
+	max_latency_us = std::max(max_latency_us, latency_us);
+}
+
+void BlockPreparatorMulticore::remove_result(std::unordered_map<Hash, size_t>::iterator rit) {
+	Result &result = result_slab.at(rit->second);
+	result_memory -= result.size;
+	result_lru.erase(result.lru_pos);
+	result.pb = PreparedBlock{};  // free memory now
+	free_results.push_back(rit->second);
+	result_index.erase(rit);
+}
+
+void BlockPreparatorMulticore::evict_results(TimePoint now) {
+	auto evict = [&](size_t slot) {
+		const Hash bid = result_slab.at(slot).pb.bid;
+		evicted.push_back(bid);
+		evicted_counter += 1;
+		remove_result(result_index.find(bid));
+	};
+	while (!result_lru.empty() && now - result_slab.at(result_lru.front()).finished >= prepared_block_timeout)
+		evict(result_lru.front());
+	// Blocks are downloaded in chain order, so oldest results are next to be applied. Over memory budget we drop
+	// newest ones, they are furthest from tip
+	while (!result_lru.empty() && result_memory > max_prepared_memory)
+		evict(result_lru.back());
+}
+
+bool BlockPreparatorMulticore::add_block(Hash bid, bool check_pow, RawBlock &&rb) {
+	size_t size = rb.block.size();
+	for (const auto &tx : rb.transactions)
+		size += tx.size();
+	std::unique_lock<std::mutex> lock(work_mu);
+	if (work_count == work_ring.size()) {
+		rejected_counter += 1;
+		return false;
+	}
+	WorkItem &item = work_ring.at((work_head + work_count) % work_ring.size());
+	item.bid       = bid;
+	item.check_pow = check_pow;
+	item.rb        = std::move(rb);
+	item.size      = 3 * size;  // raw block is stored twice in PreparedBlock, plus parsed block
+	item.added     = std::chrono::steady_clock::now();
+	work_count += 1;
+	max_queue_depth = std::max(max_queue_depth, work_count);
+	pending.insert(bid);
+	have_work.notify_one();
+	return true;
+}
+
+bool BlockPreparatorMulticore::is_saturated() const {
+	std::unique_lock<std::mutex> lock(work_mu);
+	return work_count >= work_ring.size() / 2;
 }
 
 bool BlockPreparatorMulticore::get_prepared_block(Hash bid, PreparedBlock *pb) {
-	std::unique_lock<std::mutex> lock(mu);
-	auto pid = prepared_blocks.find(bid);
-	if (pid == prepared_blocks.end())
+	wake_pending = false;
+	std::unique_lock<std::mutex> lock(result_mu);
+	auto rit = result_index.find(bid);
+	if (rit == result_index.end())
 		return false;
-	*pb = std::move(pid->second);
-	pid = prepared_blocks.erase(pid);
+	*pb = std::move(result_slab.at(rit->second).pb);
+	remove_result(rit);
 	return true;
 }
 
 bool BlockPreparatorMulticore::has_prepared_block(Hash bid) const {
-	std::unique_lock<std::mutex> lock(mu);
-	auto pid = prepared_blocks.find(bid);
-	return pid != prepared_blocks.end();
+	std::unique_lock<std::mutex> lock(result_mu);
+	return result_index.count(bid) != 0;
+}
+
+bool BlockPreparatorMulticore::has_block(Hash bid) const {
+	{
+		std::unique_lock<std::mutex> lock(work_mu);
+		if (pending.count(bid) != 0)
+			return true;
+	}
+	return has_prepared_block(bid);
+}
+
+bool BlockPreparatorMulticore::peek_prepared_block(Hash bid, Block *block) const {
+	std::unique_lock<std::mutex> lock(result_mu);
+	auto rit = result_index.find(bid);
+	if (rit == result_index.end() || result_slab.at(rit->second).pb.error)
+		return false;
+	*block = result_slab.at(rit->second).pb.block;
+	return true;
+}
+
+std::vector<Hash> BlockPreparatorMulticore::take_evicted() {
+	std::unique_lock<std::mutex> lock(result_mu);
+	evict_results(std::chrono::steady_clock::now());
+	return std::move(evicted);
+}
+
+void BlockPreparatorMulticore::fill_statistics(api::cnd::GetStatistics::Response &res) const {
+	{
+		std::unique_lock<std::mutex> lock(work_mu);
+		res.block_preparator_queue_depth     = work_count;
+		res.block_preparator_max_queue_depth = max_queue_depth;
+		res.block_preparator_rejected_count  = rejected_counter;
+	}
+	std::unique_lock<std::mutex> lock(result_mu);
+	res.block_preparator_prepared_count     = result_index.size();
+	res.block_preparator_prepared_memory    = result_memory;
+	res.block_preparator_evicted_count      = evicted_counter;
+	res.block_preparator_average_latency_us = prepared_counter == 0 ? 0 : total_latency_us / prepared_counter;
+	res.block_preparator_max_latency_us     = max_latency_us;
 }
 
 RingCheckerMulticore::RingCheckerMulticore() {
@@ -98,96 +257,170 @@ RingCheckerMulticore::~RingCheckerMulticore() {
 
 void RingCheckerMulticore::thread_run() {
 	while (true) {
-		RingSignatureArg arg;
-		RingSignatureArg3 arg3;
-		Height newest_referenced_height = 0;
-		int local_work_counter          = 0;
+		WorkItem item;
 		{
 			std::unique_lock<std::mutex> lock(mu);
 			if (quit)
 				return;
-			if (args.empty() && args3.empty()) {
+			if (work.empty() && speculative_work.empty()) {
 				have_work.wait(lock);
 				continue;
 			}
-			local_work_counter = work_counter;
-			if (!args.empty()) {
-				arg                      = std::move(args.front());
-				newest_referenced_height = arg.newest_referenced_height;
-				args.pop_front();
-			} else {
-				arg3                     = std::move(args3.front());
-				newest_referenced_height = arg3.newest_referenced_height;
-				args3.pop_front();
-			}
+			auto &queue = work.empty() ? speculative_work : work;
+			item        = std::move(queue.front());
+			queue.pop_front();
+			if (item.job->cancelled)
+				continue;
 		}
-		bool result = false;
-		if (!arg.output_keys.empty()) {
-			result = crypto::check_ring_signature(arg.tx_prefix_hash, arg.key_image, arg.output_keys.data(),
-			    arg.output_keys.size(), arg.input_signature, arg.key_image_subgroup_check);
+		bool result                     = false;
+		Height newest_referenced_height = item.arg3.newest_referenced_height;
+		if (!item.args.empty()) {
+			std::vector<crypto::RingSignatureCheck> checks(item.args.size());
+			for (size_t i = 0; i != item.args.size(); ++i) {
+				const auto &arg                    = item.args[i];
+				checks[i].prefix_hash              = arg.tx_prefix_hash;
+				checks[i].image                    = arg.key_image;
+				checks[i].pubs                     = arg.output_keys.data();
+				checks[i].pubs_count               = arg.output_keys.size();
+				checks[i].sig                      = &arg.input_signature;
+				checks[i].key_image_subgroup_check = arg.key_image_subgroup_check;
+			}
+			std::vector<bool> results;
+			result = crypto::check_ring_signatures_batch(checks.data(), checks.size(), &results);
+			if (!result)  // We report first bad ring, like sequential checker would
+				newest_referenced_height =
+				    item.args.at(std::find(results.begin(), results.end(), false) - results.begin())
+				        .newest_referenced_height;
 		} else {
 			result = crypto::check_ring_signature3(
-			    arg3.tx_prefix_hash, arg3.key_images, arg3.output_keys, arg3.input_signature);
+			    item.arg3.tx_prefix_hash, item.arg3.key_images, item.arg3.output_keys, item.arg3.input_signature);
 		}
 		{
 			std::unique_lock<std::mutex> lock(mu);
-			if (local_work_counter == work_counter) {
-				ready_counter += 1;
+			auto &slots = item.job->slots;
+			if (item.slot_index < slots.size() && slots[item.slot_index].generation == item.generation &&
+			    !slots[item.slot_index].ready) {
+				slots[item.slot_index].ready  = true;
+				slots[item.slot_index].result = result;
 				if (!result)
-					errors.push_back(ConsensusErrorBadOutputOrSignature{
-					    "Bad signature or output reference changed", newest_referenced_height});
-				result_ready.notify_all();
+					slots[item.slot_index].newest_referenced_height = newest_referenced_height;
+				item.job->ready_counter += 1;
+				if (item.job == current_job)
+					result_ready.notify_all();
 			}
 		}
 	}
 }
+
 void RingCheckerMulticore::cancel_work() {
 	std::unique_lock<std::mutex> lock(mu);
-	args.clear();
-	args3.clear();
-	work_counter += 1;
+	if (current_job)
+		current_job->cancelled = true;
+	current_job = nullptr;
+	work.clear();
 }
 
-void RingCheckerMulticore::start_work(IBlockChainState *state, const Currency &currency, const Block &block,
-    Height unlock_height, Timestamp block_timestamp, Timestamp block_median_timestamp, bool key_image_subgroup_check) {
-	{
-		std::unique_lock<std::mutex> lock(mu);
-		args.clear();
-		args3.clear();
-		errors.clear();
-		ready_counter = 0;
-		work_counter += 1;
+void RingCheckerMulticore::cancel_speculative_work() {
+	std::unique_lock<std::mutex> lock(mu);
+	for (auto &&sj : speculative_jobs)
+		sj.second->cancelled = true;
+	speculative_jobs.clear();
+	speculative_order.clear();
+	speculative_work.clear();
+}
+
+bool RingCheckerMulticore::has_speculative_work(const Hash &bid) const {
+	std::unique_lock<std::mutex> lock(mu);
+	return speculative_jobs.count(bid) != 0;
+}
+
+static void append_ring(BinaryArray *fingerprint_data, const KeyImage &key_image,
+    const std::vector<PublicKey> &output_keys) {
+	common::append(*fingerprint_data, std::begin(key_image.data), std::end(key_image.data));
+	common::append(*fingerprint_data, 1, static_cast<uint8_t>(output_keys.size()));
+	for (const auto &key : output_keys)
+		common::append(*fingerprint_data, std::begin(key.data), std::end(key.data));
+}
+
+void RingCheckerMulticore::submit(const std::shared_ptr<Job> &job, size_t slot_index, const Hash &fingerprint,
+    Height newest_referenced_height, std::vector<RingSignatureArg> &&args, RingSignatureArg3 &&arg3,
+    bool speculative) {
+	std::unique_lock<std::mutex> lock(mu);
+	if (job->slots.size() <= slot_index)
+		job->slots.resize(slot_index + 1);
+	auto &slot = job->slots[slot_index];
+	if (!speculative && slot.submitted) {
+		if (slot.fingerprint == fingerprint) {
+			speculative_reused_counter += 1;
+			return;
+		}
+		speculative_rechecked_counter += 1;
 	}
-	total_counter = 0;
+	if (slot.ready)
+		job->ready_counter -= 1;
+	slot.fingerprint              = fingerprint;
+	slot.newest_referenced_height = newest_referenced_height;
+	slot.generation               = ++next_generation;
+	slot.submitted                = true;
+	slot.ready                    = false;
+	WorkItem item{job, slot_index, slot.generation, std::move(args), std::move(arg3)};
+	(speculative ? speculative_work : work).push_back(std::move(item));
+	have_work.notify_all();
+}
+
+void RingCheckerMulticore::prepare_args(const std::shared_ptr<Job> &job, IBlockChainState *state,
+    const Currency &currency, const Block &block, Height unlock_height, Timestamp block_timestamp,
+    Timestamp block_median_timestamp, bool key_image_subgroup_check, bool speculative) {
+	// In speculative mode we cannot throw, outputs created by blocks not yet applied are not found,
+	// so corresponding slots are left unsubmitted and will be submitted by non-speculative pass
+	size_t slot_index = 0;
 	for (auto &&transaction : block.transactions) {
 		Hash tx_prefix_hash = get_transaction_prefix_hash(transaction);
+		// Fingerprint does not include signatures, because jobs are matched by block hash which commits to them
+		BinaryArray fingerprint_data;
+		common::append(fingerprint_data, std::begin(tx_prefix_hash.data), std::end(tx_prefix_hash.data));
+		common::append(fingerprint_data, 1, key_image_subgroup_check ? 1 : 0);
+		std::vector<RingSignatureArg> args;
 		RingSignatureArg3 arg3;
+		bool tx_readable = true;
 		for (size_t input_index = 0; input_index != transaction.inputs.size(); ++input_index) {
 			const auto &input               = transaction.inputs.at(input_index);
 			Height newest_referenced_height = 0;
 			if (input.type() == typeid(InputKey)) {
 				const InputKey &in = boost::get<InputKey>(input);
 				Height height      = 0;
-				if (state->read_keyimage(in.key_image, &height))
+				if (!speculative && state->read_keyimage(in.key_image, &height))
 					throw ConsensusErrorOutputSpent("Output already spent", in.key_image, height);
+				bool readable = true;
 				std::vector<size_t> global_indexes;
-				if (!relative_output_offsets_to_absolute(&global_indexes, in.output_indexes))
-					throw ConsensusError("Output indexes invalid in input");
+				if (!relative_output_offsets_to_absolute(&global_indexes, in.output_indexes)) {
+					if (!speculative)
+						throw ConsensusError("Output indexes invalid in input");
+					readable = false;
+				}
 				std::vector<PublicKey> output_keys(global_indexes.size());
-				for (size_t i = 0; i != global_indexes.size(); ++i) {
+				for (size_t i = 0; readable && i != global_indexes.size(); ++i) {
 					IBlockChainState::UnlockTimePublickKeyHeightSpent unp;
-					if (!state->read_amount_output(in.amount, global_indexes[i], &unp))
-						throw ConsensusErrorOutputDoesNotExist("Output does not exist", input_index, global_indexes[i]);
-					if (unp.auditable && global_indexes.size() != 1)
-						throw ConsensusErrorBadOutputOrSignature("Auditable output mixed", unp.height);
-					if (!currency.is_transaction_unlocked(block.header.major_version, unp.unlock_block_or_timestamp,
-					        unlock_height, block_timestamp, block_median_timestamp))
-						throw ConsensusErrorBadOutputOrSignature("Output locked", unp.height);
+					if (!state->read_amount_output(in.amount, global_indexes[i], &unp)) {
+						if (!speculative)
+							throw ConsensusErrorOutputDoesNotExist(
+							    "Output does not exist", input_index, global_indexes[i]);
+						readable = false;
+						break;
+					}
+					if (!speculative) {
+						if (unp.auditable && global_indexes.size() != 1)
+							throw ConsensusErrorBadOutputOrSignature("Auditable output mixed", unp.height);
+						if (!currency.is_transaction_unlocked(block.header.major_version,
+						        unp.unlock_block_or_timestamp, unlock_height, block_timestamp,
+						        block_median_timestamp))
+							throw ConsensusErrorBadOutputOrSignature("Output locked", unp.height);
+					}
 					output_keys[i]           = unp.public_key;
 					newest_referenced_height = std::max(newest_referenced_height, unp.height);
 				}
-				// As soon as first arg is ready, other thread can start work while we
-				// continue reading from slow DB
+				tx_readable = tx_readable && readable;
+				append_ring(&fingerprint_data, in.key_image, output_keys);
 				if (transaction.signatures.type() == typeid(RingSignatures)) {
 					auto &signatures = boost::get<RingSignatures>(transaction.signatures);
 					RingSignatureArg arg;
@@ -196,11 +429,13 @@ void RingCheckerMulticore::start_work(IBlockChainState *state, const Currency &c
 					arg.newest_referenced_height = newest_referenced_height;
 					arg.key_image                = in.key_image;
 					arg.output_keys              = std::move(output_keys);
-					arg.input_signature          = signatures.signatures.at(input_index);
-					total_counter += 1;
-					std::unique_lock<std::mutex> lock(mu);
+					if (input_index < signatures.signatures.size())
+						arg.input_signature = signatures.signatures.at(input_index);
+					else if (!speculative)
+						throw std::out_of_range("Signature index out of range");
+					else
+						tx_readable = false;
 					args.push_back(std::move(arg));
-					have_work.notify_all();
 				} else if (transaction.signatures.type() == typeid(RingSignature3)) {
 					auto &signatures = boost::get<RingSignature3>(transaction.signatures);
 					arg3.output_keys.push_back(std::move(output_keys));
@@ -208,31 +443,103 @@ void RingCheckerMulticore::start_work(IBlockChainState *state, const Currency &c
 					arg3.key_images.push_back(in.key_image);
 					if (arg3.input_signature.r.empty())
 						arg3.input_signature = signatures;
-				} else
+				} else if (!speculative)
 					throw ConsensusError("Unknown signatures type");
 			}
 		}
-		if (!arg3.output_keys.empty()) {
+		if (args.empty() && arg3.output_keys.empty())
+			continue;
+		// Whole transaction is checked by one worker, rings of RingSignatures in one batch
+		if (tx_readable) {
+			Height newest_referenced_height = arg3.newest_referenced_height;
+			for (const auto &arg : args)
+				newest_referenced_height = std::max(newest_referenced_height, arg.newest_referenced_height);
 			arg3.tx_prefix_hash = tx_prefix_hash;
-			total_counter += 1;
-			std::unique_lock<std::mutex> lock(mu);
-			args3.push_back(std::move(arg3));
-			have_work.notify_all();
+			Hash fingerprint    = crypto::cn_fast_hash(fingerprint_data.data(), fingerprint_data.size());
+			submit(job, slot_index, fingerprint, newest_referenced_height, std::move(args), std::move(arg3),
+			    speculative);
 		}
+		slot_index += 1;
 	}
+	if (speculative)
+		return;
+	std::unique_lock<std::mutex> lock(mu);
+	// Speculative pass might have seen different (invalid) block layout, we remove extra slots
+	for (size_t i = slot_index; i < job->slots.size(); ++i)
+		if (job->slots[i].ready)
+			job->ready_counter -= 1;
+	if (job->slots.size() > slot_index)
+		job->slots.resize(slot_index);
 }
 
-std::vector<ConsensusErrorBadOutputOrSignature> RingCheckerMulticore::move_errors() {
-	while (true) {
+void RingCheckerMulticore::start_work(IBlockChainState *state, const Currency &currency, const Hash &bid,
+    const Block &block, Height unlock_height, Timestamp block_timestamp, Timestamp block_median_timestamp,
+    bool key_image_subgroup_check) {
+	std::shared_ptr<Job> job;
+	{
 		std::unique_lock<std::mutex> lock(mu);
-		if (ready_counter != total_counter) {
-			result_ready.wait(lock);
-			continue;
+		if (current_job)
+			current_job->cancelled = true;
+		work.clear();
+		auto sit = speculative_jobs.find(bid);
+		if (sit != speculative_jobs.end()) {
+			job = std::move(sit->second);
+			speculative_jobs.erase(sit);
+			speculative_order.erase(std::find(speculative_order.begin(), speculative_order.end(), bid));
+			// Pending speculative items of this job now have priority
+			for (auto wit = speculative_work.begin(); wit != speculative_work.end();)
+				if (wit->job == job) {
+					work.push_back(std::move(*wit));
+					wit = speculative_work.erase(wit);
+				} else
+					++wit;
+		} else
+			job = std::make_shared<Job>();
+		current_job = job;
+	}
+	prepare_args(job, state, currency, block, unlock_height, block_timestamp, block_median_timestamp,
+	    key_image_subgroup_check, false);
+}
+
+void RingCheckerMulticore::start_speculative_work(IBlockChainState *state, const Currency &currency, const Hash &bid,
+    const Block &block, bool key_image_subgroup_check, size_t max_speculative_blocks) {
+	auto job = std::make_shared<Job>();
+	{
+		std::unique_lock<std::mutex> lock(mu);
+		if (max_speculative_blocks == 0 || speculative_jobs.count(bid) != 0)
+			return;
+		while (speculative_order.size() > max_speculative_blocks) {  // +1 for block about to be applied
+			auto sit = speculative_jobs.find(speculative_order.front());
+			sit->second->cancelled = true;
+			speculative_jobs.erase(sit);
+			speculative_order.pop_front();
 		}
-		return std::move(errors);
+		speculative_jobs.emplace(bid, job);
+		speculative_order.push_back(bid);
+	}
+	try {
+		prepare_args(job, state, currency, block, 0, 0, 0, key_image_subgroup_check, true);
+	} catch (const std::exception &) {
+		// Malformed block, will be rejected when applied. Leave job as is, unsubmitted slots will be checked then
 	}
 }
 
+std::vector<ConsensusErrorBadOutputOrSignature> RingCheckerMulticore::move_errors() {
+	std::vector<ConsensusErrorBadOutputOrSignature> errors;
+	std::unique_lock<std::mutex> lock(mu);
+	auto job = current_job;
+	if (!job)
+		return errors;
+	while (job->ready_counter != job->slots.size())
+		result_ready.wait(lock);
+	for (const auto &slot : job->slots)
+		if (!slot.result)
+			errors.push_back(ConsensusErrorBadOutputOrSignature{
+			    "Bad signature or output reference changed", slot.newest_referenced_height});
+	current_job = nullptr;
+	return errors;
+}
+
 WalletPreparatorMulticore::WalletPreparatorMulticore() {
 	auto th_count = std::max<size_t>(2, 3 * std::thread::hardware_concurrency() / 4);
 	// we use more energy but have the same speed when using hyperthreading to max
@@ -252,44 +559,46 @@ WalletPreparatorMulticore::~WalletPreparatorMulticore() {
 		th.join();
 }
 
-PreparedWalletTransaction::PreparedWalletTransaction(TransactionPrefix &&ttx, const Wallet::OutputHandler &o_handler)
-    : tx(std::move(ttx)) {
+PreparedWalletTransaction::PreparedWalletTransaction(TransactionPrefix &&ttx) : tx(std::move(ttx)) {
 	// We ignore results of most crypto calls here and absence of tx_public_key
 	// All errors will lead to spend_key not found in our wallet
-	PublicKey tx_public_key = extra_get_transaction_public_key(tx.extra);
-	prefix_hash             = get_transaction_prefix_hash(tx);
-	inputs_hash             = get_transaction_inputs_hash(tx);
-
-	KeyPair tx_keys;
+	tx_public_key = extra_get_transaction_public_key(tx.extra);
+	prefix_hash   = get_transaction_prefix_hash(tx);
+	inputs_hash   = get_transaction_inputs_hash(tx);
 	spend_keys.resize(tx.outputs.size());
 	output_secret_scalars.resize(tx.outputs.size());
-	for (size_t out_index = 0; out_index != tx.outputs.size(); ++out_index) {
-		const auto &output = tx.outputs.at(out_index);
-		if (output.type() != typeid(OutputKey))
-			continue;
-		const auto &key_output = boost::get<OutputKey>(output);
-		o_handler(tx_public_key, &derivation, inputs_hash, out_index, key_output, &spend_keys.at(out_index),
-		    &output_secret_scalars.at(out_index));
-	}
 }
 
-PreparedWalletTransaction::PreparedWalletTransaction(Transaction &&tx, const Wallet::OutputHandler &o_handler)
+PreparedWalletTransaction::PreparedWalletTransaction(
+    TransactionPrefix &&ttx, const Wallet::BlockOutputHandler &o_handler)
+    : PreparedWalletTransaction(std::move(ttx)) {
+	PreparedWalletTransaction *self = this;
+	o_handler(&self, 1);
+}
+
+PreparedWalletTransaction::PreparedWalletTransaction(Transaction &&tx, const Wallet::BlockOutputHandler &o_handler)
     : PreparedWalletTransaction(std::move(static_cast<TransactionPrefix &&>(tx)), o_handler) {}
 
 PreparedWalletBlock::PreparedWalletBlock(BlockTemplate &&bc_header, std::vector<TransactionPrefix> &&raw_transactions,
-    Hash base_transaction_hash, const Wallet::OutputHandler &o_handler)
+    Hash base_transaction_hash, const Wallet::BlockOutputHandler &o_handler)
     : base_transaction_hash(base_transaction_hash) {
 	header           = bc_header;
-	base_transaction = PreparedWalletTransaction(std::move(bc_header.base_transaction), o_handler);
+	base_transaction = PreparedWalletTransaction(std::move(bc_header.base_transaction));
 	transactions.reserve(raw_transactions.size());
-	for (size_t tx_index = 0; tx_index != raw_transactions.size(); ++tx_index) {
-		transactions.emplace_back(std::move(raw_transactions.at(tx_index)), o_handler);
-	}
+	for (size_t tx_index = 0; tx_index != raw_transactions.size(); ++tx_index)
+		transactions.emplace_back(std::move(raw_transactions.at(tx_index)));
+	// Whole block goes to output handler at once, so crypto is batched over all its outputs
+	std::vector<PreparedWalletTransaction *> all_transactions;
+	all_transactions.reserve(transactions.size() + 1);
+	all_transactions.push_back(&base_transaction);
+	for (auto &&pwtx : transactions)
+		all_transactions.push_back(&pwtx);
+	o_handler(all_transactions.data(), all_transactions.size());
 }
 
 void WalletPreparatorMulticore::thread_run() {
 	while (true) {
-		Wallet::OutputHandler o_handler;
+		Wallet::BlockOutputHandler o_handler;
 		Height height          = 0;
 		int local_work_counter = 0;
 		api::RawBlock sync_block;
@@ -329,7 +638,7 @@ void WalletPreparatorMulticore::cancel_work() {
 }
 
 void WalletPreparatorMulticore::start_work(
-    const api::cnd::SyncBlocks::Response &new_work, Wallet::OutputHandler &&o_handler) {
+    const api::cnd::SyncBlocks::Response &new_work, Wallet::BlockOutputHandler &&o_handler) {
 	std::unique_lock<std::mutex> lock(mu);
 	work        = new_work;
 	m_o_handler = std::move(o_handler);
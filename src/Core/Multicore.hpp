@@ -3,10 +3,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include "BlockChain.hpp"  // for PreparedBlock
 #include "CryptoNote.hpp"
 #include "Wallet.hpp"  // for OutputHandler
@@ -24,27 +30,76 @@ class IBlockChainState;  // We will read keyimages and outputs from it
 class Currency;
 
 class BlockPreparatorMulticore {
+	// Work ring and prepared blocks have separate locks, so that workers finishing blocks
+	// do not contend with network thread adding them. Both are bounded - when work ring is full,
+	// block is rejected and must be downloaded again, prepared blocks that were never asked for
+	// (peer disconnected, chain switched) are evicted by age, newest ones are evicted when memory budget is exceeded.
+	typedef std::chrono::steady_clock::time_point TimePoint;
+	struct WorkItem {
+		Hash bid;
+		bool check_pow = false;
+		RawBlock rb;
+		size_t size = 0;
+		TimePoint added;
+	};
+	struct Result {
+		PreparedBlock pb;
+		size_t size = 0;  // Rough estimate of memory used by raw and parsed block
+		TimePoint finished;
+		std::list<size_t>::iterator lru_pos;
+	};
 	const Currency &currency;
+	const size_t max_queue_size;
+	const size_t max_prepared_memory;
+	const std::chrono::seconds prepared_block_timeout;
+	const size_t hash_ways;  // PoW hashes interleaved by each thread
+	const size_t thread_count;
 
 	std::vector<std::thread> threads;
-	mutable std::mutex mu;
+	mutable std::mutex work_mu;
 	std::condition_variable have_work;
 	platform::EventLoop *main_loop = nullptr;
-	//	std::condition_variable prepared_blocks_ready;
+	std::atomic<bool> wake_pending{false};  // We coalesce wakes until main thread asks for blocks
 	bool quit = false;
 
-	std::deque<std::tuple<Hash, bool, RawBlock>> work;
-	std::map<Hash, PreparedBlock> prepared_blocks;
+	std::vector<WorkItem> work_ring;
+	size_t work_head  = 0;
+	size_t work_count = 0;
+	std::unordered_set<Hash> pending;  // queued or being prepared
+
+	mutable std::mutex result_mu;
+	std::vector<Result> result_slab;
+	std::vector<size_t> free_results;
+	std::unordered_map<Hash, size_t> result_index;
+	std::list<size_t> result_lru;  // oldest first
+	size_t result_memory = 0;
+	std::vector<Hash> evicted;
+
+	size_t max_queue_depth    = 0;
+	size_t rejected_counter   = 0;
+	size_t evicted_counter    = 0;
+	size_t prepared_counter   = 0;
+	uint64_t total_latency_us = 0;
+	uint64_t max_latency_us   = 0;
 
 	void thread_run();
+	void add_result(const WorkItem &item, PreparedBlock &&pb, TimePoint now);  // called under result_mu
+	void remove_result(std::unordered_map<Hash, size_t>::iterator rit);
+	void evict_results(TimePoint now);  // called under result_mu
 
 public:
-	explicit BlockPreparatorMulticore(const Currency &currency, platform::EventLoop *main_loop);
+	explicit BlockPreparatorMulticore(const Currency &currency, platform::EventLoop *main_loop, size_t max_queue_size,
+	    size_t max_prepared_memory, std::chrono::seconds prepared_block_timeout, size_t hash_ways);
 	~BlockPreparatorMulticore();
 
-	void add_block(Hash bid, bool check_pow, RawBlock &&rb);
+	bool add_block(Hash bid, bool check_pow, RawBlock &&rb);  // false if queue is full
+	bool is_saturated() const;                                // download should wait
 	bool get_prepared_block(Hash bid, PreparedBlock *pb);
 	bool has_prepared_block(Hash bid) const;
+	bool has_block(Hash bid) const;  // queued, being prepared, or prepared
+	bool peek_prepared_block(Hash bid, Block *block) const;  // copy for speculative ring checks
+	std::vector<Hash> take_evicted();                      // also evicts blocks not asked for too long
+	void fill_statistics(api::cnd::GetStatistics::Response &res) const;
 };
 
 struct RingSignatureArg {
@@ -65,42 +120,86 @@ struct RingSignatureArg3 {
 };
 
 class RingCheckerMulticore {
+	// Work is grouped into jobs, one per block. Each transaction occupies a slot, slots are numbered
+	// in order of appearance in block, so speculative job for a block
+	// started before the block is applied can be reused slot by slot when the block is finally applied.
+	// Slot is reused only if fingerprint of (prefix hash, key images, output keys) matches exactly,
+	// so speculative results based on outdated state are never used.
+	struct Slot {
+		Hash fingerprint;
+		Height newest_referenced_height = 0;
+		size_t generation               = 0;
+		bool submitted                  = false;  // false if speculative pass could not read outputs
+		bool ready                      = false;
+		bool result                     = false;
+	};
+	struct Job {
+		std::vector<Slot> slots;
+		size_t ready_counter = 0;
+		bool cancelled       = false;
+	};
+	struct WorkItem {
+		std::shared_ptr<Job> job;
+		size_t slot_index = 0;
+		size_t generation = 0;
+		std::vector<RingSignatureArg> args;  // all rings of transaction with RingSignatures, checked as batch
+		RingSignatureArg3 arg3;
+	};
 	std::vector<std::thread> threads;
 	mutable std::mutex mu;
 	mutable std::condition_variable have_work;
 	mutable std::condition_variable result_ready;
 	bool quit = false;
 
-	size_t total_counter = 0;
-	size_t ready_counter = 0;
-	std::vector<ConsensusErrorBadOutputOrSignature> errors;
+	std::shared_ptr<Job> current_job;
+	std::deque<WorkItem> work;              // current job, always processed first
+	std::deque<WorkItem> speculative_work;  // blocks not yet applied
+	std::map<Hash, std::shared_ptr<Job>> speculative_jobs;
+	std::deque<Hash> speculative_order;  // oldest first, for eviction
+	size_t next_generation = 0;
+
+	size_t speculative_reused_counter    = 0;
+	size_t speculative_rechecked_counter = 0;
 
-	std::deque<RingSignatureArg> args;
-	std::deque<RingSignatureArg3> args3;
-	int work_counter = 0;
 	void thread_run();
+	void submit(const std::shared_ptr<Job> &job, size_t slot_index, const Hash &fingerprint,
+	    Height newest_referenced_height, std::vector<RingSignatureArg> &&args, RingSignatureArg3 &&arg3,
+	    bool speculative);
+	void prepare_args(const std::shared_ptr<Job> &job, IBlockChainState *state, const Currency &currency,
+	    const Block &block, Height unlock_height, Timestamp block_timestamp, Timestamp block_median_timestamp,
+	    bool key_image_subgroup_check, bool speculative);
 
 public:
 	RingCheckerMulticore();
 	~RingCheckerMulticore();
 	void cancel_work();
-	void start_work(IBlockChainState *state, const Currency &currency, const Block &block, Height unlock_height,
-	    Timestamp block_timestamp, Timestamp block_median_timestamp,
+	void cancel_speculative_work();
+	void start_work(IBlockChainState *state, const Currency &currency, const Hash &bid, const Block &block,
+	    Height unlock_height, Timestamp block_timestamp, Timestamp block_median_timestamp,
 	    bool key_image_subgroup_check);  // can throw ConsensusError immediately
+	// Queues signature checks for block that will be applied later, reading outputs from current state.
+	// Never throws ConsensusError, all consensus checks are repeated by start_work
+	void start_speculative_work(IBlockChainState *state, const Currency &currency, const Hash &bid,
+	    const Block &block, bool key_image_subgroup_check, size_t max_speculative_blocks);
+	bool has_speculative_work(const Hash &bid) const;
 	std::vector<ConsensusErrorBadOutputOrSignature> move_errors();
+	size_t get_speculative_reused_counter() const { return speculative_reused_counter; }
+	size_t get_speculative_rechecked_counter() const { return speculative_rechecked_counter; }
 };
 
 struct PreparedWalletTransaction {
 	TransactionPrefix tx;
 	Hash prefix_hash;
 	Hash inputs_hash;
-	boost::optional<KeyDerivation> derivation;  // Will be assigned on first actual use
+	PublicKey tx_public_key;
+	boost::optional<KeyDerivation> derivation;  // Assigned by output handler if there are key outputs
 	std::vector<PublicKey> spend_keys;
 	std::vector<SecretKey> output_secret_scalars;
 
 	PreparedWalletTransaction() = default;
-	PreparedWalletTransaction(TransactionPrefix &&tx, const Wallet::OutputHandler &o_handler);
-	PreparedWalletTransaction(Transaction &&tx, const Wallet::OutputHandler &o_handler);
+	explicit PreparedWalletTransaction(TransactionPrefix &&tx);  // output handler must be called separately
+	PreparedWalletTransaction(TransactionPrefix &&tx, const Wallet::BlockOutputHandler &o_handler);
+	PreparedWalletTransaction(Transaction &&tx, const Wallet::BlockOutputHandler &o_handler);
 };
 
 struct PreparedWalletBlock {
@@ -110,7 +209,7 @@ struct PreparedWalletBlock {
 	std::vector<PreparedWalletTransaction> transactions;
 	PreparedWalletBlock() = default;
 	PreparedWalletBlock(BlockTemplate &&bc_header, std::vector<TransactionPrefix> &&raw_transactions,
-	    Hash base_transaction_hash, const Wallet::OutputHandler &o_handler);
+	    Hash base_transaction_hash, const Wallet::BlockOutputHandler &o_handler);
 };
 
 class WalletPreparatorMulticore {
@@ -123,14 +222,14 @@ class WalletPreparatorMulticore {
 	std::map<Height, PreparedWalletBlock> prepared_blocks;
 	api::cnd::SyncBlocks::Response work;
 	int work_counter = 0;
-	Wallet::OutputHandler m_o_handler;
+	Wallet::BlockOutputHandler m_o_handler;
 	void thread_run();
 
 public:
 	WalletPreparatorMulticore();
 	~WalletPreparatorMulticore();
 	void cancel_work();
-	void start_work(const api::cnd::SyncBlocks::Response &new_work, Wallet::OutputHandler &&o_handler);
+	void start_work(const api::cnd::SyncBlocks::Response &new_work, Wallet::BlockOutputHandler &&o_handler);
 	PreparedWalletBlock get_ready_work(Height height);
 };
 }  // namespace cn
@@ -4,11 +4,17 @@
 #include "Node.hpp"
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include "Config.hpp"
 #include "CryptoNoteTools.hpp"
 #include "TransactionExtra.hpp"
 #include "common/JsonValue.hpp"
+#include "common/MemoryStreams.hpp"
+#include "common/Varint.hpp"
 #include "http/Client.hpp"
 #include "http/Server.hpp"
 #include "platform/PathTools.hpp"
@@ -22,6 +28,127 @@
 
 using namespace cn;
 
+class Node::RPCWorkers {
+	// Each job opens its own BlockChainReader, so it sees committed state consistent with committed tip.
+	// Clients have at most one request in flight, jobs of disconnected clients are dropped by main thread
+	struct Job {
+		uint64_t id       = 0;
+		http::Client *who = nullptr;
+		http::RequestBody request;
+		json_rpc::Request rpc_request;
+		bool binary = false;
+		api::cnd::GetStatus::Response status;
+		bool answered = false;  // if false, main thread will answer
+		std::string raw_response;
+	};
+	const Node &node;
+	platform::EventLoop *main_loop;
+	std::vector<std::thread> threads;
+	std::mutex mu;
+	std::condition_variable have_work;
+	bool quit = false;
+	std::deque<Job> work;
+	std::deque<Job> finished;
+	std::atomic<bool> wake_pending{false};
+
+	uint64_t next_job_id = 1;
+	std::unordered_map<http::Client *, uint64_t> waiting_clients;  // main thread only
+
+	void thread_run() {
+		while (true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mu);
+				if (quit)
+					return;
+				if (work.empty()) {
+					have_work.wait(lock);
+					continue;
+				}
+				job = std::move(work.front());
+				work.pop_front();
+			}
+			process(job);
+			{
+				std::unique_lock<std::mutex> lock(mu);
+				finished.push_back(std::move(job));
+			}
+			if (!wake_pending.exchange(true))
+				main_loop->wake();  // so we write results in on_idle
+		}
+	}
+	void process(Job &job) const {
+		try {
+			BlockChainReader reader(node.m_block_chain);
+			RPCWorkerContext context{reader, node.m_config, job.status};
+			json_rpc::Request rpc_request = job.rpc_request;  // copy, main thread may need original
+			if (job.binary) {
+				const std::string &body = job.request.body;
+				const size_t sep        = body.find(char(0));
+				common::MemoryInputStream body_stream(body.data() + sep + 1, body.size() - sep - 1);
+				job.answered = m_binaryrpc_worker_handlers.at(rpc_request.get_method())(
+				    context, body_stream, std::move(rpc_request), job.raw_response);
+			} else
+				job.answered = m_jsonrpc_worker_handlers.at(rpc_request.get_method())(
+				    context, std::move(rpc_request), job.raw_response);
+		} catch (const std::exception &) {
+			job.answered = false;  // errors are reported by main thread, with authoritative state
+		}
+		if (!job.answered)
+			job.raw_response.clear();
+	}
+
+public:
+	explicit RPCWorkers(const Node &node, size_t thread_count, platform::EventLoop *main_loop)
+	    : node(node), main_loop(main_loop) {
+		for (size_t i = 0; i != thread_count; ++i)
+			threads.emplace_back(&RPCWorkers::thread_run, this);
+	}
+	~RPCWorkers() {
+		{
+			std::unique_lock<std::mutex> lock(mu);
+			quit = true;
+			have_work.notify_all();
+		}
+		for (auto &&th : threads)
+			th.join();
+	}
+	void add_job(http::Client *who, http::RequestBody &&request, json_rpc::Request &&rpc_request, bool binary,
+	    api::cnd::GetStatus::Response &&status) {
+		Job job;
+		job.id          = next_job_id++;
+		job.who         = who;
+		job.request     = std::move(request);
+		job.rpc_request = std::move(rpc_request);
+		job.binary      = binary;
+		job.status      = std::move(status);
+
+		waiting_clients[who] = job.id;
+		std::unique_lock<std::mutex> lock(mu);
+		work.push_back(std::move(job));
+		have_work.notify_one();
+	}
+	void on_disconnect(http::Client *who) { waiting_clients.erase(who); }
+	// Returns finished jobs whose clients are still connected
+	std::vector<Job> take_finished() {
+		wake_pending = false;
+		std::deque<Job> result;
+		{
+			std::unique_lock<std::mutex> lock(mu);
+			result.swap(finished);
+		}
+		std::vector<Job> jobs;
+		for (auto &&job : result) {
+			auto wit = waiting_clients.find(job.who);
+			if (wit == waiting_clients.end() || wit->second != job.id)
+				continue;
+			waiting_clients.erase(wit);
+			jobs.push_back(std::move(job));
+		}
+		return jobs;
+	}
+};
+
 Node::Node(logging::ILogger &log, const Config &config, BlockChainState &block_chain)
     : m_block_chain(block_chain)
     , m_config(config)
@@ -33,9 +160,13 @@ Node::Node(logging::ILogger &log, const Config &config, BlockChainState &block_c
     , m_multicast_timer(std::bind(&Node::send_multicast, this))
     , m_start_time(m_p2p.get_local_time())
     , m_commit_timer(std::bind(&Node::db_commit, this))
+    , m_rpc_workers_commit_timer(std::bind(&Node::db_commit, this))
     , log_request_timestamp(std::chrono::steady_clock::now())
     , log_response_timestamp(std::chrono::steady_clock::now())
-    , m_pow_checker(block_chain.get_currency(), platform::EventLoop::current()) {
+    , m_pow_checker(block_chain.get_currency(), platform::EventLoop::current(), config.block_preparator_queue_size,
+          config.max_prepared_blocks_memory,
+          std::chrono::seconds(static_cast<std::chrono::seconds::rep>(config.prepared_block_timeout)),
+          config.block_preparator_hash_ways) {
 	const std::string old_path = platform::get_default_data_directory(CRYPTONOTE_NAME);
 	const std::string new_path = config.get_data_folder();
 
@@ -43,6 +174,8 @@ Node::Node(logging::ILogger &log, const Config &config, BlockChainState &block_c
 		m_api = std::make_unique<http::Server>(config.bytecoind_bind_ip, config.bytecoind_bind_port,
 		    std::bind(&Node::on_api_http_request, this, _1, _2, _3),
 		    std::bind(&Node::on_api_http_disconnect, this, _1));
+	if (config.rpc_worker_threads != 0)
+		m_rpc_workers = std::make_unique<RPCWorkers>(*this, config.rpc_worker_threads, platform::EventLoop::current());
 
 	m_commit_timer.once(float(m_config.db_commit_period_blockchain));
 	advance_long_poll();
@@ -82,6 +215,8 @@ void Node::on_multicast(const std::string &addr, const unsigned char *data, size
 void Node::db_commit() {
 	m_block_chain.db_commit();
 	m_commit_timer.once(float(m_config.db_commit_period_blockchain));
+	m_rpc_workers_commit_timer.cancel();
+	m_rpc_workers_commit_pending = false;
 }
 
 void Node::remove_chain_block(std::map<Hash, DownloadInfo>::iterator it) {
@@ -92,6 +227,15 @@ void Node::remove_chain_block(std::map<Hash, DownloadInfo>::iterator it) {
 }
 
 void Node::advance_all_downloads() {
+	for (const auto &bid : m_pow_checker.take_evicted()) {
+		auto cit = chain_blocks.find(bid);
+		if (cit == chain_blocks.end() || !cit->second.preparing)
+			continue;
+		m_log(logging::TRACE) << "Prepared block evicted, will download again hash=" << bid << std::endl;
+		cit->second.preparing = false;
+		if (cit->second.chain_counter == 0)
+			chain_blocks.erase(cit);
+	}
 	for (auto &&who : m_broadcast_protocols)
 		who->advance_blocks();
 }
@@ -118,6 +262,7 @@ bool Node::on_idle() {
 		advance_long_poll();
 	}
 	advance_all_downloads();
+	write_rpc_worker_results();
 	return on_idle_result;
 }
 
@@ -145,6 +290,13 @@ void Node::advance_long_poll() {
 	if (m_prevent_sleep &&
 	    m_block_chain.get_tip().timestamp > now - m_block_chain.get_currency().block_future_time_limit * 2)
 		m_prevent_sleep = nullptr;
+	// While far behind, blocks are committed on usual schedule and RPC is answered by main thread
+	if (m_rpc_workers && !m_rpc_workers_commit_pending &&
+	    m_block_chain.get_committed_tip_bid() != m_block_chain.get_tip_bid() &&
+	    m_block_chain.get_tip().timestamp >= now - 86400) {
+		m_rpc_workers_commit_pending = true;
+		m_rpc_workers_commit_timer.once(float(m_config.db_commit_period_rpc_workers));
+	}
 	if (m_long_poll_http_clients.empty())
 		return;
 	const api::cnd::GetStatus::Response resp = create_status_response();
@@ -243,6 +395,8 @@ bool Node::on_api_http_request(http::Client *who, http::RequestBody &&request, h
 }
 
 void Node::on_api_http_disconnect(http::Client *who) {
+	if (m_rpc_workers)
+		m_rpc_workers->on_disconnect(who);
 	for (auto lit = m_long_poll_http_clients.begin(); lit != m_long_poll_http_clients.end();)
 		if (lit->original_who == who)
 			lit = m_long_poll_http_clients.erase(lit);
@@ -251,7 +405,7 @@ void Node::on_api_http_disconnect(http::Client *who) {
 }
 
 const std::unordered_map<std::string, Node::BINARYRPCHandlerFunction> Node::m_binaryrpc_handlers = {
-    {api::cnd::SyncBlocks::bin_method(), json_rpc::make_binary_member_method(&Node::on_sync_blocks)},
+    {api::cnd::SyncBlocks::bin_method(), &Node::on_sync_blocks_binary},
     {api::cnd::SyncMemPool::bin_method(), json_rpc::make_binary_member_method(&Node::on_sync_mempool)}};
 
 std::unordered_map<std::string, Node::JSONRPCHandlerFunction> Node::m_jsonrpc_handlers = {
@@ -278,21 +432,95 @@ std::unordered_map<std::string, Node::JSONRPCHandlerFunction> Node::m_jsonrpc_ha
     {api::cnd::GetRawTransaction::method(), json_rpc::make_member_method(&Node::on_get_raw_transaction)},
     {api::cnd::SyncMemPool::method(), json_rpc::make_member_method(&Node::on_sync_mempool)}};
 
-bool Node::on_get_random_outputs(http::Client *, http::RequestBody &&, json_rpc::Request &&,
-    api::cnd::GetRandomOutputs::Request &&request, api::cnd::GetRandomOutputs::Response &response) {
+template<typename ParamsType, typename ResultType>
+static Node::JSONRPCWorkerHandlerFunction make_worker_method(
+    bool (*handler)(const Node::RPCWorkerContext &, ParamsType &&, ResultType &)) {
+	return [handler](const Node::RPCWorkerContext &context, json_rpc::Request &&json_req,
+	           std::string &raw_response) -> bool {
+		ParamsType params{};
+		ResultType result{};
+		json_req.load_params(params);
+		if (!handler(context, std::move(params), result))
+			return false;
+		raw_response = json_rpc::create_response_body(result, json_req.get_id().get());
+		return true;
+	};
+}
+
+const std::unordered_map<std::string, Node::BINARYRPCWorkerHandlerFunction> Node::m_binaryrpc_worker_handlers = {
+    {api::cnd::SyncBlocks::bin_method(), &Node::on_sync_blocks_binary_worker}};
+
+const std::unordered_map<std::string, Node::JSONRPCWorkerHandlerFunction> Node::m_jsonrpc_worker_handlers = {
+    {api::cnd::SyncBlocks::method(), make_worker_method(&Node::on_sync_blocks_worker)},
+    {api::cnd::GetRawBlock::method(), make_worker_method(&Node::on_get_raw_block_worker)},
+    {api::cnd::GetBlockHeader::method(), make_worker_method(&Node::on_get_block_header_worker)},
+    {api::cnd::GetRawTransaction::method(), make_worker_method(&Node::on_get_raw_transaction_worker)},
+    {api::cnd::GetRandomOutputs::method(), make_worker_method(&Node::on_get_random_outputs_worker)}};
+
+bool Node::can_use_rpc_workers() const {
+	return m_rpc_workers && m_block_chain.get_committed_tip_bid() == m_block_chain.get_tip_bid();
+}
+
+bool Node::add_rpc_worker_job(
+    http::Client *who, http::RequestBody &&request, json_rpc::Request &&rpc_request, bool binary) {
+	if (!can_use_rpc_workers())
+		return false;
+	if (binary ? m_binaryrpc_worker_handlers.count(rpc_request.get_method()) == 0
+	           : m_jsonrpc_worker_handlers.count(rpc_request.get_method()) == 0)
+		return false;
+	m_rpc_workers->add_job(who, std::move(request), std::move(rpc_request), binary, create_status_response());
+	return true;
+}
+
+void Node::write_rpc_worker_results() {
+	if (!m_rpc_workers)
+		return;
+	for (auto &&job : m_rpc_workers->take_finished()) {
+		http::ResponseBody response(job.request.r);
+		response.r.add_headers_nocache();
+		if (!job.answered) {
+			const bool ready = job.binary
+			                       ? on_binary_rpc(job.who, std::move(job.request), response, false)
+			                       : on_json_rpc(job.who, std::move(job.request), response, false);
+			if (ready)
+				job.who->write(std::move(response));
+			continue;
+		}
+		response.r.headers.push_back(
+		    {"Content-Type", job.binary ? "application/octet-stream" : "application/json; charset=utf-8"});
+		response.r.status = 200;
+		response.set_body(std::move(job.raw_response));
+		job.who->write(std::move(response));
+	}
+}
+
+template<typename Chain>
+void Node::get_random_outputs(const Chain &block_chain, api::cnd::GetRandomOutputs::Request &&request,
+    api::cnd::GetRandomOutputs::Response &response) {
 	Height confirmed_height_or_depth = api::ErrorWrongHeight::fix_height_or_depth(
-	    request.confirmed_height_or_depth, m_block_chain.get_tip_height(), true, false);
-	api::BlockHeader confirmed_header = m_block_chain.get_tip();
+	    request.confirmed_height_or_depth, block_chain.get_tip_height(), true, false);
+	api::BlockHeader confirmed_header = block_chain.get_tip();
 	Hash confirmed_hash;
-	invariant(m_block_chain.get_chain(confirmed_height_or_depth, &confirmed_hash), "");
-	invariant(m_block_chain.get_header(confirmed_hash, &confirmed_header), "");
+	invariant(block_chain.get_chain(confirmed_height_or_depth, &confirmed_hash), "");
+	invariant(block_chain.get_header(confirmed_hash, &confirmed_header), "");
 	for (uint64_t amount : request.amounts) {
 		auto random_outputs =
-		    m_block_chain.get_random_outputs(confirmed_header.major_version, amount, request.output_count,
+		    block_chain.get_random_outputs(confirmed_header.major_version, amount, request.output_count,
 		        confirmed_height_or_depth, confirmed_header.timestamp, confirmed_header.timestamp_median);
 		auto &outs = response.outputs[amount];
 		outs.insert(outs.end(), random_outputs.begin(), random_outputs.end());
 	}
+}
+
+bool Node::on_get_random_outputs(http::Client *, http::RequestBody &&, json_rpc::Request &&,
+    api::cnd::GetRandomOutputs::Request &&request, api::cnd::GetRandomOutputs::Response &response) {
+	get_random_outputs(m_block_chain, std::move(request), response);
+	return true;
+}
+
+bool Node::on_get_random_outputs_worker(const RPCWorkerContext &context,
+    api::cnd::GetRandomOutputs::Request &&request, api::cnd::GetRandomOutputs::Response &response) {
+	get_random_outputs(context.block_chain, std::move(request), response);
 	return true;
 }
 
@@ -321,16 +549,46 @@ api::cnd::GetStatus::Response Node::create_status_response() const {
 	return res;
 }
 
-void Node::broadcast(P2PProtocolBytecoin *exclude, const BinaryArray &data) {
+void Node::broadcast(P2PProtocolBytecoin *exclude, BinaryArray &&data) {
+	const auto shared_data = common::BinaryArrayPool::share(std::move(data));
 	for (auto &&p : m_broadcast_protocols)
 		if (p != exclude)
-			p->P2PProtocol::send(BinaryArray(data));  // Move is impossible here
+			p->P2PProtocol::send_shared(shared_data);
 }
-void Node::broadcast(P2PProtocolBytecoin *exclude, const BinaryArray &data_v1, const BinaryArray &data_v4) {
+void Node::broadcast(P2PProtocolBytecoin *exclude, BinaryArray &&data_v1, BinaryArray &&data_v4) {
+	const auto shared_v1 = common::BinaryArrayPool::share(std::move(data_v1));
+	const auto shared_v4 = common::BinaryArrayPool::share(std::move(data_v4));
 	for (auto &&p : m_broadcast_protocols)
 		if (p != exclude)
-			p->P2PProtocol::send(BinaryArray(
-			    p->get_peer_version() >= P2PProtocolVersion::AMETHYST ? data_v4 : data_v1));  // Move is impossible here
+			p->P2PProtocol::send_shared(p->get_peer_version() >= P2PProtocolVersion::AMETHYST ? shared_v4 : shared_v1);
+}
+
+void Node::broadcast_block(P2PProtocolBytecoin *exclude, const RawBlock &raw_block, const api::BlockHeader &info) {
+	p2p::RelayBlock::Notify msg;
+	msg.b                         = raw_block;  // RawBlockLegacy{raw_block.block, raw_block.transactions};
+	msg.hop                       = 1;  // Do not increment, hop count allows tracking block origin
+	msg.current_blockchain_height = info.height;
+	msg.top_id                    = info.hash;
+	p2p::RelayBlock::Notify msg_v4;
+	msg_v4.b.block                   = msg.b.block;
+	msg_v4.current_blockchain_height = msg.current_blockchain_height;
+	msg_v4.top_id                    = msg.top_id;
+	msg_v4.hop                       = msg.hop;
+
+	msg.top_id = Hash{};  // TODO - uncomment after 3.4 fork. This is workaround of bug in 3.2
+
+	const auto shared_v1 = common::BinaryArrayPool::share(LevinProtocol::send(msg));
+	const auto shared_v4 = common::BinaryArrayPool::share(LevinProtocol::send(msg_v4));
+	const auto shared_v5 = common::BinaryArrayPool::share(
+	    LevinProtocol::send(CompactBlock::create(raw_block, info.hash, info.height, crypto::rand<uint64_t>())));
+	for (auto &&p : m_broadcast_protocols) {
+		if (p == exclude)
+			continue;
+		if (p->get_common_version() >= P2PProtocolVersion::COMPACT_BLOCKS)
+			p->P2PProtocol::send_shared(shared_v5);
+		else
+			p->P2PProtocol::send_shared(p->get_peer_version() >= P2PProtocolVersion::AMETHYST ? shared_v4 : shared_v1);
+	}
 }
 
 bool Node::on_get_status(http::Client *who, http::RequestBody &&raw_request, json_rpc::Request &&raw_js_request,
@@ -375,6 +633,10 @@ api::cnd::GetStatistics::Response Node::create_statistics_response(const api::cn
 	res.genesis_block_hash = m_block_chain.get_currency().genesis_block_hash;
 	res.start_time         = m_start_time;
 	m_block_chain.fill_statistics(res);
+	m_pow_checker.fill_statistics(res);
+	res.compact_blocks_received              = m_compact_blocks_received;
+	res.compact_blocks_reconstructed         = m_compact_blocks_reconstructed;
+	res.compact_block_transactions_requested = m_compact_block_transactions_requested;
 	return res;
 }
 
@@ -420,152 +682,326 @@ static void fill_transaction_info(const TransactionPrefix &tx, api::Transaction
 		api_tx->anonymity = 0;  // No key inputs
 }
 
-bool Node::on_sync_blocks(http::Client *, http::RequestBody &&, json_rpc::Request &&json_req,
-    api::cnd::SyncBlocks::Request &&req, api::cnd::SyncBlocks::Response &res) {
+template<typename Chain>
+std::vector<Hash> Node::get_sync_blocks_chain(
+    const Chain &block_chain, const Config &config, api::cnd::SyncBlocks::Request &req, Height *start_height) {
 	if (req.sparse_chain.empty())
 		throw std::runtime_error("Empty sparse chain - must include at least genesis block");
 	if (req.sparse_chain.back() == Hash{})  // We allow to ask for "whatever genesis bid. Useful for explorer, etc."
-		req.sparse_chain.back() = m_block_chain.get_genesis_bid();
-	if (req.sparse_chain.back() != m_block_chain.get_genesis_bid())
+		req.sparse_chain.back() = block_chain.get_genesis_bid();
+	if (req.sparse_chain.back() != block_chain.get_genesis_bid())
 		throw std::runtime_error(
-		    "Wrong currency - different genesis block. Must be " + common::pod_to_hex(m_block_chain.get_genesis_bid()));
-	if (req.max_count > m_config.rpc_sync_blocks_max_count)
-		req.max_count = m_config.rpc_sync_blocks_max_count;
-	auto first_block_timestamp = req.first_block_timestamp < m_block_chain.get_currency().block_future_time_limit
+		    "Wrong currency - different genesis block. Must be " + common::pod_to_hex(block_chain.get_genesis_bid()));
+	if (req.max_count > config.rpc_sync_blocks_max_count)
+		req.max_count = config.rpc_sync_blocks_max_count;
+	auto first_block_timestamp = req.first_block_timestamp < block_chain.get_currency().block_future_time_limit
 	                                 ? 0
-	                                 : req.first_block_timestamp - m_block_chain.get_currency().block_future_time_limit;
-	Height full_offset = m_block_chain.get_timestamp_lower_bound_height(first_block_timestamp);
-	Height start_height;
-	std::vector<Hash> subchain = m_block_chain.get_sync_headers_chain(req.sparse_chain, &start_height, req.max_count);
-	if (full_offset >= start_height + subchain.size()) {
-		start_height = full_offset;
+	                                 : req.first_block_timestamp - block_chain.get_currency().block_future_time_limit;
+	Height full_offset         = block_chain.get_timestamp_lower_bound_height(first_block_timestamp);
+	std::vector<Hash> subchain = block_chain.get_sync_headers_chain(req.sparse_chain, start_height, req.max_count);
+	if (full_offset >= *start_height + subchain.size()) {
+		*start_height = full_offset;
 		subchain.clear();
 		while (subchain.size() < req.max_count) {
 			Hash ha;
-			if (!m_block_chain.get_chain(start_height + static_cast<Height>(subchain.size()), &ha))
+			if (!block_chain.get_chain(*start_height + static_cast<Height>(subchain.size()), &ha))
 				break;
 			subchain.push_back(ha);
 		}
-	} else if (full_offset > start_height) {
-		subchain.erase(subchain.begin(), subchain.begin() + (full_offset - start_height));
-		start_height = full_offset;
+	} else if (full_offset > *start_height) {
+		subchain.erase(subchain.begin(), subchain.begin() + (full_offset - *start_height));
+		*start_height = full_offset;
 	}
-
-	res.start_height = start_height;
-	res.blocks.resize(subchain.size());
+	// Headers are cheap, so we know response block count before reading any block body
 	size_t total_size = 0;
 	for (size_t i = 0; i != subchain.size(); ++i) {
-		const auto &bhash = subchain[i];
-		auto &res_block   = res.blocks[i];
-		invariant(
-		    m_block_chain.get_header(bhash, &res_block.header), "Block header must be there, but it is not there");
-
-		//		BlockChainState::BlockGlobalIndices output_indexes;
-		// if (res.blocks[i].header.timestamp >= req.first_block_timestamp) //
-		// commented out becuase empty Block cannot be serialized
-		{
-			RawBlock rb;
-			invariant(m_block_chain.get_block(bhash, &rb), "Block must be there, but it is not there");
-			Block block(rb);
-			res_block.transactions.resize(block.transactions.size() + 1);
-			res_block.transactions.at(0).hash = get_transaction_hash(block.header.base_transaction);
-			res_block.transactions.at(0).size = seria::binary_size(block.header.base_transaction);
-			if (req.need_redundant_data) {
-				fill_transaction_info(block.header.base_transaction, &res_block.transactions.at(0));
-				res_block.transactions.at(0).block_height = start_height + static_cast<Height>(i);
-				res_block.transactions.at(0).block_hash   = bhash;
-				res_block.transactions.at(0).coinbase     = true;
-				res_block.transactions.at(0).timestamp    = block.header.timestamp;
-			}
-			res_block.raw_header = std::move(block.header);
-			res_block.raw_transactions.reserve(block.transactions.size());
-			for (size_t tx_index = 0; tx_index != block.transactions.size(); ++tx_index) {
-				res_block.transactions.at(tx_index + 1).hash = res_block.raw_header.transaction_hashes.at(tx_index);
-				res_block.transactions.at(tx_index + 1).size = rb.transactions.at(tx_index).size();
-				if (req.need_redundant_data) {
-					fill_transaction_info(block.transactions.at(tx_index), &res_block.transactions.at(tx_index + 1));
-					res_block.transactions.at(tx_index + 1).block_height = start_height + static_cast<Height>(i);
-					res_block.transactions.at(tx_index + 1).block_hash   = bhash;
-					res_block.transactions.at(tx_index + 1).timestamp    = res_block.raw_header.timestamp;
-				}
-				if (req.need_signatures)
-					res_block.signatures.push_back(std::move(block.transactions.at(tx_index).signatures));
-				res_block.raw_transactions.push_back(std::move(block.transactions.at(tx_index)));
-			}
-			invariant(m_block_chain.read_block_output_global_indices(bhash, &res_block.output_indexes),
-			    "Invariant dead - bid is in chain but blockchain has no block indices");
-		}
-		total_size += res_block.header.transactions_size;
+		api::BlockHeader header;
+		invariant(block_chain.get_header(subchain[i], &header, *start_height + static_cast<Height>(i)),
+		    "Block header must be there, but it is not there");
+		total_size += header.transactions_size;
 		if (total_size >= req.max_size) {
-			res.blocks.resize(i + 1);
+			subchain.resize(i + 1);
 			break;
 		}
 	}
+	return subchain;
+}
+
+template<typename Chain>
+void Node::fill_sync_block(const Chain &block_chain, const Hash &bid, Height height, bool need_redundant_data,
+    bool need_signatures, api::RawBlock *res_block) {
+	invariant(
+	    block_chain.get_header(bid, &res_block->header, height), "Block header must be there, but it is not there");
+	RawBlock rb;
+	invariant(block_chain.get_block(bid, &rb), "Block must be there, but it is not there");
+	Block block(rb);
+	res_block->transactions.resize(block.transactions.size() + 1);
+	res_block->transactions.at(0).hash = get_transaction_hash(block.header.base_transaction);
+	res_block->transactions.at(0).size = seria::binary_size(block.header.base_transaction);
+	if (need_redundant_data) {
+		fill_transaction_info(block.header.base_transaction, &res_block->transactions.at(0));
+		res_block->transactions.at(0).block_height = height;
+		res_block->transactions.at(0).block_hash   = bid;
+		res_block->transactions.at(0).coinbase     = true;
+		res_block->transactions.at(0).timestamp    = block.header.timestamp;
+	}
+	res_block->raw_header = std::move(block.header);
+	res_block->raw_transactions.reserve(block.transactions.size());
+	for (size_t tx_index = 0; tx_index != block.transactions.size(); ++tx_index) {
+		res_block->transactions.at(tx_index + 1).hash = res_block->raw_header.transaction_hashes.at(tx_index);
+		res_block->transactions.at(tx_index + 1).size = rb.transactions.at(tx_index).size();
+		if (need_redundant_data) {
+			fill_transaction_info(block.transactions.at(tx_index), &res_block->transactions.at(tx_index + 1));
+			res_block->transactions.at(tx_index + 1).block_height = height;
+			res_block->transactions.at(tx_index + 1).block_hash   = bid;
+			res_block->transactions.at(tx_index + 1).timestamp    = res_block->raw_header.timestamp;
+		}
+		if (need_signatures)
+			res_block->signatures.push_back(std::move(block.transactions.at(tx_index).signatures));
+		res_block->raw_transactions.push_back(std::move(block.transactions.at(tx_index)));
+	}
+	invariant(block_chain.read_block_output_global_indices(bid, &res_block->output_indexes),
+	    "Invariant dead - bid is in chain but blockchain has no block indices");
+}
+
+static std::pair<const char *, size_t> read_stored_slice(const char *&pos, const char *end) {
+	size_t size = 0;
+	if (common::read_varint(pos, end, &size) <= 0 || size > static_cast<size_t>(end - pos))
+		throw std::runtime_error("Stored block is corrupted");
+	std::pair<const char *, size_t> result{pos, size};
+	pos += size;
+	return result;
+}
+
+template<typename Chain>
+void Node::write_sync_block(
+    const Chain &block_chain, const Hash &bid, Height height, bool need_redundant_data, common::IOutputStream &out) {
+	seria::BinaryOutputStream ba(out);
+	api::BlockHeader header;
+	invariant(block_chain.get_header(bid, &header, height), "Block header must be there, but it is not there");
+	ser(header, ba);
+
+	// Stored RawBlock is varint size + block template, then varint count + (varint size + transaction) each.
+	// We copy template and transaction prefixes as is, parsing only to find prefix ends. Signatures are skipped.
+	StoredBlockData block_data;
+	invariant(block_chain.get_block_data(bid, &block_data), "Block must be there, but it is not there");
+	const char *pos = block_data.data();
+	const char *end = block_data.data() + block_data.size();
+
+	const auto raw_header = read_stored_slice(pos, end);
+	BlockTemplate block_template;
+	common::MemoryInputStream header_stream(raw_header.first, raw_header.second);
+	seria::from_binary(block_template, header_stream);
+	out.write(raw_header.first, raw_header.second);
+
+	size_t tx_count = 0;
+	if (common::read_varint(pos, end, &tx_count) <= 0 || tx_count != block_template.transaction_hashes.size())
+		throw std::runtime_error("Stored block is corrupted");
+	std::vector<api::Transaction> transactions(tx_count + 1);
+	transactions.at(0).hash = get_transaction_hash(block_template.base_transaction);
+	transactions.at(0).size = seria::binary_size(block_template.base_transaction);
+	if (need_redundant_data) {
+		fill_transaction_info(block_template.base_transaction, &transactions.at(0));
+		transactions.at(0).block_height = height;
+		transactions.at(0).block_hash   = bid;
+		transactions.at(0).coinbase     = true;
+		transactions.at(0).timestamp    = block_template.timestamp;
+	}
+	out.write_varint(tx_count);
+	TransactionPrefix prefix;
+	for (size_t tx_index = 0; tx_index != tx_count; ++tx_index) {
+		const auto raw_tx = read_stored_slice(pos, end);
+		common::MemoryInputStream tx_stream(raw_tx.first, raw_tx.second);
+		seria::BinaryInputStream tx_ba(tx_stream);
+		ser(prefix, tx_ba);
+		out.write(raw_tx.first, raw_tx.second - tx_stream.size());
+		transactions.at(tx_index + 1).hash = block_template.transaction_hashes.at(tx_index);
+		transactions.at(tx_index + 1).size = raw_tx.second;
+		if (need_redundant_data) {
+			fill_transaction_info(prefix, &transactions.at(tx_index + 1));
+			transactions.at(tx_index + 1).block_height = height;
+			transactions.at(tx_index + 1).block_hash   = bid;
+			transactions.at(tx_index + 1).timestamp    = block_template.timestamp;
+		}
+	}
+	out.write_varint(0);  // signatures
+	ser(transactions, ba);
+
+	platform::DB::Value indices_data;
+	invariant(block_chain.read_block_output_global_indices(bid, &indices_data),
+	    "Invariant dead - bid is in chain but blockchain has no block indices");
+	out.write(indices_data.data(), indices_data.size());
+}
+
+template void Node::fill_sync_block(const BlockChainState &, const Hash &, Height, bool, bool, api::RawBlock *);
+template void Node::write_sync_block(const BlockChainState &, const Hash &, Height, bool, common::IOutputStream &);
+
+template<typename Chain>
+void Node::write_sync_blocks(const Chain &block_chain, const std::vector<Hash> &subchain, Height start_height,
+    const api::cnd::SyncBlocks::Request &req, common::IOutputStream &out) {
+	if (req.need_signatures) {  // Rarely used, so not worth separate streaming code
+		std::vector<api::RawBlock> blocks(subchain.size());
+		for (size_t i = 0; i != subchain.size(); ++i)
+			fill_sync_block(block_chain, subchain[i], start_height + static_cast<Height>(i), req.need_redundant_data,
+			    true, &blocks[i]);
+		seria::BinaryOutputStream blocks_ba(out);
+		ser(blocks, blocks_ba);
+		return;
+	}
+	out.write_varint(subchain.size());
+	for (size_t i = 0; i != subchain.size(); ++i)
+		write_sync_block(block_chain, subchain[i], start_height + static_cast<Height>(i), req.need_redundant_data, out);
+}
+
+template<typename Chain>
+void Node::sync_blocks(const Chain &block_chain, const Config &config, api::cnd::SyncBlocks::Request &&req,
+    api::cnd::SyncBlocks::Response &res) {
+	std::vector<Hash> subchain = get_sync_blocks_chain(block_chain, config, req, &res.start_height);
+	res.blocks.resize(subchain.size());
+	for (size_t i = 0; i != subchain.size(); ++i)
+		fill_sync_block(block_chain, subchain[i], res.start_height + static_cast<Height>(i), req.need_redundant_data,
+		    req.need_signatures, &res.blocks[i]);
+}
+
+bool Node::on_sync_blocks(http::Client *, http::RequestBody &&, json_rpc::Request &&json_req,
+    api::cnd::SyncBlocks::Request &&req, api::cnd::SyncBlocks::Response &res) {
+	sync_blocks(m_block_chain, m_config, std::move(req), res);
 	res.status = create_status_response();
 	return true;
 }
 
+bool Node::on_sync_blocks_worker(
+    const RPCWorkerContext &context, api::cnd::SyncBlocks::Request &&req, api::cnd::SyncBlocks::Response &res) {
+	sync_blocks(context.block_chain, context.config, std::move(req), res);
+	res.status = context.status;
+	return true;
+}
+
+bool Node::on_sync_blocks_binary(
+    http::Client *, common::IInputStream &body_stream, json_rpc::Request &&binary_req, std::string &raw_response) {
+	api::cnd::SyncBlocks::Request req;
+	seria::BinaryInputStream ba(body_stream);
+	ser(req, ba);
+	Height start_height        = 0;
+	std::vector<Hash> subchain = get_sync_blocks_chain(m_block_chain, m_config, req, &start_height);
+	raw_response               = json_rpc::create_binary_response_prefix(binary_req.get_id().get());
+
+	const SyncBlocksCache::Key key{start_height, subchain.size(), req.need_redundant_data, req.need_signatures};
+	const Hash last_bid = subchain.empty() ? Hash{} : subchain.back();
+	auto &cache         = m_block_chain.get_sync_blocks_cache();
+	if (const std::string *chunk = cache.find(key, last_bid)) {
+		raw_response += *chunk;
+	} else {
+		std::string new_chunk;
+		common::StringOutputStream str(new_chunk);
+		write_sync_blocks(m_block_chain, subchain, start_height, req, str);
+		raw_response += new_chunk;
+		if (!subchain.empty())
+			cache.insert(key, last_bid, std::move(new_chunk));
+	}
+	common::StringOutputStream str(raw_response);  // continue writing
+	seria::BinaryOutputStream ba_out(str);
+	ser(start_height, ba_out);
+	auto status = create_status_response();
+	ser(status, ba_out);
+	return true;
+}
+
+bool Node::on_sync_blocks_binary_worker(const RPCWorkerContext &context, common::IInputStream &body_stream,
+    json_rpc::Request &&binary_req, std::string &raw_response) {
+	api::cnd::SyncBlocks::Request req;
+	seria::BinaryInputStream ba(body_stream);
+	ser(req, ba);
+	Height start_height        = 0;
+	std::vector<Hash> subchain = get_sync_blocks_chain(context.block_chain, context.config, req, &start_height);
+	raw_response               = json_rpc::create_binary_response_prefix(binary_req.get_id().get());
+	common::StringOutputStream str(raw_response);  // Workers do not share SyncBlocksCache with main thread
+	write_sync_blocks(context.block_chain, subchain, start_height, req, str);
+	seria::BinaryOutputStream ba_out(str);
+	ser(start_height, ba_out);
+	auto status = context.status;
+	ser(status, ba_out);
+	return true;
+}
+
 bool Node::on_sync_mempool(http::Client *, http::RequestBody &&, json_rpc::Request &&,
     api::cnd::SyncMemPool::Request &&req, api::cnd::SyncMemPool::Response &res) {
 	const auto &pool = m_block_chain.get_memory_state_transactions();
 	for (auto &&ex : req.known_hashes)
 		if (pool.count(ex) == 0)
 			res.removed_hashes.push_back(ex);
-	for (auto &&tx : pool)
+	for (auto &&tit : pool.get_sorted_by_hash()) {
+		const auto &tx = *tit;
 		if (!std::binary_search(req.known_hashes.begin(), req.known_hashes.end(), tx.first)) {
-			res.added_raw_transactions.push_back(tx.second.tx);
+			Transaction ptx = tx.second.get_transaction();
 			if (req.need_signatures)
-				res.added_signatures.push_back(tx.second.tx.signatures);
+				res.added_signatures.push_back(ptx.signatures);
 			res.added_transactions.push_back(api::Transaction{});
 			if (req.need_redundant_data)
-				fill_transaction_info(tx.second.tx, &res.added_transactions.back());
+				fill_transaction_info(ptx, &res.added_transactions.back());
+			res.added_raw_transactions.push_back(std::move(ptx));
 			res.added_transactions.back().hash      = tx.first;
 			res.added_transactions.back().timestamp = tx.second.timestamp;
 			res.added_transactions.back().amount    = tx.second.amount;
 			res.added_transactions.back().fee       = tx.second.fee;
 			res.added_transactions.back().size      = tx.second.binary_tx.size();
 		}
+	}
 	res.status = create_status_response();
 	return true;
 }
 
-bool Node::on_get_block_header(http::Client *, http::RequestBody &&, json_rpc::Request &&,
-    api::cnd::GetBlockHeader::Request &&request, api::cnd::GetBlockHeader::Response &response) {
+template<typename Chain>
+void Node::get_block_header(const Chain &block_chain, api::cnd::GetBlockHeader::Request &&request,
+    api::cnd::GetBlockHeader::Response &response) {
 	if (request.hash != Hash{} && request.height_or_depth != std::numeric_limits<api::HeightOrDepth>::max())
 		throw json_rpc::Error(
 		    json_rpc::INVALID_REQUEST, "You cannot specify both hash and height_or_depth to this method");
 	if (request.hash != Hash{}) {
-		if (!m_block_chain.get_header(request.hash, &response.block_header))
+		if (!block_chain.get_header(request.hash, &response.block_header))
 			throw api::ErrorHashNotFound("Block not found in either main or side chains", request.hash);
 	} else {
 		Height height_or_depth = api::ErrorWrongHeight::fix_height_or_depth(
-		    request.height_or_depth, m_block_chain.get_tip_height(), true, true);
+		    request.height_or_depth, block_chain.get_tip_height(), true, true);
 		invariant(
-		    m_block_chain.get_chain(height_or_depth, &request.hash), "");  // after fix_height it must always succeed
-		invariant(m_block_chain.get_header(request.hash, &response.block_header), "");
+		    block_chain.get_chain(height_or_depth, &request.hash), "");  // after fix_height it must always succeed
+		invariant(block_chain.get_header(request.hash, &response.block_header), "");
 	}
-	response.orphan_status = !m_block_chain.in_chain(response.block_header.height, response.block_header.hash);
+	response.orphan_status = !block_chain.in_chain(response.block_header.height, response.block_header.hash);
 	response.depth =
-	    api::HeightOrDepth(response.block_header.height) - api::HeightOrDepth(m_block_chain.get_tip_height()) - 1;
+	    api::HeightOrDepth(response.block_header.height) - api::HeightOrDepth(block_chain.get_tip_height()) - 1;
+}
+
+bool Node::on_get_block_header(http::Client *, http::RequestBody &&, json_rpc::Request &&,
+    api::cnd::GetBlockHeader::Request &&request, api::cnd::GetBlockHeader::Response &response) {
+	get_block_header(m_block_chain, std::move(request), response);
 	return true;
 }
-bool Node::on_get_raw_block(http::Client *, http::RequestBody &&, json_rpc::Request &&,
-    api::cnd::GetRawBlock::Request &&request, api::cnd::GetRawBlock::Response &response) {
+
+bool Node::on_get_block_header_worker(const RPCWorkerContext &context, api::cnd::GetBlockHeader::Request &&request,
+    api::cnd::GetBlockHeader::Response &response) {
+	get_block_header(context.block_chain, std::move(request), response);
+	return true;
+}
+
+template<typename Chain>
+void Node::get_raw_block(
+    const Chain &block_chain, api::cnd::GetRawBlock::Request &&request, api::cnd::GetRawBlock::Response &response) {
 	if (request.hash != Hash{} && request.height_or_depth != std::numeric_limits<api::HeightOrDepth>::max())
 		throw json_rpc::Error(
 		    json_rpc::INVALID_REQUEST, "You cannot specify both hash and height_or_depth to this method");
 	if (request.hash != Hash{}) {
-		if (!m_block_chain.get_header(request.hash, &response.block.header))
+		if (!block_chain.get_header(request.hash, &response.block.header))
 			throw api::ErrorHashNotFound("Block not found in either main or side chains", request.hash);
 	} else {
 		Height height_or_depth = api::ErrorWrongHeight::fix_height_or_depth(
-		    request.height_or_depth, m_block_chain.get_tip_height(), true, true);
+		    request.height_or_depth, block_chain.get_tip_height(), true, true);
 		invariant(
-		    m_block_chain.get_chain(height_or_depth, &request.hash), "");  // after fix_height it must always succeed
-		invariant(m_block_chain.get_header(request.hash, &response.block.header), "");
+		    block_chain.get_chain(height_or_depth, &request.hash), "");  // after fix_height it must always succeed
+		invariant(block_chain.get_header(request.hash, &response.block.header), "");
 	}
 	RawBlock rb;
-	invariant(m_block_chain.get_block(request.hash, &rb), "Block must be there, but it is not there");
+	invariant(block_chain.get_block(request.hash, &rb), "Block must be there, but it is not there");
 	Block block(rb);
 
 	api::RawBlock &b = response.block;
@@ -590,10 +1026,41 @@ bool Node::on_get_raw_block(http::Client *, http::RequestBody &&, json_rpc::Requ
 			b.signatures.push_back(std::move(block.transactions.at(tx_index).signatures));
 		b.raw_transactions.push_back(std::move(block.transactions.at(tx_index)));
 	}
-	m_block_chain.read_block_output_global_indices(request.hash, &b.output_indexes);
+	block_chain.read_block_output_global_indices(request.hash, &b.output_indexes);
 	// If block not in main chain - global indices will be empty
-	response.orphan_status = !m_block_chain.in_chain(b.header.height, b.header.hash);
-	response.depth = api::HeightOrDepth(b.header.height) - api::HeightOrDepth(m_block_chain.get_tip_height()) - 1;
+	response.orphan_status = !block_chain.in_chain(b.header.height, b.header.hash);
+	response.depth = api::HeightOrDepth(b.header.height) - api::HeightOrDepth(block_chain.get_tip_height()) - 1;
+}
+
+bool Node::on_get_raw_block(http::Client *, http::RequestBody &&, json_rpc::Request &&,
+    api::cnd::GetRawBlock::Request &&request, api::cnd::GetRawBlock::Response &response) {
+	get_raw_block(m_block_chain, std::move(request), response);
+	return true;
+}
+
+bool Node::on_get_raw_block_worker(const RPCWorkerContext &context, api::cnd::GetRawBlock::Request &&request,
+    api::cnd::GetRawBlock::Response &response) {
+	get_raw_block(context.block_chain, std::move(request), response);
+	return true;
+}
+
+template<typename Chain>
+bool Node::get_raw_transaction_in_chain(const Chain &block_chain, const api::cnd::GetRawTransaction::Request &req,
+    api::cnd::GetRawTransaction::Response &res) {
+	BinaryArray binary_tx;
+	Transaction tx;
+	size_t index_in_block = 0;
+	if (!block_chain.get_transaction(
+	        req.hash, &binary_tx, &res.transaction.block_height, &res.transaction.block_hash, &index_in_block))
+		return false;
+	res.transaction.size = binary_tx.size();
+	seria::from_binary(tx, binary_tx);
+	res.raw_transaction = static_cast<const TransactionPrefix &>(tx);
+	if (req.need_signatures)
+		res.signatures = tx.signatures;
+	fill_transaction_info(tx, &res.transaction);
+	res.transaction.hash = req.hash;
+	res.transaction.fee  = get_tx_fee(res.raw_transaction);  // 0 for coinbase
 	return true;
 }
 
@@ -602,10 +1069,11 @@ bool Node::on_get_raw_transaction(http::Client *, http::RequestBody &&, json_rpc
 	const auto &pool = m_block_chain.get_memory_state_transactions();
 	auto tit         = pool.find(req.hash);
 	if (tit != pool.end()) {
-		res.raw_transaction = static_cast<const TransactionPrefix &>(tit->second.tx);
+		Transaction tx      = tit->second.get_transaction();
+		res.raw_transaction = static_cast<const TransactionPrefix &>(tx);
 		if (req.need_signatures)
-			res.signatures = tit->second.tx.signatures;
-		fill_transaction_info(tit->second.tx, &res.transaction);
+			res.signatures = tx.signatures;
+		fill_transaction_info(tx, &res.transaction);
 		res.transaction.fee          = tit->second.fee;
 		res.transaction.hash         = req.hash;
 		res.transaction.block_height = m_block_chain.get_tip_height() + 1;
@@ -613,26 +1081,19 @@ bool Node::on_get_raw_transaction(http::Client *, http::RequestBody &&, json_rpc
 		res.transaction.size         = tit->second.binary_tx.size();
 		return true;
 	}
-	BinaryArray binary_tx;
-	Transaction tx;
-	size_t index_in_block = 0;
-	if (m_block_chain.get_transaction(
-	        req.hash, &binary_tx, &res.transaction.block_height, &res.transaction.block_hash, &index_in_block)) {
-		res.transaction.size = binary_tx.size();
-		seria::from_binary(tx, binary_tx);
-		res.raw_transaction = static_cast<const TransactionPrefix &>(tx);
-		if (req.need_signatures)
-			res.signatures = tx.signatures;
-		fill_transaction_info(tx, &res.transaction);
-		res.transaction.hash = req.hash;
-		res.transaction.fee  = get_tx_fee(res.raw_transaction);  // 0 for coinbase
+	if (get_raw_transaction_in_chain(m_block_chain, req, res))
 		return true;
-	}
 	throw api::ErrorHashNotFound(
 	    "Transaction not found in main chain. You cannot get transactions from side chains with this method.",
 	    req.hash);
 }
 
+bool Node::on_get_raw_transaction_worker(const RPCWorkerContext &context, api::cnd::GetRawTransaction::Request &&req,
+    api::cnd::GetRawTransaction::Response &res) {
+	// Pool belongs to main thread, so worker looks only in chain and leaves "not found" to main thread
+	return get_raw_transaction_in_chain(context.block_chain, req, res);
+}
+
 bool Node::on_send_transaction(http::Client *, http::RequestBody &&, json_rpc::Request &&,
     api::cnd::SendTransaction::Request &&request, api::cnd::SendTransaction::Response &response) {
 	response.send_result = "broadcast";
@@ -658,7 +1119,7 @@ bool Node::on_send_transaction(http::Client *, http::RequestBody &&, json_rpc::R
 
 			BinaryArray raw_msg    = LevinProtocol::send(msg);
 			BinaryArray raw_msg_v4 = LevinProtocol::send(msg_v4);
-			broadcast(nullptr, raw_msg, raw_msg_v4);
+			broadcast(nullptr, std::move(raw_msg), std::move(raw_msg_v4));
 			advance_long_poll();
 		}
 	} catch (const ConsensusErrorOutputDoesNotExist &ex) {
@@ -829,22 +1290,7 @@ void Node::submit_block(const BinaryArray &blockblob, api::BlockHeader *info) {
 	}
 	for (auto who : m_broadcast_protocols)
 		who->advance_transactions();
-	p2p::RelayBlock::Notify msg;
-	msg.b                         = std::move(raw_block);  // RawBlockLegacy{raw_block.block, raw_block.transactions};
-	msg.hop                       = 1;
-	msg.current_blockchain_height = m_block_chain.get_tip_height();
-	msg.top_id                    = m_block_chain.get_tip_bid();
-	p2p::RelayBlock::Notify msg_v4;
-	msg_v4.b.block                   = msg.b.block;
-	msg_v4.current_blockchain_height = msg.current_blockchain_height;
-	msg_v4.top_id                    = msg.top_id;
-	msg_v4.hop                       = msg.hop;
-
-	msg.top_id = Hash{};  // TODO - uncomment after 3.4 fork. This is workaround of bug in 3.2
-
-	BinaryArray raw_msg    = LevinProtocol::send(msg);
-	BinaryArray raw_msg_v4 = LevinProtocol::send(msg_v4);
-	broadcast(nullptr, raw_msg, raw_msg_v4);
+	broadcast_block(nullptr, raw_block, *info);
 	advance_long_poll();
 }
 
@@ -9,6 +9,8 @@
 #include <mutex>
 #include <thread>
 #include "BlockChainState.hpp"
+#include "CompactBlock.hpp"
+#include "DownloadWindow.hpp"
 #include "http/BinaryRpc.hpp"
 #include "http/JsonRpc.hpp"
 #include "p2p/P2P.hpp"
@@ -31,6 +33,18 @@ public:
 	typedef std::function<bool(Node *, http::Client *, common::IInputStream &, json_rpc::Request &&, std::string &)>
 	    BINARYRPCHandlerFunction;
 
+	// RPC worker handlers see committed DB state through reader and status as of request arrival. They return
+	// false if they cannot answer from committed state (block not committed yet, etc.), then main thread answers
+	struct RPCWorkerContext {
+		const BlockChainReader &block_chain;
+		const Config &config;
+		const api::cnd::GetStatus::Response &status;
+	};
+	typedef std::function<bool(const RPCWorkerContext &, json_rpc::Request &&, std::string &)>
+	    JSONRPCWorkerHandlerFunction;
+	typedef std::function<bool(const RPCWorkerContext &, common::IInputStream &, json_rpc::Request &&, std::string &)>
+	    BINARYRPCWorkerHandlerFunction;
+
 	explicit Node(logging::ILogger &, const Config &, BlockChainState &);
 	~Node();
 	bool on_idle();
@@ -38,6 +52,16 @@ public:
 	// binary method
 	bool on_sync_blocks(http::Client *, http::RequestBody &&, json_rpc::Request &&, api::cnd::SyncBlocks::Request &&,
 	    api::cnd::SyncBlocks::Response &);
+	// Streams stored block bytes into response without building SyncBlocks::Response, blocks are cached
+	bool on_sync_blocks_binary(http::Client *, common::IInputStream &, json_rpc::Request &&, std::string &);
+	// Both write the same api::RawBlock binary (write_sync_block never includes signatures)
+	// Chain is BlockChainState or BlockChainReader
+	template<typename Chain>
+	static void fill_sync_block(const Chain &, const Hash &bid, Height height, bool need_redundant_data,
+	    bool need_signatures, api::RawBlock *);
+	template<typename Chain>
+	static void write_sync_block(
+	    const Chain &, const Hash &bid, Height height, bool need_redundant_data, common::IOutputStream &);
 	bool on_sync_mempool(http::Client *, http::RequestBody &&, json_rpc::Request &&, api::cnd::SyncMemPool::Request &&,
 	    api::cnd::SyncMemPool::Response &);
 
@@ -80,8 +104,8 @@ public:
 	bool on_get_block_header_by_height(http::Client *, http::RequestBody &&, json_rpc::Request &&,
 	    api::cnd::GetBlockHeaderByHeightLegacy::Request &&, api::cnd::GetBlockHeaderByHeightLegacy::Response &);
 
-	bool on_json_rpc(http::Client *, http::RequestBody &&, http::ResponseBody &);
-	bool on_binary_rpc(http::Client *, http::RequestBody &&, http::ResponseBody &);
+	bool on_json_rpc(http::Client *, http::RequestBody &&, http::ResponseBody &, bool allow_workers = true);
+	bool on_binary_rpc(http::Client *, http::RequestBody &&, http::ResponseBody &, bool allow_workers = true);
 
 	BlockChainState &m_block_chain;
 	const Config &m_config;
@@ -98,6 +122,41 @@ protected:
 	std::list<LongPollClient> m_long_poll_http_clients;
 	void advance_long_poll();
 
+	// Read-only methods are written once for main thread (BlockChainState) and RPC workers (BlockChainReader)
+	template<typename Chain>
+	static std::vector<Hash> get_sync_blocks_chain(
+	    const Chain &, const Config &, api::cnd::SyncBlocks::Request &req, Height *start_height);
+	template<typename Chain>
+	static void write_sync_blocks(const Chain &, const std::vector<Hash> &subchain, Height start_height,
+	    const api::cnd::SyncBlocks::Request &req, common::IOutputStream &);
+	template<typename Chain>
+	static void sync_blocks(
+	    const Chain &, const Config &, api::cnd::SyncBlocks::Request &&, api::cnd::SyncBlocks::Response &);
+	template<typename Chain>
+	static void get_raw_block(const Chain &, api::cnd::GetRawBlock::Request &&, api::cnd::GetRawBlock::Response &);
+	template<typename Chain>
+	static void get_block_header(
+	    const Chain &, api::cnd::GetBlockHeader::Request &&, api::cnd::GetBlockHeader::Response &);
+	template<typename Chain>
+	static bool get_raw_transaction_in_chain(
+	    const Chain &, const api::cnd::GetRawTransaction::Request &, api::cnd::GetRawTransaction::Response &);
+	template<typename Chain>
+	static void get_random_outputs(
+	    const Chain &, api::cnd::GetRandomOutputs::Request &&, api::cnd::GetRandomOutputs::Response &);
+
+	static bool on_sync_blocks_worker(const RPCWorkerContext &, api::cnd::SyncBlocks::Request &&,
+	    api::cnd::SyncBlocks::Response &);
+	static bool on_sync_blocks_binary_worker(
+	    const RPCWorkerContext &, common::IInputStream &, json_rpc::Request &&, std::string &);
+	static bool on_get_raw_block_worker(
+	    const RPCWorkerContext &, api::cnd::GetRawBlock::Request &&, api::cnd::GetRawBlock::Response &);
+	static bool on_get_block_header_worker(
+	    const RPCWorkerContext &, api::cnd::GetBlockHeader::Request &&, api::cnd::GetBlockHeader::Response &);
+	static bool on_get_raw_transaction_worker(const RPCWorkerContext &, api::cnd::GetRawTransaction::Request &&,
+	    api::cnd::GetRawTransaction::Response &);
+	static bool on_get_random_outputs_worker(
+	    const RPCWorkerContext &, api::cnd::GetRandomOutputs::Request &&, api::cnd::GetRandomOutputs::Response &);
+
 	bool m_block_chain_was_far_behind;
 	logging::LoggerRef m_log;
 	PeerDB m_peer_db;
@@ -109,6 +168,8 @@ protected:
 
 	const Timestamp m_start_time;
 	platform::Timer m_commit_timer;
+	platform::Timer m_rpc_workers_commit_timer;
+	bool m_rpc_workers_commit_pending = false;
 	void db_commit();
 
 	bool check_trust(const p2p::ProofOfTrust &);
@@ -140,6 +201,22 @@ protected:
 		std::deque<std::map<Hash, DownloadInfo>::iterator> m_chain;
 		size_t m_chain_start_height = 0;
 
+		// With P2PCapability::BLOCK_RANGES, blocks in flight are limited by window instead of config constant
+		DownloadWindow m_download_window;
+		struct RangeRequest {
+			std::vector<Hash> bids;
+			size_t delivered_at_send = 0;
+			std::chrono::steady_clock::time_point sent;
+		};
+		std::deque<RangeRequest> m_range_requests;  // peer answers in order
+		bool get_downloaded_block_hash(const RawBlock &rb, Hash *bid);  // disconnects if block cannot be parsed
+		void block_downloaded(std::map<Hash, DownloadInfo>::iterator cit, RawBlock &&rb);
+
+		// Relayed compact block waiting for transactions we asked peer for, blocks relayed meanwhile are downloaded
+		std::unique_ptr<CompactBlock> m_compact_block;
+		void compact_block_complete(bool transactions_from_peer);
+		void add_relayed_block(RawBlock &&raw_block, const Hash &top_id, Height height, bool check_claims);
+
 		bool m_syncpool_equest_sent = false;
 		std::pair<Amount, Hash> syncpool_start{std::numeric_limits<Amount>::max(), Hash{}};
 		size_t m_downloading_transaction_count = 0;
@@ -149,6 +226,7 @@ protected:
 		void on_syncpool_timer();
 		void on_download_transactions_timer();
 		void transaction_download_finished(const Hash &tid, bool success);
+		void start_speculative_checks();
 		bool on_transaction_descs(const std::vector<TransactionDesc> &descs);
 
 	protected:
@@ -165,12 +243,17 @@ protected:
 		void on_msg_notify_request_chain(p2p::GetChainResponse::Notify &&) override;
 		void on_msg_notify_request_objects(p2p::GetObjectsRequest::Notify &&) override;
 		void on_msg_notify_request_objects(p2p::GetObjectsResponse::Notify &&) override;
+		void on_msg_request_block_range(p2p::GetBlockRange::Request &&) override;
+		void on_msg_request_block_range(p2p::GetBlockRange::Response &&) override;
 		void on_msg_notify_request_tx_pool(p2p::SyncPool::Notify &&) override;
 		void on_msg_notify_request_tx_pool(p2p::SyncPool::Request &&) override;
 		void on_msg_notify_request_tx_pool(p2p::SyncPool::Response &&) override;
 		void on_msg_timed_sync(p2p::TimedSync::Request &&) override;
 		void on_msg_timed_sync(p2p::TimedSync::Response &&) override;
 		void on_msg_notify_new_block(p2p::RelayBlock::Notify &&) override;
+		void on_msg_notify_new_block(p2p::RelayCompactBlock::Notify &&) override;
+		void on_msg_request_block_transactions(p2p::GetBlockTransactions::Request &&) override;
+		void on_msg_request_block_transactions(p2p::GetBlockTransactions::Response &&) override;
 		void on_msg_notify_new_transactions(p2p::RelayTransactions::Notify &&) override;
 		void on_msg_notify_checkpoint(p2p::Checkpoint::Notify &&) override;
 #if bytecoin_ALLOW_DEBUG_COMMANDS
@@ -194,18 +277,34 @@ protected:
 
 	void advance_all_downloads();
 	std::set<P2PProtocolBytecoin *> m_broadcast_protocols;
+	size_t m_compact_blocks_received              = 0;
+	size_t m_compact_blocks_reconstructed         = 0;
+	size_t m_compact_block_transactions_requested = 0;
 
 	BlockPreparatorMulticore m_pow_checker;
-	// TODO - periodically clear m_pow_checker of blocks that were not asked
 
-	void broadcast(P2PProtocolBytecoin *exclude, const BinaryArray &data);
-	void broadcast(P2PProtocolBytecoin *exclude, const BinaryArray &data_v1, const BinaryArray &data_v4);
+	// Message is serialized once, all peers queue the same shared buffer
+	void broadcast(P2PProtocolBytecoin *exclude, BinaryArray &&data);
+	void broadcast(P2PProtocolBytecoin *exclude, BinaryArray &&data_v1, BinaryArray &&data_v4);
+	// Full block to V1 peers, header to V4 peers, compact block to V5 peers
+	void broadcast_block(P2PProtocolBytecoin *exclude, const RawBlock &raw_block, const api::BlockHeader &info);
 
 	bool on_api_http_request(http::Client *, http::RequestBody &&, http::ResponseBody &);
 	void on_api_http_disconnect(http::Client *);
 
 	static std::unordered_map<std::string, JSONRPCHandlerFunction> m_jsonrpc_handlers;
 	static const std::unordered_map<std::string, BINARYRPCHandlerFunction> m_binaryrpc_handlers;
+
+	// Workers are started only if config.rpc_worker_threads != 0. Requests go to workers only when
+	// committed tip is the same as main thread tip, so answers do not depend on who answered
+	class RPCWorkers;
+	std::unique_ptr<RPCWorkers> m_rpc_workers;
+	bool can_use_rpc_workers() const;
+	// Moves request into worker queue and returns true if request will be answered by worker
+	bool add_rpc_worker_job(http::Client *, http::RequestBody &&, json_rpc::Request &&, bool binary);
+	void write_rpc_worker_results();
+	static const std::unordered_map<std::string, JSONRPCWorkerHandlerFunction> m_jsonrpc_worker_handlers;
+	static const std::unordered_map<std::string, BINARYRPCWorkerHandlerFunction> m_binaryrpc_worker_handlers;
 };
 
 }  // namespace cn
@@ -16,7 +16,8 @@
 
 using namespace cn;
 
-bool Node::on_json_rpc(http::Client *who, http::RequestBody &&request, http::ResponseBody &response) {
+bool Node::on_json_rpc(
+    http::Client *who, http::RequestBody &&request, http::ResponseBody &response, bool allow_workers) {
 	response.r.headers.push_back({"Content-Type", "application/json; charset=utf-8"});
 
 	common::JsonValue jid(nullptr);
@@ -34,6 +35,8 @@ bool Node::on_json_rpc(http::Client *who, http::RequestBody &&request, http::Res
 				        " (attempt to call walletd method on " CRYPTONOTE_NAME "d)");
 			throw json_rpc::Error(json_rpc::METHOD_NOT_FOUND, "Method not found " + json_req.get_method());
 		}
+		if (allow_workers && add_rpc_worker_job(who, std::move(request), std::move(json_req), false))
+			return false;
 		std::string response_body;
 		if (!it->second(this, who, std::move(request), std::move(json_req), response_body))
 			return false;
@@ -48,7 +51,8 @@ bool Node::on_json_rpc(http::Client *who, http::RequestBody &&request, http::Res
 	return true;
 }
 
-bool Node::on_binary_rpc(http::Client *who, http::RequestBody &&request, http::ResponseBody &response) {
+bool Node::on_binary_rpc(
+    http::Client *who, http::RequestBody &&request, http::ResponseBody &response, bool allow_workers) {
 	response.r.headers.push_back({"Content-Type", "application/octet-stream"});
 
 	common::JsonValue jid(nullptr);
@@ -66,6 +70,8 @@ bool Node::on_binary_rpc(http::Client *who, http::RequestBody &&request, http::R
 			m_log(logging::INFO) << "binaryrpc request method not found - " << binary_req.get_method() << std::endl;
 			throw json_rpc::Error(json_rpc::METHOD_NOT_FOUND, "Method not found " + binary_req.get_method());
 		}
+		if (allow_workers && add_rpc_worker_job(who, std::move(request), std::move(binary_req), true))
+			return false;
 		std::string response_body;
 		if (!it->second(this, who, body_stream, std::move(binary_req), response_body))
 			return false;
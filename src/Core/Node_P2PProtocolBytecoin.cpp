@@ -17,11 +17,19 @@
 
 using namespace cn;
 
+static const size_t MIN_DOWNLOAD_WINDOW = 16;  // Request of 1/4 of it should still have several blocks
+
+static DownloadWindow create_download_window(const Config &config) {
+	return DownloadWindow(
+	    MIN_DOWNLOAD_WINDOW, config.download_range_max_blocks, config.max_downloading_blocks_from_each_peer);
+}
+
 Node::P2PProtocolBytecoin::P2PProtocolBytecoin(Node *node, P2PClient *client)
     : P2PProtocolBasic(node->m_config, node->m_p2p.get_unique_number(), client)
     , m_node(node)
     , m_chain_timer(std::bind(&P2PProtocolBytecoin::on_chain_timer, this))
     , m_download_timer(std::bind(&P2PProtocolBytecoin::on_download_timer, this))
+    , m_download_window(create_download_window(node->m_config))
     , m_syncpool_timer(std::bind(&P2PProtocolBytecoin::on_syncpool_timer, this))
     , m_download_transactions_timer(std::bind(&P2PProtocolBytecoin::on_download_transactions_timer, this)) {}
 
@@ -123,12 +131,21 @@ void Node::P2PProtocolBytecoin::advance_blocks() {
 		m_node->remove_chain_block(m_chain.front());
 		m_chain.pop_front();
 	}
-	if (m_downloading_block_count == m_node->m_config.max_downloading_blocks_from_each_peer)
+	const bool block_ranges = has_capability(P2PCapability::BLOCK_RANGES);
+	const size_t max_downloading_blocks =
+	    block_ranges ? m_download_window.get_window() : m_node->m_config.max_downloading_blocks_from_each_peer;
+	if (m_downloading_block_count >= max_downloading_blocks)
 		return;
+	if (m_node->m_pow_checker.is_saturated())
+		return;  // We will be called from on_idle when blocks are taken from preparator
+	const size_t max_range_size =
+	    std::min<size_t>(m_download_window.get_batch(), p2p::GetBlockRange::Request::MAX_BLOCK_COUNT);
 	size_t we_downloading = 0;
 	std::vector<Hash> request_block_ids;
-	for (size_t i = 0; i < std::min(m_chain.size(), m_node->m_config.download_window) &&
-	                   we_downloading < m_node->m_config.max_downloading_blocks_from_each_peer;
+	std::vector<std::vector<Hash>> request_ranges;  // consecutive blocks in m_chain
+	size_t previous_index = 0;
+	for (size_t i = 0;
+	     i < std::min(m_chain.size(), m_node->m_config.download_window) && we_downloading < max_downloading_blocks;
 	     ++i) {
 		auto cit = m_chain.at(i);
 		if (cit->second.who_downloading || cit->second.preparing) {
@@ -140,6 +157,10 @@ void Node::P2PProtocolBytecoin::advance_blocks() {
 		cit->second.expected_height = static_cast<Height>(m_chain_start_height + i);
 		m_downloading_block_count += 1;
 		request_block_ids.push_back(cit->first);
+		if (request_ranges.empty() || previous_index + 1 != i || request_ranges.back().size() == max_range_size)
+			request_ranges.emplace_back();
+		request_ranges.back().push_back(cit->first);
+		previous_index = i;
 		const auto now = std::chrono::steady_clock::now();
 		if (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_node->log_request_timestamp).count() > 1000) {
 			m_node->log_request_timestamp = now;
@@ -150,6 +171,17 @@ void Node::P2PProtocolBytecoin::advance_blocks() {
 	}
 	if (!request_block_ids.empty())
 		m_download_timer.once(m_node->m_config.download_block_timeout);
+	if (block_ranges) {
+		for (auto &&range : request_ranges) {
+			p2p::GetBlockRange::Request msg;
+			msg.start_bid = range.front();
+			msg.count     = static_cast<uint32_t>(range.size());
+			m_range_requests.push_back(
+			    RangeRequest{std::move(range), m_download_window.get_delivered(), std::chrono::steady_clock::now()});
+			send(LevinProtocol::send(msg));
+		}
+		return;
+	}
 	for (const auto &bid : request_block_ids) {
 		p2p::GetObjectsRequest::Notify msg;
 		msg.blocks.push_back(bid);
@@ -164,10 +196,10 @@ void Node::P2PProtocolBytecoin::advance_transactions() {
 		if (m_syncpool_equest_sent)
 			return;  // We will never reset m_syncpool_equest_sent on V1 connection
 		p2p::SyncPool::Notify msg;
-		auto mytxs = m_node->m_block_chain.get_memory_state_transactions();
+		const auto mytxs = m_node->m_block_chain.get_memory_state_transactions().get_sorted_by_hash();
 		msg.txs.reserve(mytxs.size());
-		for (auto &&tx : mytxs)
-			msg.txs.push_back(tx.first);
+		for (auto &&tit : mytxs)
+			msg.txs.push_back(tit->first);
 		m_syncpool_equest_sent = true;
 		send(LevinProtocol::send(msg));
 		return;
@@ -263,6 +295,7 @@ bool Node::P2PProtocolBytecoin::on_idle(std::chrono::steady_clock::time_point id
 		const Height expected_height = cit->second.expected_height;
 		cit->second.preparing        = false;
 		m_node->remove_chain_block(cit);
+		start_speculative_checks();
 
 		api::BlockHeader info;
 		bool add_block_result = false;
@@ -293,7 +326,7 @@ bool Node::P2PProtocolBytecoin::on_idle(std::chrono::steady_clock::time_point id
 				    CoreSyncData{m_node->m_block_chain.get_tip_height(), m_node->m_block_chain.get_tip_bid()};
 				BinaryArray raw_msg = LevinProtocol::send(req);
 				m_node->broadcast(
-				    nullptr, raw_msg);  // nullptr - we can not always know which connection was block source
+				    nullptr, std::move(raw_msg));  // nullptr - we can not always know which connection was block source
 			}
 		}
 		added_counter += 1;
@@ -305,6 +338,20 @@ bool Node::P2PProtocolBytecoin::on_idle(std::chrono::steady_clock::time_point id
 	return !m_chain.empty() && m_node->m_pow_checker.has_prepared_block(m_chain.front()->first);
 }
 
+void Node::P2PProtocolBytecoin::start_speculative_checks() {
+	// Worker threads check signatures of next blocks while we apply current one
+	const size_t depth = std::min(m_chain.size(), m_node->m_config.ring_checker_pipeline_blocks);
+	for (size_t i = 0; i != depth; ++i) {
+		auto cit = m_chain.at(i);
+		if (!m_node->m_block_chain.wants_speculative_check(cit->first, cit->second.expected_height))
+			continue;
+		Block block;
+		if (!m_node->m_pow_checker.peek_prepared_block(cit->first, &block))
+			break;
+		m_node->m_block_chain.start_speculative_check(cit->first, block, cit->second.expected_height);
+	}
+}
+
 void Node::P2PProtocolBytecoin::after_handshake() {
 	m_node->m_p2p.peers_updated();
 	m_node->m_broadcast_protocols.insert(this);
@@ -432,17 +479,8 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_objects(p2p::GetObjectsRes
 		return disconnect("Too much transactions in GetObjectsResponse");
 	for (auto &&rb : req.blocks) {
 		Hash bid;
-		try {
-			BlockTemplate bheader;
-			seria::from_binary(bheader, rb.block);
-			auto body_proxy = get_body_proxy_from_template(bheader);
-			bid             = cn::get_block_hash(bheader, body_proxy);
-		} catch (const std::exception &ex) {
-			m_node->m_log(logging::INFO) << "Exception " << common::what(ex)
-			                             << " while parsing returned block, banning " << get_address() << std::endl;
-			disconnect("Bad Block Returned");
+		if (!get_downloaded_block_hash(rb, &bid))
 			return;
-		}
 		auto cit = m_node->chain_blocks.find(bid);
 		if (cit == m_node->chain_blocks.end() || cit->second.who_downloading != this) {
 			m_node->m_log(logging::INFO) << "GetObjectsResponse received stray block from " << get_address()
@@ -450,15 +488,7 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_objects(p2p::GetObjectsRes
 			disconnect("Stray Block Returned");
 			return;
 		}
-		cit->second.who_downloading = nullptr;
-		cit->second.preparing       = true;
-		invariant(m_downloading_block_count > 0, "");
-		m_downloading_block_count -= 1;
-		m_node->m_log(logging::TRACE) << "GetObjectsResponse received block " << cit->second.expected_height
-		                              << " hash=" << cit->first << " from " << get_address() << std::endl;
-		bool check_pow = m_node->m_config.paranoid_checks ||
-		                 !m_node->m_block_chain.get_currency().is_in_hard_checkpoint_zone(cit->second.expected_height);
-		m_node->m_pow_checker.add_block(bid, check_pow, std::move(rb));
+		block_downloaded(cit, std::move(rb));
 	}
 	p2p::RelayTransactions::Notify msg;
 	p2p::RelayTransactions::Notify msg_v4;
@@ -552,13 +582,122 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_objects(p2p::GetObjectsRes
 			msg_v4.transaction_descs.resize(p2p::RelayTransactions::Notify::MAX_DESC_COUNT);
 		BinaryArray raw_msg_v4 = LevinProtocol::send(msg_v4);
 
-		m_node->broadcast(this, raw_msg, raw_msg_v4);
+		m_node->broadcast(this, std::move(raw_msg), std::move(raw_msg_v4));
 		m_node->advance_long_poll();
 	}
 	if (!req.blocks.empty())
 		advance_blocks();
 }
 
+bool Node::P2PProtocolBytecoin::get_downloaded_block_hash(const RawBlock &rb, Hash *bid) {
+	try {
+		BlockTemplate bheader;
+		seria::from_binary(bheader, rb.block);
+		auto body_proxy = get_body_proxy_from_template(bheader);
+		*bid            = cn::get_block_hash(bheader, body_proxy);
+	} catch (const std::exception &ex) {
+		m_node->m_log(logging::INFO) << "Exception " << common::what(ex) << " while parsing returned block, banning "
+		                             << get_address() << std::endl;
+		disconnect("Bad Block Returned");
+		return false;
+	}
+	return true;
+}
+
+void Node::P2PProtocolBytecoin::block_downloaded(std::map<Hash, DownloadInfo>::iterator cit, RawBlock &&rb) {
+	cit->second.who_downloading = nullptr;
+	cit->second.preparing       = true;
+	invariant(m_downloading_block_count > 0, "");
+	m_downloading_block_count -= 1;
+	m_node->m_log(logging::TRACE) << "Received block " << cit->second.expected_height << " hash=" << cit->first
+	                              << " from " << get_address() << std::endl;
+	bool check_pow = m_node->m_config.paranoid_checks ||
+	                 !m_node->m_block_chain.get_currency().is_in_hard_checkpoint_zone(cit->second.expected_height);
+	if (!m_node->m_pow_checker.add_block(cit->first, check_pow, std::move(rb))) {
+		m_node->m_log(logging::TRACE) << "Block preparator queue full, dropped block " << cit->second.expected_height
+		                              << " hash=" << cit->first << std::endl;
+		cit->second.preparing = false;  // Will be downloaded again
+		if (cit->second.chain_counter == 0)
+			m_node->chain_blocks.erase(cit);
+	}
+}
+
+void Node::P2PProtocolBytecoin::on_msg_request_block_range(p2p::GetBlockRange::Request &&req) {
+	if (!has_capability(P2PCapability::BLOCK_RANGES))
+		return disconnect("GetBlockRange without capability");
+	if (req.count == 0 || req.count > p2p::GetBlockRange::Request::MAX_BLOCK_COUNT)
+		return disconnect("GetBlockRange wrong count");
+	p2p::GetBlockRange::Response msg;
+	msg.start_bid = req.start_bid;
+	api::BlockHeader info;
+	if (m_node->m_block_chain.get_header(req.start_bid, &info) &&
+	    m_node->m_block_chain.in_chain(info.height, req.start_bid)) {
+		size_t total_size = 0;
+		Hash bid;
+		for (Height ha = info.height; ha - info.height != req.count && m_node->m_block_chain.get_chain(ha, &bid);
+		     ++ha) {
+			RawBlock raw_block;
+			invariant(m_node->m_block_chain.get_block(bid, &raw_block), "");
+			size_t size = raw_block.block.size() + 64;  // KV overhead estimate
+			for (const auto &tx : raw_block.transactions)
+				size += tx.size() + 8;
+			if (!msg.blocks.empty() && total_size + size > p2p::GetBlockRange::Response::MAX_BLOCKS_SIZE)
+				break;
+			total_size += size;
+			msg.blocks.push_back(std::move(raw_block));
+		}
+	}
+	send(LevinProtocol::send(msg));
+}
+
+void Node::P2PProtocolBytecoin::on_msg_request_block_range(p2p::GetBlockRange::Response &&req) {
+	if (!has_capability(P2PCapability::BLOCK_RANGES))
+		return disconnect("GetBlockRange without capability");
+	if (m_range_requests.empty() || m_range_requests.front().bids.front() != req.start_bid)
+		return disconnect("GetBlockRange stray response");
+	if (req.blocks.size() > m_range_requests.front().bids.size())
+		return disconnect("GetBlockRange too much blocks");
+	const RangeRequest range = std::move(m_range_requests.front());
+	m_range_requests.pop_front();
+	size_t received_count = 0;
+	size_t received_size  = 0;
+	for (auto &&rb : req.blocks) {
+		Hash bid;
+		if (!get_downloaded_block_hash(rb, &bid))
+			return;
+		if (bid != range.bids.at(received_count))
+			break;  // Peer switched to another chain after sending us its chain
+		auto cit = m_node->chain_blocks.find(bid);
+		if (cit == m_node->chain_blocks.end() || cit->second.who_downloading != this)
+			return disconnect("Stray Block Returned");
+		received_size += rb.block.size();
+		for (const auto &tx : rb.transactions)
+			received_size += tx.size();
+		block_downloaded(cit, std::move(rb));
+		received_count += 1;
+	}
+	for (size_t i = received_count; i != range.bids.size(); ++i) {  // Will be requested again
+		auto cit = m_node->chain_blocks.find(range.bids.at(i));
+		if (cit != m_node->chain_blocks.end() && cit->second.who_downloading == this) {
+			cit->second.who_downloading = nullptr;
+			m_downloading_block_count -= 1;
+		}
+	}
+	m_download_window.on_response(
+	    received_count, received_size, range.delivered_at_send, range.sent, std::chrono::steady_clock::now());
+	m_node->m_log(logging::TRACE) << "GetBlockRange received " << received_count << " of " << range.bids.size()
+	                              << " blocks from " << get_address() << " window=" << m_download_window.get_window()
+	                              << " throughput=" << m_download_window.get_throughput()
+	                              << " latency=" << m_download_window.get_latency() << std::endl;
+	if (m_downloading_block_count != 0)
+		m_download_timer.once(m_node->m_config.download_block_timeout);
+	else
+		m_download_timer.cancel();
+	if (received_count == 0)  // Peer has no blocks from chain it sent us, probably reorganized
+		return disconnect(std::string());
+	advance_blocks();
+}
+
 void Node::P2PProtocolBytecoin::on_disconnect(const std::string &ban_reason) {
 	m_node->m_broadcast_protocols.erase(this);
 
@@ -573,6 +712,9 @@ void Node::P2PProtocolBytecoin::on_disconnect(const std::string &ban_reason) {
 		m_node->remove_chain_block(cit);
 	}
 	m_chain.clear();
+	m_range_requests.clear();
+	m_compact_block.reset();
+	m_download_window = create_download_window(m_node->m_config);
 	m_download_timer.cancel();
 	invariant(m_downloading_block_count == 0, "");
 
@@ -599,15 +741,15 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_tx_pool(p2p::SyncPool::Not
 	if (get_peer_version() >= P2PProtocolVersion::AMETHYST)
 		return disconnect("SyncPool notify not allowed in V4");
 	p2p::RelayTransactions::Notify msg;
-	auto mytxs = m_node->m_block_chain.get_memory_state_transactions();
+	const auto mytxs = m_node->m_block_chain.get_memory_state_transactions().get_sorted_by_hash();
 	msg.txs.reserve(mytxs.size());
 	std::sort(req.txs.begin(), req.txs.end());  // Should have been sorted on wire,
 	                                            // checked here, but alas, legacy
-	for (auto &&tx : mytxs) {
-		auto it = std::lower_bound(req.txs.begin(), req.txs.end(), tx.first);
-		if (it != req.txs.end() && *it == tx.first)
+	for (auto &&tit : mytxs) {
+		auto it = std::lower_bound(req.txs.begin(), req.txs.end(), tit->first);
+		if (it != req.txs.end() && *it == tit->first)
 			continue;
-		msg.txs.push_back(tx.second.binary_tx);
+		msg.txs.push_back(tit->second.binary_tx);
 	}
 	m_node->m_log(logging::TRACE) << "on_msg_notify_request_tx_pool from " << get_address()
 	                              << " peer sent=" << req.txs.size() << " we are relaying=" << msg.txs.size()
@@ -679,30 +821,113 @@ void Node::P2PProtocolBytecoin::on_msg_notify_new_block(p2p::RelayBlock::Notify
 		}
 		// We reassembled full block, can now broadcast it to V1 or V4 clients
 	}
-	PreparedBlock pb{RawBlock{req.b}, m_node->m_block_chain.get_currency(), nullptr};
-	if (get_peer_version() >= P2PProtocolVersion::AMETHYST && req.top_id != pb.bid)
+	add_relayed_block(std::move(req.b), req.top_id, req.current_blockchain_height,
+	    get_peer_version() >= P2PProtocolVersion::AMETHYST);
+}
+
+void Node::P2PProtocolBytecoin::add_relayed_block(
+    RawBlock &&raw_block, const Hash &top_id, Height height, bool check_claims) {
+	PreparedBlock pb{std::move(raw_block), m_node->m_block_chain.get_currency(), nullptr};
+	if (check_claims && top_id != pb.bid)
 		return disconnect("RelayBlock lied about top_id");
 	api::BlockHeader info;
 	// We'll catch consensus error automatically in common handler
 	if (m_node->m_block_chain.add_block(pb, &info, get_address().to_string())) {
-		if (get_peer_version() >= P2PProtocolVersion::AMETHYST && req.current_blockchain_height != info.height)
+		if (check_claims && height != info.height)
 			return disconnect("RelayBlock lied about current_blockchain_height");
 		set_peer_sync_data(CoreSyncData{info.height, pb.bid});
-		p2p::RelayBlock::Notify req_v4;
-		req_v4.b.block = req.b.block;
-		req_v4.top_id = req.top_id       = info.hash;
-		req_v4.current_blockchain_height = req.current_blockchain_height = info.height;
-		req_v4.hop = req.hop = 1;  // req.hop + 1; Do not do that, hop count allows tracking block origin
-
-		req.top_id = Hash{};  // TODO - uncomment after 3.4 fork. Workaround for 3.2 bug
-
-		BinaryArray raw_msg    = LevinProtocol::send(req);
-		BinaryArray raw_msg_v4 = LevinProtocol::send(req_v4);
-		m_node->broadcast(this, raw_msg, raw_msg_v4);
+		m_node->broadcast_block(this, pb.raw_block, info);
 		m_node->advance_long_poll();
 	} else {
-		set_peer_sync_data(CoreSyncData{req.current_blockchain_height, pb.bid});
+		set_peer_sync_data(CoreSyncData{height, pb.bid});
+	}
+}
+
+void Node::P2PProtocolBytecoin::on_msg_notify_new_block(p2p::RelayCompactBlock::Notify &&req) {
+	if (get_common_version() < P2PProtocolVersion::COMPACT_BLOCKS)
+		return disconnect("RelayCompactBlock not negotiated");
+	if (m_node->m_block_chain.has_header(req.top_id))
+		return;
+	// Checks top_id against header, so pool is not scanned for made up blocks. We'll catch errors in common handler
+	auto compact_block = std::make_unique<CompactBlock>(std::move(req));
+	if (m_compact_block && m_node->m_block_chain.has_header(m_compact_block->get_bid()))
+		m_compact_block.reset();  // Got it from another peer meanwhile
+	if (m_compact_block) {  // Peer should wait for our GetBlockTransactions, will download block normally
+		set_peer_sync_data(CoreSyncData{compact_block->get_height(), compact_block->get_bid()});
+		advance_chain();
+		return;
+	}
+	api::BlockHeader previous;
+	if (!m_node->m_block_chain.get_header(compact_block->get_header().previous_block_hash, &previous)) {
+		set_peer_sync_data(CoreSyncData{compact_block->get_height(), compact_block->get_bid()});
+		advance_chain();  // We are behind, will download block normally
+		return;
+	}
+	if (compact_block->get_height() != previous.height + 1)
+		return disconnect("RelayCompactBlock lied about current_blockchain_height");
+	m_compact_block = std::move(compact_block);
+	m_node->m_compact_blocks_received += 1;
+	m_compact_block->fill_from_pool(m_node->m_block_chain.get_memory_state_transactions());
+	m_node->m_log(logging::TRACE) << "RelayCompactBlock height=" << m_compact_block->get_height()
+	                              << " bid=" << m_compact_block->get_bid()
+	                              << " transactions=" << m_compact_block->get_transaction_count()
+	                              << " missing=" << m_compact_block->get_missing().size() << " from "
+	                              << get_address() << std::endl;
+	if (m_compact_block->get_missing().empty())
+		return compact_block_complete(false);
+	p2p::GetBlockTransactions::Request msg;
+	msg.top_id  = m_compact_block->get_bid();
+	msg.indexes = m_compact_block->get_missing();
+	m_node->m_compact_block_transactions_requested += msg.indexes.size();
+	send(LevinProtocol::send(msg));
+}
+
+void Node::P2PProtocolBytecoin::compact_block_complete(bool transactions_from_peer) {
+	const auto compact_block = std::move(m_compact_block);
+	RawBlock raw_block;
+	if (!compact_block->get_block(&raw_block)) {
+		// Transactions peer sent us were checked against short ids, so with 48-bit salted short ids only liar gets here
+		if (transactions_from_peer)
+			return disconnect("GetBlockTransactions transactions do not match merkle root");
+		// Short id collision with pool transaction, will download block normally
+		set_peer_sync_data(CoreSyncData{compact_block->get_height(), compact_block->get_bid()});
+		advance_chain();
+		return;
+	}
+	m_node->m_compact_blocks_reconstructed += 1;
+	add_relayed_block(std::move(raw_block), compact_block->get_bid(), compact_block->get_height(), true);
+}
+
+void Node::P2PProtocolBytecoin::on_msg_request_block_transactions(p2p::GetBlockTransactions::Request &&req) {
+	if (get_common_version() < P2PProtocolVersion::COMPACT_BLOCKS)
+		return disconnect("GetBlockTransactions not negotiated");
+	p2p::GetBlockTransactions::Response msg;
+	msg.top_id = req.top_id;
+	RawBlock raw_block;
+	if (m_node->m_block_chain.get_block(req.top_id, &raw_block))
+		for (size_t i = 0; i != req.indexes.size(); ++i) {
+			const auto index = req.indexes.at(i);
+			if (index >= raw_block.transactions.size() || (i != 0 && index <= req.indexes.at(i - 1)))
+				return disconnect("GetBlockTransactions wrong index");  // Also protects from moving twice
+			msg.transactions.push_back(std::move(raw_block.transactions.at(index)));
+		}
+	send(LevinProtocol::send(msg));
+}
+
+void Node::P2PProtocolBytecoin::on_msg_request_block_transactions(p2p::GetBlockTransactions::Response &&req) {
+	if (get_common_version() < P2PProtocolVersion::COMPACT_BLOCKS)
+		return disconnect("GetBlockTransactions not negotiated");
+	if (!m_compact_block || m_compact_block->get_bid() != req.top_id)
+		return;  // We got next compact block before answer
+	if (req.transactions.empty()) {  // Peer switched to another chain, will download block normally
+		set_peer_sync_data(CoreSyncData{m_compact_block->get_height(), m_compact_block->get_bid()});
+		m_compact_block.reset();
+		advance_chain();
+		return;
 	}
+	if (!m_compact_block->add_missing(req.transactions))
+		return disconnect("GetBlockTransactions wrong transactions");
+	compact_block_complete(true);
 }
 
 void Node::P2PProtocolBytecoin::on_msg_notify_new_transactions(p2p::RelayTransactions::Notify &&req) {
@@ -757,7 +982,7 @@ void Node::P2PProtocolBytecoin::on_msg_notify_new_transactions(p2p::RelayTransac
 	if (msg_v4.transaction_descs.size() > p2p::RelayTransactions::Notify::MAX_DESC_COUNT)
 		msg_v4.transaction_descs.resize(p2p::RelayTransactions::Notify::MAX_DESC_COUNT);
 	BinaryArray raw_msg_v4 = LevinProtocol::send(msg_v4);
-	m_node->broadcast(this, raw_msg, raw_msg_v4);
+	m_node->broadcast(this, std::move(raw_msg), std::move(raw_msg_v4));
 	m_node->advance_long_poll();
 }
 
@@ -767,11 +992,11 @@ void Node::P2PProtocolBytecoin::on_msg_notify_checkpoint(p2p::Checkpoint::Notify
 	m_node->m_log(logging::INFO) << "p2p::Checkpoint::Notify height=" << req.height << " hash=" << req.hash
 	                             << " key_id=" << req.key_id << " counter=" << req.counter << std::endl;
 	BinaryArray raw_msg = LevinProtocol::send(req);
-	m_node->broadcast(nullptr, raw_msg);  // nullptr, not this - so a sender sees "reflection" of message
+	m_node->broadcast(nullptr, std::move(raw_msg));  // nullptr, not this - so a sender sees "reflection" of message
 	p2p::TimedSync::Request ts_req;
 	ts_req.payload_data = CoreSyncData{m_node->m_block_chain.get_tip_height(), m_node->m_block_chain.get_tip_bid()};
 	raw_msg             = LevinProtocol::send(ts_req);
-	m_node->broadcast(nullptr, raw_msg);
+	m_node->broadcast(nullptr, std::move(raw_msg));
 	m_node->advance_long_poll();
 }
 
@@ -0,0 +1,53 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "SyncBlocksCache.hpp"
+
+using namespace cn;
+
+const std::string *SyncBlocksCache::find(const Key &key, const Hash &last_bid) {
+	auto it = m_entries.find(key);
+	if (it == m_entries.end() || it->second.last_bid != last_bid) {
+		m_misses += 1;
+		return nullptr;
+	}
+	m_lru.splice(m_lru.begin(), m_lru, it->second.lru_it);
+	m_hits += 1;
+	m_bytes_served += it->second.data.size();
+	return &it->second.data;
+}
+
+void SyncBlocksCache::insert(const Key &key, const Hash &last_bid, std::string &&data) {
+	auto it = m_entries.find(key);
+	if (it != m_entries.end())
+		erase(it);
+	const size_t entry_size = data.size() + ENTRY_OVERHEAD;
+	if (entry_size > m_memory_budget)
+		return;
+	while (m_memory_usage + entry_size > m_memory_budget) {
+		erase(m_entries.find(m_lru.back()));
+		m_evictions += 1;
+	}
+	m_lru.push_front(key);
+	Entry &entry   = m_entries[key];
+	entry.data     = std::move(data);
+	entry.last_bid = last_bid;
+	entry.lru_it   = m_lru.begin();
+	m_memory_usage += entry_size;
+}
+
+void SyncBlocksCache::invalidate(Height height) {
+	for (auto it = m_entries.begin(); it != m_entries.end();) {
+		if (it->first.start_height + it->first.count > height) {
+			erase(it++);
+			m_invalidations += 1;
+		} else
+			++it;
+	}
+}
+
+void SyncBlocksCache::erase(std::map<Key, Entry>::iterator it) {
+	m_memory_usage -= it->second.data.size() + ENTRY_OVERHEAD;
+	m_lru.erase(it->second.lru_it);
+	m_entries.erase(it);
+}
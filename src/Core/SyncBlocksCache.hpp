@@ -0,0 +1,64 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+#include <tuple>
+#include "CryptoNote.hpp"
+
+namespace cn {
+
+// Serialized blocks part of binary sync_blocks responses. Many wallets syncing from the same node ask
+// for the same height ranges, so we build each chunk once. Chunks reference main chain by height,
+// owner must call invalidate() with lowest undone height on every reorganization.
+// Eviction is LRU within memory budget. Returned pointers are valid until next insert or invalidate.
+class SyncBlocksCache {
+public:
+	struct Key {
+		Height start_height      = 0;
+		size_t count             = 0;
+		bool need_redundant_data = false;
+		bool need_signatures     = false;
+		bool operator<(const Key &other) const {
+			return std::tie(start_height, count, need_redundant_data, need_signatures) <
+			       std::tie(other.start_height, other.count, other.need_redundant_data, other.need_signatures);
+		}
+	};
+	explicit SyncBlocksCache(size_t memory_budget) : m_memory_budget(memory_budget) {}
+
+	const std::string *find(const Key &key, const Hash &last_bid);  // last_bid guards against missed invalidation
+	void insert(const Key &key, const Hash &last_bid, std::string &&data);
+	void invalidate(Height height);  // removes chunks containing blocks at height or above
+
+	size_t size() const { return m_entries.size(); }
+	size_t memory_usage() const { return m_memory_usage; }  // estimate
+	size_t get_hits() const { return m_hits; }
+	size_t get_misses() const { return m_misses; }
+	size_t get_bytes_served() const { return m_bytes_served; }
+	size_t get_evictions() const { return m_evictions; }
+	size_t get_invalidations() const { return m_invalidations; }
+
+private:
+	struct Entry {
+		std::string data;
+		Hash last_bid;
+		std::list<Key>::iterator lru_it;
+	};
+	static constexpr size_t ENTRY_OVERHEAD = sizeof(Entry) + 2 * sizeof(Key) + 64;  // plus map and list nodes
+	std::map<Key, Entry> m_entries;
+	std::list<Key> m_lru;  // most recently used at front
+	const size_t m_memory_budget;
+	size_t m_memory_usage  = 0;
+	size_t m_hits          = 0;
+	size_t m_misses        = 0;
+	size_t m_bytes_served  = 0;
+	size_t m_evictions     = 0;
+	size_t m_invalidations = 0;
+
+	void erase(std::map<Key, Entry>::iterator it);
+};
+
+}  // namespace cn
@@ -0,0 +1,95 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "TransactionPool.hpp"
+#include <algorithm>
+#include "CryptoNoteTools.hpp"
+#include "common/Invariant.hpp"
+#include "seria/BinaryInputStream.hpp"
+
+using namespace cn;
+
+PoolTransaction::PoolTransaction(const Transaction &tx, const BinaryArray &binary_tx, Amount fee, Timestamp timestamp,
+    const Hash &newest_referenced_block)
+    : binary_tx(binary_tx)
+    , amount(get_tx_sum_outputs(tx))
+    , fee(fee)
+    , timestamp(timestamp)
+    , newest_referenced_block(newest_referenced_block) {
+	for (const auto &input : tx.inputs)
+		if (input.type() == typeid(InputKey))
+			key_images.push_back(boost::get<InputKey>(input).key_image);
+}
+
+Transaction PoolTransaction::get_transaction() const {
+	Transaction tx;
+	seria::from_binary(tx, binary_tx);
+	return tx;
+}
+
+size_t TransactionPool::entry_memory_usage(const PoolTransaction &ptx) {
+	return ENTRY_OVERHEAD + ptx.binary_tx.size() + ptx.key_images.size() * (sizeof(KeyImage) + KEYIMAGE_OVERHEAD);
+}
+
+bool TransactionPool::insert(const Hash &tid, PoolTransaction &&ptx) {
+	if (m_transactions.count(tid) != 0)
+		return false;
+	for (const auto &ki : ptx.key_images)
+		if (m_keyimage_index.count(ki) != 0)
+			return false;
+	for (const auto &ki : ptx.key_images)
+		m_keyimage_index.insert(std::make_pair(ki, tid));
+	invariant(m_fee_index.insert(std::make_pair(ptx.fee_per_byte(), tid)).second, "");
+	m_total_size += ptx.binary_tx.size();
+	m_memory_usage += entry_memory_usage(ptx);
+	m_transactions.insert(std::make_pair(tid, std::move(ptx)));
+	return true;
+}
+
+bool TransactionPool::erase(const Hash &tid) {
+	auto tit = m_transactions.find(tid);
+	if (tit == m_transactions.end())
+		return false;
+	const PoolTransaction &ptx = tit->second;
+	bool all_erased            = true;
+	for (const auto &ki : ptx.key_images)
+		if (m_keyimage_index.erase(ki) != 1)
+			all_erased = false;
+	if (m_fee_index.erase(std::make_pair(ptx.fee_per_byte(), tid)) != 1)
+		all_erased = false;
+	m_total_size -= ptx.binary_tx.size();
+	m_memory_usage -= entry_memory_usage(ptx);
+	m_transactions.erase(tit);
+	invariant(all_erased, "TransactionPool failed to erase from all indices");
+	return true;
+}
+
+bool TransactionPool::find_keyimage(const KeyImage &key_image, Hash *tid) const {
+	auto kit = m_keyimage_index.find(key_image);
+	if (kit == m_keyimage_index.end())
+		return false;
+	*tid = kit->second;
+	return true;
+}
+
+std::vector<TransactionPool::Transactions::const_iterator> TransactionPool::get_sorted_by_hash() const {
+	std::vector<Transactions::const_iterator> result;
+	result.reserve(m_transactions.size());
+	for (auto tit = m_transactions.begin(); tit != m_transactions.end(); ++tit)
+		result.push_back(tit);
+	std::sort(result.begin(), result.end(),
+	    [](Transactions::const_iterator a, Transactions::const_iterator b) { return a->first < b->first; });
+	return result;
+}
+
+Amount TransactionPool::minimum_fee_per_byte(bool zero_if_not_full, Hash *minimal_tid) const {
+	if (m_fee_index.empty() || (zero_if_not_full && m_total_size < m_max_size)) {
+		if (minimal_tid)
+			*minimal_tid = Hash{};
+		return 0;
+	}
+	auto be = m_fee_index.begin();
+	if (minimal_tid)
+		*minimal_tid = be->second;
+	return be->first;
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "CryptoNote.hpp"
+
+namespace cn {
+
+// We keep binary transaction and small summary only, parsed transaction with signatures is several
+// times larger than binary. Those who need inputs or signatures call get_transaction().
+struct PoolTransaction {
+	BinaryArray binary_tx;
+	Amount amount       = 0;
+	Amount fee          = 0;
+	Timestamp timestamp = 0;
+	Hash newest_referenced_block;
+	std::vector<KeyImage> key_images;
+
+	PoolTransaction() = default;
+	PoolTransaction(const Transaction &tx, const BinaryArray &binary_tx, Amount fee, Timestamp timestamp,
+	    const Hash &newest_referenced_block);
+	Amount fee_per_byte() const { return fee / binary_tx.size(); }
+	Transaction get_transaction() const;  // parses binary_tx
+};
+
+// Indexed by hash and key image in hash tables, by fee per byte in ordered set, so that lookups are O(1)
+// and eviction of cheapest transaction is O(log n). Does not validate, owner must check that key images
+// do not conflict and evict cheapest transactions while total_size() is over max_size().
+class TransactionPool {
+public:
+	typedef std::unordered_map<Hash, PoolTransaction> Transactions;
+	typedef std::set<std::pair<Amount, Hash>> FeeIndex;  // (fee_per_byte, tid), cheapest first
+
+	explicit TransactionPool(size_t max_size) : m_max_size(max_size) {}
+
+	bool insert(const Hash &tid, PoolTransaction &&ptx);  // false if already in pool or key image conflict
+	bool erase(const Hash &tid);
+
+	Transactions::const_iterator find(const Hash &tid) const { return m_transactions.find(tid); }
+	size_t count(const Hash &tid) const { return m_transactions.count(tid); }
+	Transactions::const_iterator begin() const { return m_transactions.begin(); }
+	Transactions::const_iterator end() const { return m_transactions.end(); }
+	const PoolTransaction &at(const Hash &tid) const { return m_transactions.at(tid); }
+	// Hash table order is arbitrary, lists sent to peers and RPC clients are sorted by hash as before
+	std::vector<Transactions::const_iterator> get_sorted_by_hash() const;
+	bool find_keyimage(const KeyImage &key_image, Hash *tid) const;
+	const FeeIndex &get_fee_index() const { return m_fee_index; }
+
+	size_t size() const { return m_transactions.size(); }
+	bool empty() const { return m_transactions.empty(); }
+	size_t total_size() const { return m_total_size; }  // sum of binary sizes, limited by max_size()
+	size_t max_size() const { return m_max_size; }
+	size_t memory_usage() const { return m_memory_usage; }  // estimate
+
+	Amount minimum_fee_per_byte(bool zero_if_not_full, Hash *minimal_tid) const;
+
+private:
+	static constexpr size_t ENTRY_OVERHEAD    = sizeof(PoolTransaction) + sizeof(Hash) + 96;  // plus index nodes
+	static constexpr size_t KEYIMAGE_OVERHEAD = sizeof(KeyImage) + sizeof(Hash) + 32;
+	Transactions m_transactions;
+	std::unordered_map<KeyImage, Hash> m_keyimage_index;
+	FeeIndex m_fee_index;
+	size_t m_max_size;
+	size_t m_total_size   = 0;
+	size_t m_memory_usage = 0;
+
+	static size_t entry_memory_usage(const PoolTransaction &ptx);
+};
+
+}  // namespace cn
@@ -654,6 +654,41 @@ Wallet::OutputHandler WalletContainerStorage::get_output_handler() const {
 	    };
 }
 
+Wallet::BlockOutputHandler WalletContainerStorage::get_block_output_handler() const {
+	SecretKey vsk_copy = m_view_secret_key;
+	return [vsk_copy](PreparedWalletTransaction *const transactions[], size_t count) {
+		std::vector<PreparedWalletTransaction *> with_outputs;  // derivation is calculated only if needed
+		std::vector<PublicKey> tx_public_keys;
+		std::vector<crypto::OutputScanItem> items;
+		for (size_t i = 0; i != count; ++i) {
+			const auto &outputs = transactions[i]->tx.outputs;
+			for (size_t out_index = 0; out_index != outputs.size(); ++out_index) {
+				if (outputs.at(out_index).type() != typeid(OutputKey))
+					continue;
+				if (with_outputs.empty() || with_outputs.back() != transactions[i]) {
+					with_outputs.push_back(transactions[i]);
+					tx_public_keys.push_back(transactions[i]->tx_public_key);
+				}
+				crypto::OutputScanItem item;
+				item.tx_number         = with_outputs.size() - 1;
+				item.output_index      = out_index;
+				item.output_public_key = boost::get<OutputKey>(outputs.at(out_index)).public_key;
+				items.push_back(item);
+			}
+		}
+		// tx_public_key is not checked by daemon, so can be invalid, then derivation is zero
+		std::vector<KeyDerivation> derivations(with_outputs.size());
+		crypto::generate_key_derivations_batch(
+		    vsk_copy, tx_public_keys.data(), tx_public_keys.size(), derivations.data());
+		std::vector<PublicKey> spend_keys(items.size());
+		crypto::underive_public_keys_batch(derivations.data(), items.data(), items.size(), spend_keys.data());
+		for (size_t j = 0; j != with_outputs.size(); ++j)
+			with_outputs[j]->derivation = derivations[j];
+		for (size_t k = 0; k != items.size(); ++k)
+			with_outputs[items[k].tx_number]->spend_keys.at(items[k].output_index) = spend_keys[k];
+	};
+}
+
 bool WalletContainerStorage::detect_our_output(const Hash &tid, const Hash &tx_inputs_hash,
     const boost::optional<KeyDerivation> &kd, size_t out_index, const PublicKey &spend_public_key,
     const SecretKey &secret_scalar, const OutputKey &key_output, Amount *amount, KeyPair *output_keypair,
@@ -1291,6 +1326,37 @@ Wallet::OutputHandler WalletHD::get_output_handler() const {
 	    };
 }
 
+Wallet::BlockOutputHandler WalletHD::get_block_output_handler() const {
+	SecretKey vsk_copy = m_view_secret_key;
+	return [vsk_copy](PreparedWalletTransaction *const transactions[], size_t count) {
+		std::vector<Hash> tx_inputs_hashes(count);
+		std::vector<crypto::OutputScanItem> items;
+		for (size_t i = 0; i != count; ++i) {
+			tx_inputs_hashes[i] = transactions[i]->inputs_hash;
+			const auto &outputs = transactions[i]->tx.outputs;
+			for (size_t out_index = 0; out_index != outputs.size(); ++out_index) {
+				if (outputs.at(out_index).type() != typeid(OutputKey))
+					continue;
+				const auto &key_output = boost::get<OutputKey>(outputs.at(out_index));
+				crypto::OutputScanItem item;
+				item.tx_number               = i;
+				item.output_index            = out_index;
+				item.output_public_key       = key_output.public_key;
+				item.encrypted_output_secret = key_output.encrypted_secret;
+				items.push_back(item);
+			}
+		}
+		std::vector<PublicKey> spend_keys(items.size());
+		std::vector<SecretKey> spend_scalars(items.size());
+		crypto::unlinkable_underive_public_keys_batch(vsk_copy, tx_inputs_hashes.data(), items.data(), items.size(),
+		    spend_keys.data(), spend_scalars.data());
+		for (size_t k = 0; k != items.size(); ++k) {
+			transactions[items[k].tx_number]->spend_keys.at(items[k].output_index)            = spend_keys[k];
+			transactions[items[k].tx_number]->output_secret_scalars.at(items[k].output_index) = spend_scalars[k];
+		}
+	};
+}
+
 bool WalletHD::detect_our_output(const Hash &tid, const Hash &tx_inputs_hash, const boost::optional<KeyDerivation> &kd,
     size_t out_index, const PublicKey &spend_public_key, const SecretKey &secret_scalar, const OutputKey &key_output,
     Amount *amount, KeyPair *output_keypair, AccountAddress *address) {
@@ -16,6 +16,8 @@
 
 namespace cn {
 
+struct PreparedWalletTransaction;
+
 struct WalletRecord {
 	PublicKey spend_public_key{};
 	SecretKey spend_secret_key{};
@@ -110,6 +112,10 @@ public:
 	virtual bool detect_our_output(const Hash &tid, const Hash &tx_inputs_hash,
 	    const boost::optional<KeyDerivation> &kd, size_t out_index, const PublicKey &spend_public_key,
 	    const SecretKey &secret_scalar, const OutputKey &, Amount *, KeyPair *output_keypair, AccountAddress *) = 0;
+	// Same as OutputHandler for each key output of several transactions (usually whole block), so crypto is batched.
+	// Fills derivation, spend_keys and output_secret_scalars, which must be already sized to outputs
+	typedef std::function<void(PreparedWalletTransaction *const transactions[], size_t count)> BlockOutputHandler;
+	virtual BlockOutputHandler get_block_output_handler() const = 0;
 };
 
 // stores at most 1 view secret key. 1 or more spend secret keys
@@ -168,6 +174,7 @@ public:
 	std::string get_label(const std::string &address) const override { return std::string(); }
 
 	OutputHandler get_output_handler() const override;
+	BlockOutputHandler get_block_output_handler() const override;
 	bool detect_our_output(const Hash &tid, const Hash &tx_inputs_hash, const boost::optional<KeyDerivation> &kd,
 	    size_t out_index, const PublicKey &spend_public_key, const SecretKey &secret_scalar, const OutputKey &,
 	    Amount *, KeyPair *output_keypair, AccountAddress *) override;
@@ -242,6 +249,7 @@ public:
 	std::string get_label(const std::string &address) const override;
 
 	OutputHandler get_output_handler() const override;
+	BlockOutputHandler get_block_output_handler() const override;
 	bool detect_our_output(const Hash &tid, const Hash &tx_inputs_hash, const boost::optional<KeyDerivation> &kd,
 	    size_t out_index, const PublicKey &spend_public_key, const SecretKey &secret_scalar, const OutputKey &,
 	    Amount *, KeyPair *output_keypair, AccountAddress *) override;
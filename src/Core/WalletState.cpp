@@ -284,7 +284,7 @@ void WalletState::add_transaction_to_mempool(Hash tid, Transaction &&tx, bool fr
 	m_log(logging::INFO) << "Now " << (from_pq ? "PQ" : "node") << " transaction " << tid
 	                     << " is in MS size before adding=" << m_memory_state.get_transactions().size() << std::endl;
 	std::vector<size_t> global_indices(tx.outputs.size(), 0);
-	PreparedWalletTransaction pwtx(std::move(tx), m_wallet.get_output_handler());
+	PreparedWalletTransaction pwtx(std::move(tx), m_wallet.get_block_output_handler());
 	if (!redo_transaction(pwtx, global_indices, &m_memory_state, false, tid, get_tip_height() + 1, Hash{}, now)) {
 	}  // just ignore result
 }
@@ -328,7 +328,7 @@ bool WalletState::sync_with_blockchain(api::cnd::SyncBlocks::Response &resp) {
 		if (empty_chain())
 			reset_chain(resp.start_height);
 		preparator.cancel_work();
-		preparator.start_work(resp, m_wallet.get_output_handler());
+		preparator.start_work(resp, m_wallet.get_block_output_handler());
 		while (get_tip_height() + 1 < resp.start_height + resp.blocks.size()) {
 			size_t bin         = get_tip_height() + 1 - resp.start_height;
 			const auto &header = resp.blocks.at(bin).header;
@@ -561,7 +561,7 @@ bool WalletState::parse_raw_transaction(bool is_base, api::Transaction *ptx,
 bool WalletState::parse_raw_transaction(bool is_base, api::Transaction &ptx, Transaction &&tx, Hash tid) const {
 	std::vector<size_t> global_indices(tx.outputs.size(), 0);
 	Amount unrecognized_inputs_amount = 0;
-	PreparedWalletTransaction pwtx(std::move(tx), m_wallet.get_output_handler());
+	PreparedWalletTransaction pwtx(std::move(tx), m_wallet.get_block_output_handler());
 	std::vector<api::Transfer> input_transfers;
 	std::vector<api::Transfer> output_transfers;
 	parse_raw_transaction(is_base, &ptx, &input_transfers, &output_transfers, &unrecognized_inputs_amount, pwtx, tid,
@@ -17,7 +17,7 @@
 
 static const auto LEVEL = logging::TRACE;
 
-static const std::string version_current = "9";
+static const std::string version_current = "10";
 
 static const std::string INDEX_UID_to_STATE = "X";  // We do not store it for empty blocks
 
@@ -26,12 +26,15 @@ static const std::string INDEX_HEIGHT_to_HEADER = "c";
 // (tid) -> tx                  <- find tx by tid
 static const std::string INDEX_TID_to_TRANSACTIONS = "tx";  // for get_transations
 
-// (   _, he, tid) -> ()        <- find transfers
-// (addr, he, tid) -> ()        <- find transfers by addr
+// (addr) -> (aid)              <- address id used instead of addr in keys below, aid 0 is for all addresses
+static const std::string INDEX_ADDRESS_to_ID = "id";  // assigned on first use, never deleted
+
+// (  0, he, tid) -> ()         <- find transfers
+// (aid, he, tid) -> ()         <- find transfers by addr
 static const std::string INDEX_ADDRESS_HEIGHT_TID = "th";  // for get_transfers
 
-// (   _) -> (balance)          <- find total balance
-// (addr) -> (balance)          <- find balance by addr
+// (  0) -> (balance)           <- find total balance
+// (aid) -> (balance)           <- find balance by addr
 static const std::string INDEX_ADDRESS_to_BALANCE = "ba";  // for get_balance
 
 // (ki) -> (he, am, gi)          <- find largest coin from same ki group (can be spent or not)
@@ -41,7 +44,7 @@ static const std::string INDEX_KEYIMAGE_to_HE_AM_GI = "ki";  // ki->output_key,
 static const std::string INDEX_AM_GI_to_HE_PK = "g";
 
 // (he, am, gi) -> output       <- find available unspents         (never locked or already unlocked)
-// (addr, he, am, gi) -> ()     <- find available unspents by addr (never locked or already unlocked)
+// (aid, he, am, gi) -> ()      <- find available unspents by addr (never locked or already unlocked)
 static const std::string INDEX_HE_AM_GI_to_OUTPUT = "un";
 static const std::string INDEX_ADDRESS_HE_AM_GI   = "uh";
 
@@ -115,6 +118,32 @@ WalletStateBasic::WalletStateBasic(logging::ILogger &log, const Config &config,
 		}
 		fix_empty_chain();
 	}
+	for (DB::Cursor cur = m_db.begin(INDEX_ADDRESS_to_ID); !cur.end(); cur.next())
+		m_address_ids[cur.get_suffix()] = common::read_varint_sqlite4(cur.get_value_string());
+}
+
+uint64_t WalletStateBasic::intern_address(const std::string &address) {
+	if (address.empty())
+		return 0;
+	auto ait = m_address_ids.find(address);
+	if (ait != m_address_ids.end())
+		return ait->second;
+	const uint64_t aid = m_address_ids.size() + 1;
+	m_db.put(INDEX_ADDRESS_to_ID + address, common::write_varint_sqlite4(aid), true);  // not undone, aid stays valid
+	m_address_ids.insert(std::make_pair(address, aid));
+	return aid;
+}
+
+bool WalletStateBasic::find_address_id(const std::string &address, uint64_t *aid) const {
+	if (address.empty()) {
+		*aid = 0;
+		return true;
+	}
+	auto ait = m_address_ids.find(address);
+	if (ait == m_address_ids.end())
+		return false;  // nothing was ever added for this address
+	*aid = ait->second;
+	return true;
 }
 
 void WalletStateBasic::put_am_gi_he(Amount am, size_t gi, Height he, const PublicKey &pk) {
@@ -480,8 +509,8 @@ void WalletStateBasic::add_transaction(
 		addresses.insert(transfer.address);
 	}
 	for (auto &&addr : addresses) {
-		auto adtrkey = INDEX_ADDRESS_HEIGHT_TID + addr + "/" + common::write_varint_sqlite4(height) +
-		               DB::to_binary_key(tid.data, sizeof(tid.data));
+		auto adtrkey = INDEX_ADDRESS_HEIGHT_TID + common::write_varint_sqlite4(intern_address(addr)) +
+		               common::write_varint_sqlite4(height) + DB::to_binary_key(tid.data, sizeof(tid.data));
 		put_with_undo(adtrkey, BinaryArray(), true);
 	}
 }
@@ -505,9 +534,10 @@ bool WalletStateBasic::api_add_unspent(std::vector<api::Output> *result, Amount
 std::vector<api::Block> WalletStateBasic::api_get_transfers(
     const std::string &address, Height *from_height, Height *to_height, bool forward, size_t desired_tx_count) const {
 	std::vector<api::Block> result;
-	if (*from_height >= *to_height)
+	uint64_t aid = 0;
+	if (*from_height >= *to_height || !find_address_id(address, &aid))
 		return result;
-	auto prefix = INDEX_ADDRESS_HEIGHT_TID + address + "/";
+	auto prefix = INDEX_ADDRESS_HEIGHT_TID + common::write_varint_sqlite4(aid);
 	std::string middle =
 	    common::write_varint_sqlite4(forward ? *from_height : *to_height - 1);  // to_height != 0 checked in if above
 	api::Block current_block;
@@ -596,9 +626,12 @@ std::vector<api::Output> WalletStateBasic::api_get_locked_or_unconfirmed_unspent
 // unconfirmed: unspent (conf..inf] || recently_unlocked
 
 api::Balance WalletStateBasic::get_balance(const std::string &address, Height confirmed_height) const {
-	auto bakey = INDEX_ADDRESS_to_BALANCE + address;
-	BinaryArray ba;
+	uint64_t aid = 0;
 	api::Balance balance;
+	if (!find_address_id(address, &aid))
+		return balance;
+	auto bakey = INDEX_ADDRESS_to_BALANCE + common::write_varint_sqlite4(aid);
+	BinaryArray ba;
 	if (m_db.get(bakey, ba))
 		seria::from_binary(balance, ba);
 
@@ -727,8 +760,8 @@ std::vector<api::Transfer> WalletStateBasic::api_get_unlocked_transfers(
 }
 
 void WalletStateBasic::modify_balance(const api::Output &output, int locked_op, int spendable_op) {
-	auto bakey  = INDEX_ADDRESS_to_BALANCE + output.address;
-	auto bakey2 = INDEX_ADDRESS_to_BALANCE;
+	auto bakey  = INDEX_ADDRESS_to_BALANCE + common::write_varint_sqlite4(intern_address(output.address));
+	auto bakey2 = INDEX_ADDRESS_to_BALANCE + common::write_varint_sqlite4(0);
 	BinaryArray ba;
 	api::Balance balance;
 	api::Balance balance2;
@@ -825,7 +858,11 @@ bool WalletStateBasic::read_from_unspent_index(const HeightAmounGi &value, api::
 }
 bool WalletStateBasic::for_each_in_unspent_index(
     const std::string &address, Height from, Height to, std::function<bool(api::Output &&)> fun) const {
-	auto prefix        = address.empty() ? INDEX_HE_AM_GI_to_OUTPUT : INDEX_ADDRESS_HE_AM_GI + address + "/";
+	uint64_t aid = 0;
+	if (!find_address_id(address, &aid))
+		return true;
+	auto prefix        = address.empty() ? INDEX_HE_AM_GI_to_OUTPUT
+	                                     : INDEX_ADDRESS_HE_AM_GI + common::write_varint_sqlite4(aid);
 	std::string middle = common::write_varint_sqlite4(from);
 	for (DB::Cursor cur = m_db.begin(prefix, middle); !cur.end(); cur.next()) {
 		const std::string &suf = cur.get_suffix();
@@ -857,8 +894,9 @@ void WalletStateBasic::add_to_unspent_index(const api::Output &output) {
 	             common::write_varint_sqlite4(output.amount) + common::write_varint_sqlite4(output.index);
 	put_with_undo(keyun, seria::to_binary(output), true);
 
-	keyun = INDEX_ADDRESS_HE_AM_GI + output.address + "/" + common::write_varint_sqlite4(output.height) +
-	        common::write_varint_sqlite4(output.amount) + common::write_varint_sqlite4(output.index);
+	keyun = INDEX_ADDRESS_HE_AM_GI + common::write_varint_sqlite4(intern_address(output.address)) +
+	        common::write_varint_sqlite4(output.height) + common::write_varint_sqlite4(output.amount) +
+	        common::write_varint_sqlite4(output.index);
 	put_with_undo(keyun, BinaryArray{}, true);
 }
 
@@ -869,8 +907,9 @@ void WalletStateBasic::remove_from_unspent_index(const api::Output &output) {
 	             common::write_varint_sqlite4(output.amount) + common::write_varint_sqlite4(output.index);
 	del_with_undo(keyun, true);
 
-	keyun = INDEX_ADDRESS_HE_AM_GI + output.address + "/" + common::write_varint_sqlite4(output.height) +
-	        common::write_varint_sqlite4(output.amount) + common::write_varint_sqlite4(output.index);
+	keyun = INDEX_ADDRESS_HE_AM_GI + common::write_varint_sqlite4(intern_address(output.address)) +
+	        common::write_varint_sqlite4(output.height) + common::write_varint_sqlite4(output.amount) +
+	        common::write_varint_sqlite4(output.index);
 	del_with_undo(keyun, true);
 }
 
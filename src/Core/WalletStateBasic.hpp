@@ -11,6 +11,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include "BlockChainState.hpp"
 #include "CryptoNote.hpp"
 #include "Wallet.hpp"
@@ -136,6 +137,11 @@ private:
 	void save_db_state(Height state, const UndoMap &undo_map);
 	void undo_db_state(Height state);
 
+	// Index keys contain small address id instead of address, id 0 is for all addresses
+	std::unordered_map<std::string, uint64_t> m_address_ids;  // mirrors whole address id index
+	uint64_t intern_address(const std::string &address);
+	bool find_address_id(const std::string &address, uint64_t *aid) const;
+
 	// indices implemenation
 	Amount add_incoming_output(const api::Output &, const Hash &tid, bool just_unlocked);
 	void modify_balance(const api::Output &output, int locked_op, int spendable_op);
@@ -0,0 +1,228 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "Compression.hpp"
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <stdexcept>
+#include "Varint.hpp"
+
+namespace common {
+
+static const size_t MIN_MATCH  = 4;
+static const size_t MAX_OFFSET = 65535;
+
+static uint32_t read32(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint64_t read64(const uint8_t *p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static size_t hash4(uint32_t v) { return (v * 2654435761U) >> (32 - LZDictionary::HASH_BITS); }
+
+LZDictionary::LZDictionary(BinaryArray &&data) : data(std::move(data)), hash_table(size_t(1) << HASH_BITS) {
+	for (size_t pos = 0; pos + MIN_MATCH <= this->data.size(); ++pos)
+		hash_table[hash4(read32(this->data.data() + pos))] = static_cast<uint32_t>(pos + 1);
+}
+
+static void write_length(BinaryArray *out, size_t len) {
+	for (; len >= 255; len -= 255)
+		out->push_back(255);
+	out->push_back(static_cast<uint8_t>(len));
+}
+
+static void write_sequence(BinaryArray *out, const uint8_t *literals, size_t literal_count, size_t offset,
+    size_t match_len) {  // match_len 0 for last sequence
+	const size_t match_code = match_len == 0 ? 0 : match_len - MIN_MATCH;
+	out->push_back(static_cast<uint8_t>((std::min<size_t>(literal_count, 15) << 4) | std::min<size_t>(match_code, 15)));
+	if (literal_count >= 15)
+		write_length(out, literal_count - 15);
+	out->insert(out->end(), literals, literals + literal_count);
+	if (match_len == 0)
+		return;
+	out->push_back(static_cast<uint8_t>(offset));
+	out->push_back(static_cast<uint8_t>(offset >> 8));
+	if (match_code >= 15)
+		write_length(out, match_code - 15);
+}
+
+LZCompressor::LZCompressor(const LZDictionary &dictionary)
+    : dictionary_size(dictionary.data.size()), buf(dictionary.data), hash_table(dictionary.hash_table) {
+	hash_table.resize(size_t(1) << LZDictionary::HASH_BITS);
+}
+
+BinaryArray LZCompressor::compress(const uint8_t *data, size_t size) {
+	buf.resize(dictionary_size);
+	buf.insert(buf.end(), data, data + size);
+	auto set_slot = [&](size_t h, size_t pos) {
+		undo.emplace_back(static_cast<uint32_t>(h), hash_table[h]);
+		hash_table[h] = static_cast<uint32_t>(pos + 1);
+	};
+
+	BinaryArray result = get_varint_data(size);
+	result.reserve(result.size() + size + size / 255 + 16);
+	const uint8_t *const b = buf.data();
+	const size_t end       = buf.size();
+	size_t anchor          = dictionary_size;
+	size_t pos             = dictionary_size;
+	while (pos + MIN_MATCH <= end) {
+		const uint32_t v  = read32(b + pos);
+		const size_t h    = hash4(v);
+		const size_t cand = hash_table[h];
+		set_slot(h, pos);
+		if (cand == 0 || pos - (cand - 1) > MAX_OFFSET || read32(b + cand - 1) != v) {
+			pos += 1;
+			continue;
+		}
+		const size_t match_pos = cand - 1;
+		size_t len             = MIN_MATCH;
+		while (pos + len < end && b[match_pos + len] == b[pos + len])
+			len += 1;
+		write_sequence(&result, b + anchor, pos - anchor, pos - match_pos, len);
+		for (size_t p = pos + 1; p < pos + len && p + MIN_MATCH <= end; ++p)
+			set_slot(hash4(read32(b + p)), p);
+		pos += len;
+		anchor = pos;
+	}
+	if (anchor != end)
+		write_sequence(&result, b + anchor, end - anchor, 0, 0);
+	for (auto uit = undo.rbegin(); uit != undo.rend(); ++uit)
+		hash_table[uit->first] = uit->second;
+	undo.clear();
+	return result;
+}
+
+BinaryArray lz_compress(const uint8_t *data, size_t size, const LZDictionary &dictionary) {
+	return LZCompressor(dictionary).compress(data, size);
+}
+
+static size_t read_length(const uint8_t *&p, const uint8_t *end, size_t len) {
+	while (true) {
+		if (p == end)
+			throw std::runtime_error("lz_decompress: data truncated");
+		const uint8_t c = *p++;
+		len += c;
+		if (c != 255)
+			return len;
+	}
+}
+
+BinaryArray lz_decompress(const uint8_t *data, size_t size, const LZDictionary &dictionary) {
+	const BinaryArray &dict = dictionary.get_data();
+	const uint8_t *p        = data;
+	const uint8_t *end      = data + size;
+	size_t original_size    = 0;
+	if (read_varint(p, end, &original_size) <= 0 || original_size / 256 > size)
+		throw std::runtime_error("lz_decompress: bad original size");
+	BinaryArray result(original_size);
+	uint8_t *const out = result.data();
+	size_t o           = 0;
+	while (o != original_size) {
+		if (p == end)
+			throw std::runtime_error("lz_decompress: data truncated");
+		const uint8_t token  = *p++;
+		size_t literal_count = token >> 4;
+		if (literal_count == 15)
+			literal_count = read_length(p, end, literal_count);
+		if (literal_count > static_cast<size_t>(end - p) || literal_count > original_size - o)
+			throw std::runtime_error("lz_decompress: literals out of bounds");
+		memcpy(out + o, p, literal_count);
+		p += literal_count;
+		o += literal_count;
+		if (o == original_size)
+			break;
+		if (end - p < 2)
+			throw std::runtime_error("lz_decompress: data truncated");
+		const size_t offset = p[0] | (size_t(p[1]) << 8);
+		p += 2;
+		size_t match_len = token & 0x0f;
+		if (match_len == 15)
+			match_len = read_length(p, end, match_len);
+		match_len += MIN_MATCH;
+		if (offset == 0 || offset > dict.size() + o || match_len > original_size - o)
+			throw std::runtime_error("lz_decompress: match out of bounds");
+		size_t from = dict.size() + o - offset;  // position in dictionary then data
+		for (; from < dict.size() && match_len != 0; ++from, --match_len)
+			out[o++] = dict[from];
+		for (from -= dict.size(); match_len != 0; --match_len)  // may overlap, so byte by byte
+			out[o++] = out[from++];
+	}
+	if (p != end)
+		throw std::runtime_error("lz_decompress: excess data");
+	return result;
+}
+
+BinaryArray LZDictionary::train(const std::vector<BinaryArray> &samples, size_t dictionary_size) {
+	// Approximate COVER algorithm - segments are scored by frequency (number of samples containing it)
+	// of 8-byte sequences inside, sequences of chosen segments no longer count. Frequencies are counted
+	// in hash buckets, collisions only make scores a bit less precise.
+	const size_t GRAM = 8, SEGMENT = 64, STEP = 16, BUCKET_BITS = 20;
+	std::vector<uint16_t> frequency(size_t(1) << BUCKET_BITS);
+	std::vector<uint32_t> last_sample(size_t(1) << BUCKET_BITS);
+	auto bucket = [&](const uint8_t *p) -> size_t {
+		return static_cast<size_t>((read64(p) * 0x9E3779B97F4A7C15ULL) >> (64 - BUCKET_BITS));
+	};
+	for (size_t s = 0; s != samples.size(); ++s)
+		for (size_t pos = 0; pos + GRAM <= samples[s].size(); ++pos) {
+			const size_t h = bucket(samples[s].data() + pos);
+			if (last_sample[h] != s + 1 && frequency[h] != 0xffff) {
+				last_sample[h] = static_cast<uint32_t>(s + 1);
+				frequency[h] += 1;
+			}
+		}
+	struct Candidate {
+		size_t score;
+		size_t sample;
+		size_t offset;
+		bool operator<(const Candidate &other) const { return score < other.score; }
+	};
+	auto score = [&](const Candidate &c) {
+		size_t result = 0;
+		for (size_t pos = c.offset; pos + GRAM <= c.offset + SEGMENT; ++pos) {
+			const size_t f = frequency[bucket(samples[c.sample].data() + pos)];
+			result += f > 1 ? f : 0;  // sequence found in single sample is probably a key or hash
+		}
+		return result;
+	};
+	std::priority_queue<Candidate> queue;
+	for (size_t s = 0; s != samples.size(); ++s)
+		for (size_t offset = 0; offset + SEGMENT <= samples[s].size(); offset += STEP) {
+			Candidate c{0, s, offset};
+			c.score = score(c);
+			if (c.score != 0)
+				queue.push(c);
+		}
+	std::vector<Candidate> chosen;
+	size_t chosen_size = 0;
+	while (!queue.empty() && chosen_size + SEGMENT <= dictionary_size) {
+		Candidate c = queue.top();
+		queue.pop();
+		c.score = score(c);  // lazy greedy, score can only decrease
+		if (c.score == 0)
+			continue;
+		if (!queue.empty() && c.score < queue.top().score) {
+			queue.push(c);
+			continue;
+		}
+		for (size_t pos = c.offset; pos + GRAM <= c.offset + SEGMENT; ++pos)
+			frequency[bucket(samples[c.sample].data() + pos)] = 0;
+		chosen.push_back(c);
+		chosen_size += SEGMENT;
+	}
+	BinaryArray result;  // best segments last, closest to data
+	result.reserve(chosen_size);
+	for (auto cit = chosen.rbegin(); cit != chosen.rend(); ++cit) {
+		const uint8_t *p = samples[cit->sample].data() + cit->offset;
+		result.insert(result.end(), p, p + SEGMENT);
+	}
+	return result;
+}
+
+}  // namespace common
@@ -0,0 +1,52 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "BinaryArray.hpp"
+
+namespace common {
+
+// LZ77 codec with preset dictionary. Stream is varint of original size, then sequences in LZ4 block format
+// (token, literals, 2-byte offset, match), offsets can reach into dictionary as if it preceded data.
+// Keys, hashes and signatures do not compress, so gains come from transaction structure, amounts and extra,
+// which are similar between transactions, hence dictionary trained on real blocks.
+class LZDictionary {
+public:
+	static constexpr size_t HASH_BITS = 14;
+
+	LZDictionary() = default;
+	explicit LZDictionary(BinaryArray &&data);
+	const BinaryArray &get_data() const { return data; }
+
+	// Selects segments with most frequent 8-byte sequences, samples are usually recent blocks
+	static BinaryArray train(const std::vector<BinaryArray> &samples, size_t dictionary_size);
+
+private:
+	BinaryArray data;
+	std::vector<uint32_t> hash_table;  // positions + 1 in data, 0 for empty
+	friend class LZCompressor;
+};
+
+// Keeps dictionary and its hash table between calls and restores table after each one, so compressing many
+// blocks with the same dictionary costs only their own size. Not thread safe
+class LZCompressor {
+public:
+	explicit LZCompressor(const LZDictionary &dictionary);
+	BinaryArray compress(const uint8_t *data, size_t size);
+
+private:
+	const size_t dictionary_size;
+	BinaryArray buf;  // dictionary then data, so positions in both are in the same space
+	std::vector<uint32_t> hash_table;
+	std::vector<std::pair<uint32_t, uint32_t>> undo;  // slot and previous value, for each change
+};
+
+BinaryArray lz_compress(const uint8_t *data, size_t size, const LZDictionary &dictionary);  // for single use
+// Throws std::runtime_error if data is corrupted or was compressed with different dictionary
+BinaryArray lz_decompress(const uint8_t *data, size_t size, const LZDictionary &dictionary);
+
+}  // namespace common
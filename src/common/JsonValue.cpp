@@ -501,20 +501,31 @@ std::string JsonValue::to_string() const {
 
 std::string JsonValue::escape_string(const std::string &str) {
 	std::string result;
+	escape_string(str.data(), str.size(), &result);
+	return result;
+}
+
+void JsonValue::escape_string(const char *data, size_t size, std::string *result) {
 	static const std::string escape_table[32] = {"\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005",
 	    "\\u0006", "\\u0007", "\\b", "\\t", "\\n", "\\u000B", "\\f", "\\r", "\\u000E", "\\u000F", "\\u0010", "\\u0011",
 	    "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017", "\\u0018", "\\u0019", "\\u001A", "\\u001B",
 	    "\\u001C", "\\u001D", "\\u001E", "\\u001F"};
-	for (auto &&c : str)
+	const char *end = data + size;
+	while (data != end) {
+		const char *run = data;  // Most strings need no escaping, so we append them in runs
+		while (data != end && *data != '\\' && *data != '"' && static_cast<unsigned char>(*data) >= ' ')
+			++data;
+		result->append(run, data);
+		if (data == end)
+			break;
+		const char c = *data++;
 		if (c == '\\' || c == '"') {
-			result += '\\';
-			result += c;
-		} else if (static_cast<unsigned char>(c) < ' ') {
-			result += escape_table[static_cast<unsigned char>(c)];
+			*result += '\\';
+			*result += c;
 		} else {
-			result += c;
+			*result += escape_table[static_cast<unsigned char>(c)];
 		}
-	return result;
+	}
 }
 
 std::ostream &operator<<(std::ostream &out, const JsonValue &json_value) {
@@ -130,6 +130,7 @@ public:
 	friend std::ostream &operator<<(std::ostream &out, const JsonValue &json_value);
 
 	static std::string escape_string(const std::string &str);
+	static void escape_string(const char *data, size_t size, std::string *result);  // appends to result
 
 private:
 	Type type;
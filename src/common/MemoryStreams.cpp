@@ -138,3 +138,46 @@ size_t CircularBuffer::copy_to(IOutputStream &out, size_t max_count) {
 	}
 	return total_count;
 }
+
+namespace {
+struct PooledBuffers {
+	std::vector<BinaryArray> free;
+	~PooledBuffers();
+};
+thread_local bool pooled_buffers_destroyed = false;  // messages can be released during thread exit
+thread_local PooledBuffers pooled_buffers;
+PooledBuffers::~PooledBuffers() { pooled_buffers_destroyed = true; }
+}  // anonymous namespace
+
+BinaryArray BinaryArrayPool::take(size_t reserve) {
+	if (!pooled_buffers_destroyed) {
+		auto &free = pooled_buffers.free;
+		for (size_t i = free.size(); i-- != 0;)
+			if (free[i].capacity() >= reserve) {
+				std::swap(free[i], free.back());
+				BinaryArray result = std::move(free.back());
+				free.pop_back();
+				return result;
+			}
+	}
+	BinaryArray result;
+	result.reserve(reserve);
+	return result;
+}
+
+void BinaryArrayPool::give_back(BinaryArray &&data) {
+	if (pooled_buffers_destroyed || data.capacity() == 0 || data.capacity() > MAX_CAPACITY)
+		return;
+	auto &free = pooled_buffers.free;
+	if (free.size() >= MAX_COUNT)
+		return;
+	data.clear();
+	free.push_back(std::move(data));
+}
+
+SharedBinaryArray BinaryArrayPool::share(BinaryArray &&data) {
+	return SharedBinaryArray(new BinaryArray(std::move(data)), [](const BinaryArray *ba) {
+		give_back(std::move(*const_cast<BinaryArray *>(ba)));
+		delete ba;
+	});
+}
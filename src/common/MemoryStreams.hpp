@@ -4,6 +4,7 @@
 #pragma once
 
 #include <limits>
+#include <memory>
 #include <string>
 #include "Streams.hpp"
 #include "common/BinaryArray.hpp"
@@ -173,4 +174,19 @@ public:
 	void copy_from(IInputStream &in);
 	size_t copy_to(IOutputStream &out, size_t max_count = std::numeric_limits<size_t>::max());
 };
+
+// Immutable message shared by many output queues, for example block relayed to all peers
+typedef std::shared_ptr<const BinaryArray> SharedBinaryArray;
+
+// Per-thread free list of message buffers. Message is serialized into buffer from take(), then share() makes it
+// immutable and returns storage to pool when last queue releases it, so steady traffic does not hit allocator
+class BinaryArrayPool {
+public:
+	static const size_t MAX_COUNT    = 256;
+	static const size_t MAX_CAPACITY = 64 * 1024;  // blocks and large responses are returned to allocator
+
+	static BinaryArray take(size_t reserve);  // empty, capacity at least reserve
+	static SharedBinaryArray share(BinaryArray &&data);
+	static void give_back(BinaryArray &&data);
+};
 }  // namespace common
@@ -0,0 +1,87 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <deque>
+#include <iterator>
+#include <set>
+#include <utility>
+#include "Invariant.hpp"
+
+namespace common {
+
+// Median of values in a window which can grow and shrink at both ends, O(log n) per operation.
+// Result is identical to median_value() called on a vector of all counted values in the window.
+// Values not counted (skipped) still occupy their position in the window.
+template<class T>
+class SlidingMedian {
+	std::deque<std::pair<T, bool>> m_window;  // second - value is counted
+	std::multiset<T> m_low;                   // m_low.size() == m_high.size() or m_high.size() + 1
+	std::multiset<T> m_high;                  // all values in m_high >= all values in m_low
+
+	void insert(const T &value) {
+		if (m_low.empty() || !(*m_low.rbegin() < value))
+			m_low.insert(value);
+		else
+			m_high.insert(value);
+		rebalance();
+	}
+	void erase(const T &value) {
+		invariant(!m_low.empty(), "SlidingMedian erasing from empty set");
+		if (!(*m_low.rbegin() < value))
+			m_low.erase(m_low.find(value));
+		else
+			m_high.erase(m_high.find(value));
+		rebalance();
+	}
+	void rebalance() {
+		while (m_low.size() > m_high.size() + 1) {
+			auto it = std::prev(m_low.end());
+			m_high.insert(*it);
+			m_low.erase(it);
+		}
+		while (m_high.size() > m_low.size()) {
+			m_low.insert(*m_high.begin());
+			m_high.erase(m_high.begin());
+		}
+	}
+
+public:
+	void push_back(const T &value, bool counted = true) {
+		m_window.emplace_back(value, counted);
+		if (counted)
+			insert(value);
+	}
+	void push_front(const T &value, bool counted = true) {
+		m_window.emplace_front(value, counted);
+		if (counted)
+			insert(value);
+	}
+	void pop_back() {
+		if (m_window.back().second)
+			erase(m_window.back().first);
+		m_window.pop_back();
+	}
+	void pop_front() {
+		if (m_window.front().second)
+			erase(m_window.front().first);
+		m_window.pop_front();
+	}
+	void clear() {
+		m_window.clear();
+		m_low.clear();
+		m_high.clear();
+	}
+	size_t size() const { return m_window.size(); }  // including values not counted
+	size_t counted_size() const { return m_low.size() + m_high.size(); }
+	T median() const {
+		if (m_low.empty())
+			return T();
+		if (m_low.size() != m_high.size())  // 1, 3, 5...
+			return *m_low.rbegin();
+		return (*m_low.rbegin() + *m_high.begin()) / 2;  // 2, 4, 6...
+	}
+};
+
+}  // namespace common
@@ -29,6 +29,17 @@ void IOutputStream::write(const void *data, size_t size) {
 	}
 }
 
+size_t IOutputStream::gather_write_some(const ConstBuffer *buffers, size_t count) {
+	size_t total = 0;
+	for (size_t i = 0; i != count; ++i) {
+		size_t wc = write_some(buffers[i].data, buffers[i].size);
+		total += wc;
+		if (wc != buffers[i].size)
+			break;
+	}
+	return total;
+}
+
 static const size_t CHUNK = 1024 * 1024;
 // We read sized entities in chunks to prevent over-sized allocation attacks
 
@@ -31,10 +31,17 @@ public:
 	}
 };
 
+struct ConstBuffer {
+	const void *data;
+	size_t size;
+};
+
 class IOutputStream {
 public:
 	virtual ~IOutputStream()                                 = default;
 	virtual size_t write_some(const void *data, size_t size) = 0;
+	// writes parts of several buffers in order, returns total bytes written. Default calls write_some for each
+	virtual size_t gather_write_some(const ConstBuffer *buffers, size_t count);
 	void write(const void *data, size_t size);
 	void write(const BinaryArray &data);
 	void write(const std::string &data);
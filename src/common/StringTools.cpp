@@ -5,6 +5,13 @@
 #include <stdexcept>
 #include "string.hpp"
 
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
 namespace common {
 
 static const uint8_t character_values[256] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -45,32 +52,205 @@ bool from_hex(char character, uint8_t &value) {
 	return true;
 }
 
-void from_hex_or_throw(const std::string &text, void *data, size_t buffer_size) {
-	if (text.size() != buffer_size * 2)
-		throw std::runtime_error("from_hex: Wrong string size (" + common::to_string(text.size()) + ") must be " +
-		                         common::to_string(buffer_size * 2));
-	for (size_t i = 0; i < buffer_size; ++i)
-		static_cast<uint8_t *>(data)[i] = (from_hex(text[i * 2]) << 4) | from_hex(text[i * 2 + 1]);
-}
+// Kernels convert whole blocks only, scalar loops below finish the tail. On x86-64 SSE2 is always present,
+// AVX2 is selected at runtime. Decoding kernels stop before first block with invalid character and return
+// number of bytes written, so scalar code finds exact error position.
+#if defined(__x86_64__) || defined(_M_X64)
 
-bool from_hex(const std::string &text, void *data, size_t buffer_size) {
-	if (text.size() != buffer_size * 2)
+#if defined(_MSC_VER)
+#define HEX_TARGET_AVX2
+#else
+#define HEX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	const int osxsave_and_avx = (1 << 27) | (1 << 28);
+	if ((info[2] & osxsave_and_avx) != osxsave_and_avx || (_xgetbv(0) & 6) != 6)
 		return false;
-	for (size_t i = 0; i < buffer_size; ++i) {
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+static __m128i hex_digits_sse2(__m128i nibbles) {  // 0..15 -> '0'..'9', 'a'..'f'
+	const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+	return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+static size_t encode_hex_sse2(const uint8_t *data, size_t size, char *out) {
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	size_t i           = 0;
+	for (; i + 16 <= size; i += 16) {
+		const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+		const __m128i hi = hex_digits_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+		const __m128i lo = hex_digits_sse2(_mm_and_si128(v, mask));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2), _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+	}
+	return i;
+}
+
+// Returns nibbles, sets *valid to all ones in lanes with hex characters
+static __m128i hex_nibbles_sse2(__m128i chars, __m128i *valid) {
+	const __m128i digits    = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+	const __m128i letters   = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	const __m128i is_digit  = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+	const __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)), letters);
+	*valid                  = _mm_or_si128(is_digit, is_letter);
+	return _mm_or_si128(_mm_and_si128(is_digit, digits),
+	    _mm_and_si128(is_letter, _mm_add_epi8(letters, _mm_set1_epi8(10))));
+}
+
+static __m128i hex_pairs_sse2(__m128i nibbles) {  // high nibble is in even byte, result in low byte of each word
+	return _mm_or_si128(
+	    _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00ff)), _mm_srli_epi16(nibbles, 8));
+}
+
+static size_t decode_hex_sse2(const char *text, uint8_t *out, size_t size) {
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		__m128i valid0, valid1;
+		const __m128i n0 =
+		    hex_nibbles_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i * 2)), &valid0);
+		const __m128i n1 =
+		    hex_nibbles_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i * 2 + 16)), &valid1);
+		if (_mm_movemask_epi8(_mm_and_si128(valid0, valid1)) != 0xffff)
+			break;
+		_mm_storeu_si128(
+		    reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(hex_pairs_sse2(n0), hex_pairs_sse2(n1)));
+	}
+	return i;
+}
+
+HEX_TARGET_AVX2 static __m256i hex_digits_avx2(__m256i nibbles) {
+	const __m256i letters =
+	    _mm256_and_si256(_mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+	return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')), letters);
+}
+
+HEX_TARGET_AVX2 static size_t encode_hex_avx2(const uint8_t *data, size_t size, char *out) {
+	const __m256i mask = _mm256_set1_epi8(0x0f);
+	size_t i           = 0;
+	for (; i + 32 <= size; i += 32) {
+		const __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+		const __m256i hi = hex_digits_avx2(_mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+		const __m256i lo = hex_digits_avx2(_mm256_and_si256(v, mask));
+		const __m256i a  = _mm256_unpacklo_epi8(hi, lo);  // unpack works within 128-bit lanes
+		const __m256i b  = _mm256_unpackhi_epi8(hi, lo);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i * 2), _mm256_permute2x128_si256(a, b, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i * 2 + 32), _mm256_permute2x128_si256(a, b, 0x31));
+	}
+	return i + encode_hex_sse2(data + i, size - i, out + i * 2);
+}
+
+HEX_TARGET_AVX2 static __m256i hex_nibbles_avx2(__m256i chars, __m256i *valid) {
+	const __m256i digits    = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+	const __m256i letters   = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+	const __m256i is_digit  = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+	const __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letters, _mm256_set1_epi8(5)), letters);
+	*valid                  = _mm256_or_si256(is_digit, is_letter);
+	return _mm256_or_si256(_mm256_and_si256(is_digit, digits),
+	    _mm256_and_si256(is_letter, _mm256_add_epi8(letters, _mm256_set1_epi8(10))));
+}
+
+HEX_TARGET_AVX2 static __m256i hex_pairs_avx2(__m256i nibbles) {
+	return _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(nibbles, 4), _mm256_set1_epi16(0x00ff)),
+	    _mm256_srli_epi16(nibbles, 8));
+}
+
+HEX_TARGET_AVX2 static size_t decode_hex_avx2(const char *text, uint8_t *out, size_t size) {
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		__m256i valid0, valid1;
+		const __m256i n0 =
+		    hex_nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i * 2)), &valid0);
+		const __m256i n1 =
+		    hex_nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i * 2 + 32)), &valid1);
+		if (_mm256_movemask_epi8(_mm256_and_si256(valid0, valid1)) != -1)
+			break;
+		const __m256i packed = _mm256_packus_epi16(hex_pairs_avx2(n0), hex_pairs_avx2(n1));  // within lanes
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_permute4x64_epi64(packed, 0xd8));
+	}
+	if (i + 32 <= size)  // invalid character, no sense to continue with SSE2
+		return i;
+	return i + decode_hex_sse2(text + i * 2, out + i, size - i);
+}
+
+struct HexKernels {
+	size_t (*encode)(const uint8_t *data, size_t size, char *out);
+	size_t (*decode)(const char *text, uint8_t *out, size_t size);
+};
+
+static const HexKernels &hex_kernels() {
+	static const HexKernels kernels =
+	    cpu_has_avx2() ? HexKernels{encode_hex_avx2, decode_hex_avx2} : HexKernels{encode_hex_sse2, decode_hex_sse2};
+	return kernels;
+}
+
+static size_t encode_hex_blocks(const uint8_t *data, size_t size, char *out) {
+	return size < 16 ? 0 : hex_kernels().encode(data, size, out);
+}
+static size_t decode_hex_blocks(const char *text, uint8_t *out, size_t size) {
+	return size < 16 ? 0 : hex_kernels().decode(text, out, size);
+}
+
+#else
+
+static size_t encode_hex_blocks(const uint8_t *, size_t, char *) { return 0; }
+static size_t decode_hex_blocks(const char *, uint8_t *, size_t) { return 0; }
+
+#endif
+
+static bool decode_hex(const char *text, uint8_t *out, size_t size) {
+	for (size_t i = decode_hex_blocks(text, out, size); i < size; ++i) {
 		uint8_t value1, value2;
 		if (!from_hex(text[i * 2], value1) || !from_hex(text[i * 2 + 1], value2))
 			return false;
-		static_cast<uint8_t *>(data)[i] = value1 << 4 | value2;
+		out[i] = value1 << 4 | value2;
 	}
 	return true;
 }
 
-BinaryArray from_hex(const std::string &text) {
-	if (text.size() % 2 != 0)
+[[noreturn]] static void throw_invalid_hex(const char *text, size_t text_size) {
+	for (size_t i = 0; i < text_size; ++i)
+		from_hex(text[i]);  // throws with character description
+	throw std::runtime_error("from_hex: invalid character");
+}
+
+void from_hex_or_throw(const std::string &text, void *data, size_t buffer_size) {
+	from_hex_or_throw(text.data(), text.size(), data, buffer_size);
+}
+
+void from_hex_or_throw(const char *text, size_t text_size, void *data, size_t buffer_size) {
+	if (text_size != buffer_size * 2)
+		throw std::runtime_error("from_hex: Wrong string size (" + common::to_string(text_size) + ") must be " +
+		                         common::to_string(buffer_size * 2));
+	if (!decode_hex(text, static_cast<uint8_t *>(data), buffer_size))
+		throw_invalid_hex(text, text_size);
+}
+
+bool from_hex(const std::string &text, void *data, size_t buffer_size) {
+	if (text.size() != buffer_size * 2)
+		return false;
+	return decode_hex(text.data(), static_cast<uint8_t *>(data), buffer_size);
+}
+
+BinaryArray from_hex(const std::string &text) { return from_hex(text.data(), text.size()); }
+
+BinaryArray from_hex(const char *text, size_t text_size) {
+	if (text_size % 2 != 0)
 		throw std::runtime_error("from_hex: invalid string size");
-	BinaryArray data(text.size() / 2);
-	for (size_t i = 0; i < data.size(); ++i)
-		data[i] = from_hex(text[i * 2]) << 4 | from_hex(text[i * 2 + 1]);
+	BinaryArray data(text_size / 2);
+	if (!decode_hex(text, data.data(), data.size()))
+		throw_invalid_hex(text, text_size);
 	return data;
 }
 
@@ -78,34 +258,29 @@ bool from_hex(const std::string &text, BinaryArray *data) {
 	if (text.size() % 2 != 0)
 		return false;
 	BinaryArray result(text.size() / 2);
-	for (size_t i = 0; i < result.size(); ++i) {
-		uint8_t value1, value2;
-		if (!from_hex(text[i * 2], value1) || !from_hex(text[i * 2 + 1], value2))
-			return false;
-		result[i] = value1 << 4 | value2;
-	}
+	if (!decode_hex(text.data(), result.data(), result.size()))
+		return false;
 	*data = std::move(result);
 	return true;
 }
 
 std::string to_hex(const void *data, size_t size) {
 	std::string text;
-	for (size_t i = 0; i < size; ++i) {
-		text += "0123456789abcdef"[static_cast<const uint8_t *>(data)[i] >> 4];
-		text += "0123456789abcdef"[static_cast<const uint8_t *>(data)[i] & 0x0f];
-	}
-
+	append_hex(data, size, &text);
 	return text;
 }
 
-std::string to_hex(const BinaryArray &data) {
-	std::string text;
-	for (size_t i = 0; i < data.size(); ++i) {
-		text += "0123456789abcdef"[data[i] >> 4];
-		text += "0123456789abcdef"[data[i] & 0x0f];
-	}
+std::string to_hex(const BinaryArray &data) { return to_hex(data.data(), data.size()); }
 
-	return text;
+void append_hex(const void *data, size_t size, std::string *text) {
+	const size_t was_size = text->size();
+	text->resize(was_size + size * 2);
+	char *out         = &(*text)[was_size];
+	const auto *bytes = static_cast<const uint8_t *>(data);
+	for (size_t i = encode_hex_blocks(bytes, size, out); i < size; ++i) {
+		out[i * 2]     = "0123456789abcdef"[bytes[i] >> 4];
+		out[i * 2 + 1] = "0123456789abcdef"[bytes[i] & 0x0f];
+	}
 }
 
 std::string extract(std::string &text, char delimiter) {
@@ -19,8 +19,10 @@ BinaryArray as_binary_array(const std::string &data);
 uint8_t from_hex(char character);
 bool from_hex(char character, uint8_t &value);
 void from_hex_or_throw(const std::string &text, void *data, size_t buffer_size);
+void from_hex_or_throw(const char *text, size_t text_size, void *data, size_t buffer_size);
 bool from_hex(const std::string &text, void *data, size_t buffer_size);
 BinaryArray from_hex(const std::string &text);  // Returns values of hex 'text', throws on error
+BinaryArray from_hex(const char *text, size_t text_size);
 bool from_hex(const std::string &text, BinaryArray *data);
 
 template<typename T>
@@ -31,6 +33,7 @@ bool pod_from_hex(const std::string &text, T *val) {
 
 std::string to_hex(const void *data, size_t size);
 std::string to_hex(const BinaryArray &data);
+void append_hex(const void *data, size_t size, std::string *text);
 
 template<class T>
 std::string pod_to_hex(const T &s) {
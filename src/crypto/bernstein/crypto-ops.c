@@ -3566,3 +3566,43 @@ int sc_iszero(const struct cryptoEllipticCurveScalar *ss) {
     s[18] | s[19] | s[20] | s[21] | s[22] | s[23] | s[24] | s[25] | s[26] |
     s[27] | s[28] | s[29] | s[30] | s[31]) == 0;
 }
+
+/* Converts many points with single field inversion (Montgomery trick).
+   scratch must hold 10 * count int32_t. */
+void ge_tobytes_batch(struct cryptoEllipticCurvePoint *ss, const ge_p2 *h, size_t count, int32_t *scratch) {
+  fe *acc = (fe *) scratch;
+  fe inv;
+  fe recip;
+  fe x;
+  fe y;
+  size_t i;
+
+  if (count == 0) {
+    return;
+  }
+  for (i = 0; i != count; ++i) {
+    if (!fe_isnonzero(h[i].Z)) { /* Not a valid point, keep single conversion semantics */
+      for (i = 0; i != count; ++i) {
+        ge_tobytes(&ss[i], &h[i]);
+      }
+      return;
+    }
+  }
+  fe_copy(acc[0], h[0].Z);
+  for (i = 1; i != count; ++i) {
+    fe_mul(acc[i], acc[i - 1], h[i].Z);
+  }
+  fe_invert(inv, acc[count - 1]);
+  for (i = count - 1; i != 0; --i) {
+    fe_mul(recip, inv, acc[i - 1]);
+    fe_mul(inv, inv, h[i].Z);
+    fe_mul(x, h[i].X, recip);
+    fe_mul(y, h[i].Y, recip);
+    fe_tobytes(ss[i].data, y);
+    ss[i].data[31] ^= fe_isnegative(x) << 7;
+  }
+  fe_mul(x, h[0].X, inv);
+  fe_mul(y, h[0].Y, inv);
+  fe_tobytes(ss[0].data, y);
+  ss[0].data[31] ^= fe_isnegative(x) << 7;
+}
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "c_types.h"
+#include <stddef.h>
 #include <stdint.h>
 #if defined(__cplusplus)
 extern "C" {
@@ -122,6 +123,7 @@ void sc_mul(struct cryptoEllipticCurveScalar *, const struct cryptoEllipticCurve
 void sc_invert(struct cryptoEllipticCurveScalar *, const struct cryptoEllipticCurveScalar *);
 int sc_isvalid_vartime(const struct cryptoEllipticCurveScalar *);
 int sc_iszero(const struct cryptoEllipticCurveScalar *); // Doesn't normalize
+void ge_tobytes_batch(struct cryptoEllipticCurvePoint *, const ge_p2 *, size_t count, int32_t *scratch); // scratch is 10 * count
 
 #if defined(__cplusplus)
 }
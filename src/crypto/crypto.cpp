@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
 
@@ -367,6 +368,71 @@ bool check_ring_signature(const Hash &prefix_hash, const KeyImage &image, const
 	return sc_iszero(&h) != 0;
 }
 
+bool check_ring_signatures_batch(const RingSignatureCheck checks[], size_t count, std::vector<bool> *results) {
+	struct MemberPoints {
+		ge_p3 pub;
+		ge_p3 hash_pub;
+	};
+	std::map<PublicKey, MemberPoints> members;  // Ring members often repeat inside block
+	std::vector<ge_p2> points;                   // L, R for each member of each ring
+	std::vector<size_t> first_point(count);
+	std::vector<bool> valid(count, true);
+	for (size_t k = 0; k != count; ++k) {
+		const RingSignatureCheck &check = checks[k];
+		const RingSignature &sig        = *check.sig;
+		first_point[k]                  = points.size();
+		ge_dsmp image_dsm;
+		if (sig.size() != check.pubs_count || !ge_dsm_frombytes_vartime(image_dsm, check.image) ||
+		    (check.key_image_subgroup_check && ge_check_subgroup_precomp_vartime(image_dsm) != 0)) {
+			valid[k] = false;
+			continue;
+		}
+		for (size_t i = 0; i < check.pubs_count; i++) {
+			if (!sc_isvalid_vartime(&sig[i].c) || !sc_isvalid_vartime(&sig[i].r)) {
+				valid[k] = false;
+				points.resize(first_point[k]);
+				break;
+			}
+			auto mit = members.find(check.pubs[i]);
+			if (mit == members.end()) {
+				const ge_p3 pub_p3 = ge_frombytes_vartime(check.pubs[i]);
+				mit = members.insert(std::make_pair(check.pubs[i], MemberPoints{pub_p3, hash_to_ec_p3(check.pubs[i])}))
+				          .first;
+			}
+			points.push_back(ge_double_scalarmult_base_vartime(sig[i].c, mit->second.pub, sig[i].r));
+			points.push_back(
+			    ge_double_scalarmult_precomp_vartime(sig[i].r, mit->second.hash_pub, sig[i].c, image_dsm));
+		}
+	}
+	std::vector<EllipticCurvePoint> point_bytes(points.size());
+	std::vector<int32_t> scratch(10 * points.size());
+	ge_tobytes_batch(point_bytes.data(), points.data(), points.size(), scratch.data());
+	bool all_valid = true;
+	std::vector<uint8_t> buf_storage;
+	for (size_t k = 0; k != count; ++k) {
+		if (valid[k]) {
+			const RingSignatureCheck &check = checks[k];
+			buf_storage.resize(rs_comm_size(check.pubs_count));
+			MiniBuffer buf(buf_storage.data(), buf_storage.size());
+			EllipticCurveScalar sum;
+			sc_0(&sum);
+			buf.append(check.prefix_hash);
+			for (size_t i = 0; i < check.pubs_count; i++) {
+				buf.append(point_bytes[first_point[k] + 2 * i]);
+				buf.append(point_bytes[first_point[k] + 2 * i + 1]);
+				sc_add(&sum, &sum, &(*check.sig)[i].c);
+			}
+			EllipticCurveScalar h = buf.hash_to_scalar();
+			sc_sub(&h, &h, &sum);
+			valid[k] = sc_iszero(&h) != 0;
+		}
+		all_valid = all_valid && valid[k];
+	}
+	if (results)
+		*results = std::move(valid);
+	return all_valid;
+}
+
 RingSignature3 generate_ring_signature3(const Hash &prefix_hash, const std::vector<KeyImage> &images,
     const std::vector<std::vector<PublicKey>> &pubs, const std::vector<SecretKey> &secs,
     const std::vector<size_t> &sec_indexes, const SecretKey &view_secret_key) {
@@ -563,6 +629,53 @@ PublicKey underive_public_key(
 	return ge_tobytes(ge_p1p1_to_p2(point_diff));
 }
 
+void generate_key_derivations_batch(
+    const SecretKey &view_secret_key, const PublicKey tx_public_keys[], size_t count, KeyDerivation derivations[]) {
+	check_scalar(view_secret_key);
+	std::vector<ge_p2> points;
+	std::vector<size_t> point_items;
+	points.reserve(count);
+	point_items.reserve(count);
+	for (size_t i = 0; i != count; ++i) {
+		derivations[i] = KeyDerivation{};
+		ge_p3 tx_public_key_p3;
+		if (ge_frombytes_vartime(&tx_public_key_p3, &tx_public_keys[i]) != 0)
+			continue;
+		points.push_back(ge_p1p1_to_p2(ge_mul8(ge_scalarmult(view_secret_key, tx_public_key_p3))));
+		point_items.push_back(i);
+	}
+	std::vector<EllipticCurvePoint> point_bytes(points.size());
+	std::vector<int32_t> scratch(10 * points.size());
+	ge_tobytes_batch(point_bytes.data(), points.data(), points.size(), scratch.data());
+	for (size_t j = 0; j != points.size(); ++j)
+		static_cast<EllipticCurvePoint &>(derivations[point_items[j]]) = point_bytes[j];
+}
+
+void underive_public_keys_batch(
+    const KeyDerivation derivations[], const OutputScanItem items[], size_t count, PublicKey spend_public_keys[]) {
+	std::vector<ge_p2> points;
+	std::vector<size_t> point_items;
+	points.reserve(count);
+	point_items.reserve(count);
+	for (size_t i = 0; i != count; ++i) {
+		spend_public_keys[i] = PublicKey{};
+		ge_p3 output_public_key_p3;
+		if (ge_frombytes_vartime(&output_public_key_p3, &items[i].output_public_key) != 0)
+			continue;
+		const EllipticCurveScalar scalar = derivation_to_scalar(derivations[items[i].tx_number], items[i].output_index);
+		const ge_cached point3           = ge_p3_to_cached(ge_scalarmult_base(scalar));
+		ge_p1p1 point_diff;
+		ge_sub(&point_diff, &output_public_key_p3, &point3);
+		points.push_back(ge_p1p1_to_p2(point_diff));
+		point_items.push_back(i);
+	}
+	std::vector<EllipticCurvePoint> point_bytes(points.size());
+	std::vector<int32_t> scratch(10 * points.size());
+	ge_tobytes_batch(point_bytes.data(), points.data(), points.size(), scratch.data());
+	for (size_t j = 0; j != points.size(); ++j)
+		static_cast<EllipticCurvePoint &>(spend_public_keys[point_items[j]]) = point_bytes[j];
+}
+
 Signature generate_sendproof(const PublicKey &txkey_pub, const SecretKey &txkey_sec,
     const PublicKey &receiver_view_key_pub, const KeyDerivation &derivation, const Hash &message_hash) {
 	const ge_p3 receiver_view_key_pub_p3 = ge_frombytes_vartime(receiver_view_key_pub);
@@ -829,6 +942,47 @@ PublicKey unlinkable_underive_public_key(const SecretKey &view_secret_key, const
 	return ge_tobytes(ge_scalarmult(*spend_scalar, output_public_key_p3));
 }
 
+void unlinkable_underive_public_keys_batch(const SecretKey &view_secret_key, const Hash tx_inputs_hashes[],
+    const OutputScanItem items[], size_t count, PublicKey spend_public_keys[], SecretKey spend_scalars[]) {
+	check_scalar(view_secret_key);
+	std::vector<ge_p3> output_public_keys;
+	std::vector<ge_p2> points;
+	std::vector<size_t> point_items;
+	output_public_keys.reserve(count);
+	points.reserve(count);
+	point_items.reserve(count);
+	for (size_t i = 0; i != count; ++i) {
+		spend_public_keys[i] = PublicKey{};
+		spend_scalars[i]     = SecretKey{};
+		ge_p3 output_public_key_p3;
+		ge_p3 encrypted_output_secret_p3;
+		if (ge_frombytes_vartime(&output_public_key_p3, &items[i].output_public_key) != 0 ||
+		    ge_frombytes_vartime(&encrypted_output_secret_p3, &items[i].encrypted_output_secret) != 0)
+			continue;
+		const ge_cached p_v = ge_p3_to_cached(ge_scalarmult3(view_secret_key, output_public_key_p3));
+		ge_p1p1 point_diff;
+		ge_sub(&point_diff, &encrypted_output_secret_p3, &p_v);
+		output_public_keys.push_back(output_public_key_p3);
+		points.push_back(ge_p1p1_to_p2(point_diff));
+		point_items.push_back(i);
+	}
+	std::vector<EllipticCurvePoint> point_bytes(points.size());
+	std::vector<int32_t> scratch(10 * points.size());
+	ge_tobytes_batch(point_bytes.data(), points.data(), points.size(), scratch.data());  // output secrets
+	for (size_t j = 0; j != points.size(); ++j) {
+		const OutputScanItem &item = items[point_items[j]];
+		FixedBuffer<sizeof(PublicKey) + sizeof(Hash) + max_varint_size> cr_comm;
+		cr_comm.append(point_bytes[j]);
+		cr_comm.append(tx_inputs_hashes[item.tx_number]);
+		cr_comm.append(item.output_index);
+		spend_scalars[point_items[j]] = cr_comm.hash_to_scalar();
+		points[j]                     = ge_scalarmult(spend_scalars[point_items[j]], output_public_keys[j]);
+	}
+	ge_tobytes_batch(point_bytes.data(), points.data(), points.size(), scratch.data());  // spend keys
+	for (size_t j = 0; j != points.size(); ++j)
+		static_cast<EllipticCurvePoint &>(spend_public_keys[point_items[j]]) = point_bytes[j];
+}
+
 SecretKey unlinkable_derive_secret_key(const SecretKey &spend_secret_key, const SecretKey &spend_scalar) {
 	check_scalar(spend_secret_key);
 	check_scalar(spend_scalar);
@@ -81,6 +81,19 @@ RingSignature generate_ring_signature(const Hash &prefix_hash, const KeyImage &i
 bool check_ring_signature(const Hash &prefix_hash, const KeyImage &image, const PublicKey pubs[], size_t pubs_count,
     const RingSignature &sig, bool key_image_subgroup_check);
 
+// Ring signatures hash every L and R point, so they cannot be folded into one multi-scalar multiplication.
+// Batch check shares point decompression between rings with the same members and converts all points
+// to bytes with a single field inversion. Returns true if all are valid, results (if not null) get per-ring verdicts
+struct RingSignatureCheck {
+	Hash prefix_hash;
+	KeyImage image;
+	const PublicKey *pubs         = nullptr;
+	size_t pubs_count             = 0;
+	const RingSignature *sig      = nullptr;
+	bool key_image_subgroup_check = false;
+};
+bool check_ring_signatures_batch(const RingSignatureCheck checks[], size_t count, std::vector<bool> *results);
+
 RingSignature3 generate_ring_signature3(const Hash &prefix_hash, const std::vector<KeyImage> &images,
     const std::vector<std::vector<PublicKey>> &pubs, const std::vector<SecretKey> &secs,
     const std::vector<size_t> &sec_indexes, const SecretKey &view_secret_key);
@@ -118,6 +131,20 @@ PublicKey underive_public_key(const KeyDerivation &derivation, size_t output_ind
 SecretKey derive_secret_key(
     const KeyDerivation &derivation, std::size_t output_index, const SecretKey &spend_secret_key);
 
+// Wallets scan every output of every transaction. Batch versions give the same results as calling single
+// versions for each item, but convert all points of each stage to bytes with single field inversion.
+// Items with invalid keys get zero results instead of exceptions (zero keys are never found in wallet).
+struct OutputScanItem {
+	size_t tx_number    = 0;  // index into per-transaction array (derivations or tx_inputs_hashes)
+	size_t output_index = 0;
+	PublicKey output_public_key;
+	PublicKey encrypted_output_secret;  // unlinkable only
+};
+void generate_key_derivations_batch(
+    const SecretKey &view_secret_key, const PublicKey tx_public_keys[], size_t count, KeyDerivation derivations[]);
+void underive_public_keys_batch(
+    const KeyDerivation derivations[], const OutputScanItem items[], size_t count, PublicKey spend_public_keys[]);
+
 Signature generate_sendproof(const PublicKey &txkey_pub, const SecretKey &txkey_sec,
     const PublicKey &receiver_view_key_pub, const KeyDerivation &derivation, const Hash &message_hash);
 
@@ -151,6 +178,9 @@ PublicKey unlinkable_underive_public_key(const SecretKey &view_secret_key, const
     size_t output_index, const PublicKey &output_public_key, const PublicKey &encrypted_output_secret,
     SecretKey *spend_scalar);
 
+void unlinkable_underive_public_keys_batch(const SecretKey &view_secret_key, const Hash tx_inputs_hashes[],
+    const OutputScanItem items[], size_t count, PublicKey spend_public_keys[], SecretKey spend_scalars[]);
+
 SecretKey unlinkable_derive_secret_key(const SecretKey &spend_secret_key, const SecretKey &spend_scalar);
 
 void unlinkable_underive_address(const PublicKey &output_secret, const Hash &tx_inputs_hash, size_t output_index,
@@ -11,46 +11,138 @@
 #else
 #include <sys/mman.h>
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
 
 #endif
 
 namespace crypto {
 
-enum { MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff) };
+enum { MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff), HUGE_PAGE_SIZE = 2 * 1024 * 1024 };
 
 #if defined(_WIN32)
 
-CryptoNightContext::CryptoNightContext() {
-	data = VirtualAlloc(nullptr, MAP_SIZE, MEM_COMMIT, PAGE_READWRITE);
+// Large pages on Windows require SeLockMemoryPrivilege, which is almost never granted, so we do not try
+CryptoNightContext::CryptoNightContext(size_t ways, bool) : ways(ways), map_size(MAP_SIZE * ways) {
+	if (ways == 0 || ways > SLOW_HASH_MAX_WAYS)
+		throw std::bad_alloc();
+	data = map_data = VirtualAlloc(nullptr, map_size, MEM_COMMIT, PAGE_READWRITE);
 	if (data == nullptr)
 		throw std::bad_alloc();
 }
 
 CryptoNightContext::~CryptoNightContext() {
-	if (!VirtualFree(data, 0, MEM_RELEASE))
+	if (!VirtualFree(map_data, 0, MEM_RELEASE))
 		assert(false);
 }
 
 #else
 
-CryptoNightContext::CryptoNightContext() {
+static size_t round_up(size_t size, size_t page) { return (size + page - 1) / page * page; }
+
+#if defined(MADV_HUGEPAGE)
+// False if administrator set transparent huge pages to "never", or kernel has no support
+static bool transparent_huge_pages_enabled() {
+	std::ifstream enabled("/sys/kernel/mm/transparent_hugepage/enabled");
+	std::string line;
+	return std::getline(enabled, line) && line.find("[never]") == std::string::npos;
+}
+
+// Kernel can give ordinary pages even after madvise, if memory is fragmented, so we look at mapping in smaps
+static bool has_anon_huge_pages(const void *addr) {
+	std::ifstream smaps("/proc/self/smaps");
+	const size_t address = reinterpret_cast<size_t>(addr);
+	bool inside          = false;
+	for (std::string line; std::getline(smaps, line);) {
+		size_t begin = 0, end = 0;
+		char dash    = 0;
+		std::istringstream range(line);
+		if (range >> std::hex >> begin >> dash >> end && dash == '-') {  // header line of next mapping
+			inside = address >= begin && address < end;
+			continue;
+		}
+		const char prefix[] = "AnonHugePages:";
+		if (inside && line.compare(0, sizeof(prefix) - 1, prefix) == 0)
+			return std::stoul(line.substr(sizeof(prefix) - 1)) != 0;
+	}
+	return false;
+}
+#endif
+
+bool CryptoNightContext::map_huge_pages() {
+	const size_t aligned_size = round_up(map_size, HUGE_PAGE_SIZE);
+#if defined(MAP_HUGETLB)
+	// Explicit huge pages, only if administrator reserved them (vm.nr_hugepages)
+	map_data = mmap(nullptr, aligned_size, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+	if (map_data != MAP_FAILED) {
+		map_size     = aligned_size;
+		data         = map_data;
+		huge_pages   = true;
+		locked_pages = mlock(data, map_size) == 0;
+		return true;
+	}
+#endif
+#if defined(MADV_HUGEPAGE)
+	if (!transparent_huge_pages_enabled())
+		return false;
+	// Transparent huge pages, we align mapping so that kernel can use them, pages must not be touched before madvise
+	map_data = mmap(nullptr, aligned_size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map_data == MAP_FAILED)
+		return false;
+	data = reinterpret_cast<void *>(round_up(reinterpret_cast<size_t>(map_data), HUGE_PAGE_SIZE));
+	if (madvise(data, aligned_size, MADV_HUGEPAGE) != 0) {
+		munmap(map_data, aligned_size + HUGE_PAGE_SIZE);
+		return false;
+	}
+	map_size     = aligned_size + HUGE_PAGE_SIZE;
+	locked_pages = mlock(data, aligned_size) == 0;
+	if (!locked_pages)  // RLIMIT_MEMLOCK is usually too small, touch pages so that kernel allocates them now
+		std::memset(data, 0, aligned_size);
+	huge_pages = has_anon_huge_pages(data);
+	return true;  // mapping is used even if kernel gave ordinary pages
+#else
+	return false;
+#endif
+}
+
+CryptoNightContext::CryptoNightContext(size_t ways, bool try_huge_pages) : ways(ways), map_size(MAP_SIZE * ways) {
+	if (ways == 0 || ways > SLOW_HASH_MAX_WAYS)
+		throw std::bad_alloc();
+	if (try_huge_pages && map_huge_pages())
+		return;
 #if !defined(__APPLE__)
-	data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	map_data = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
 #else
-	data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	map_data = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
 #endif
-	if (data == MAP_FAILED)
+	if (map_data == MAP_FAILED)
 		throw std::bad_alloc();
-	mlock(data, MAP_SIZE);
+	data         = map_data;
+	locked_pages = mlock(data, map_size) == 0;
 }
 
 CryptoNightContext::~CryptoNightContext() {
-	if (munmap(data, MAP_SIZE) != 0)
+	if (munmap(map_data, map_size) != 0)
 		assert(false);
 }
 
 #endif
 
+void CryptoNightContext::cn_slow_hash_multi(
+    const void *const src_data[], const size_t lengths[], Hash hashes[], size_t count) {
+	assert(count <= ways);
+	void *scratchpads[SLOW_HASH_MAX_WAYS]{};
+	for (size_t i = 0; i != count; ++i)
+		scratchpads[i] = reinterpret_cast<uint8_t *>(data) + i * MAP_SIZE;
+	cryptoHash results[SLOW_HASH_MAX_WAYS];
+	crypto_cn_slow_hash_multi(scratchpads, src_data, lengths, results, count);
+	for (size_t i = 0; i != count; ++i)
+		static_cast<cryptoHash &>(hashes[i]) = results[i];
+}
+
 static Hash fill_merge_mining_branches(const std::vector<MergeMiningItem *> &pitems, size_t depth) {
 	if (pitems.size() == 1)
 		return pitems.at(0)->leaf;
@@ -17,7 +17,7 @@ struct cryptoHash {
 };
 #pragma pack(pop)
 
-enum { HASH_DATA_AREA = 136, SLOW_HASH_CONTEXT_SIZE = 2097552 };
+enum { HASH_DATA_AREA = 136, SLOW_HASH_CONTEXT_SIZE = 2097552, SLOW_HASH_MAX_WAYS = 4 };
 
 void crypto_cn_fast_hash(const void *data, size_t length, struct cryptoHash *hash);
 void crypto_cn_fast_hash64(const void *data, size_t length, unsigned char hash[64]);
@@ -25,6 +25,10 @@ void crypto_cn_fast_hash64(const void *data, size_t length, unsigned char hash[6
 void crypto_cn_slow_hash(void *scratchpad, const void *data, size_t length, struct cryptoHash *hash);
 void crypto_cn_slow_hash_platform_independent(
     void *scratchpad, const void *data, size_t length, struct cryptoHash *hash);
+// Calculates count (1..SLOW_HASH_MAX_WAYS) independent hashes, interleaving their memory-hard loops
+// so that latencies of AES and scratchpad reads overlap. Each hash needs its own scratchpad.
+void crypto_cn_slow_hash_multi(void *const scratchpads[], const void *const data[], const size_t lengths[],
+    struct cryptoHash hashes[], size_t count);
 
 struct cryptoKeccakState {
 	uint8_t b[200];
@@ -18,9 +18,12 @@ inline Hash cn_fast_hash(const void *data, size_t length) {
 	return h;
 }
 
+// Scratchpads are mapped with huge pages when OS allows (2 MB scratchpad is random-accessed,
+// so with 4 KB pages almost every access is TLB miss), otherwise we fall back to ordinary pages.
+// Context with ways > 1 has several scratchpads in single mapping for cn_slow_hash_multi.
 class CryptoNightContext {
 public:
-	CryptoNightContext();
+	explicit CryptoNightContext(size_t ways = 1, bool try_huge_pages = true);
 	~CryptoNightContext();
 
 	CryptoNightContext(const CryptoNightContext &) = delete;
@@ -34,10 +37,21 @@ public:
 		crypto_cn_slow_hash(data, src_data, length, &hash);
 		return hash;
 	}
+	void cn_slow_hash_multi(const void *const src_data[], const size_t lengths[], Hash hashes[], size_t count);
 	void *get_data() const { return data; }
+	size_t get_ways() const { return ways; }
+	bool has_huge_pages() const { return huge_pages; }      // kernel actually gave huge pages, not just was asked
+	bool has_locked_pages() const { return locked_pages; }  // false if mlock failed, usually due to RLIMIT_MEMLOCK
 
 private:
 	void *data;
+	size_t ways;
+	size_t map_size;
+	void *map_data;  // data is aligned inside map_data when transparent huge pages are used
+	bool huge_pages   = false;
+	bool locked_pages = false;
+
+	bool map_huge_pages();  // not on Windows
 };
 
 inline Hash tree_hash(const Hash hashes[], size_t count) {
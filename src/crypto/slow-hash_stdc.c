@@ -168,4 +168,10 @@ void crypto_cn_slow_hash(void *scratchpad, const void *data, size_t length, stru
 	crypto_cn_slow_hash_platform_independent(scratchpad, data, length, hash);
 }
 
+void crypto_cn_slow_hash_multi(void *const scratchpads[], const void *const data[], const size_t lengths[],
+    struct cryptoHash hashes[], size_t count) {
+	for (size_t h = 0; h != count; ++h)
+		crypto_cn_slow_hash_platform_independent(scratchpads[h], data[h], lengths[h], &hashes[h]);
+}
+
 #endif  // TARGET_OS_IPHONE
@@ -185,7 +185,121 @@ static void (*cn_slow_hash_fp)(void *, const void *, size_t, void *) = cn_slow_h
 
 void crypto_cn_slow_hash(void *a, const void *b, size_t c, struct cryptoHash *d) { (*cn_slow_hash_fp)(a, b, c, d); }
 
+// Multi-hash splits cn_slow_hash_aesni into phases. Only memory-hard loop is interleaved,
+// AES phases already have 8 independent blocks in flight.
+// We do not use name "ctx" below, it is defined as macro in slow-hash_x86.inl
+
+static void cn_explode_aesni(struct cn_ctx *cn, const void *data, size_t length) {
+	ALIGNED_DECL(uint8_t ExpandedKey[256], 16);
+	crypto_keccak_into_state((const uint8_t *)data, length, &cn->state.hs);
+	memcpy(cn->text, cn->state.init, INIT_SIZE_BYTE);
+	memcpy(ExpandedKey, cn->state.hs.b, AES_KEY_SIZE);
+	ExpandAESKey256(ExpandedKey);
+
+	__m128i *longoutput = (__m128i *)cn->long_state;
+	__m128i *expkey     = (__m128i *)ExpandedKey;
+	__m128i *xmminput   = (__m128i *)cn->text;
+	for (size_t i = 0; likely(i < MEMORY); i += INIT_SIZE_BYTE) {
+		for (size_t j = 0; j < 10; j++)
+			for (size_t k = 0; k != INIT_SIZE_BLK; ++k)
+				xmminput[k] = _mm_aesenc_si128(xmminput[k], expkey[j]);
+		for (size_t k = 0; k != INIT_SIZE_BLK; ++k)
+			_mm_store_si128(&(longoutput[(i >> 4) + k]), xmminput[k]);
+	}
+}
+
+static void cn_implode_aesni(struct cn_ctx *cn, struct cryptoHash *hash) {
+	ALIGNED_DECL(uint8_t ExpandedKey[256], 16);
+	memcpy(cn->text, cn->state.init, INIT_SIZE_BYTE);
+	memcpy(ExpandedKey, &cn->state.hs.b[32], AES_KEY_SIZE);
+	ExpandAESKey256(ExpandedKey);
+
+	__m128i *longoutput = (__m128i *)cn->long_state;
+	__m128i *expkey     = (__m128i *)ExpandedKey;
+	__m128i *xmminput   = (__m128i *)cn->text;
+	for (size_t i = 0; likely(i < MEMORY); i += INIT_SIZE_BYTE) {
+		for (size_t k = 0; k != INIT_SIZE_BLK; ++k)
+			xmminput[k] = _mm_xor_si128(longoutput[(i >> 4) + k], xmminput[k]);
+		for (size_t j = 0; j < 10; j++)
+			for (size_t k = 0; k != INIT_SIZE_BLK; ++k)
+				xmminput[k] = _mm_aesenc_si128(xmminput[k], expkey[j]);
+	}
+	memcpy(cn->state.init, cn->text, INIT_SIZE_BYTE);
+	crypto_keccak_permutation(&cn->state.hs);
+	extra_hashes[cn->state.hs.b[0] & 3](&cn->state, 200, hash);
+}
+
+static void cn_slow_hash_multi_aesni(void *const scratchpads[], const void *const data[], const size_t lengths[],
+    struct cryptoHash hashes[], size_t count) {
+	uint8_t *long_state[SLOW_HASH_MAX_WAYS];
+	ALIGNED_DECL(uint64_t a[SLOW_HASH_MAX_WAYS][2], 16);
+	__m128i b_x[SLOW_HASH_MAX_WAYS];
+	for (size_t h = 0; h != count; ++h) {
+		struct cn_ctx *cn = (struct cn_ctx *)scratchpads[h];
+		cn_explode_aesni(cn, data[h], lengths[h]);
+		const uint64_t *k = (const uint64_t *)cn->state.k;
+		long_state[h]     = cn->long_state;
+		a[h][0]           = k[0] ^ k[4];
+		a[h][1]           = k[1] ^ k[5];
+		b_x[h]            = _mm_set_epi64x((long long)(k[3] ^ k[7]), (long long)(k[2] ^ k[6]));
+	}
+	for (size_t i = 0; likely(i < 0x80000); i++) {
+		for (size_t h = 0; h != count; ++h) {
+			__m128i c_x = _mm_load_si128((__m128i *)&long_state[h][a[h][0] & 0x1FFFF0]);
+			__m128i a_x = _mm_load_si128((__m128i *)a[h]);
+			ALIGNED_DECL(uint64_t c[2], 16);
+			uint64_t b0, b1, hi, lo, *nextblock;
+
+			c_x = _mm_aesenc_si128(c_x, a_x);
+			_mm_store_si128((__m128i *)c, c_x);
+
+			b_x[h] = _mm_xor_si128(b_x[h], c_x);
+			_mm_store_si128((__m128i *)&long_state[h][a[h][0] & 0x1FFFF0], b_x[h]);
+
+			nextblock = (uint64_t *)&long_state[h][c[0] & 0x1FFFF0];
+			b0        = nextblock[0];
+			b1        = nextblock[1];
+			lo        = mul128(c[0], b0, &hi);
+			a[h][0] += hi;
+			a[h][1] += lo;
+			nextblock[0] = a[h][0];
+			nextblock[1] = a[h][1];
+			a[h][0] ^= b0;
+			a[h][1] ^= b1;
+			b_x[h] = c_x;
+		}
+	}
+	for (size_t h = 0; h != count; ++h)
+		cn_implode_aesni((struct cn_ctx *)scratchpads[h], &hashes[h]);
+}
+
+static void cn_slow_hash_multi_noaesni(void *const scratchpads[], const void *const data[], const size_t lengths[],
+    struct cryptoHash hashes[], size_t count) {
+	for (size_t h = 0; h != count; ++h)
+		cn_slow_hash_noaesni(scratchpads[h], data[h], lengths[h], &hashes[h]);
+}
+
+static void cn_slow_hash_multi_runtime_aes_check(void *const scratchpads[], const void *const data[],
+    const size_t lengths[], struct cryptoHash hashes[], size_t count) {
+	if (cpu_has_aesni())
+		cn_slow_hash_multi_aesni(scratchpads, data, lengths, hashes, count);
+	else
+		cn_slow_hash_multi_noaesni(scratchpads, data, lengths, hashes, count);
+}
+
+static void (*cn_slow_hash_multi_fp)(void *const[], const void *const[], const size_t[], struct cryptoHash[],
+    size_t) = cn_slow_hash_multi_runtime_aes_check;
+
+void crypto_cn_slow_hash_multi(void *const scratchpads[], const void *const data[], const size_t lengths[],
+    struct cryptoHash hashes[], size_t count) {
+	assert(count <= SLOW_HASH_MAX_WAYS);
+	(*cn_slow_hash_multi_fp)(scratchpads, data, lengths, hashes, count);
+}
+
 // If INITIALIZER fails to compile on your platform, just comment out INITIALIZER below
-INITIALIZER(detect_aes) { cn_slow_hash_fp = cpu_has_aesni() ? &cn_slow_hash_aesni : &cn_slow_hash_noaesni; }
+INITIALIZER(detect_aes) {
+	cn_slow_hash_fp       = cpu_has_aesni() ? &cn_slow_hash_aesni : &cn_slow_hash_noaesni;
+	cn_slow_hash_multi_fp = cpu_has_aesni() ? &cn_slow_hash_multi_aesni : &cn_slow_hash_multi_noaesni;
+}
 
 #endif  // !TARGET_OS_IPHONE
@@ -49,14 +49,12 @@ std::string create_binary_request_body(
 	return json_body;
 }
 
+// Json part of response, followed by 0 char. Handlers streaming binary result append to it directly
+std::string create_binary_response_prefix(const common::JsonValue &jid);
+
 template<typename ResultType>
 std::string create_binary_response_body(const ResultType &result, const common::JsonValue &jid) {
-	common::JsonValue ps_req(common::JsonValue::OBJECT);
-	ps_req.set("jsonrpc", std::string("2.0"));
-	ps_req.set("id", jid);
-	ps_req.set("result", common::JsonValue(common::JsonValue::OBJECT));
-	std::string json_body = ps_req.to_string();
-	json_body += char(0);
+	std::string json_body = create_binary_response_prefix(jid);
 	common::StringOutputStream str(json_body);  // continue writing
 	seria::BinaryOutputStream ba(str);
 	ser(const_cast<ResultType &>(result), ba);
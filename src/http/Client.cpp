@@ -30,6 +30,7 @@ void Client::clear() {
 	parser.reset();
 	buffer.clear();
 	responses.clear();
+	response_pos   = 0;
 	receiving_body = false;
 	receiving_body_stream.clear();
 	request = http::RequestHeader{};
@@ -57,10 +58,25 @@ bool Client::read_next(RequestBody &req) {
 
 void Client::write() {
 	while (!responses.empty()) {
-		responses.front().copy_to(sock);
-		if (!responses.front().empty())
+		common::ConstBuffer bufs[2];
+		size_t count = 0;
+		for (auto it = responses.begin(); it != responses.end() && count != 2; ++it) {
+			const size_t skip = count == 0 ? response_pos : 0;
+			bufs[count++]     = common::ConstBuffer{it->data() + skip, it->size() - skip};
+		}
+		size_t wc = sock.gather_write_some(bufs, count);
+		if (wc == 0)
 			break;
-		responses.pop_front();
+		while (wc != 0) {
+			const size_t left = responses.front().size() - response_pos;
+			if (wc < left) {
+				response_pos += wc;
+				break;
+			}
+			wc -= left;
+			responses.pop_front();
+			response_pos = 0;
+		}
 	}
 	if (!waiting_write_response && responses.empty() && !keep_alive) {
 		sock.shutdown_both();
@@ -73,10 +89,9 @@ void Client::write(ResponseBody &&response) {
 	waiting_write_response = false;
 	invariant(response.r.http_version_major, "Someone forgot to set version, method, status or url");
 	this->keep_alive = response.r.keep_alive;
-	std::string str  = response.r.to_string();
-	responses.emplace_back();
-	responses.back().write(str.data(), str.size());
-	responses.emplace_back(std::move(response.body));
+	responses.push_back(response.r.to_string());
+	if (!response.body.empty())
+		responses.push_back(std::move(response.body));
 	write();
 }
 
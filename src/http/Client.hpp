@@ -28,7 +28,8 @@ private:
 	friend class Server;
 
 	common::CircularBuffer buffer;
-	std::deque<common::StringStream> responses;
+	std::deque<std::string> responses;  // header and body of response are sent with single gather write
+	size_t response_pos = 0;            // already sent part of responses.front()
 
 	http::RequestHeader request;
 	http::RequestParser parser;
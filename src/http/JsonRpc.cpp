@@ -2,6 +2,7 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for details.
 
 #include "http/JsonRpc.hpp"
+#include <memory>
 
 namespace cn { namespace json_rpc {
 
@@ -45,74 +46,70 @@ void make_generic_error_reponse(common::JsonValue &resp, const std::string &what
 	resp.insert("error", error);
 }
 
-void Request::parse(const std::string &request_body, bool allow_empty_id) {
-	common::JsonValue ps_req;
+// Envelope is checked with JsonInputStreamText without parsing params or result, they are parsed later directly
+// into their types. Only id and error (both small) become JsonValue
+static std::unique_ptr<seria::JsonInputStreamText> parse_envelope(const std::string &body, const char *what) {
+	std::unique_ptr<seria::JsonInputStreamText> s;
 	try {
-		ps_req = common::JsonValue::from_string(request_body);
+		s = std::make_unique<seria::JsonInputStreamText>(body, true);
 	} catch (const std::exception &ex) {
 		throw Error(PARSE_ERROR, common::what(ex));
 	}
-	if (!ps_req.is_object())
-		throw Error(INVALID_REQUEST, "Request is not a json object");
-	if (!ps_req.contains("jsonrpc"))
-		throw Error(INVALID_REQUEST, "Request must include jsonrpc key");
-	auto &j = ps_req("jsonrpc");
-	if (!j.is_string() || j.get_string() != "2.0")
+	if (s->raw_value()[0] != '{')
+		throw Error(INVALID_REQUEST, std::string(what) + " is not a json object");
+	s->begin_object();
+	if (!s->object_key("jsonrpc"))
+		throw Error(INVALID_REQUEST, std::string(what) + " must include jsonrpc key");
+	if (s->raw_value() != common::StringView("\"2.0\""))
 		throw Error(INVALID_REQUEST, "jsonrpc value must be exactly \"2.0\"");
-	if (!ps_req.contains("method"))
+	return s;
+}
+
+static common::JsonValue parse_id(seria::JsonInputStreamText &s) {
+	common::JsonValue result = common::JsonValue::from_string(std::string(s.raw_value()));
+	if (!result.is_string() && !result.is_integer() && !result.is_nil())  // Json RPC spec 4.2
+		throw Error(INVALID_REQUEST, "id value must be an integer number, string or null");
+	return result;
+}
+
+void Request::parse(const std::string &request_body, bool allow_empty_id) {
+	auto s = parse_envelope(request_body, "Request");
+	if (!s->object_key("method"))
 		throw Error(INVALID_REQUEST, "Request must include method key");
-	auto &m = ps_req("method");
-	if (!m.is_string())
+	if (s->raw_value()[0] != '"')
 		throw Error(INVALID_REQUEST, "method value must be string");
-	method = m.get_string();
-	if (ps_req.contains("id")) {
-		auto &p = ps_req("id");
-		if (!p.is_string() && !p.is_integer() && !p.is_nil())  // Json RPC spec 4.2
-			throw Error(INVALID_REQUEST, "id value must be an integer number, string or null");
-		jid = std::move(p);
+	s->object_key("method");
+	s->seria_v(method);
+	if (s->object_key("id")) {
+		jid = parse_id(*s);
 	} else {
 		if (!allow_empty_id)
 			throw Error(INVALID_REQUEST, "id value is REQUIRED");
 	}
-	if (ps_req.contains("params")) {
-		auto &p = ps_req("params");
-		if (!p.is_object() && !p.is_array())  // Json RPC spec 4.2
+	if (s->object_key("params")) {
+		const common::StringView p = s->raw_value();
+		if (p[0] != '{' && p[0] != '[')  // Json RPC spec 4.2
 			throw Error(INVALID_REQUEST, "params value must be an object or array");
-		params = std::move(p);
+		params_text = std::string(p);
 	}
 }
 
 void Response::parse(const std::string &response_body) {
-	common::JsonValue ps_req;
-	try {
-		ps_req = common::JsonValue::from_string(response_body);
-	} catch (const std::exception &ex) {
-		throw Error(PARSE_ERROR, common::what(ex));
-	}
-	if (!ps_req.is_object())
-		throw Error(INVALID_REQUEST, "Response is not a json object");
-	if (!ps_req.contains("jsonrpc"))
-		throw Error(INVALID_REQUEST, "Response must include jsonrpc key");
-	auto &j = ps_req("jsonrpc");
-	if (!j.is_string() || j.get_string() != "2.0")
-		throw Error(INVALID_REQUEST, "jsonrpc value must be exactly \"2.0\"");
-	if (!ps_req.contains("id"))
+	auto s = parse_envelope(response_body, "Response");
+	if (!s->object_key("id"))
 		throw Error(INVALID_REQUEST, "id value is REQUIRED");
-	auto &p = ps_req("id");
-	if (!p.is_string() && !p.is_integer() && !p.is_nil())  // Json RPC spec 4.2
-		throw Error(INVALID_REQUEST, "id value must be an integer number, string or null");
-	jid = std::move(p);
-	if (ps_req.contains("result"))
-		result = std::move(ps_req("result"));
-	if (ps_req.contains("error")) {
-		auto &e = ps_req("error");
+	jid = parse_id(*s);
+	if (s->object_key("result"))
+		result_text = std::string(s->raw_value());
+	if (s->object_key("error")) {
+		auto e = common::JsonValue::from_string(std::string(s->raw_value()));
 		if (!e.is_object())
 			throw Error(INVALID_REQUEST, "error value must be an object");
 		error = std::move(e);
 	}
-	if (result && error)
+	if (!result_text.empty() && error)
 		throw Error(INVALID_REQUEST, "Response cannot contain both error and result");
-	if (!result && !error)
+	if (result_text.empty() && !error)
 		throw Error(INVALID_REQUEST, "Response must contain either error or result");
 }
 
@@ -123,6 +120,15 @@ std::string create_error_response_body(const Error &error, const common::JsonVal
 	ps_req.set("error", seria::to_json_value(error));
 	return ps_req.to_string();
 }
+std::string create_binary_response_prefix(const common::JsonValue &jid) {
+	common::JsonValue ps_req(common::JsonValue::OBJECT);
+	ps_req.set("jsonrpc", std::string("2.0"));
+	ps_req.set("id", jid);
+	ps_req.set("result", common::JsonValue(common::JsonValue::OBJECT));
+	std::string json_body = ps_req.to_string();
+	json_body += char(0);
+	return json_body;
+}
 std::string create_binary_response_error_body(const Error &error, const common::JsonValue &jid) {
 	//	static_assert(std::is_base_of<json_rpc::Error, ErrorType>::value, "ErrorType must be an json_rpc::Error
 	// descendant");
@@ -47,8 +47,8 @@ public:
 	}
 	template<typename T>
 	void load_params(T &v) const {
-		if (params)
-			seria::from_json_value(v, params.get());
+		if (!params_text.empty())
+			seria::from_json_text(v, params_text);
 	}
 	const std::string &get_method() const { return method; }
 	const OptionalJsonValue &get_id() const { return jid; }
@@ -56,7 +56,7 @@ public:
 private:
 	void parse(const std::string &request_body, bool allow_empty_id);
 
-	OptionalJsonValue params;
+	std::string params_text;  // Parsed directly into params type by load_params
 	OptionalJsonValue jid;
 	std::string method;
 };
@@ -76,15 +76,14 @@ public:
 	}
 	template<typename T>
 	void get_result(T &v) const {
-		invariant(result, "");
-		seria::from_json_value(v, result.get());
+		invariant(!result_text.empty(), "");
+		seria::from_json_text(v, result_text);
 	}
 
 private:
 	void parse(const std::string &response_body);
 
-	OptionalJsonValue result;
-	std::string result_body;
+	std::string result_text;  // Parsed directly into result type by get_result
 	common::JsonValue jid;
 	OptionalJsonValue error;
 };
@@ -95,16 +94,18 @@ std::string prepare_result_prefix(const common::JsonValue &jid);
 template<typename ParamsType>
 http::RequestBody create_request(const std::string &uri, const std::string &method, const ParamsType &params,
     const OptionalJsonValue &jid = common::JsonValue(nullptr)) {
-	common::JsonValue ps_req(common::JsonValue::OBJECT);
-	ps_req.set("jsonrpc", std::string("2.0"));
-	ps_req.set("method", method);
-	ps_req.set("params", seria::to_json_value(params));
+	std::string body = "{\"jsonrpc\":\"2.0\",\"method\":\"";
+	common::JsonValue::escape_string(method.data(), method.size(), &body);
+	body += "\",\"params\":";
+	seria::JsonOutputStreamText s(body);
+	ser(const_cast<ParamsType &>(params), s);
 	if (jid)
-		ps_req.set("id", jid.get());
+		body += ",\"id\":" + jid.get().to_string();
+	body += "}";
 	http::RequestBody http_request;
 	http_request.r.set_firstline("POST", uri, 1, 1);
 	http_request.r.headers.push_back({"Content-Type", "application/json; charset=utf-8"});
-	http_request.set_body(ps_req.to_string());
+	http_request.set_body(std::move(body));
 	return http_request;
 }
 
@@ -0,0 +1,142 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "AsyncLogWriter.hpp"
+#include "FileLogger.hpp"
+#include "common/Invariant.hpp"
+
+namespace logging {
+
+static std::atomic<uint64_t> next_writer_id{1};
+
+thread_local std::vector<std::pair<uint64_t, AsyncLogWriter::Ring *>> AsyncLogWriter::thread_rings;
+
+AsyncLogWriter::AsyncLogWriter(size_t queue_size, bool drop_on_overflow)
+    : queue_size(queue_size), drop_on_overflow(drop_on_overflow), id(next_writer_id++) {
+	invariant(queue_size != 0, "AsyncLogWriter queue size must not be 0");
+	thread = std::thread(&AsyncLogWriter::thread_run, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		quit = true;
+	}
+	have_messages.notify_all();
+	thread.join();
+}
+
+AsyncLogWriter::Ring *AsyncLogWriter::get_ring() {
+	for (const auto &tr : thread_rings)
+		if (tr.first == id)
+			return tr.second;
+	std::unique_lock<std::mutex> lock(mutex);
+	rings.push_back(std::make_unique<Ring>(queue_size));
+	thread_rings.emplace_back(id, rings.back().get());
+	return rings.back().get();
+}
+
+void AsyncLogWriter::push(FileLogger *target, const std::string &message) {
+	Ring *ring       = get_ring();
+	const size_t pos = ring->tail.load(std::memory_order_relaxed);
+	size_t head      = ring->head.load(std::memory_order_acquire);
+	while (pos - head == queue_size) {
+		if (drop_on_overflow) {
+			dropped += 1;
+			return;
+		}
+		have_messages.notify_one();
+		std::unique_lock<std::mutex> lock(mutex);
+		have_space.wait_for(lock, std::chrono::milliseconds(10));
+		head = ring->head.load(std::memory_order_acquire);
+	}
+	Record &record = ring->records[pos % queue_size];
+	record.target  = target;
+	record.message.assign(message);  // reuses capacity left by previous message
+	ring->tail.store(pos + 1, std::memory_order_release);
+	if (pos == head)  // writer may be sleeping, otherwise it will see message on its next pass
+		have_messages.notify_one();
+}
+
+void AsyncLogWriter::flush() {
+	std::vector<std::pair<Ring *, size_t>> tails;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (const auto &ring : rings)
+			tails.emplace_back(ring.get(), ring->tail.load(std::memory_order_acquire));
+	}
+	for (const auto &rt : tails)
+		while (rt.first->head.load(std::memory_order_acquire) < rt.second) {
+			have_messages.notify_one();
+			std::unique_lock<std::mutex> lock(mutex);
+			have_space.wait_for(lock, std::chrono::milliseconds(10));
+		}
+}
+
+size_t AsyncLogWriter::get_queued() const {
+	std::unique_lock<std::mutex> lock(mutex);
+	size_t result = 0;
+	for (const auto &ring : rings)
+		result += ring->tail.load(std::memory_order_acquire) - ring->head.load(std::memory_order_acquire);
+	return result;
+}
+
+size_t AsyncLogWriter::write_pass() {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		ring_snapshot.clear();
+		for (const auto &ring : rings)
+			ring_snapshot.push_back(ring.get());
+	}
+	size_t count = 0;
+	ring_heads.clear();
+	for (Ring *ring : ring_snapshot) {
+		size_t head       = ring->head.load(std::memory_order_relaxed);
+		const size_t tail = ring->tail.load(std::memory_order_acquire);
+		for (; head != tail; ++head) {
+			Record &record = ring->records[head % queue_size];
+			auto bit       = buffers.begin();
+			while (bit != buffers.end() && bit->first != record.target)
+				++bit;
+			if (bit == buffers.end())
+				bit = buffers.emplace(buffers.end(), record.target, std::string());
+			FileLogger::append_for_file(&bit->second, record.message);
+			if (record.message.capacity() > 64 * 1024)  // do not keep memory of rare huge messages
+				std::string().swap(record.message);
+			count += 1;
+		}
+		ring_heads.push_back(head);
+	}
+	const size_t now_dropped = dropped;
+	if (now_dropped != reported_dropped) {
+		for (auto &buf : buffers)
+			FileLogger::append_for_file(&buf.second,
+			    "--- " + std::to_string(now_dropped - reported_dropped) + " log messages dropped, queue is full\n");
+		reported_dropped = now_dropped;
+	}
+	for (auto &buf : buffers)
+		if (!buf.second.empty()) {
+			buf.first->write_to_file(buf.second);
+			buf.second.clear();
+		}
+	// Slots are released after writing, so flush() returns when messages are in files
+	for (size_t i = 0; i != ring_snapshot.size(); ++i)
+		ring_snapshot[i]->head.store(ring_heads[i], std::memory_order_release);
+	written += count;
+	if (count != 0)
+		have_space.notify_all();
+	return count;
+}
+
+void AsyncLogWriter::thread_run() {
+	while (true) {
+		const size_t count = write_pass();
+		std::unique_lock<std::mutex> lock(mutex);
+		if (quit)
+			break;
+		if (count == 0)  // timeout in case we missed notification, push does not lock mutex
+			have_messages.wait_for(lock, std::chrono::milliseconds(100));
+	}
+	write_pass();  // loggers stopped pushing before destructor was called
+}
+}  // namespace logging
@@ -0,0 +1,71 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/Nocopy.hpp"
+
+namespace logging {
+
+class FileLogger;
+
+// Writes messages of FileLoggers from background thread, so logging thread does not wait for disk.
+// Each logging thread has its own single-producer ring, so pushing takes no locks. When ring is full,
+// message is dropped and counted if drop_on_overflow, otherwise logging thread waits for writer.
+// Messages from different threads can be written slightly out of order, each has its own timestamp.
+class AsyncLogWriter : private common::Nocopy {
+public:
+	AsyncLogWriter(size_t queue_size, bool drop_on_overflow);
+	~AsyncLogWriter();  // writes all queued messages, loggers must outlive writer
+
+	void push(FileLogger *target, const std::string &message);
+	void flush();  // returns when all messages pushed before the call are written
+
+	size_t get_queued() const;
+	size_t get_written() const { return written; }
+	size_t get_dropped() const { return dropped; }
+
+private:
+	struct Record {
+		FileLogger *target = nullptr;
+		std::string message;
+	};
+	struct Ring {
+		explicit Ring(size_t size) : records(size) {}
+		std::vector<Record> records;
+		std::atomic<size_t> head{0};  // advanced by writer thread
+		std::atomic<size_t> tail{0};  // advanced by owner thread
+	};
+	const size_t queue_size;
+	const bool drop_on_overflow;
+	const uint64_t id;  // rings are found by id, because new writer can get address of destroyed one
+	std::atomic<size_t> written{0};
+	std::atomic<size_t> dropped{0};
+
+	mutable std::mutex mutex;
+	std::condition_variable have_messages;
+	std::condition_variable have_space;
+	bool quit = false;
+	std::vector<std::unique_ptr<Ring>> rings;  // never removed, thread can log again after long pause
+
+	// Used by writer thread only
+	std::vector<Ring *> ring_snapshot;
+	std::vector<size_t> ring_heads;
+	std::vector<std::pair<FileLogger *, std::string>> buffers;  // one write per logger per pass
+	size_t reported_dropped = 0;
+
+	std::thread thread;
+
+	static thread_local std::vector<std::pair<uint64_t, Ring *>> thread_rings;
+	Ring *get_ring();
+	size_t write_pass();
+	void thread_run();
+};
+}  // namespace logging
@@ -7,54 +7,99 @@ namespace logging {
 
 namespace {
 
-std::string format_pattern(
-    const std::string &pattern, const std::string &category, Level level, boost::posix_time::ptime time) {
-	std::stringstream s;
+void append_number(std::string *s, uint64_t value, size_t digits) {
+	char buf[20];
+	size_t pos = sizeof(buf);
+	do {
+		buf[--pos] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0 || sizeof(buf) - pos < digits);
+	s->append(buf + pos, sizeof(buf) - pos);
+}
 
+// Formats the same text as boost streaming operators, but without stringstream and locale, which took most time
+// of logging call. Date is like 2018-Jan-05, time like 09:03:07.000125 (fraction is omitted when zero)
+void append_pattern(std::string *s, const std::string &pattern, const std::string &category, Level level,
+    boost::posix_time::ptime time) {
+	static const char *const MONTHS[] = {
+	    "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
 	for (const char *p = pattern.c_str(); p && *p != 0; ++p) {
-		if (*p == '%') {
-			++p;
-			switch (*p) {
-			case 0:
-				break;
-			case 'C':
-				s << category;
-				break;
-			case 'D':
-				s << time.date();
-				break;
-			case 'T':
-				s << time.time_of_day();
-				break;
-			case 'l':
-				s << ILogger::LEVEL_NAMES[level][0];
+		if (*p != '%') {
+			*s += *p;
+			continue;
+		}
+		++p;
+		switch (*p) {
+		case 0:
+			return;
+		case 'C':
+			*s += category;
+			break;
+		case 'D': {
+			if (time.is_special()) {
+				std::stringstream ss;
+				ss << time.date();
+				*s += ss.str();
 				break;
-			case 'L':
-				s << std::setw(4) << std::left << ILogger::LEVEL_NAMES[level];
+			}
+			const auto ymd = time.date().year_month_day();
+			append_number(s, ymd.year, 4);
+			*s += '-';
+			*s += MONTHS[ymd.month - 1];
+			*s += '-';
+			append_number(s, ymd.day, 2);
+			break;
+		}
+		case 'T': {
+			const auto tod = time.time_of_day();
+			if (time.is_special() || tod.is_negative()) {
+				std::stringstream ss;
+				ss << tod;
+				*s += ss.str();
 				break;
-			default:
-				s << *p;
 			}
-		} else {
-			s << *p;
+			append_number(s, tod.hours(), 2);
+			*s += ':';
+			append_number(s, tod.minutes(), 2);
+			*s += ':';
+			append_number(s, tod.seconds(), 2);
+			if (tod.fractional_seconds() != 0) {
+				*s += '.';
+				append_number(s, tod.fractional_seconds(), boost::posix_time::time_duration::num_fractional_digits());
+			}
+			break;
+		}
+		case 'l':
+			*s += ILogger::LEVEL_NAMES[level][0];
+			break;
+		case 'L':
+			*s += ILogger::LEVEL_NAMES[level];
+			if (ILogger::LEVEL_NAMES[level].size() < 4)
+				s->append(4 - ILogger::LEVEL_NAMES[level].size(), ' ');
+			break;
+		default:
+			*s += *p;
 		}
 	}
-
-	return s.str();
 }
 }  // namespace
 
 void CommonLogger::write(
     const std::string &category, Level level, boost::posix_time::ptime time, const std::string &body) {
 	if (level <= log_level && m_disabled_categories.count(category) == 0) {
-		std::string body2 = body;
-		if (!pattern.empty()) {
-			size_t insert_pos = 0;
-			if (body2.size() >= 2 && body2[0] == ILogger::COLOR_PREFIX) {
-				insert_pos = 2;
-			}
-			body2.insert(insert_pos, format_pattern(pattern, category, level, time));
+		if (pattern.empty()) {
+			do_log_string(body);
+			return;
+		}
+		size_t insert_pos = 0;
+		if (body.size() >= 2 && body[0] == ILogger::COLOR_PREFIX) {
+			insert_pos = 2;
 		}
+		std::string body2;
+		body2.reserve(body.size() + 64);
+		body2.append(body, 0, insert_pos);
+		append_pattern(&body2, pattern, category, level, time);
+		body2.append(body, insert_pos, std::string::npos);
 
 		do_log_string(body2);
 	}
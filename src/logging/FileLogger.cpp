@@ -2,35 +2,58 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for details.
 
 #include "FileLogger.hpp"
+#include "AsyncLogWriter.hpp"
 #include "common/ConsoleTools.hpp"
 #include "common/exception.hpp"
 #include "platform/PathTools.hpp"
 
 namespace logging {
 
-FileLogger::FileLogger(const std::string &fullfilenamenoext, size_t max_size, Level level)
-    : CommonLogger(level), initial_max_size(max_size), max_size(max_size), fullfilenamenoext(fullfilenamenoext) {
+FileLogger::FileLogger(
+    const std::string &fullfilenamenoext, size_t max_size, Level level, AsyncLogWriter *async_writer)
+    : CommonLogger(level)
+    , async_writer(async_writer)
+    , initial_max_size(max_size)
+    , max_size(max_size)
+    , fullfilenamenoext(fullfilenamenoext) {
 	file_stream = std::make_unique<platform::FileStream>(this->fullfilenamenoext + ".log", platform::O_OPEN_ALWAYS);
 	file_stream->seek(0, SEEK_END);
 }
 
 void FileLogger::do_log_string(const std::string &message) {
-	std::lock_guard<std::mutex> lock(mutex);
+	if (async_writer) {
+		async_writer->push(this, message);
+		return;
+	}
 	std::string real_message;
-	real_message.reserve(message.size());
+	append_for_file(&real_message, message);
+	write_to_file(real_message);
+}
 
-	for (size_t char_pos = 0; char_pos < message.size(); ++char_pos) {
-		if (message[char_pos] == ILogger::COLOR_PREFIX) {
-			char_pos += 1;
-		} else {
+void FileLogger::append_for_file(std::string *buffer, const std::string &message) {
+	buffer->reserve(buffer->size() + message.size());
+	for (size_t pos = 0; pos < message.size();) {
 #ifdef _WIN32
-			if (message[char_pos] == '\n')
-				real_message += "\r\n";
-			else
+		const size_t next = message.find_first_of(std::string{ILogger::COLOR_PREFIX, '\n'}, pos);
+#else
+		const size_t next = message.find(ILogger::COLOR_PREFIX, pos);
 #endif
-				real_message += message[char_pos];
+		if (next == std::string::npos) {
+			buffer->append(message, pos, std::string::npos);
+			return;
 		}
+		buffer->append(message, pos, next - pos);
+		if (message[next] == ILogger::COLOR_PREFIX) {
+			pos = next + 2;  // color letter follows prefix
+			continue;
+		}
+		*buffer += "\r\n";
+		pos = next + 1;
 	}
+}
+
+void FileLogger::write_to_file(const std::string &real_message) {
+	std::lock_guard<std::mutex> lock(mutex);
 	try {
 		if (file_stream)
 			file_stream->write(real_message.data(), real_message.size());
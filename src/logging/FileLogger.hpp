@@ -9,14 +9,23 @@
 
 namespace logging {
 
+class AsyncLogWriter;
+
 class FileLogger : public CommonLogger {
 public:
-	explicit FileLogger(const std::string &fullfilenamenoext, size_t max_size, Level level = DEBUGGING);
+	// With async_writer, messages are queued and written (and log rotated) by writer thread
+	explicit FileLogger(const std::string &fullfilenamenoext, size_t max_size, Level level = DEBUGGING,
+	    AsyncLogWriter *async_writer = nullptr);
 
 protected:
 	virtual void do_log_string(const std::string &message) override;
 
 private:
+	friend class AsyncLogWriter;
+	static void append_for_file(std::string *buffer, const std::string &message);  // strips colors
+	void write_to_file(const std::string &real_message);
+
+	AsyncLogWriter *const async_writer;
 	std::mutex mutex;
 	const size_t initial_max_size;
 	size_t max_size;
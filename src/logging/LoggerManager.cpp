@@ -15,18 +15,22 @@ void LoggerManager::write(
 	LoggerGroup::write(category, level, time, body);
 }
 
-void LoggerManager::configure_default(
-    const std::string &log_folder, const std::string &log_prefix, const std::string &version) {
+void LoggerManager::configure_default(const std::string &log_folder, const std::string &log_prefix,
+    const std::string &version, size_t async_queue_size, bool drop_on_overflow) {
 	{
+		async_writer.reset();  // writes queued messages to old loggers
 		loggers.clear();
 		LoggerGroup::loggers.clear();
+		if (async_queue_size != 0)
+			async_writer = std::make_unique<AsyncLogWriter>(async_queue_size, drop_on_overflow);
 
 		std::unique_ptr<logging::CommonLogger> logger(
-		    new FileLogger(log_folder + "/" + log_prefix + "verbose", 1024 * 1024, TRACE));
+		    new FileLogger(log_folder + "/" + log_prefix + "verbose", 1024 * 1024, TRACE, async_writer.get()));
 		loggers.emplace_back(std::move(logger));
 		add_logger(*loggers.back());
 
-		logger.reset(new FileLogger(log_folder + "/" + log_prefix + "errors", 1024 * 1024, ERROR));
+		logger.reset(
+		    new FileLogger(log_folder + "/" + log_prefix + "errors", 1024 * 1024, ERROR, async_writer.get()));
 		loggers.emplace_back(std::move(logger));
 		add_logger(*loggers.back());
 
@@ -6,6 +6,7 @@
 #include <memory>
 #include <vector>
 //#include <mutex>
+#include "AsyncLogWriter.hpp"
 #include "LoggerGroup.hpp"
 #include "LoggerMessage.hpp"
 
@@ -14,12 +15,16 @@ namespace logging {
 class LoggerManager : public LoggerGroup {
 public:
 	LoggerManager() = default;
-	void configure_default(const std::string &log_folder, const std::string &log_prefix, const std::string &version);
-	// log_folder must exist
+	void configure_default(const std::string &log_folder, const std::string &log_prefix, const std::string &version,
+	    size_t async_queue_size = 0, bool drop_on_overflow = false);
+	// log_folder must exist. When async_queue_size is not 0, log files are written by background thread
 	virtual void write(
 	    const std::string &category, Level level, boost::posix_time::ptime time, const std::string &body) override;
 
+	const AsyncLogWriter *get_async_writer() const { return async_writer.get(); }  // nullptr if not async
+
 private:
 	std::vector<std::unique_ptr<CommonLogger>> loggers;
+	std::unique_ptr<AsyncLogWriter> async_writer;  // declared after loggers, so destroyed before them
 };
 }  // namespace logging
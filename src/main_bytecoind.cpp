@@ -27,6 +27,12 @@ Options:
   --p2p-bind-address=<ip:port>           IP and port for P2P network protocol [default: 0.0.0.0:8080].
   --p2p-external-port=<port>             External port for P2P network protocol, if port forwarding used with NAT [default: 8080].
   --bytecoind-bind-address=<ip:port>     IP and port for bytecoind RPC API [default: 127.0.0.1:8081].
+  --p2p-no-block-ranges                  Request blocks one by one, as older versions do, instead of in contiguous ranges [default: off].
+  --p2p-no-compact-blocks                Relay new blocks to peers with transaction hashes instead of short transaction ids [default: off].
+  --rpc-worker-threads=<count>           Answer read-only RPC methods (sync_blocks, get_raw_block, etc.) from worker threads [default: 0].
+  --compress-blocks                      Store blocks compressed when creating new blockchain database [default: off].
+  --log-queue-size=<count>               Messages each thread queues for background log writer, 0 to write logs directly [default: 4096].
+  --log-drop-on-overflow                 Drop log messages when queue is full instead of waiting for log writer [default: off].
   --seed-node-address=<ip:port>          Specify list (one or more) of nodes to start connecting to.
   --priority-node-address=<ip:port>      Specify list (one or more) of nodes to connect to and attempt to keep the connection open.
   --exclusive-node-address=<ip:port>     Specify list (one or more) of nodes to connect to only. All other nodes including seed nodes will be ignored.
@@ -108,7 +114,8 @@ int main(int argc, const char *argv[]) try {
 	platform::ExclusiveLock coin_lock(coin_folder, CRYPTONOTE_NAME "d.lock");
 
 	logging::LoggerManager log_manager;
-	log_manager.configure_default(config.get_data_folder("logs"), CRYPTONOTE_NAME "d-", cn::app_version());
+	log_manager.configure_default(config.get_data_folder("logs"), CRYPTONOTE_NAME "d-", cn::app_version(),
+	    config.log_queue_size, config.log_drop_on_overflow);
 
 	BlockChainState block_chain(log_manager, config, currency, false);
 	//	block_chain.test_undo_everything(0);
@@ -124,19 +131,18 @@ int main(int argc, const char *argv[]) try {
 	//		block_chain.test_print_tips();
 	//	}
 
-	boost::asio::io_service io;
-	platform::EventLoop run_loop(io);
+	platform::EventLoop run_loop;
 
 	Node node(log_manager, config, block_chain);
 
 	auto idea_ms =
 	    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - idea_start);
 	std::cout << "bytecoind started seconds=" << double(idea_ms.count()) / 1000 << std::endl;
-	while (!io.stopped()) {
+	while (!run_loop.stopped()) {
 		if (node.on_idle())  // Using it to load blockchain
-			io.poll();
+			run_loop.poll();
 		else
-			io.run_one();
+			run_loop.run_one();
 	}
 	return 0;
 } catch (const platform::ExclusiveLock::FailedToLock &ex) {
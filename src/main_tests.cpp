@@ -11,6 +11,7 @@
 #include "platform/DB.hpp"
 #include "version.hpp"
 
+#include "../tests/benchmarks/benchmarks.hpp"
 #include "../tests/blockchain/test_blockchain.hpp"
 #include "../tests/crypto/test_crypto.hpp"
 #include "../tests/hash/test_hash.hpp"
@@ -29,11 +30,54 @@ Usage:
 Options:
   -h --help                    Show this screen.
   -v --version                 Show version.
+  --benchmarks                 Run performance benchmarks instead of tests.
 )";
 
 int main(int argc, const char *argv[]) {
 	common::CommandLine cmd(argc, argv);
 
+	if (cmd.get_bool("--benchmarks")) {
+		if (cmd.should_quit(USAGE, cn::app_version()))
+			return 0;
+		std::cout << "Benchmarking Ring Checker" << std::endl;
+		benchmark_ring_checker(100, 20, 8);
+		std::cout << "Benchmarking CryptoNight" << std::endl;
+		benchmark_cryptonight(200);
+		std::cout << "Benchmarking wallet output scanning" << std::endl;
+		benchmark_wallet_scan(1000, 4);
+		std::cout << "Benchmarking sync_blocks" << std::endl;
+		benchmark_sync_blocks(cmd, 1000);
+		std::cout << "Benchmarking transaction pool" << std::endl;
+		benchmark_mempool(100000, 16 * 1024 * 1024);
+		std::cout << "Benchmarking event loop connections" << std::endl;
+		benchmark_connections(100, 1000, 64);
+		benchmark_connections(2000, 50, 64);
+		std::cout << "Benchmarking block relay" << std::endl;
+		benchmark_relay(100, 10, 1024 * 1024);
+		std::cout << "Benchmarking RPC workers" << std::endl;
+		benchmark_rpc_workers(cmd, 500, 4, 20);
+		std::cout << "Benchmarking JSON" << std::endl;
+		benchmark_json(1000, 10, 5);
+		std::cout << "Benchmarking hex" << std::endl;
+		benchmark_hex(32, 256 * 1024 * 1024);
+		benchmark_hex(64 * 1024, 256 * 1024 * 1024);
+		std::cout << "Benchmarking blocks file import" << std::endl;
+		benchmark_import(cmd, 500);
+		std::cout << "Benchmarking compressed block storage" << std::endl;
+		benchmark_block_storage(cmd, 500, 100000);
+		std::cout << "Benchmarking KV binary decoding" << std::endl;
+		benchmark_kv_binary(20, 250, 100);
+		std::cout << "Benchmarking logging" << std::endl;
+		benchmark_logging(4, 100000);
+		std::cout << "Benchmarking block download" << std::endl;
+		benchmark_block_download(cmd, 2000, 3, 0.1f);
+		std::cout << "Benchmarking compact block relay" << std::endl;
+		benchmark_block_relay(cmd, 4, 20, 2000);
+		std::cout << "Benchmarking wallet cache" << std::endl;
+		benchmark_wallet_cache(cmd, 10000, 4);
+		return 0;
+	}
+
 	std::cout << "Testing Wallet State" << std::endl;
 	test_wallet_state(cmd);
 
@@ -52,6 +52,8 @@ Options:
   --backup-wallet-data=<folder-path>    Perform hot backup of wallet file, history, payment queue and wallet cache into specified empty folder, then exit.
                                         Add --set-password to set different password for backed-up wallet file.
   --net=<main|stage|test>               Configure for mainnet or testnet [default: main].
+  --log-queue-size=<count>              Messages each thread queues for background log writer, 0 to write logs directly [default: 4096].
+  --log-drop-on-overflow                Drop log messages when queue is full instead of waiting for log writer [default: off].
 
 Options for built-in bytecoind (run when no --bytecoind-remote-address specified):
 DEPRECATED AND NOT RECOMMENDED as entailing security risk. Please always run bytecoind as a separate process.
@@ -252,7 +254,8 @@ int main(int argc, const char *argv[]) try {
 	//		wallet_file = "C:\\Users\\user\\test.wallet";
 
 	logging::LoggerManager logManagerWalletNode;
-	logManagerWalletNode.configure_default(config.get_data_folder("logs"), "walletd-", cn::app_version());
+	logManagerWalletNode.configure_default(config.get_data_folder("logs"), "walletd-", cn::app_version(),
+	    config.log_queue_size, config.log_drop_on_overflow);
 	std::unique_ptr<Wallet> wallet;
 	try {
 		if (create_wallet) {
@@ -403,14 +406,14 @@ int main(int argc, const char *argv[]) try {
 	}
 	WalletState wallet_state(*wallet, logManagerWalletNode, config, currency);
 	//	wallet_state.test_undo_blocks();
-	boost::asio::io_service io;
-	platform::EventLoop run_loop(io);
+	platform::EventLoop run_loop;
 
 	std::unique_ptr<BlockChainState> block_chain;
 	std::unique_ptr<Node> node;
 
 	logging::LoggerManager logManagerNode;
-	logManagerNode.configure_default(config.get_data_folder("logs"), CRYPTONOTE_NAME "d-", cn::app_version());
+	logManagerNode.configure_default(config.get_data_folder("logs"), CRYPTONOTE_NAME "d-", cn::app_version(),
+	    config.log_queue_size, config.log_drop_on_overflow);
 
 	std::unique_ptr<WalletNode> wallet_node;
 	try {
@@ -426,8 +429,7 @@ int main(int argc, const char *argv[]) try {
 		try {
 			if (separate_thread_for_bytecoind) {
 				bytecoind_thread      = std::thread([&prm, &logManagerNode, &config, &currency] {
-                    boost::asio::io_service io;
-                    platform::EventLoop separate_run_loop(io);
+                    platform::EventLoop separate_run_loop;
 
                     std::unique_ptr<BlockChainState> separate_block_chain;
                     std::unique_ptr<Node> separate_node;
@@ -440,11 +442,11 @@ int main(int argc, const char *argv[]) try {
                         prm.set_exception(std::current_exception());
                         return;
                     }
-                    while (!io.stopped()) {
+                    while (!separate_run_loop.stopped()) {
                         if (separate_node->on_idle())  // We load blockchain there
-                            io.poll();
+                            separate_run_loop.poll();
                         else
-                            io.run_one();
+                            separate_run_loop.run_one();
                     }
                 });
 				std::future<void> fut = prm.get_future();
@@ -468,11 +470,11 @@ int main(int argc, const char *argv[]) try {
 	    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - idea_start);
 	std::cout << "walletd started seconds=" << double(idea_ms.count()) / 1000 << std::endl;
 
-	while (!io.stopped()) {
+	while (!run_loop.stopped()) {
 		if (node && node->on_idle())  // We load blockchain there
-			io.poll();
+			run_loop.poll();
 		else
-			io.run_one();
+			run_loop.run_one();
 	}
 	return 0;
 } catch (const std::exception &ex) {  // On Windows what() is not printed if thrown from main
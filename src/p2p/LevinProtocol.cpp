@@ -39,8 +39,7 @@ BinaryArray LevinProtocol::send(CommandType rrn, uint32_t command, const BinaryA
 	head.m_flags               = rrn == RESPONSE ? LEVIN_PACKET_RESPONSE : LEVIN_PACKET_REQUEST;
 
 	// write header and body in one operation
-	BinaryArray write_buffer;
-	write_buffer.reserve(sizeof(head) + out.size());
+	BinaryArray write_buffer = common::BinaryArrayPool::take(sizeof(head) + out.size());
 
 	common::VectorOutputStream stream(write_buffer);
 	stream.write_some(&head, sizeof(head));
@@ -22,6 +22,7 @@ void P2PProtocol::on_disconnect(const std::string &ban_reason) {
 const NetworkAddress &P2PProtocol::get_address() const { return m_client->get_address(); }
 bool P2PProtocol::is_incoming() const { return m_client->is_incoming(); }
 void P2PProtocol::send(BinaryArray &&body) { return m_client->send(std::move(body)); }
+void P2PProtocol::send_shared(const common::SharedBinaryArray &body) { return m_client->send_shared(body); }
 void P2PProtocol::send_shutdown() { return m_client->send_shutdown(); }
 void P2PProtocol::disconnect(const std::string &ban_reason) { return m_client->disconnect(ban_reason); }
 void P2PProtocol::update_my_port(uint16_t port) { return m_client->update_my_port(port); }
@@ -49,10 +50,25 @@ void P2PClient::set_protocol(std::unique_ptr<P2PProtocol> &&protocol) {
 
 void P2PClient::write() {
 	while (!responses.empty()) {
-		responses.front().copy_to(sock);
-		if (!responses.front().empty())
+		common::ConstBuffer bufs[MAX_GATHER_COUNT];
+		size_t count = 0;
+		for (auto it = responses.begin(); it != responses.end() && count != MAX_GATHER_COUNT; ++it) {
+			const size_t skip = count == 0 ? response_pos : 0;
+			bufs[count++]     = common::ConstBuffer{(*it)->data() + skip, (*it)->size() - skip};
+		}
+		size_t wc = sock.gather_write_some(bufs, count);
+		if (wc == 0)
 			break;
-		responses.pop_front();
+		while (wc != 0) {
+			const size_t left = responses.front()->size() - response_pos;
+			if (wc < left) {
+				response_pos += wc;
+				break;
+			}
+			wc -= left;
+			responses.pop_front();
+			response_pos = 0;
+		}
 	}
 	if (responses.empty() && waiting_shutdown)
 		sock.shutdown_both();
@@ -103,8 +119,12 @@ bool P2PClient::read_next_request(BinaryArray &header, BinaryArray &body) {
 	return !waiting_shutdown;  // consume input when waiting_shutdown. TODO - implement socket.shutdown_read
 }
 
-void P2PClient::send(BinaryArray &&body) {
-	responses.emplace_back(std::move(body));
+void P2PClient::send(BinaryArray &&body) { send_shared(common::BinaryArrayPool::share(std::move(body))); }
+
+void P2PClient::send_shared(const common::SharedBinaryArray &body) {
+	if (body->empty())
+		return;  // would stall write()
+	responses.push_back(body);
 
 	write();
 }
@@ -120,6 +140,7 @@ void P2PClient::disconnect(const std::string &ban_reason) {
 	request               = BinaryArray();
 	receiving_body_stream = common::VectorStream();
 	responses.clear();
+	response_pos = 0;
 
 	sock.close();
 	//	std::cout << "P2PClient::disconnect this=" << std::hex << (size_t)this << std::dec << std::endl;
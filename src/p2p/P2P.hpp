@@ -32,6 +32,7 @@ public:
 	const NetworkAddress &get_address() const;
 	bool is_incoming() const;
 	virtual void send(BinaryArray &&body);
+	void send_shared(const common::SharedBinaryArray &body);  // same buffer can be queued to many clients
 	void send_shutdown();
 	void disconnect(const std::string &ban_reason);
 	P2PClient *get_client() const { return m_client; }
@@ -55,6 +56,7 @@ public:
 	const NetworkAddress &get_address() const { return address; }
 	bool is_incoming() const { return incoming; }
 	virtual void send(BinaryArray &&body);  // We want to make sure to update stats when calling with a base class
+	void send_shared(const common::SharedBinaryArray &body);
 	void send_shutdown();
 	void disconnect(const std::string &ban_reason);  // empty for no ban
 	bool test_connect(const NetworkAddress &addr);   // for single connects without p2p
@@ -87,7 +89,9 @@ private:
 
 	common::CircularBuffer buffer;
 
-	std::deque<common::VectorStream> responses;
+	enum { MAX_GATHER_COUNT = 16 };
+	std::deque<common::SharedBinaryArray> responses;
+	size_t response_pos   = 0;  // already sent part of responses.front()
 	bool waiting_shutdown = false;
 };
 
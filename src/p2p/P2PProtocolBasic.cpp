@@ -45,6 +45,7 @@ const std::map<std::pair<uint32_t, LevinProtocol::CommandType>,
         levin_pair<p2p::GetStatInfo::Response>(&P2PProtocolBasic::on_msg_stat_info),
 #endif
         levin_pair<p2p::RelayBlock::Notify>(&P2PProtocolBasic::on_msg_notify_new_block),
+        levin_pair<p2p::RelayCompactBlock::Notify>(&P2PProtocolBasic::on_msg_notify_new_block),
         levin_pair<p2p::RelayTransactions::Notify>(&P2PProtocolBasic::on_msg_notify_new_transactions),
         levin_pair<p2p::SyncPool::Notify>(&P2PProtocolBasic::on_msg_notify_request_tx_pool),
         levin_pair<p2p::SyncPool::Request>(&P2PProtocolBasic::on_msg_notify_request_tx_pool),
@@ -53,7 +54,11 @@ const std::map<std::pair<uint32_t, LevinProtocol::CommandType>,
         levin_pair<p2p::GetChainResponse::Notify>(&P2PProtocolBasic::on_msg_notify_request_chain),
         levin_pair<p2p::Checkpoint::Notify>(&P2PProtocolBasic::on_msg_notify_checkpoint),
         levin_pair<p2p::GetObjectsRequest::Notify>(&P2PProtocolBasic::on_msg_notify_request_objects),
-        levin_pair<p2p::GetObjectsResponse::Notify>(&P2PProtocolBasic::on_msg_notify_request_objects)};
+        levin_pair<p2p::GetObjectsResponse::Notify>(&P2PProtocolBasic::on_msg_notify_request_objects),
+        levin_pair<p2p::GetBlockRange::Request>(&P2PProtocolBasic::on_msg_request_block_range),
+        levin_pair<p2p::GetBlockRange::Response>(&P2PProtocolBasic::on_msg_request_block_range),
+        levin_pair<p2p::GetBlockTransactions::Request>(&P2PProtocolBasic::on_msg_request_block_transactions),
+        levin_pair<p2p::GetBlockTransactions::Response>(&P2PProtocolBasic::on_msg_request_block_transactions)};
 
 P2PProtocolBasic::P2PProtocolBasic(const Config &config, uint64_t my_unique_number, P2PClient *client)
     : P2PProtocol(client)
@@ -79,13 +84,19 @@ void P2PProtocolBasic::send(BinaryArray &&body) {
 
 Timestamp P2PProtocolBasic::get_local_time() const { return platform::now_unix_timestamp(); }
 
+P2PProtocolVersion P2PProtocolBasic::get_my_version() const {
+	return config.p2p_compact_blocks ? P2PProtocolVersion::COMPACT_BLOCKS : P2PProtocolVersion::AMETHYST;
+}
+
 BasicNodeData P2PProtocolBasic::get_my_node_data() const {
 	BasicNodeData node_data;
-	node_data.version    = P2PProtocolVersion::AMETHYST;
+	node_data.version    = get_my_version();
 	node_data.local_time = get_local_time();
 	node_data.peer_id    = my_unique_number;
 	node_data.my_port    = config.p2p_external_port;
 	node_data.network_id = config.network_id;
+	if (config.p2p_block_ranges)
+		node_data.capabilities |= P2PCapability::BLOCK_RANGES;
 	return node_data;
 }
 
@@ -111,6 +122,7 @@ void P2PProtocolBasic::on_disconnect(const std::string &ban_reason) {
 	first_message_after_handshake_processed = false;
 	set_peer_sync_data(CoreSyncData{});
 	peer_unique_number = 0;
+	peer_capabilities  = 0;
 }
 
 size_t P2PProtocolBasic::on_parse_header(common::CircularBuffer &buffer, BinaryArray &request) {
@@ -166,6 +178,7 @@ void P2PProtocolBasic::msg_handshake(p2p::Handshake::Request &&req) {
 	peer_version = req.node_data.version;
 	set_peer_sync_data(req.payload_data);
 	peer_unique_number = req.node_data.peer_id;
+	peer_capabilities  = req.node_data.capabilities;
 	update_my_port(req.node_data.my_port);  // We set port to unknown on accept
 
 	std::cout << "P2p p2p::Handshake request version=" << int(req.node_data.version)
@@ -186,6 +199,7 @@ void P2PProtocolBasic::msg_handshake(p2p::Handshake::Response &&req) {
 	    req.local_peerlist.size() > p2p::Handshake::Response::MAX_PEER_COUNT)
 		return disconnect("204 max_peer_count");
 	peer_unique_number = req.node_data.peer_id;
+	peer_capabilities  = req.node_data.capabilities;
 	set_peer_sync_data(req.payload_data);
 	std::cout << "P2p p2p::Handshake response version=" << int(req.node_data.version)
 	          << " unique_number=" << req.node_data.peer_id << " current_height=" << req.payload_data.current_height
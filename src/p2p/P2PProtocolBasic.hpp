@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include "LevinProtocol.hpp"
 #include "P2P.hpp"
 #include "P2pProtocolDefinitions.hpp"
@@ -24,7 +25,9 @@ private:
 	const uint64_t my_unique_number;
 	CoreSyncData peer_sync_data;
 	uint64_t peer_unique_number = 0;
+	uint64_t peer_capabilities  = 0;
 	Timestamp get_local_time() const;
+	P2PProtocolVersion get_my_version() const;
 	static const std::map<std::pair<uint32_t, LevinProtocol::CommandType>, std::pair<LevinHandlerFunction, size_t>>
 	    before_handshake_handlers;
 	static const std::map<std::pair<uint32_t, LevinProtocol::CommandType>, std::pair<LevinHandlerFunction, size_t>>
@@ -60,6 +63,7 @@ protected:
 	virtual void on_msg_stat_info(p2p::GetStatInfo::Response &&) {}
 #endif
 	virtual void on_msg_notify_new_block(p2p::RelayBlock::Notify &&) {}
+	virtual void on_msg_notify_new_block(p2p::RelayCompactBlock::Notify &&) {}
 	virtual void on_msg_notify_new_transactions(p2p::RelayTransactions::Notify &&) {}
 	virtual void on_msg_notify_request_tx_pool(p2p::SyncPool::Notify &&) {}
 	virtual void on_msg_notify_request_tx_pool(p2p::SyncPool::Request &&) {}
@@ -68,6 +72,10 @@ protected:
 	virtual void on_msg_notify_request_chain(p2p::GetChainResponse::Notify &&) {}
 	virtual void on_msg_notify_request_objects(p2p::GetObjectsRequest::Notify &&) {}
 	virtual void on_msg_notify_request_objects(p2p::GetObjectsResponse::Notify &&) {}
+	virtual void on_msg_request_block_range(p2p::GetBlockRange::Request &&) {}
+	virtual void on_msg_request_block_range(p2p::GetBlockRange::Response &&) {}
+	virtual void on_msg_request_block_transactions(p2p::GetBlockTransactions::Request &&) {}
+	virtual void on_msg_request_block_transactions(p2p::GetBlockTransactions::Response &&) {}
 	virtual void on_msg_notify_checkpoint(p2p::Checkpoint::Notify &&) {}
 	virtual CoreSyncData get_my_sync_data() const = 0;
 	virtual std::vector<PeerlistEntryLegacy> get_peers_to_share(bool lots) const {
@@ -79,11 +87,18 @@ protected:
 public:
 	explicit P2PProtocolBasic(const Config &config, uint64_t my_unique_number, P2PClient *client);
 	int get_peer_version() const { return peer_version; }
+	// Features added after V4 are used only if both we and peer announced them
+	int get_common_version() const { return std::min<int>(peer_version, get_my_version()); }
 	uint64_t get_my_unique_number() const { return my_unique_number; }
 	void send(BinaryArray &&body) override;
 	virtual BasicNodeData get_my_node_data() const;
 	CoreSyncData get_peer_sync_data() const { return peer_sync_data; }
 	uint64_t get_peer_unique_number() const { return peer_unique_number; }
+	// Capability is used only if both we and peer announced it
+	bool has_capability(P2PCapability capability) const {
+		return peer_version >= P2PProtocolVersion::AMETHYST &&
+		       (get_my_node_data().capabilities & peer_capabilities & capability) != 0;
+	}
 
 	static BinaryArray create_multicast_announce(const UUID &network_id, Hash genesis_bid, uint16_t p2p_external_port);
 	static uint16_t parse_multicast_announce(const unsigned char *data, size_t size, const UUID &network_id,
@@ -129,6 +129,71 @@ struct GetObjectsResponse {
 	};
 };
 
+struct GetBlockRange {  // Only when both peers announced P2PCapability::BLOCK_RANGES, otherwise ban
+	struct Request {
+		enum {
+			ID              = BC_COMMANDS_POOL_BASE + 11,
+			TYPE            = LevinProtocol::REQUEST,
+			MAX_BLOCK_COUNT = 1000,
+			MAX_SIZE        = 1024
+		};
+		Hash start_bid;
+		uint32_t count = 0;  // 1..MAX_BLOCK_COUNT, otherwise ban
+	};
+	struct Response {
+		enum {
+			ID              = BC_COMMANDS_POOL_BASE + 11,
+			TYPE            = LevinProtocol::RESPONSE,
+			MAX_BLOCKS_SIZE = 8 * 1000 * 1000,  // KV overhead per block and transaction is small and counted in it
+			MAX_SIZE        = 4096 + MAX_BLOCKS_SIZE + parameters::MAX_HEADER_SIZE + parameters::BLOCK_CAPACITY_VOTE_MAX
+		};
+		// Responses come in order of requests. Blocks are consecutive main chain blocks starting with start_bid,
+		// fewer than requested when their total size would exceed MAX_BLOCKS_SIZE (but at least one) or when
+		// peer's main chain ends, none when start_bid is not in peer's main chain
+		Hash start_bid;  // same as in request
+		std::vector<RawBlock> blocks;
+	};
+};
+
+struct RelayCompactBlock {  // Only when both peers announced P2PProtocolVersion::COMPACT_BLOCKS, otherwise ban
+	struct Notify {
+		enum {
+			ID                    = BC_COMMANDS_POOL_BASE + 12,
+			TYPE                  = LevinProtocol::NOTIFY,
+			SHORT_ID_SIZE         = 6,
+			MAX_TRANSACTION_COUNT = parameters::BLOCK_CAPACITY_VOTE_MAX / (8 * 32),  // as in RelayBlock
+			MAX_SIZE              = 4096 + parameters::MAX_HEADER_SIZE + MAX_TRANSACTION_COUNT * SHORT_ID_SIZE
+		};
+		BinaryArray header;  // BlockTemplate with coinbase, transaction_hashes must be empty, otherwise ban
+		uint64_t salt = 0;   // chosen by sender, so that colliding transactions cannot be prepared in advance
+		BinaryArray short_ids;  // SHORT_ID_SIZE bytes per block transaction, in block order
+		Hash transactions_merkle_root;  // so that receiver checks top_id before looking into its pool
+		Hash top_id;                    // hash of block
+		Height current_blockchain_height = 0;  // height of block
+	};
+};
+
+struct GetBlockTransactions {  // Asked after RelayCompactBlock for transactions not found in pool
+	struct Request {
+		enum {
+			ID       = BC_COMMANDS_POOL_BASE + 13,
+			TYPE     = LevinProtocol::REQUEST,
+			MAX_SIZE = 1024 + RelayCompactBlock::Notify::MAX_TRANSACTION_COUNT * sizeof(uint32_t)
+		};
+		Hash top_id;
+		std::vector<uint32_t> indexes;  // in transaction_hashes of block, ascending
+	};
+	struct Response {
+		enum {
+			ID       = BC_COMMANDS_POOL_BASE + 13,
+			TYPE     = LevinProtocol::RESPONSE,
+			MAX_SIZE = 4096 + parameters::BLOCK_CAPACITY_VOTE_MAX
+		};
+		Hash top_id;                            // same as in request
+		std::vector<BinaryArray> transactions;  // in order of indexes, empty if peer has no such block
+	};
+};
+
 struct GetChainRequest {
 	struct Notify {
 		enum {
@@ -245,6 +310,11 @@ void ser_members(cn::p2p::RelayBlock::Notify &v, seria::ISeria &s);
 void ser_members(cn::p2p::RelayTransactions::Notify &v, seria::ISeria &s);
 void ser_members(cn::p2p::GetObjectsRequest::Notify &v, seria::ISeria &s);
 void ser_members(cn::p2p::GetObjectsResponse::Notify &v, seria::ISeria &s);
+void ser_members(cn::p2p::GetBlockRange::Request &v, seria::ISeria &s);
+void ser_members(cn::p2p::GetBlockRange::Response &v, seria::ISeria &s);
+void ser_members(cn::p2p::RelayCompactBlock::Notify &v, seria::ISeria &s);
+void ser_members(cn::p2p::GetBlockTransactions::Request &v, seria::ISeria &s);
+void ser_members(cn::p2p::GetBlockTransactions::Response &v, seria::ISeria &s);
 void ser_members(cn::p2p::GetChainRequest::Notify &v, seria::ISeria &s);
 void ser_members(cn::p2p::GetChainResponse::Notify &v, seria::ISeria &s);
 void ser_members(cn::p2p::SyncPool::Notify &v, seria::ISeria &s);
@@ -16,8 +16,12 @@ using common::NetworkAddress;
 
 typedef uint64_t PeerIdType;
 
-enum P2PProtocolVersion : uint8_t { NO_HANDSHAKE_YET = 0, V1 = 1, AMETHYST = 4 };
+enum P2PProtocolVersion : uint8_t { NO_HANDSHAKE_YET = 0, V1 = 1, AMETHYST = 4, COMPACT_BLOCKS = 5 };
 // V4 adds several fields/messages and sets strict rules, violating would be BAN.
+// V5 adds RelayCompactBlock and GetBlockTransactions, used only if both peers announced V5 or later.
+
+enum P2PCapability : uint64_t { BLOCK_RANGES = 1 };
+// Bits announced in handshake, feature is used on connection only if both sides announced it. Unknown bits ignored
 
 #pragma pack(push, 1)
 struct UUID {
@@ -45,10 +49,11 @@ struct PeerlistEntryLegacy {
 
 struct BasicNodeData {
 	UUID network_id{};
-	uint8_t version      = 0;
-	Timestamp local_time = 0;
-	uint16_t my_port     = 0;  // p2p external port.
-	PeerIdType peer_id   = 0;
+	uint8_t version       = 0;
+	Timestamp local_time  = 0;
+	uint16_t my_port      = 0;  // p2p external port.
+	PeerIdType peer_id    = 0;
+	uint64_t capabilities = 0;  // P2PCapability bits, only in V4
 };
 
 struct CoreSyncData {
@@ -104,8 +109,58 @@ struct CoreStatistics {
 	size_t transaction_pool_size                = 0;
 	size_t transaction_pool_max_size            = 0;
 	Amount transaction_pool_lowest_fee_per_byte = 0;
+	size_t transaction_pool_memory_usage        = 0;  // bytes, estimate
 	Height upgrade_decided_height               = 0;
 	Height upgrade_votes_in_top_block           = 0;
+
+	size_t keyimage_filter_count              = 0;
+	size_t keyimage_filter_memory_usage       = 0;  // bytes
+	size_t keyimage_filter_lookups            = 0;
+	size_t keyimage_filter_false_positives    = 0;
+	size_t keyimage_filter_false_positive_ppm = 0;  // false positives per million lookups of unspent key images
+
+	size_t block_preparator_queue_depth        = 0;
+	size_t block_preparator_max_queue_depth    = 0;
+	size_t block_preparator_rejected_count     = 0;  // queue was full, block must be downloaded again
+	size_t block_preparator_prepared_count     = 0;
+	size_t block_preparator_prepared_memory    = 0;  // bytes, estimate
+	size_t block_preparator_evicted_count      = 0;
+	size_t block_preparator_average_latency_us = 0;  // from add_block until prepared
+	size_t block_preparator_max_latency_us     = 0;
+
+	size_t header_cache_count        = 0;
+	size_t header_cache_memory_usage = 0;  // bytes, estimate
+	size_t header_cache_hits         = 0;
+	size_t header_cache_misses       = 0;
+	size_t header_cache_evictions    = 0;
+	size_t header_tip_window_count   = 0;
+	size_t header_tip_window_hits    = 0;
+
+	size_t sync_blocks_cache_count         = 0;
+	size_t sync_blocks_cache_memory_usage  = 0;  // bytes, estimate
+	size_t sync_blocks_cache_hits          = 0;
+	size_t sync_blocks_cache_misses        = 0;
+	size_t sync_blocks_cache_hit_rate_ppm  = 0;
+	size_t sync_blocks_cache_bytes_served  = 0;
+	size_t sync_blocks_cache_evictions     = 0;
+	size_t sync_blocks_cache_invalidations = 0;  // chunks removed on reorganizations
+
+	size_t block_dictionary_count   = 0;  // 0 if blocks stored uncompressed
+	size_t block_cache_memory_usage = 0;  // bytes, estimate
+	size_t block_cache_hits         = 0;
+	size_t block_cache_misses       = 0;
+
+	size_t block_template_builds              = 0;
+	size_t block_template_last_build_us       = 0;
+	size_t block_template_average_build_us    = 0;
+	size_t block_template_max_build_us        = 0;
+	size_t block_template_candidates          = 0;  // pool transactions already redone for next block
+	size_t block_template_pending             = 0;  // pool transactions waiting to be redone
+	size_t block_template_redone_transactions = 0;
+
+	size_t compact_blocks_received              = 0;
+	size_t compact_blocks_reconstructed         = 0;  // added without downloading, missing transactions asked for
+	size_t compact_block_transactions_requested = 0;
 };
 
 // inline bool operator<(const NetworkAddressLegacy &a, const NetworkAddressLegacy &b) {
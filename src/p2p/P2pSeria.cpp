@@ -3,6 +3,7 @@
 
 #include "P2pProtocolDefinitions.hpp"
 #include "P2pProtocolTypes.hpp"
+#include "common/StringTools.hpp"
 #include "common/Varint.hpp"
 #include "crypto/hash.hpp"
 #include "seria/BinaryOutputStream.hpp"
@@ -34,6 +35,9 @@ typename std::enable_if<std::is_standard_layout<T>::value>::type serialize_as_bi
 	std::string blob;
 	if (serializer.is_input()) {
 		ser(blob, serializer);
+		if (blob.size() % sizeof(T) != 0)
+			throw std::runtime_error("serialize_as_binary blob size " + common::to_string(blob.size()) +
+			                         " is not a multiple of element size " + common::to_string(sizeof(T)));
 		value.resize(blob.size() / sizeof(T));
 		if (!blob.empty())
 			memcpy(&value[0], blob.data(), blob.size());
@@ -88,8 +92,51 @@ void ser_members(CoreStatistics &v, seria::ISeria &s) {
 	seria_kv("transaction_pool_size", v.transaction_pool_size, s);
 	seria_kv("transaction_pool_max_size", v.transaction_pool_max_size, s);
 	seria_kv("transaction_pool_lowest_fee_per_byte", v.transaction_pool_lowest_fee_per_byte, s);
+	seria_kv_optional("transaction_pool_memory_usage", v.transaction_pool_memory_usage, s);
 	seria_kv("upgrade_decided_height", v.upgrade_decided_height, s);
 	seria_kv("upgrade_votes_in_top_block", v.upgrade_votes_in_top_block, s);
+	seria_kv_optional("keyimage_filter_count", v.keyimage_filter_count, s);
+	seria_kv_optional("keyimage_filter_memory_usage", v.keyimage_filter_memory_usage, s);
+	seria_kv_optional("keyimage_filter_lookups", v.keyimage_filter_lookups, s);
+	seria_kv_optional("keyimage_filter_false_positives", v.keyimage_filter_false_positives, s);
+	seria_kv_optional("keyimage_filter_false_positive_ppm", v.keyimage_filter_false_positive_ppm, s);
+	seria_kv_optional("block_preparator_queue_depth", v.block_preparator_queue_depth, s);
+	seria_kv_optional("block_preparator_max_queue_depth", v.block_preparator_max_queue_depth, s);
+	seria_kv_optional("block_preparator_rejected_count", v.block_preparator_rejected_count, s);
+	seria_kv_optional("block_preparator_prepared_count", v.block_preparator_prepared_count, s);
+	seria_kv_optional("block_preparator_prepared_memory", v.block_preparator_prepared_memory, s);
+	seria_kv_optional("block_preparator_evicted_count", v.block_preparator_evicted_count, s);
+	seria_kv_optional("block_preparator_average_latency_us", v.block_preparator_average_latency_us, s);
+	seria_kv_optional("block_preparator_max_latency_us", v.block_preparator_max_latency_us, s);
+	seria_kv_optional("header_cache_count", v.header_cache_count, s);
+	seria_kv_optional("header_cache_memory_usage", v.header_cache_memory_usage, s);
+	seria_kv_optional("header_cache_hits", v.header_cache_hits, s);
+	seria_kv_optional("header_cache_misses", v.header_cache_misses, s);
+	seria_kv_optional("header_cache_evictions", v.header_cache_evictions, s);
+	seria_kv_optional("header_tip_window_count", v.header_tip_window_count, s);
+	seria_kv_optional("header_tip_window_hits", v.header_tip_window_hits, s);
+	seria_kv_optional("sync_blocks_cache_count", v.sync_blocks_cache_count, s);
+	seria_kv_optional("sync_blocks_cache_memory_usage", v.sync_blocks_cache_memory_usage, s);
+	seria_kv_optional("sync_blocks_cache_hits", v.sync_blocks_cache_hits, s);
+	seria_kv_optional("sync_blocks_cache_misses", v.sync_blocks_cache_misses, s);
+	seria_kv_optional("sync_blocks_cache_hit_rate_ppm", v.sync_blocks_cache_hit_rate_ppm, s);
+	seria_kv_optional("sync_blocks_cache_bytes_served", v.sync_blocks_cache_bytes_served, s);
+	seria_kv_optional("sync_blocks_cache_evictions", v.sync_blocks_cache_evictions, s);
+	seria_kv_optional("sync_blocks_cache_invalidations", v.sync_blocks_cache_invalidations, s);
+	seria_kv_optional("block_dictionary_count", v.block_dictionary_count, s);
+	seria_kv_optional("block_cache_memory_usage", v.block_cache_memory_usage, s);
+	seria_kv_optional("block_cache_hits", v.block_cache_hits, s);
+	seria_kv_optional("block_cache_misses", v.block_cache_misses, s);
+	seria_kv_optional("block_template_builds", v.block_template_builds, s);
+	seria_kv_optional("block_template_last_build_us", v.block_template_last_build_us, s);
+	seria_kv_optional("block_template_average_build_us", v.block_template_average_build_us, s);
+	seria_kv_optional("block_template_max_build_us", v.block_template_max_build_us, s);
+	seria_kv_optional("block_template_candidates", v.block_template_candidates, s);
+	seria_kv_optional("block_template_pending", v.block_template_pending, s);
+	seria_kv_optional("block_template_redone_transactions", v.block_template_redone_transactions, s);
+	seria_kv_optional("compact_blocks_received", v.compact_blocks_received, s);
+	seria_kv_optional("compact_blocks_reconstructed", v.compact_blocks_reconstructed, s);
+	seria_kv_optional("compact_block_transactions_requested", v.compact_block_transactions_requested, s);
 	seria_kv("peer_list_white", v.peer_list_white, s);
 	seria_kv("peer_list_gray", v.peer_list_gray, s);
 	seria_kv("connected_peers", v.connected_peers, s);
@@ -101,6 +148,8 @@ void ser_members(BasicNodeData &v, seria::ISeria &s) {
 	seria_kv("peer_id", v.peer_id, s);
 	seria_kv("local_time", v.local_time, s);
 	seria_kv("my_port", v.my_port, s);
+	if (s.is_input() || v.capabilities != 0)
+		seria_kv("capabilities", v.capabilities, s);
 }
 
 void ser_kv_plus1(common::StringView name, Height &v, seria::ISeria &s) {
@@ -204,6 +253,35 @@ void ser_members(p2p::GetObjectsResponse::Notify &v, seria::ISeria &s) {
 	ser_kv_plus1("current_blockchain_height", v.current_blockchain_height, s);
 }
 
+void ser_members(p2p::GetBlockRange::Request &v, seria::ISeria &s) {
+	seria_kv("start_bid", v.start_bid, s);
+	seria_kv("count", v.count, s);
+}
+
+void ser_members(p2p::GetBlockRange::Response &v, seria::ISeria &s) {
+	seria_kv("start_bid", v.start_bid, s);
+	seria_kv("blocks", v.blocks, s);
+}
+
+void ser_members(p2p::RelayCompactBlock::Notify &v, seria::ISeria &s) {
+	seria_kv("header", v.header, s);
+	seria_kv("salt", v.salt, s);
+	seria_kv("short_ids", v.short_ids, s);
+	seria_kv("transactions_merkle_root", v.transactions_merkle_root, s);
+	seria_kv("top_id", v.top_id, s);
+	seria_kv("current_blockchain_height", v.current_blockchain_height, s);
+}
+
+void ser_members(p2p::GetBlockTransactions::Request &v, seria::ISeria &s) {
+	seria_kv("top_id", v.top_id, s);
+	serialize_as_binary(v.indexes, "indexes", s);
+}
+
+void ser_members(p2p::GetBlockTransactions::Response &v, seria::ISeria &s) {
+	seria_kv("top_id", v.top_id, s);
+	seria_kv("transactions", v.transactions, s);
+}
+
 void ser_members(p2p::GetChainRequest::Notify &v, seria::ISeria &s) {
 	serialize_as_binary(v.block_ids, "block_ids", s);
 }
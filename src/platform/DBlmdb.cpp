@@ -39,6 +39,11 @@ platform::lmdb::Txn::Txn(Env &db_env) {
 	lmdb_check(::mdb_txn_begin(db_env.handle, nullptr, db_env.m_read_only ? MDB_RDONLY : 0, &handle), "mdb_txn_begin ");
 }
 
+platform::lmdb::Txn::Txn(const Env &db_env, bool read_only) {
+	lmdb_check(::mdb_txn_begin(db_env.handle, nullptr, (read_only || db_env.m_read_only) ? MDB_RDONLY : 0, &handle),
+	    "mdb_txn_begin ");
+}
+
 void platform::lmdb::Txn::commit() {
 	lmdb_check(::mdb_txn_commit(handle), "mdb_txn_commit ");
 	handle = nullptr;
@@ -85,9 +90,10 @@ DBlmdb::DBlmdb(OpenMode open_mode, const std::string &full_path, uint64_t max_db
 	// VALGRIND is limited to 32GB, modify line above to use (max_db_size > 28000000000 ? 28000000000 : max_db_size)
 	create_folders_if_necessary(full_path);
 	lmdb_check(::mdb_env_open(db_env.handle, full_path.c_str(),
-	               MDB_NOMETASYNC | (open_mode == O_READ_EXISTING ? MDB_RDONLY : 0), 0644),
+	               MDB_NOMETASYNC | MDB_NOTLS | (open_mode == O_READ_EXISTING ? MDB_RDONLY : 0), 0644),
 	    "Failed to open database " + full_path + " in mdb_env_open ");
 	// MDB_NOMETASYNC - We agree to trade chance of losing 1 last transaction for 2x performance boost
+	// MDB_NOTLS - ReadTxn slots are not bound to threads, so thread with write txn can also have ReadTxn
 	db_txn.reset(new lmdb::Txn(db_env));
 	db_dbi.reset(new lmdb::Dbi(*db_txn));
 }
@@ -165,6 +171,38 @@ DBlmdb::Cursor DBlmdb::rbegin(const std::string &prefix, const std::string &midd
 	return Cursor(lmdb::Cur(*db_txn, *db_dbi), prefix, middle, max_key_size, false);
 }
 
+DBlmdb::ReadTxn::ReadTxn(const DBlmdb &db) : db(db), db_txn(db.db_env, true) {}
+
+bool DBlmdb::ReadTxn::get(const std::string &key, common::BinaryArray &value) const {
+	lmdb::Val val1;
+	if (!db.db_dbi->get(db_txn, lmdb::Val(key), val1))
+		return false;
+	value.assign(val1.data(), val1.data() + val1.size());
+	return true;
+}
+
+bool DBlmdb::ReadTxn::get(const std::string &key, std::string &value) const {
+	lmdb::Val val1;
+	if (!db.db_dbi->get(db_txn, lmdb::Val(key), val1))
+		return false;
+	value = std::string(val1.data(), val1.size());
+	return true;
+}
+
+bool DBlmdb::ReadTxn::get(const std::string &key, Value &value) const {
+	return db.db_dbi->get(db_txn, lmdb::Val(key), value);
+}
+
+DBlmdb::Cursor DBlmdb::ReadTxn::begin(const std::string &prefix, const std::string &middle) const {
+	int max_key_size = ::mdb_env_get_maxkeysize(db.db_env.handle);
+	return Cursor(lmdb::Cur(db_txn, *db.db_dbi), prefix, middle, max_key_size, true);
+}
+
+DBlmdb::Cursor DBlmdb::ReadTxn::rbegin(const std::string &prefix, const std::string &middle) const {
+	int max_key_size = ::mdb_env_get_maxkeysize(db.db_env.handle);
+	return Cursor(lmdb::Cur(db_txn, *db.db_dbi), prefix, middle, max_key_size, false);
+}
+
 void DBlmdb::commit_db_txn() {
 	db_txn->commit();
 	db_txn.reset();
@@ -36,6 +36,7 @@ struct Env : private common::Nocopy {
 struct Txn : private common::Nocopy {
 	MDB_txn *handle = nullptr;
 	explicit Txn(Env &db_env);
+	Txn(const Env &db_env, bool read_only);
 	void commit();
 	~Txn();
 };
@@ -65,6 +66,7 @@ class DBlmdb {
 	std::unique_ptr<lmdb::Txn> db_txn;
 
 public:
+	class ReadTxn;
 	explicit DBlmdb(OpenMode open_mode, const std::string &full_path,
 	    uint64_t max_db_size = 0x8000000000);  // 0.5 Tb default, out of total 4 Tb on windows
 	const std::string &get_path() const { return full_path; }
@@ -92,6 +94,7 @@ public:
 		const bool forward;
 		void check_prefix(const lmdb::Val &itkey);
 		friend class DBlmdb;
+		friend class ReadTxn;
 		Cursor(lmdb::Cur &&db_cur, const std::string &prefix, const std::string &middle, size_t max_key_size,
 		    bool forward);
 
@@ -106,6 +109,22 @@ public:
 	Cursor begin(const std::string &prefix, const std::string &middle = std::string()) const;
 	Cursor rbegin(const std::string &prefix, const std::string &middle = std::string()) const;
 
+	// Sees state as of last commit_db_txn, can be used from any thread while writes continue in db_txn.
+	// Each thread needs its own ReadTxn, values and cursors must not outlive it. Keep it short, while it exists
+	// LMDB cannot reuse pages freed by later commits.
+	class ReadTxn : private common::Nocopy {
+		const DBlmdb &db;
+		mutable lmdb::Txn db_txn;
+
+	public:
+		explicit ReadTxn(const DBlmdb &db);
+		bool get(const std::string &key, common::BinaryArray &value) const;
+		bool get(const std::string &key, std::string &value) const;
+		bool get(const std::string &key, Value &value) const;
+		Cursor begin(const std::string &prefix, const std::string &middle = std::string()) const;
+		Cursor rbegin(const std::string &prefix, const std::string &middle = std::string()) const;
+	};
+
 	static std::string to_binary_key(const unsigned char *data, size_t size) {
 		std::string result;
 		result.append(reinterpret_cast<const char *>(data), size);
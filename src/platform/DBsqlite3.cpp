@@ -25,6 +25,7 @@ void sqlite::Dbi::open_check_create(OpenMode open_mode, const std::string &full_
 	                  nullptr),
 	    "sqlite3_open ");
 	invariant(open_mode != OpenMode::O_CREATE_ALWAYS, "sqlite database does not support clearing existing data");
+	sqlite::check(sqlite3_busy_timeout(handle, 5000), "sqlite3_busy_timeout");  // ms, before first lock is taken
 	if (open_mode == OpenMode::O_READ_EXISTING)
 		exec("BEGIN TRANSACTION");
 	else
@@ -34,7 +35,6 @@ void sqlite::Dbi::open_check_create(OpenMode open_mode, const std::string &full_
 	*created = !stmt_get_tables.step();
 	if (open_mode == OpenMode::O_CREATE_NEW && !*created)
 		throw Error("sqlite database " + full_path + " already exists and will not be overwritten");
-	sqlite::check(sqlite3_busy_timeout(handle, 5000), "sqlite3_busy_timeout");  // ms
 }
 
 void sqlite::Dbi::exec(const char *statement) {
@@ -228,6 +228,36 @@ bool DBsqliteKV::get(const std::string &key, std::string &value) const {
 	return true;
 }
 
+DBsqliteKV::ReadTxn::ReadTxn(const DBsqliteKV &db) {
+	bool created = false;  // Deferred transaction keeps shared lock after first read, so we read tables here
+	db_dbi.open_check_create(OpenMode::O_READ_EXISTING, db.get_path(), &created);
+	stmt_get.prepare(db_dbi, "SELECT kk, vv FROM kv_table WHERE kk = ?");
+}
+
+bool DBsqliteKV::ReadTxn::get(const std::string &key, common::BinaryArray &value) const {
+	auto result = ::get(stmt_get, key);
+	if (!result.first)
+		return false;
+	value.assign(result.first, result.first + result.second);
+	return true;
+}
+
+bool DBsqliteKV::ReadTxn::get(const std::string &key, std::string &value) const {
+	auto result = ::get(stmt_get, key);
+	if (!result.first)
+		return false;
+	value.assign(result.first, result.first + result.second);
+	return true;
+}
+
+DBsqliteKV::Cursor DBsqliteKV::ReadTxn::begin(const std::string &prefix, const std::string &middle) const {
+	return Cursor(nullptr, db_dbi, prefix, middle, true);  // erase is not allowed
+}
+
+DBsqliteKV::Cursor DBsqliteKV::ReadTxn::rbegin(const std::string &prefix, const std::string &middle) const {
+	return Cursor(nullptr, db_dbi, prefix, middle, false);
+}
+
 void DBsqliteKV::del(const std::string &key, bool mustexist) {
 	sqlite3_reset(stmt_del.handle);
 	stmt_del.bind_blob(1, key.data(), key.size());
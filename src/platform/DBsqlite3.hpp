@@ -46,6 +46,7 @@ class DBsqliteKV {
 	const std::string full_path;
 
 public:
+	class ReadTxn;
 	sqlite::Dbi db_dbi;
 
 	explicit DBsqliteKV(
@@ -77,6 +78,7 @@ public:
 		const std::string prefix;
 		void step_and_check();
 		friend class DBsqliteKV;
+		friend class ReadTxn;
 		Cursor(const DBsqliteKV *db, const sqlite::Dbi &db_dbi, const std::string &prefix, const std::string &middle,
 		    bool forward);
 
@@ -91,6 +93,20 @@ public:
 	Cursor begin(const std::string &prefix, const std::string &middle = std::string()) const;
 	Cursor rbegin(const std::string &prefix, const std::string &middle = std::string()) const;
 
+	// Separate read-only connection, sees state as of last commit_db_txn, can be used from any thread.
+	// While it exists, commit_db_txn waits (up to busy timeout) for it to finish, so keep it short.
+	class ReadTxn : private common::Nocopy {
+		sqlite::Dbi db_dbi;
+		sqlite::Stmt stmt_get;
+
+	public:
+		explicit ReadTxn(const DBsqliteKV &db);
+		bool get(const std::string &key, common::BinaryArray &value) const;
+		bool get(const std::string &key, std::string &value) const;
+		Cursor begin(const std::string &prefix, const std::string &middle = std::string()) const;
+		Cursor rbegin(const std::string &prefix, const std::string &middle = std::string()) const;
+	};
+
 	static std::string to_binary_key(const unsigned char *data, size_t size) {
 		std::string result;
 		result.append(reinterpret_cast<const char *>(data), size);
@@ -418,7 +418,782 @@ static void add_system_root_certs(ssl::context &ctx) {
 
 thread_local EventLoop *EventLoop::current_loop = nullptr;
 
-EventLoop::EventLoop(boost::asio::io_service &io_service) : io_service(io_service) {
+std::vector<std::string> TCPAcceptor::local_addresses(bool ipv4, bool ipv6) {
+	std::vector<std::string> result;
+#ifndef _WIN32  // TODO - get adapters info on Win32
+	struct ifaddrs *ifaddr = nullptr;
+	if (getifaddrs(&ifaddr) == -1)
+		return result;
+
+	for (struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+		if (ifa->ifa_addr == NULL)
+			continue;
+		int family = ifa->ifa_addr->sa_family;
+		;
+		if (family != AF_INET && family != AF_INET6)
+			continue;
+		char host[NI_MAXHOST]{};
+		int s =
+		    getnameinfo(ifa->ifa_addr, (family == AF_INET) ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6),
+		        host, NI_MAXHOST, NULL, 0, NI_NUMERICHOST);
+		if (s == 0 && ipv4 && family == AF_INET)
+			result.push_back(host);
+		if (s == 0 && ipv6 && family == AF_INET6)
+			result.push_back(host);
+	}
+	freeifaddrs(ifaddr);
+#endif
+	return result;
+}
+
+#if platform_USE_EPOLL
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <set>
+#include <system_error>
+
+static void throw_errno(const char *msg) { throw std::system_error(errno, std::generic_category(), msg); }
+
+static uint64_t monotonic_ns() {
+	struct timespec ts {};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+static std::string numeric_host(const struct sockaddr *address, socklen_t address_len) {
+	char host[NI_MAXHOST]{};
+	if (getnameinfo(address, address_len, host, NI_MAXHOST, nullptr, 0, NI_NUMERICHOST) != 0)
+		return std::string();
+	return host;
+}
+
+// Sockets and timers, epoll_event.data.ptr of registered file descriptors points to watcher
+class EpollWatcher {
+public:
+	virtual void on_event(uint32_t events) = 0;  // events == 0 for deferred calls and timers
+
+protected:
+	~EpollWatcher() = default;
+};
+
+class EventLoop::Impl {
+public:
+	Impl();
+	~Impl();
+
+	void add(int fd, EpollWatcher *watcher, uint32_t events);
+	void remove(EpollWatcher *watcher);  // watcher gets no more calls, closing fd removes it from epoll
+	void defer(EpollWatcher *watcher);   // watcher->on_event(0) will be called from run loop, never from caller
+	void start_timer(EpollWatcher *timer, uint64_t deadline);
+	void stop_timer(EpollWatcher *timer, uint64_t deadline);
+
+	void run_once(bool can_wait);
+	void wake();
+	std::atomic<bool> stopped{false};
+
+private:
+	enum { MAX_EVENTS = 256 };
+	int epoll_fd = -1;
+	int wake_fd  = -1;  // eventfd, data.ptr == &wake_fd
+	int timer_fd = -1;  // timerfd armed for earliest timer, data.ptr == &timer_fd
+
+	uint64_t timer_fd_deadline = 0;                     // 0 - not armed or already fired
+	std::set<std::pair<uint64_t, EpollWatcher *>> timers;  // (deadline, timer), earliest first
+
+	struct epoll_event events[MAX_EVENTS];
+	size_t events_pos   = 0;  // events_pos..events_count are not processed yet
+	size_t events_count = 0;
+	std::vector<EpollWatcher *> deferred;
+	std::vector<EpollWatcher *> deferred_processing;
+	size_t deferred_pos = 0;
+
+	void add_fd(int fd, void *ptr, uint32_t events);
+	void close_fds();
+	void arm_timer_fd();
+	void fire_timers();
+};
+
+EventLoop::Impl::Impl() {
+#if platform_USE_SSL
+	// OpenSSL writes to socket with ::write, which raises SIGPIPE on connection closed by peer
+	signal(SIGPIPE, SIG_IGN);
+#endif
+	try {
+		if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1)
+			throw_errno("epoll_create1");
+		if ((wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+			throw_errno("eventfd");
+		if ((timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1)
+			throw_errno("timerfd_create");
+		add_fd(wake_fd, &wake_fd, EPOLLIN);
+		add_fd(timer_fd, &timer_fd, EPOLLIN);
+	} catch (const std::exception &) {
+		close_fds();
+		throw;
+	}
+}
+
+EventLoop::Impl::~Impl() { close_fds(); }
+
+void EventLoop::Impl::close_fds() {
+	for (int fd : {timer_fd, wake_fd, epoll_fd})
+		if (fd != -1)
+			::close(fd);
+}
+
+void EventLoop::Impl::add_fd(int fd, void *ptr, uint32_t events) {
+	struct epoll_event ev {};
+	ev.events   = events;
+	ev.data.ptr = ptr;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+		throw_errno("epoll_ctl");
+}
+
+void EventLoop::Impl::add(int fd, EpollWatcher *watcher, uint32_t events) { add_fd(fd, watcher, events); }
+
+void EventLoop::Impl::remove(EpollWatcher *watcher) {
+	// Watcher can be removed by handler of another watcher while we are processing batch of events
+	for (size_t i = events_pos; i < events_count; ++i)
+		if (events[i].data.ptr == watcher)
+			events[i].data.ptr = nullptr;
+	for (size_t i = deferred_pos; i < deferred_processing.size(); ++i)
+		if (deferred_processing[i] == watcher)
+			deferred_processing[i] = nullptr;
+	deferred.erase(std::remove(deferred.begin(), deferred.end(), watcher), deferred.end());
+}
+
+void EventLoop::Impl::defer(EpollWatcher *watcher) {
+	if (std::find(deferred.begin(), deferred.end(), watcher) == deferred.end())
+		deferred.push_back(watcher);
+}
+
+void EventLoop::Impl::start_timer(EpollWatcher *timer, uint64_t deadline) {
+	timers.emplace(deadline, timer);
+	if (timers.begin()->second == timer)
+		arm_timer_fd();
+}
+
+// We do not disarm timer_fd, if it fires early fire_timers() will simply arm it again
+void EventLoop::Impl::stop_timer(EpollWatcher *timer, uint64_t deadline) {
+	timers.erase(std::make_pair(deadline, timer));
+}
+
+void EventLoop::Impl::arm_timer_fd() {
+	const uint64_t deadline = timers.empty() ? 0 : timers.begin()->first;
+	if (deadline == timer_fd_deadline)
+		return;
+	struct itimerspec spec {};  // zero it_value disarms
+	spec.it_value.tv_sec  = static_cast<time_t>(deadline / 1000000000);
+	spec.it_value.tv_nsec = static_cast<long>(deadline % 1000000000);
+	if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr) == -1)
+		throw_errno("timerfd_settime");
+	timer_fd_deadline = deadline;
+}
+
+void EventLoop::Impl::fire_timers() {
+	const uint64_t now = monotonic_ns();
+	while (!timers.empty() && timers.begin()->first <= now) {
+		EpollWatcher *timer = timers.begin()->second;
+		timers.erase(timers.begin());
+		timer->on_event(0);  // can start or stop any timers, restarted ones are always later than now
+	}
+	arm_timer_fd();
+}
+
+void EventLoop::Impl::wake() {
+	const uint64_t one = 1;
+	const auto wc      = ::write(wake_fd, &one, sizeof(one));  // fails only if counter overflows
+	(void)wc;
+}
+
+void EventLoop::Impl::run_once(bool can_wait) {
+	if (!deferred.empty()) {
+		can_wait = false;
+		deferred_processing.swap(deferred);
+		for (deferred_pos = 0; deferred_pos != deferred_processing.size();)
+			if (EpollWatcher *watcher = deferred_processing[deferred_pos++])
+				watcher->on_event(0);
+		deferred_processing.clear();
+		deferred_pos = 0;
+	}
+	const int count = epoll_wait(epoll_fd, events, MAX_EVENTS, can_wait && !stopped ? -1 : 0);
+	if (count == -1) {
+		if (errno == EINTR)
+			return;
+		throw_errno("epoll_wait");
+	}
+	uint64_t value = 0;
+	events_count   = static_cast<size_t>(count);
+	for (events_pos = 0; events_pos != events_count;) {
+		const struct epoll_event ev = events[events_pos++];
+		if (ev.data.ptr == &wake_fd) {
+			const auto rc = ::read(wake_fd, &value, sizeof(value));
+			(void)rc;
+		} else if (ev.data.ptr == &timer_fd) {
+			const auto rc = ::read(timer_fd, &value, sizeof(value));
+			(void)rc;
+			timer_fd_deadline = 0;
+			fire_timers();
+		} else if (ev.data.ptr)
+			static_cast<EpollWatcher *>(ev.data.ptr)->on_event(ev.events);
+	}
+	events_pos = events_count = 0;
+}
+
+EventLoop::EventLoop() {
+	if (current_loop)
+		throw std::logic_error("RunLoop::RunLoop Only single RunLoop per thread is allowed");
+	m_impl       = std::make_unique<Impl>();
+	current_loop = this;
+}
+
+EventLoop::~EventLoop() { current_loop = nullptr; }
+
+void EventLoop::run() {
+	while (!m_impl->stopped)
+		m_impl->run_once(true);
+}
+void EventLoop::run_one() { m_impl->run_once(true); }
+void EventLoop::poll() { m_impl->run_once(false); }
+bool EventLoop::stopped() const { return m_impl->stopped; }
+void EventLoop::cancel() {
+	m_impl->stopped = true;
+	m_impl->wake();
+}
+void EventLoop::wake() { m_impl->wake(); }
+
+class Timer::Impl : public EpollWatcher {
+public:
+	explicit Impl(Timer *owner) : owner(owner), loop(EventLoop::current()->impl()) {}
+	Timer *owner;
+	EventLoop::Impl *loop;
+	uint64_t deadline = 0;  // 0 if not started
+
+	void on_event(uint32_t events) override {  // loop removed us from timers already
+		deadline = 0;
+		owner->a_handler();
+	}
+};
+
+void Timer::cancel() {
+	if (!impl || impl->deadline == 0)
+		return;
+	impl->loop->stop_timer(impl.get(), impl->deadline);
+	impl->deadline = 0;
+}
+
+void Timer::once(float after_seconds) {
+	cancel();
+	if (!impl)
+		impl = std::make_shared<Impl>(this);
+	const double after_ns = std::max(0.0, 1e9 * after_seconds / get_time_multiplier_for_tests());
+	impl->deadline        = monotonic_ns() + std::max<uint64_t>(1, static_cast<uint64_t>(after_ns));
+	impl->loop->start_timer(impl.get(), impl->deadline);
+}
+
+// Edge-triggered, so we read and write until EAGAIN or until our buffer is full (empty). If we stopped
+// reading because incoming_buffer is full, read_some() defers next read to the run loop.
+class TCPSocket::Impl : public EpollWatcher {
+public:
+	enum { MAX_GATHER_COUNT = 16 };
+	explicit Impl(TCPSocket *owner)
+	    : owner(owner), loop(EventLoop::current()->impl()), incoming_buffer(8192), outgoing_buffer(8192) {}
+	~Impl() { close(false); }
+	TCPSocket *owner;
+	EventLoop::Impl *loop;
+	int fd               = -1;
+	bool pending_connect = false;
+	bool connected       = false;  // after connect and SSL handshake
+	bool asked_shutdown  = false;
+	bool shutdown_sent   = false;
+	bool can_read        = false;  // stopped reading because incoming_buffer was full
+	bool can_write       = false;  // kernel accepted everything we wrote last time
+	bool failed          = false;  // error or disconnect, will be reported from run loop
+#if platform_USE_SSL
+	std::shared_ptr<ssl::context> ssl_context;
+	SSL *ssl = nullptr;
+#endif
+	common::CircularBuffer incoming_buffer;
+	common::CircularBuffer outgoing_buffer;
+
+	void close(bool called_from_run_loop) {
+		loop->remove(this);
+#if platform_USE_SSL
+		if (ssl)
+			SSL_free(ssl);
+		ssl = nullptr;
+		ssl_context.reset();
+#endif
+		if (fd != -1)
+			::close(fd);
+		fd              = -1;
+		pending_connect = false;
+		connected       = false;
+		asked_shutdown  = false;
+		shutdown_sent   = false;
+		can_read        = false;
+		can_write       = false;
+		failed          = false;
+		incoming_buffer.clear();
+		outgoing_buffer.clear();
+		if (called_from_run_loop)
+			owner->d_handler();
+	}
+	bool start_connect(const struct addrinfo &address, bool use_ssl, const std::string &host) {
+		fd = ::socket(address.ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd == -1)
+			return false;
+		if (::connect(fd, address.ai_addr, address.ai_addrlen) == -1 && errno != EINPROGRESS)
+			return false;
+#if platform_USE_SSL
+		if (use_ssl) {
+			ssl_context = std::make_shared<ssl::context>(ssl::context::tlsv12_client);
+			add_system_root_certs(*ssl_context);
+			ssl = SSL_new(ssl_context->native_handle());
+			if (!ssl || !SSL_set_fd(ssl, fd) || !SSL_set_tlsext_host_name(ssl, host.c_str()) ||
+			    !X509_VERIFY_PARAM_set1_host(SSL_get0_param(ssl), host.c_str(), 0))
+				return false;
+			SSL_set_verify(ssl, SSL_VERIFY_PEER, nullptr);
+		}
+#endif
+		pending_connect = true;
+		loop->add(fd, this, EPOLLIN | EPOLLOUT | EPOLLET);
+		return true;
+	}
+	void attach(int accepted_fd) {
+		fd        = accepted_fd;
+		connected = true;
+		can_write = true;
+		loop->add(fd, this, EPOLLIN | EPOLLOUT | EPOLLET);
+	}
+	bool finish_connect(uint32_t events) {
+		if (pending_connect) {
+			if ((events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) == 0)
+				return false;
+			int error     = 0;
+			socklen_t len = sizeof(error);
+			if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1 || error != 0) {
+				failed = true;
+				return false;
+			}
+			pending_connect = false;
+		}
+#if platform_USE_SSL
+		if (ssl) {
+			const int rc = SSL_connect(ssl);
+			if (rc != 1) {
+				const int err = SSL_get_error(ssl, rc);
+				if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE)
+					failed = true;
+				return false;
+			}
+		}
+#endif
+		connected = true;
+		can_write = true;
+		return true;
+	}
+	// Returns number of bytes read, 0 on EAGAIN, sets failed on error or disconnect
+	size_t read_chunk() {
+#if platform_USE_SSL
+		if (ssl) {
+			const int rc = SSL_read(ssl, incoming_buffer.write_ptr(), static_cast<int>(incoming_buffer.write_count()));
+			if (rc > 0)
+				return static_cast<size_t>(rc);
+			const int err = SSL_get_error(ssl, rc);
+			if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE)
+				failed = true;
+			return 0;
+		}
+#endif
+		struct iovec bufs[2] = {{incoming_buffer.write_ptr(), incoming_buffer.write_count()},
+		    {incoming_buffer.write_ptr2(), incoming_buffer.write_count2()}};
+		while (true) {
+			const ssize_t rc = ::readv(fd, bufs, 2);
+			if (rc > 0)
+				return static_cast<size_t>(rc);
+			if (rc == -1 && errno == EINTR)
+				continue;
+			if (rc == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+				failed = true;
+			return 0;
+		}
+	}
+	bool do_read() {
+		bool progress = false;
+		can_read      = false;
+		while (!failed) {
+			if (incoming_buffer.full()) {
+				can_read = true;
+				break;
+			}
+			const size_t capacity = incoming_buffer.capacity();
+			const size_t rc       = read_chunk();
+			if (rc == 0)
+				break;
+			if (!asked_shutdown) {
+				incoming_buffer.did_write(rc);
+				progress = true;
+			}
+			if (rc < capacity && !ssl_active())
+				break;  // short read means kernel buffer is empty, saves us syscall returning EAGAIN
+		}
+		return progress;
+	}
+	// Returns number of bytes written, 0 on EAGAIN, sets failed on error
+	size_t write_chunk() {
+#if platform_USE_SSL
+		if (ssl) {
+			const int rc = SSL_write(ssl, outgoing_buffer.read_ptr(), static_cast<int>(outgoing_buffer.read_count()));
+			if (rc > 0)
+				return static_cast<size_t>(rc);
+			const int err = SSL_get_error(ssl, rc);
+			if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE)
+				failed = true;
+			return 0;
+		}
+#endif
+		struct iovec bufs[2] = {{const_cast<unsigned char *>(outgoing_buffer.read_ptr()), outgoing_buffer.read_count()},
+		    {const_cast<unsigned char *>(outgoing_buffer.read_ptr2()), outgoing_buffer.read_count2()}};
+		struct msghdr msg {};
+		msg.msg_iov    = bufs;
+		msg.msg_iovlen = 2;
+		while (true) {
+			const ssize_t rc = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+			if (rc > 0)
+				return static_cast<size_t>(rc);
+			if (rc == -1 && errno == EINTR)
+				continue;
+			if (rc == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+				failed = true;
+			return 0;
+		}
+	}
+	bool do_write() {
+		bool progress = false;
+		can_write     = true;
+		while (!failed && !outgoing_buffer.empty()) {
+			const size_t size = outgoing_buffer.size();
+			const size_t wc   = write_chunk();
+			if (wc != 0) {
+				outgoing_buffer.did_read(wc);
+				progress = true;
+			}
+			if (wc == 0 || (wc < size && !ssl_active())) {
+				can_write = false;  // short write means kernel buffer is full, EPOLLOUT will come
+				break;
+			}
+		}
+		if (!failed && outgoing_buffer.empty() && asked_shutdown && !shutdown_sent) {
+			shutdown_sent = true;
+			::shutdown(fd, SHUT_RDWR);
+		}
+		return progress;
+	}
+	void write_from_client() {  // called from write_some and shutdown_both, errors are reported from run loop
+		if (!connected || !can_write || failed)
+			return;
+		do_write();
+		if (failed)
+			loop->defer(this);
+	}
+	size_t write_gather(const common::ConstBuffer *buffers, size_t count) {
+		size_t sent = 0;
+		if (connected && can_write && !failed && outgoing_buffer.empty() && !ssl_active()) {
+			struct iovec bufs[MAX_GATHER_COUNT];
+			size_t requested     = 0;
+			const size_t iov_len = std::min<size_t>(count, MAX_GATHER_COUNT);
+			for (size_t i = 0; i != iov_len; ++i) {
+				bufs[i] = {const_cast<void *>(buffers[i].data), buffers[i].size};
+				requested += buffers[i].size;
+			}
+			struct msghdr msg {};
+			msg.msg_iov    = bufs;
+			msg.msg_iovlen = iov_len;
+			while (requested != 0) {
+				const ssize_t rc = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+				if (rc > 0) {
+					sent = static_cast<size_t>(rc);
+					if (sent < requested)
+						can_write = false;  // short write means kernel buffer is full, EPOLLOUT will come
+					break;
+				}
+				if (rc == -1 && errno == EINTR)
+					continue;
+				if (rc == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+					failed = true;
+					loop->defer(this);
+					return 0;
+				}
+				can_write = false;
+				break;
+			}
+		}
+		size_t queued = 0;
+		size_t skip   = sent;
+		for (size_t i = 0; i != count; ++i) {
+			if (skip >= buffers[i].size) {
+				skip -= buffers[i].size;
+				continue;
+			}
+			const size_t size = buffers[i].size - skip;
+			const size_t wc   = outgoing_buffer.write_some(static_cast<const char *>(buffers[i].data) + skip, size);
+			skip              = 0;
+			queued += wc;
+			if (wc != size)
+				break;
+		}
+		write_from_client();
+		return sent + queued;
+	}
+	bool ssl_active() const {
+#if platform_USE_SSL
+		return ssl != nullptr;
+#else
+		return false;
+#endif
+	}
+
+	void on_event(uint32_t events) override {
+		bool progress = false;
+		if (!connected && !failed) {
+			if (!finish_connect(events)) {
+				if (failed)
+					close(true);
+				return;
+			}
+			progress = true;
+		}
+		if (!failed) {
+			progress = do_read() || progress;
+			progress = do_write() || progress;
+		}
+		if (progress) {
+			if (failed)
+				loop->defer(this);  // disconnect is reported after handler reads what we received
+			owner->rw_handler(true, true);  // can close or destroy us, we must not touch members after
+			return;
+		}
+		if (failed)
+			close(true);
+	}
+};
+
+TCPSocket::TCPSocket(RW_handler &&rw_handler, D_handler &&d_handler)
+    : impl(std::make_shared<Impl>(this)), rw_handler(std::move(rw_handler)), d_handler(std::move(d_handler)) {}
+
+TCPSocket::~TCPSocket() { close(); }
+
+void TCPSocket::close() { impl->close(false); }
+
+bool TCPSocket::is_open() const { return impl->fd != -1; }
+
+bool TCPSocket::connect(const std::string &addr, uint16_t port) {
+	close();
+
+	auto ssl_addr = split_ssl_address(addr);
+#if !platform_USE_SSL
+	if (ssl_addr.first)
+		return false;
+#endif
+	struct addrinfo hints {};
+	hints.ai_family         = ssl_addr.first ? AF_INET : AF_UNSPEC;  // first IPv4 address of SSL host, as with boost
+	hints.ai_socktype       = SOCK_STREAM;
+	hints.ai_flags          = ssl_addr.first ? 0 : AI_NUMERICHOST;
+	struct addrinfo *result = nullptr;
+	if (getaddrinfo(ssl_addr.second.c_str(), common::to_string(port).c_str(), &hints, &result) != 0)
+		return false;
+	bool success = false;
+	try {
+		success = impl->start_connect(*result, ssl_addr.first, ssl_addr.second);
+	} catch (const std::exception &) {
+	}
+	freeaddrinfo(result);
+	if (!success)
+		close();
+	return success;
+}
+
+size_t TCPSocket::read_some(void *data, size_t size) {
+	size_t rc = impl->incoming_buffer.read_some(data, size);
+	if (rc != 0 && impl->can_read) {
+		impl->can_read = false;
+		impl->loop->defer(impl.get());
+	}
+	return rc;
+}
+
+size_t TCPSocket::write_some(const void *data, size_t size) {
+	if (impl->asked_shutdown)
+		return 0;
+	size_t wc = impl->outgoing_buffer.write_some(data, size);
+	impl->write_from_client();
+	return wc;
+}
+
+size_t TCPSocket::gather_write_some(const common::ConstBuffer *buffers, size_t count) {
+	if (impl->asked_shutdown)
+		return 0;
+	return impl->write_gather(buffers, count);
+}
+
+void TCPSocket::shutdown_both() {
+	if (impl->asked_shutdown)
+		return;
+	impl->asked_shutdown = true;
+	impl->incoming_buffer.clear();
+	impl->write_from_client();
+}
+
+class TCPAcceptor::Impl : public EpollWatcher {
+public:
+	explicit Impl(TCPAcceptor *owner) : owner(owner), loop(EventLoop::current()->impl()) {}
+	~Impl() { close(); }
+	TCPAcceptor *owner;
+	EventLoop::Impl *loop;
+	int fd = -1;
+
+	void close() {
+		loop->remove(this);
+		if (fd != -1)
+			::close(fd);
+		fd = -1;
+	}
+	void on_event(uint32_t events) override { owner->a_handler(); }
+};
+
+TCPAcceptor::TCPAcceptor(const std::string &addr, uint16_t port, A_handler &&a_handler) try
+    : impl(std::make_shared<Impl>(this)),
+      a_handler(std::move(a_handler)) {
+	struct addrinfo hints {};
+	hints.ai_family         = AF_UNSPEC;
+	hints.ai_socktype       = SOCK_STREAM;
+	hints.ai_flags          = AI_PASSIVE;
+	struct addrinfo *result = nullptr;
+	const int rc            = getaddrinfo(addr.c_str(), common::to_string(port).c_str(), &hints, &result);
+	if (rc != 0)
+		throw std::system_error(EADDRNOTAVAIL, std::generic_category(), gai_strerror(rc));
+	const int one = 1;
+	impl->fd      = ::socket(result->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	const bool listening =
+	    impl->fd != -1 && setsockopt(impl->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0 &&
+	    ::bind(impl->fd, result->ai_addr, result->ai_addrlen) == 0 && ::listen(impl->fd, SOMAXCONN) == 0;
+	const int error = errno;
+	freeaddrinfo(result);
+	if (!listening)
+		throw std::system_error(error, std::generic_category(), "listen");
+	impl->loop->add(impl->fd, impl.get(), EPOLLIN | EPOLLET);
+} catch (const std::system_error &) {
+	std::throw_with_nested(AddressInUse("Failed to create TCP listening socket, probably address in use addr=" + addr +
+	                                    " port=" + common::to_string(port)));
+}
+
+TCPAcceptor::~TCPAcceptor() { impl->close(); }
+
+bool TCPAcceptor::accept(TCPSocket &socket, std::string &accepted_addr) {
+	struct sockaddr_storage address {};
+	socklen_t address_len = sizeof(address);
+	const int fd = ::accept4(impl->fd, reinterpret_cast<struct sockaddr *>(&address), &address_len,
+	    SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd == -1)
+		return false;  // Edge will fire accept_handler when next connection arrives
+	socket.close();
+	accepted_addr = numeric_host(reinterpret_cast<struct sockaddr *>(&address), address_len);
+	try {
+		socket.impl->attach(fd);
+	} catch (const std::exception &) {
+		socket.close();
+		return false;
+	}
+	return true;
+}
+
+class UDPMulticast::Impl : public EpollWatcher {
+public:
+	explicit Impl(UDPMulticast *owner) : owner(owner), loop(EventLoop::current()->impl()) {}
+	~Impl() {
+		loop->remove(this);
+		if (fd != -1)
+			::close(fd);
+	}
+	UDPMulticast *owner;
+	EventLoop::Impl *loop;
+	int fd = -1;
+	enum { max_length = 1024 };
+	unsigned char data[max_length];
+
+	void on_event(uint32_t events) override {
+		struct sockaddr_storage sender {};
+		socklen_t sender_len = sizeof(sender);
+		const ssize_t rc =
+		    ::recvfrom(fd, data, max_length, 0, reinterpret_cast<struct sockaddr *>(&sender), &sender_len);
+		if (rc < 0)
+			return;  // EAGAIN, edge will fire on next packet
+		loop->defer(this);  // Edge-triggered, so there might be more packets, p_handler can destroy us
+		owner->p_handler(numeric_host(reinterpret_cast<struct sockaddr *>(&sender), sender_len), data,
+		    static_cast<size_t>(rc));
+	}
+};
+
+UDPMulticast::UDPMulticast(const std::string &addr, uint16_t port, P_handler &&p_handler)
+    : impl(std::make_shared<Impl>(this)), p_handler(std::move(p_handler)) {
+	// Multiple processes can only bind to multicast socket if listen_ad is multicast addr
+	struct sockaddr_in listen_address {};
+	listen_address.sin_family = AF_INET;
+	listen_address.sin_port   = htons(port);
+	if (inet_pton(AF_INET, addr.c_str(), &listen_address.sin_addr) != 1)
+		return;
+	struct ip_mreq group {};
+	group.imr_multiaddr        = listen_address.sin_addr;
+	group.imr_interface.s_addr = htonl(INADDR_ANY);
+	const int one              = 1;
+	impl->fd                   = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (impl->fd == -1 || setsockopt(impl->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+	    ::bind(impl->fd, reinterpret_cast<struct sockaddr *>(&listen_address), sizeof(listen_address)) != 0 ||
+	    setsockopt(impl->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) != 0)
+		return;  // Multicast is optional, as with boost
+	try {
+		impl->loop->add(impl->fd, impl.get(), EPOLLIN | EPOLLET);
+	} catch (const std::exception &) {
+	}
+}
+UDPMulticast::~UDPMulticast() {}
+void UDPMulticast::send(const std::string &addr, uint16_t port, const void *data, size_t size) {
+	struct sockaddr_in ep {};
+	ep.sin_family = AF_INET;
+	ep.sin_port   = htons(port);
+	if (inet_pton(AF_INET, addr.c_str(), &ep.sin_addr) != 1)
+		return;
+	const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		return;
+	auto local_addresses = TCPAcceptor::local_addresses(true, false);
+	for (const auto &la : local_addresses) {
+		struct in_addr local_interface {};
+		if (inet_pton(AF_INET, la.c_str(), &local_interface) == 1 &&
+		    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &local_interface, sizeof(local_interface)) == 0)
+			::sendto(fd, data, size, 0, reinterpret_cast<struct sockaddr *>(&ep), sizeof(ep));
+	}
+	if (local_addresses.empty())  // Send on default gateway
+		::sendto(fd, data, size, 0, reinterpret_cast<struct sockaddr *>(&ep), sizeof(ep));
+	::close(fd);
+}
+
+#else
+
+EventLoop::EventLoop() {
 	if (current_loop)
 		throw std::logic_error("RunLoop::RunLoop Only single RunLoop per thread is allowed");
 	current_loop = this;
@@ -429,6 +1204,8 @@ EventLoop::~EventLoop() { current_loop = nullptr; }
 void EventLoop::cancel() { io_service.stop(); }
 
 void EventLoop::run() { io_service.run(); }
+void EventLoop::run_one() { io_service.run_one(); }
+void EventLoop::poll() { io_service.poll(); }
 void EventLoop::wake() {
 	io_service.post([]() {});
 }
@@ -829,34 +1606,6 @@ bool TCPAcceptor::accept(TCPSocket &socket, std::string &accepted_addr) {
 	return true;
 }
 
-std::vector<std::string> TCPAcceptor::local_addresses(bool ipv4, bool ipv6) {
-	std::vector<std::string> result;
-#ifndef _WIN32  // TODO - get adapters info on Win32
-	struct ifaddrs *ifaddr = nullptr;
-	if (getifaddrs(&ifaddr) == -1)
-		return result;
-
-	for (struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
-		if (ifa->ifa_addr == NULL)
-			continue;
-		int family = ifa->ifa_addr->sa_family;
-		;
-		if (family != AF_INET && family != AF_INET6)
-			continue;
-		char host[NI_MAXHOST]{};
-		int s =
-		    getnameinfo(ifa->ifa_addr, (family == AF_INET) ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6),
-		        host, NI_MAXHOST, NULL, 0, NI_NUMERICHOST);
-		if (s == 0 && ipv4 && family == AF_INET)
-			result.push_back(host);
-		if (s == 0 && ipv6 && family == AF_INET6)
-			result.push_back(host);
-	}
-	freeifaddrs(ifaddr);
-#endif
-	return result;
-}
-
 class UDPMulticast::Impl {
 public:
 	explicit Impl(UDPMulticast *owner) : owner(owner), socket(EventLoop::current()->io()) {}
@@ -958,6 +1707,8 @@ void UDPMulticast::send(const std::string &addr, uint16_t port, const void *data
 	}
 }
 
+#endif  // #if platform_USE_EPOLL
+
 #endif  // #if TARGET_OS_IPHONE
 
 // Code to stress-test timers
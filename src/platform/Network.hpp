@@ -158,6 +158,10 @@ private:
 };
 }  // namespace platform
 #else
+#if platform_USE_EPOLL
+#include <stdexcept>
+#include <vector>
+#else
 #ifndef NOMINMAX
 #define NOMINMAX
 #endif
@@ -165,15 +169,46 @@ private:
 #ifdef _WIN32
 #undef ERROR
 #endif
+#endif
 namespace platform {
+#if platform_USE_EPOLL
+// Native Linux loop - edge-triggered epoll, single timerfd for all timers, eventfd for wake.
+// Socket reads and writes go directly to kernel from run loop, no allocations or handlers per operation
+class EventLoop : private common::Nocopy {
+public:
+	EventLoop();
+	~EventLoop();
+
+	static EventLoop *current() { return current_loop; }
+
+	void run();      // run until cancel
+	void run_one();  // waits for events, then processes all ready events
+	void poll();     // processes all ready events without waiting
+	bool stopped() const;
+	void cancel();
+	void wake();  // can be called from any thread
+
+	static void cancel_current() { current()->cancel(); }
+
+	class Impl;
+	Impl *impl() { return m_impl.get(); }
+
+private:
+	std::unique_ptr<Impl> m_impl;
+	static thread_local EventLoop *current_loop;
+};
+#else
 class EventLoop : private common::Nocopy {  // enough wrappers! if boost, use no impl at all...
 public:
-	explicit EventLoop(boost::asio::io_service &io_service);
+	EventLoop();
 	~EventLoop();
 
 	static EventLoop *current() { return current_loop; }
 
-	void run();  // run until cancel
+	void run();      // run until cancel
+	void run_one();  // waits for and runs at least one handler
+	void poll();     // runs all ready handlers without waiting
+	bool stopped() const { return io_service.stopped(); }
 	void cancel();
 	void wake();
 
@@ -182,9 +217,10 @@ public:
 	boost::asio::io_service &io() { return io_service; }
 
 private:
-	boost::asio::io_service &io_service;
+	boost::asio::io_service io_service;
 	static thread_local EventLoop *current_loop;
 };
+#endif
 
 class Timer : private common::Nocopy {
 public:
@@ -198,7 +234,7 @@ public:
 
 private:
 	class Impl;
-	std::shared_ptr<Impl> impl;  // Owned by boost async machinery
+	std::shared_ptr<Impl> impl;  // Owned by boost async machinery, owned by us with epoll
 	after_handler a_handler;
 };
 
@@ -219,10 +255,14 @@ public:
 	// reads 0..count-1, if returns 0 (incoming buffer empty) would fire rw_handler or d_handler in future
 	virtual size_t write_some(const void *val, size_t count) override;
 	// writes 0..count-1, if returns 0 (outgoing buffer full) will fire rw_handler or d_handler in future
+#if platform_USE_EPOLL
+	size_t gather_write_some(const common::ConstBuffer *buffers, size_t count) override;
+	// sends directly from buffers with single sendmsg when nothing is queued, the rest goes to outgoing buffer
+#endif
 	void shutdown_both();  // will fire d_handler only after all sent data is acknowledged or disconnect happens
 private:
 	class Impl;
-	std::shared_ptr<Impl> impl;  // Owned by boost async machinery
+	std::shared_ptr<Impl> impl;  // Owned by boost async machinery, owned by us with epoll
 
 	friend class TCPAcceptor;
 	RW_handler rw_handler;
@@ -251,7 +291,7 @@ public:
 
 private:
 	class Impl;
-	std::shared_ptr<Impl> impl;  // Owned by boost async machinery
+	std::shared_ptr<Impl> impl;  // Owned by boost async machinery, owned by us with epoll
 	A_handler a_handler;
 };
 
@@ -264,7 +304,7 @@ public:
 	static void send(const std::string &addr, uint16_t port, const void *data, size_t size);  // simple synchronous send
 private:
 	class Impl;
-	std::shared_ptr<Impl> impl;  // Owned by boost async machinery
+	std::shared_ptr<Impl> impl;  // Owned by boost async machinery, owned by us with epoll
 	P_handler p_handler;
 };
 }  // namespace platform
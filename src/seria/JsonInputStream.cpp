@@ -3,8 +3,10 @@
 
 #include "JsonInputStream.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <limits>
 #include <stdexcept>
 
 #include "common/Invariant.hpp"
@@ -193,3 +195,441 @@ const JsonValue *JsonInputStreamValue::get_value() {
 	object_key_value = nullptr;
 	return ret;
 }
+
+namespace {
+bool is_json_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+bool is_json_digit(char c) { return c >= '0' && c <= '9'; }
+}  // namespace
+
+JsonInputStreamText::JsonInputStreamText(common::StringView text, bool allow_unused_object_keys)
+    : text_begin(text.begin()), text_end(text.end()), allow_unused_object_keys(allow_unused_object_keys) {
+	root          = skip_ws(text_begin);
+	const char *p = skip_ws(skip_value(root));
+	if (p != text_end)
+		throw_error(p, "expecting only whitespace at the end of json");
+}
+
+void JsonInputStreamText::throw_error(const char *p, const std::string &text) const {
+	const char *from = p - std::min<size_t>(p - text_begin, 32);
+	throw std::runtime_error("Failed to parse json, " + text + ", ..." + std::string(from, p) + " <-- here");
+}
+
+const char *JsonInputStreamText::skip_ws(const char *p) const {
+	while (p != text_end && is_json_space(*p))
+		++p;
+	return p;
+}
+
+const char *JsonInputStreamText::expect(const char *p, char c) const {
+	if (p == text_end)
+		throw_error(p, "unexpected end of json, expecting '" + std::string({c}) + "'");
+	if (*p != c)
+		throw_error(p, "expecting '" + std::string({c}) + "' but got '" + std::string({*p}) + "' (character code " +
+		                   common::to_string(static_cast<unsigned char>(*p)) + ") instead");
+	return p + 1;
+}
+
+const char *JsonInputStreamText::skip_value(const char *p) const {
+	if (p == text_end)
+		throw_error(p, "unexpected end of json");
+	switch (*p) {
+	case '{':
+		p = skip_ws(p + 1);
+		if (p != text_end && *p == '}')
+			return p + 1;
+		while (true) {
+			if (p == text_end || *p != '"')
+				expect(p, '"');
+			p = skip_ws(read_string(p, nullptr));
+			p = skip_ws(skip_value(skip_ws(expect(p, ':'))));
+			if (p != text_end && *p == '}')
+				return p + 1;
+			p = skip_ws(expect(p, ','));
+		}
+	case '[':
+		p = skip_ws(p + 1);
+		if (p != text_end && *p == ']')
+			return p + 1;
+		while (true) {
+			p = skip_ws(skip_value(p));
+			if (p != text_end && *p == ']')
+				return p + 1;
+			p = skip_ws(expect(p, ','));
+		}
+	case '"':
+		return read_string(p, nullptr);
+	case 't':
+		if (text_end - p < 4 || std::memcmp(p, "true", 4) != 0)
+			throw_error(p, "'true' is expected");
+		return p + 4;
+	case 'f':
+		if (text_end - p < 5 || std::memcmp(p, "false", 5) != 0)
+			throw_error(p, "'false' is expected");
+		return p + 5;
+	case 'n':
+		if (text_end - p < 4 || std::memcmp(p, "null", 4) != 0)
+			throw_error(p, "'null' is expected");
+		return p + 4;
+	default: {
+		bool negative = false, overflow = false, integer = false;
+		uint64_t magnitude = 0;
+		return read_number(p, &negative, &magnitude, &overflow, &integer);
+	}
+	}
+}
+
+const char *JsonInputStreamText::read_number(
+    const char *p, bool *negative, uint64_t *magnitude, bool *overflow, bool *integer) const {
+	const char *start = p;
+	*negative         = p != text_end && *p == '-';
+	if (*negative)
+		++p;
+	if (p == text_end || !is_json_digit(*p))
+		throw_error(p, "Unexpected character");
+	*magnitude = 0;
+	*overflow  = false;
+	if (*p == '0')
+		++p;
+	else
+		for (; p != text_end && is_json_digit(*p); ++p) {
+			const uint64_t digit = *p - '0';
+			if (*magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+				*overflow = true;
+			*magnitude = *magnitude * 10 + digit;
+		}
+	*integer = true;
+	if (p != text_end && *p == '.') {
+		*integer = false;
+		if (++p == text_end || !is_json_digit(*p))
+			throw_error(p, "Digit expected");
+		while (p != text_end && is_json_digit(*p))
+			++p;
+	}
+	if (p != text_end && (*p == 'e' || *p == 'E')) {
+		*integer = false;
+		if (++p != text_end && (*p == '+' || *p == '-'))
+			++p;
+		if (p == text_end || !is_json_digit(*p))
+			throw_error(p, "Digit expected");
+		while (p != text_end && is_json_digit(*p))
+			++p;
+	}
+	if (p != text_end && is_json_digit(*p))
+		throw_error(start, "Number expected");  // leading zeroes
+	return p;
+}
+
+const char *JsonInputStreamText::read_string(const char *p, std::string *value) const {
+	p = expect(p, '"');
+	while (true) {
+		const char *run = p;
+		while (p != text_end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= ' ' && *p != 127)
+			++p;
+		if (value)
+			value->append(run, p);
+		if (p == text_end)
+			throw_error(p, "end of json inside string");
+		if (*p == '"')
+			return p + 1;
+		if (*p != '\\')
+			throw_error(p, "control character inside string (character code " +
+			                   common::to_string(static_cast<unsigned char>(*p)) + ")");
+		if (++p == text_end)
+			throw_error(p, "end of json inside string");
+		char c = *p++;
+		switch (c) {
+		case '\\':
+		case '/':
+		case '"':
+			break;
+		case 'n':
+			c = '\n';
+			break;
+		case 'r':
+			c = '\r';
+			break;
+		case 't':
+			c = '\t';
+			break;
+		case 'b':
+			c = '\b';
+			break;
+		case 'f':
+			c = '\f';
+			break;
+		case 'u': {
+			unsigned cp = 0;
+			for (size_t i = 0; i != 4; ++i, ++p) {
+				uint8_t v = 0;
+				if (p == text_end || !common::from_hex(*p, v))
+					throw_error(p, "\\u wrong hex characters");
+				cp = cp * 16 + v;
+			}
+			if ((cp >= 0xD800 && cp <= 0xDFFF) || cp >= 0xFFFE)
+				throw_error(p, "\\u does not support surrogate pairs");
+			if (!value)
+				continue;
+			if (cp < 0x80) {
+				*value += static_cast<char>(cp);
+			} else if (cp < 0x800) {
+				*value += static_cast<char>(0xC0 | (cp >> 6));
+				*value += static_cast<char>(0x80 | (cp & 0x3F));
+			} else {
+				*value += static_cast<char>(0xE0 | (cp >> 12));
+				*value += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+				*value += static_cast<char>(0x80 | (cp & 0x3F));
+			}
+			continue;
+		}
+		default:
+			throw_error(p - 1, "unknown escape character '" + std::string({c}) + "' (character code " +
+			                       common::to_string(static_cast<unsigned char>(c)) + ")");
+		}
+		if (value)
+			*value += c;
+	}
+}
+
+JsonInputStreamText::Level &JsonInputStreamText::push_level(bool is_array, bool present) {
+	if (depth == levels.size())
+		levels.emplace_back();
+	Level &level    = levels.at(depth++);
+	level.is_array  = is_array;
+	level.present   = present;
+	level.next_item = 0;
+	level.items.clear();
+	level.keys.clear();
+	level.key_values.clear();
+	level.used_keys.clear();
+	level.map.clear();
+	level.map_it = level.map.end();
+	return level;
+}
+
+const char *JsonInputStreamText::get_value() {
+	if (depth == 0)
+		return root;
+	Level &level = levels.at(depth - 1);
+	if (!level.present)  // Optional object
+		return nullptr;
+	if (level.is_array) {
+		if (level.next_item == level.items.size())
+			throw std::out_of_range("JsonInputStreamText array index out of range");
+		return level.items.at(level.next_item++);
+	}
+	auto ret         = object_key_value;
+	object_key_value = nullptr;
+	return ret;
+}
+
+common::StringView JsonInputStreamText::raw_value() {
+	const char *p = get_value();
+	if (!p)
+		return common::StringView();
+	return common::StringView(p, skip_value(p) - p);
+}
+
+void JsonInputStreamText::begin_object() {
+	const char *p = get_value();
+	if (p && *p != '{')
+		throw std::runtime_error("JsonInputStreamText doesn't support this type of serialization: Object expected.");
+	Level &level = push_level(false, p != nullptr);
+	if (!p)
+		return;
+	p = skip_ws(p + 1);
+	if (*p == '}')
+		return;
+	while (true) {
+		level.keys.emplace_back();
+		p = skip_ws(read_string(p, &level.keys.back()));
+		p = skip_ws(p + 1);  // ':'
+		level.key_values.push_back(p);
+		level.used_keys.push_back(false);
+		p = skip_ws(skip_value(p));
+		if (*p == '}')
+			return;
+		p = skip_ws(p + 1);  // ','
+	}
+}
+
+bool JsonInputStreamText::object_key(common::StringView name, bool optional) {
+	object_key_value = nullptr;  // All fields are optional
+	if (depth == 0 || !levels.at(depth - 1).present)
+		return false;
+	Level &level = levels.at(depth - 1);
+	if (level.is_array)
+		throw std::runtime_error("JsonInputStreamText::object_key this is not an object");
+	for (size_t i = 0; i != level.keys.size(); ++i)
+		if (common::StringView(level.keys[i]) == name) {
+			level.used_keys[i] = true;
+			object_key_value   = level.key_values[i];  // Last one wins, like in JsonValue
+		}
+	return object_key_value != nullptr;
+}
+
+void JsonInputStreamText::end_object() {
+	invariant(depth != 0 && !levels.at(depth - 1).is_array, "JsonInputStreamText unexpected end_object.");
+	const Level &level = levels.at(depth - 1);
+	if (level.present && !allow_unused_object_keys) {
+		std::set<std::string> unused_keys;
+		for (size_t i = 0; i != level.keys.size(); ++i)
+			if (!level.used_keys[i])
+				unused_keys.insert(level.keys[i]);
+		if (!unused_keys.empty()) {
+			std::string all_keys;
+			for (const auto &k : unused_keys)
+				all_keys += (all_keys.empty() ? "'" : ", '") + k + "'";
+			throw std::runtime_error("key(s) " + all_keys + " have no meaning. Typo?");
+		}
+	}
+	depth -= 1;
+}
+
+void JsonInputStreamText::begin_map(size_t &size) {
+	begin_object();
+	Level &level = levels.at(depth - 1);
+	for (size_t i = 0; i != level.keys.size(); ++i) {
+		level.map[level.keys[i]] = level.key_values[i];
+		level.used_keys[i]       = true;
+	}
+	level.map_it = level.map.begin();
+	size         = level.map.size();
+}
+
+void JsonInputStreamText::next_map_key(std::string &name) {
+	Level &level = levels.at(depth - 1);
+	if (!level.present)
+		throw std::runtime_error("JsonInputStreamText::object_key object key of optional empty map is requested");
+	if (level.map_it == level.map.end())
+		throw std::runtime_error("JsonInputStreamText::object_key too many map keys requested");
+	name             = level.map_it->first;
+	object_key_value = level.map_it->second;
+	++level.map_it;
+}
+
+void JsonInputStreamText::begin_array(size_t &size, bool fixed_size) {
+	const char *p = get_value();
+	if (p && *p != '[')
+		throw std::runtime_error("JsonInputStreamText doesn't support this type of serialization: Array expected.");
+	Level &level = push_level(true, p != nullptr);
+	size         = 0;
+	if (!p)
+		return;
+	p = skip_ws(p + 1);
+	if (*p != ']')
+		while (true) {
+			level.items.push_back(p);
+			p = skip_ws(skip_value(p));
+			if (*p == ']')
+				break;
+			p = skip_ws(p + 1);  // ','
+		}
+	size = level.items.size();
+}
+
+void JsonInputStreamText::end_array() {
+	invariant(depth != 0 && levels.at(depth - 1).is_array, "JsonInputStreamText unexpected end_array.");
+	depth -= 1;
+}
+
+template<typename T>
+void JsonInputStreamText::read_integer(T &v, const char *t_name) {
+	const char *p = get_value();
+	if (!p)
+		return;
+	if (*p != '-' && !is_json_digit(*p))
+		throw std::runtime_error("JsonInputStreamText value is not INTEGER");
+	bool negative = false, overflow = false, integer = false;
+	uint64_t magnitude = 0;
+	read_number(p, &negative, &magnitude, &overflow, &integer);
+	if (!integer)
+		throw std::runtime_error("JsonInputStreamText value is not INTEGER");
+	const std::string text(p, skip_value(p));
+	if (overflow)
+		throw std::out_of_range("value " + text + " does not fit into " + std::string(t_name));
+	if (negative) {
+		if (!std::is_signed<T>::value)
+			throw std::runtime_error("JsonInputStreamText value < 0 cannot be returned as unsigned (" + text + ")");
+		if (magnitude > static_cast<uint64_t>(std::numeric_limits<T>::max()) + 1)
+			throw std::out_of_range("value " + text + " does not fit into " + std::string(t_name));
+		v = static_cast<T>(0 - magnitude);
+		return;
+	}
+	if (magnitude > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+		throw std::out_of_range("value " + text + " does not fit into " + std::string(t_name));
+	v = static_cast<T>(magnitude);
+}
+
+void JsonInputStreamText::seria_v(uint8_t &value) { read_integer(value, "uint8_t"); }
+
+void JsonInputStreamText::seria_v(int16_t &value) { read_integer(value, "int16_t"); }
+
+void JsonInputStreamText::seria_v(uint16_t &value) { read_integer(value, "uint16_t"); }
+
+void JsonInputStreamText::seria_v(int32_t &value) { read_integer(value, "int32_t"); }
+
+void JsonInputStreamText::seria_v(uint32_t &value) { read_integer(value, "uint32_t"); }
+
+void JsonInputStreamText::seria_v(int64_t &value) { read_integer(value, "int64_t"); }
+
+void JsonInputStreamText::seria_v(uint64_t &value) { read_integer(value, "uint64_t"); }
+
+void JsonInputStreamText::seria_v(bool &value) {
+	const char *p = get_value();
+	if (!p)
+		return;
+	if (*p != 't' && *p != 'f')
+		throw std::runtime_error("JsonInputStreamText value is not BOOL");
+	value = *p == 't';
+}
+
+bool JsonInputStreamText::seria_v(std::string &value) {
+	const char *p = get_value();
+	if (!p)
+		return false;
+	if (*p != '"')
+		throw std::runtime_error("JsonInputStreamText value is not STRING");
+	value.clear();
+	read_string(p, &value);
+	return true;
+}
+
+bool JsonInputStreamText::seria_v(common::BinaryArray &value) {
+	const char *p = get_value();
+	if (!p)
+		return false;
+	if (*p != '"')
+		throw std::runtime_error("JsonInputStreamText value is not STRING");
+	const char *end = read_string(p, nullptr) - 1;
+	if (std::find(p + 1, end, '\\') == end) {  // Hex never needs escapes, so we decode directly from text
+		value = common::from_hex(p + 1, end - p - 1);
+		return true;
+	}
+	std::string str;
+	read_string(p, &str);
+	value = common::from_hex(str);
+	return true;
+}
+
+bool JsonInputStreamText::binary(void *value, size_t size) {
+	const char *p = get_value();
+	if (!p)
+		return false;
+	if (*p != '"')
+		throw std::runtime_error("JsonInputStreamText value is not STRING");
+	const char *end = read_string(p, nullptr) - 1;
+	if (std::find(p + 1, end, '\\') == end) {
+		if (end == p + 1)
+			memset(value, 0, size);
+		else
+			common::from_hex_or_throw(p + 1, end - p - 1, value, size);
+		return true;
+	}
+	std::string str;
+	read_string(p, &str);
+	if (str.empty())
+		memset(value, 0, size);
+	else
+		common::from_hex_or_throw(str, value, size);
+	return true;
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <deque>
 #include "ISeria.hpp"
 #include "common/JsonValue.hpp"
 #include "common/Nocopy.hpp"
@@ -54,6 +55,87 @@ private:
 	const common::JsonValue *get_value();
 };
 
+// Reads json text directly, without building JsonValue. Whole text is validated in constructor, then each object or
+// array is indexed (positions of keys and elements) when entered, and values are parsed only when asked for
+class JsonInputStreamText : public JsonInputStream, private common::Nocopy {
+public:
+	JsonInputStreamText(common::StringView text, bool allow_unused_object_keys);
+	using JsonInputStream::begin_array;
+	using JsonInputStream::object_key;
+
+	bool is_input() const override { return true; }
+
+	void begin_object() override;
+	bool object_key(common::StringView name, bool optional) override;
+	void end_object() override;
+
+	void begin_map(size_t &size) override;
+	void next_map_key(std::string &name) override;
+	void end_map() override { end_object(); }
+
+	void begin_array(size_t &size, bool fixed_size) override;
+	void end_array() override;
+
+	void seria_v(uint8_t &value) override;
+	void seria_v(int16_t &value) override;
+	void seria_v(uint16_t &value) override;
+	void seria_v(int32_t &value) override;
+	void seria_v(uint32_t &value) override;
+	void seria_v(int64_t &value) override;
+	void seria_v(uint64_t &value) override;
+	void seria_v(bool &value) override;
+	bool seria_v(std::string &value) override;
+	bool seria_v(common::BinaryArray &value) override;
+	bool binary(void *value, size_t size) override;
+
+	// Text of next value as is, empty if value is absent. Used to pass parts of json_rpc envelope around
+	common::StringView raw_value();
+
+private:
+	struct Level {
+		bool is_array = false;
+		bool present  = false;  // false for absent optional object or array, all its values are absent
+		std::vector<const char *> items;
+		size_t next_item = 0;
+		std::vector<std::string> keys;  // in order of appearance, duplicates allowed
+		std::vector<const char *> key_values;
+		std::vector<bool> used_keys;
+		std::map<std::string, const char *> map;  // sorted and without duplicates, like in JsonValue
+		std::map<std::string, const char *>::const_iterator map_it;
+	};
+	const char *const text_begin;
+	const char *const text_end;
+	const bool allow_unused_object_keys;
+	const char *root             = nullptr;
+	const char *object_key_value = nullptr;
+	std::deque<Level> levels;  // we reuse levels to keep capacity of vectors, deque keeps map_it valid
+	size_t depth = 0;
+
+	const char *get_value();
+	Level &push_level(bool is_array, bool present);
+	template<typename T>
+	void read_integer(T &v, const char *t_name);
+
+	const char *skip_ws(const char *p) const;
+	const char *skip_value(const char *p) const;
+	const char *read_string(const char *p, std::string *value) const;  // value can be nullptr to only check
+	const char *read_number(const char *p, bool *negative, uint64_t *magnitude, bool *overflow, bool *integer) const;
+	const char *expect(const char *p, char c) const;
+	[[noreturn]] void throw_error(const char *p, const std::string &text) const;
+};
+
+template<typename T, typename... Context>
+void from_json_text(T &v, common::StringView text, Context... context) {
+	static_assert(!std::is_pointer<T>::value, "Cannot be called with pointer");
+	JsonInputStreamText s(text, false);
+	try {
+		ser(v, s, context...);
+	} catch (const std::exception &) {
+		std::throw_with_nested(std::runtime_error(
+		    "Error while deserializing json text of type '" + common::demangle(typeid(T).name()) + "'"));
+	}
+}
+
 template<typename T, typename... Context>
 void from_json_value(T &v, const common::JsonValue &js, Context... context) {
 	static_assert(!std::is_pointer<T>::value, "Cannot be called with pointer");
@@ -2,6 +2,7 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for details.
 
 #include "JsonOutputStream.hpp"
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include "common/Invariant.hpp"
@@ -109,18 +110,18 @@ common::JsonValue *JsonOutputStreamValue::insert_or_push(const common::JsonValue
 	throw std::logic_error("can only insert into object array or root");
 }
 
-bool JsonOutputStreamText::append_prefix(const std::string &value, bool skip_if_optional) {
+bool JsonOutputStreamText::append_prefix(common::StringView value, bool skip_if_optional) {
 	if (chain.empty()) {
 		invariant(expecting_root, "unexpected root");
 		expecting_root = false;
-		text += value;
+		text.append(value.data(), value.size());
 		return true;
 	}
 	if (chain.back().first == JsonValue::ARRAY) {
 		if (chain.back().second != 0)
 			text += ",";
 		chain.back().second += 1;
-		text += value;
+		text.append(value.data(), value.size());
 		return true;
 	}
 	common::StringView key = next_key;
@@ -131,9 +132,9 @@ bool JsonOutputStreamText::append_prefix(const std::string &value, bool skip_if_
 		text += ",";
 	chain.back().second += 1;
 	text += "\"";
-	text += JsonValue::escape_string(std::string(key.begin(), key.end()));
+	JsonValue::escape_string(key.data(), key.size(), &text);
 	text += "\":";
-	text += value;
+	text.append(value.data(), value.size());
 	return true;
 }
 
@@ -162,7 +163,7 @@ void JsonOutputStreamText::end_object() {
 }
 
 void JsonOutputStreamText::begin_array(size_t &size, bool fixed_size) {
-	if (!append_prefix(std::string(), size == 0)) {
+	if (!append_prefix(common::StringView(), size == 0)) {
 		chain.push_back(std::make_pair(JsonValue::NIL, 0));  // NIL to mark empty optional array
 		return;
 	}
@@ -194,26 +195,32 @@ void JsonOutputStreamText::seria_v(int64_t &value) { append_prefix(common::to_st
 bool JsonOutputStreamText::seria_v(std::string &value) {
 	if (!append_prefix("\"", value.empty()))
 		return false;
-	text += JsonValue::escape_string(value);
+	JsonValue::escape_string(value.data(), value.size(), &text);
 	text += "\"";
 	return true;
 }
 
 bool JsonOutputStreamText::seria_v(common::BinaryArray &value) {
-	std::string hex = common::to_hex(value);
-	return seria_v(hex);
+	if (!append_prefix("\"", value.empty()))
+		return false;
+	common::append_hex(value.data(), value.size(), &text);  // hex never needs escaping
+	text += "\"";
+	return true;
 }
 
 void JsonOutputStreamText::seria_v(uint8_t &value) { append_prefix(common::to_string(value), value == 0); }
 
-void JsonOutputStreamText::seria_v(bool &value) { append_prefix(value ? "true" : "false", !value); }
+void JsonOutputStreamText::seria_v(bool &value) {
+	append_prefix(value ? common::StringView("true") : common::StringView("false"), !value);
+}
 
 bool JsonOutputStreamText::binary(void *value, size_t size) {
-	std::string hex = common::to_hex(value, size);
-	bool all_zeroes = hex.find_first_not_of('0') == std::string::npos;
+	const auto *data      = static_cast<const unsigned char *>(value);
+	const bool all_zeroes = std::all_of(data, data + size, [](unsigned char c) { return c == 0; });
 	if (!append_prefix("\"", all_zeroes))
 		return false;
-	text += all_zeroes ? std::string() : hex;
+	if (!all_zeroes)
+		common::append_hex(data, size, &text);
 	text += "\"";
 	return true;
 }
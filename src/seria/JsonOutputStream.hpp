@@ -53,6 +53,7 @@ private:
 	common::JsonValue *insert_or_push(const common::JsonValue &value, bool skip_if_optional);
 };
 
+// Appends json directly to text, without building JsonValue
 class JsonOutputStreamText : public JsonOutputStream {
 public:
 	explicit JsonOutputStreamText(std::string &text) : text(text) {}
@@ -90,7 +91,7 @@ private:
 	std::string &text;
 	std::vector<std::pair<common::JsonValue::Type, int>>
 	    chain;  // object, array or null (for empty array) only + count of elements
-	bool append_prefix(const std::string &value, bool skip_if_optional);
+	bool append_prefix(common::StringView value, bool skip_if_optional);
 };
 
 template<typename T, typename... Context>
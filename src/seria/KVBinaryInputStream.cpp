@@ -9,7 +9,9 @@
 #include <stdexcept>
 #include "KVBinaryCommon.hpp"
 #include "common/Invariant.hpp"
+#include "common/Math.hpp"
 #include "common/Streams.hpp"
+#include "common/StringTools.hpp"
 #include "common/Varint.hpp"
 
 using namespace common;
@@ -184,12 +186,13 @@ JsonValue parse_binary(common::IInputStream &stream) {
 }
 }  // namespace
 
-KVBinaryInputStream::KVBinaryInputStream(common::IInputStream &strm) : JsonInputStreamValue(value_storage, true) {
+KVBinaryInputStreamValue::KVBinaryInputStreamValue(common::IInputStream &strm)
+    : JsonInputStreamValue(value_storage, true) {
 	// We init parent with & of value_storage, then set storage
 	value_storage = parse_binary(strm);
 }
 
-bool KVBinaryInputStream::seria_v(common::BinaryArray &value) {
+bool KVBinaryInputStreamValue::seria_v(common::BinaryArray &value) {
 	std::string str;
 	if (!seria_v(str))
 		return false;
@@ -197,7 +200,7 @@ bool KVBinaryInputStream::seria_v(common::BinaryArray &value) {
 	return true;
 }
 
-bool KVBinaryInputStream::binary(void *value, size_t size) {
+bool KVBinaryInputStreamValue::binary(void *value, size_t size) {
 	if (size == 0)  // This is important case, do not remove
 		return true;
 	std::string str;
@@ -208,3 +211,341 @@ bool KVBinaryInputStream::binary(void *value, size_t size) {
 	memcpy(value, str.data(), size);
 	return true;
 }
+
+// Nesting is limited, so hostile message cannot overflow stack
+static const size_t MAX_NESTING = 64;
+
+static size_t fixed_value_size(uint8_t type) {
+	switch (type) {
+	case BIN_KV_SERIALIZE_TYPE_INT64:
+	case BIN_KV_SERIALIZE_TYPE_UINT64:
+		return 8;
+	case BIN_KV_SERIALIZE_TYPE_INT32:
+	case BIN_KV_SERIALIZE_TYPE_UINT32:
+		return 4;
+	case BIN_KV_SERIALIZE_TYPE_INT16:
+	case BIN_KV_SERIALIZE_TYPE_UINT16:
+		return 2;
+	case BIN_KV_SERIALIZE_TYPE_INT8:
+	case BIN_KV_SERIALIZE_TYPE_UINT8:
+	case BIN_KV_SERIALIZE_TYPE_BOOL:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+KVBinaryInputStream::KVBinaryInputStream(const void *data, size_t size)
+    : data_begin(reinterpret_cast<const uint8_t *>(data)), data_end(data_begin + size) {
+	const uint8_t *p = need(data_begin, 2 * sizeof(uint32_t) + 1);
+	if (uint_le_from_bytes<uint32_t>(data_begin, sizeof(uint32_t)) != PORTABLE_STORAGE_SIGNATUREA ||
+	    uint_le_from_bytes<uint32_t>(data_begin + sizeof(uint32_t), sizeof(uint32_t)) != PORTABLE_STORAGE_SIGNATUREB)
+		throw std::runtime_error("KVBinaryInputStream invalid binary storage signature");
+	if (data_begin[2 * sizeof(uint32_t)] != PORTABLE_STORAGE_FORMAT_VER)
+		throw std::runtime_error("KVBinaryInputStream unknown binary storage format version");
+	root.pos  = p;
+	root.type = BIN_KV_SERIALIZE_TYPE_OBJECT;
+	root_end  = skip_value(root, 0);
+}
+
+const uint8_t *KVBinaryInputStream::need(const uint8_t *p, size_t size) const {
+	if (size > static_cast<size_t>(data_end - p))
+		throw std::runtime_error("KVBinaryInputStream unexpected end of data");
+	return p + size;
+}
+
+const uint8_t *KVBinaryInputStream::read_size(const uint8_t *p, size_t *size) const {
+	need(p, 1);
+	const size_t len = size_t(1) << (*p & PORTABLE_RAW_SIZE_MARK_MASK);
+	need(p, len);
+	*size = integer_cast<size_t>(uint_le_from_bytes<uint64_t>(p, len) >> 2);
+	return p + len;
+}
+
+const uint8_t *KVBinaryInputStream::read_item(const uint8_t *p, uint8_t item_type, Value *value) const {
+	if (item_type != BIN_KV_SERIALIZE_TYPE_ARRAY) {
+		value->pos      = p;
+		value->type     = item_type;
+		value->is_array = false;
+		return p;
+	}
+	need(p, 1);
+	if ((*p & BIN_KV_SERIALIZE_FLAG_ARRAY) == 0)
+		throw std::runtime_error("KVBinaryInputStream Incorrect array of array encoding");
+	value->pos      = p + 1;
+	value->type     = *p & ~BIN_KV_SERIALIZE_FLAG_ARRAY;
+	value->is_array = true;
+	return p + 1;
+}
+
+const uint8_t *KVBinaryInputStream::read_entry(const uint8_t *p, common::StringView *name, Value *value) const {
+	p                = need(p, 1);
+	const size_t len = p[-1];
+	*name            = common::StringView(reinterpret_cast<const char *>(p), len);
+	p                = need(need(p, len), 1);
+	value->pos       = p;
+	value->type      = p[-1];
+	value->is_array  = (value->type & BIN_KV_SERIALIZE_FLAG_ARRAY) != 0 || value->type == BIN_KV_SERIALIZE_TYPE_ARRAY;
+	value->type &= ~BIN_KV_SERIALIZE_FLAG_ARRAY;  // unflagged ARRAY is array of arrays
+	return p;
+}
+
+const uint8_t *KVBinaryInputStream::skip_value(const Value &value, size_t nesting) const {
+	if (nesting > MAX_NESTING)
+		throw std::runtime_error("KVBinaryInputStream nesting is too deep");
+	const uint8_t *p = value.pos;
+	size_t count     = 0;
+	if (value.is_array) {
+		p                       = read_size(p, &count);
+		const size_t fixed_size = fixed_value_size(value.type);
+		if (fixed_size != 0) {
+			if (count > static_cast<size_t>(data_end - p) / fixed_size)
+				throw std::runtime_error("KVBinaryInputStream unexpected end of data");
+			return p + count * fixed_size;
+		}
+		for (; count != 0; --count) {
+			Value item;
+			read_item(p, value.type, &item);
+			p = skip_value(item, nesting + 1);
+		}
+		return p;
+	}
+	if (const size_t fixed_size = fixed_value_size(value.type))
+		return need(p, fixed_size);
+	switch (value.type) {
+	case BIN_KV_SERIALIZE_TYPE_STRING:
+		p = read_size(p, &count);
+		return need(p, count);
+	case BIN_KV_SERIALIZE_TYPE_OBJECT:
+		p = read_size(p, &count);
+		for (; count != 0; --count) {
+			common::StringView name;
+			Value entry;
+			p = skip_value((read_entry(p, &name, &entry), entry), nesting + 1);
+		}
+		return p;
+	case BIN_KV_SERIALIZE_TYPE_DOUBLE:
+		throw std::logic_error("KVBinaryInputStream double serialization is not supported in KVBinaryInputStream");
+	default:
+		throw std::runtime_error("KVBinaryInputStream Unknown data type");
+	}
+}
+
+KVBinaryInputStream::Level &KVBinaryInputStream::push_level(bool is_array, bool present) {
+	if (depth == levels.size())
+		levels.emplace_back();
+	Level &level        = levels.at(depth++);
+	level.is_array      = is_array;
+	level.present       = present;
+	level.next_entry    = 0;
+	level.item_type     = 0;
+	level.item_count    = 0;
+	level.next_item     = 0;
+	level.next_item_pos = nullptr;
+	level.entries.clear();
+	level.map.clear();
+	return level;
+}
+
+KVBinaryInputStream::Value KVBinaryInputStream::get_value() {
+	if (depth == 0)
+		return root;
+	Level &level = levels.at(depth - 1);
+	if (!level.present)  // Optional object
+		return Value{};
+	if (level.is_array) {
+		if (level.next_item == level.item_count)
+			throw std::out_of_range("KVBinaryInputStream array index out of range");
+		Value item;
+		read_item(level.next_item_pos, level.item_type, &item);
+		level.next_item_pos = skip_value(item, 0);  // already validated, so nesting is not counted
+		level.next_item += 1;
+		return item;
+	}
+	auto ret         = object_key_value;
+	object_key_value = Value{};
+	return ret;
+}
+
+void KVBinaryInputStream::begin_object() {
+	const Value value = get_value();
+	if (value.pos && (value.is_array || value.type != BIN_KV_SERIALIZE_TYPE_OBJECT))
+		throw std::runtime_error("KVBinaryInputStream doesn't support this type of serialization: Object expected.");
+	Level &level = push_level(false, value.pos != nullptr);
+	if (!value.pos)
+		return;
+	size_t count     = 0;
+	const uint8_t *p = read_size(value.pos, &count);
+	for (; count != 0; --count) {
+		common::StringView name;
+		Value entry;
+		p = skip_value((read_entry(p, &name, &entry), entry), 0);
+		level.entries.emplace_back(name, entry);
+	}
+}
+
+bool KVBinaryInputStream::object_key(common::StringView name, bool optional) {
+	object_key_value = Value{};  // All fields are optional
+	if (depth == 0 || !levels.at(depth - 1).present)
+		return false;
+	const Level &level = levels.at(depth - 1);
+	if (level.is_array)
+		throw std::runtime_error("KVBinaryInputStream::object_key this is not an object");
+	for (const auto &entry : level.entries)
+		if (entry.first == name) {
+			object_key_value = entry.second;  // First one wins, like in JsonValue::insert
+			return true;
+		}
+	return false;
+}
+
+void KVBinaryInputStream::end_object() {
+	invariant(depth != 0 && !levels.at(depth - 1).is_array, "KVBinaryInputStream unexpected end_object.");
+	depth -= 1;
+}
+
+void KVBinaryInputStream::begin_map(size_t &size) {
+	begin_object();
+	Level &level = levels.at(depth - 1);
+	level.map    = level.entries;
+	std::stable_sort(level.map.begin(), level.map.end(),
+	    [](const std::pair<StringView, Value> &a, const std::pair<StringView, Value> &b) { return a.first < b.first; });
+	level.map.erase(std::unique(level.map.begin(), level.map.end(),
+	                    [](const std::pair<StringView, Value> &a, const std::pair<StringView, Value> &b) {
+		                    return a.first == b.first;
+	                    }),
+	    level.map.end());
+	size = level.map.size();
+}
+
+void KVBinaryInputStream::next_map_key(std::string &name) {
+	Level &level = levels.at(depth - 1);
+	if (!level.present)
+		throw std::runtime_error("KVBinaryInputStream::object_key object key of optional empty map is requested");
+	if (level.next_entry == level.map.size())
+		throw std::runtime_error("KVBinaryInputStream::object_key too many map keys requested");
+	const auto &entry = level.map.at(level.next_entry++);
+	name              = std::string(entry.first);
+	object_key_value  = entry.second;
+}
+
+void KVBinaryInputStream::begin_array(size_t &size, bool fixed_size) {
+	const Value value = get_value();
+	if (value.pos && !value.is_array)
+		throw std::runtime_error("KVBinaryInputStream doesn't support this type of serialization: Array expected.");
+	Level &level = push_level(true, value.pos != nullptr);
+	size         = 0;
+	if (!value.pos)
+		return;
+	level.item_type     = value.type;
+	level.next_item_pos = read_size(value.pos, &level.item_count);
+	size                = level.item_count;
+}
+
+void KVBinaryInputStream::end_array() {
+	invariant(depth != 0 && levels.at(depth - 1).is_array, "KVBinaryInputStream unexpected end_array.");
+	depth -= 1;
+}
+
+namespace {
+template<typename T, typename S>
+void cast_integer(T &v, S s, const char *t_name) {
+	try {
+		v = integer_cast<T>(s);
+	} catch (const std::exception &) {
+		throw std::out_of_range("value " + common::to_string(s) + " does not fit into " + std::string(t_name));
+	}
+}
+}  // namespace
+
+template<typename T>
+void KVBinaryInputStream::read_integer(T &v, const char *t_name) {
+	const Value value = get_value();
+	if (!value.pos)
+		return;
+	if (value.is_array)
+		throw std::runtime_error("KVBinaryInputStream value is not INTEGER");
+	switch (value.type) {
+	case BIN_KV_SERIALIZE_TYPE_INT64:
+		return cast_integer(v, static_cast<int64_t>(uint_le_from_bytes<uint64_t>(value.pos, 8)), t_name);
+	case BIN_KV_SERIALIZE_TYPE_INT32:
+		return cast_integer<T, int64_t>(v, static_cast<int32_t>(uint_le_from_bytes<uint32_t>(value.pos, 4)), t_name);
+	case BIN_KV_SERIALIZE_TYPE_INT16:
+		return cast_integer<T, int64_t>(v, static_cast<int16_t>(uint_le_from_bytes<uint16_t>(value.pos, 2)), t_name);
+	case BIN_KV_SERIALIZE_TYPE_INT8:
+		return cast_integer<T, int64_t>(v, static_cast<int8_t>(value.pos[0]), t_name);
+	case BIN_KV_SERIALIZE_TYPE_UINT64:
+		return cast_integer(v, uint_le_from_bytes<uint64_t>(value.pos, 8), t_name);
+	case BIN_KV_SERIALIZE_TYPE_UINT32:
+		return cast_integer<T, uint64_t>(v, uint_le_from_bytes<uint32_t>(value.pos, 4), t_name);
+	case BIN_KV_SERIALIZE_TYPE_UINT16:
+		return cast_integer<T, uint64_t>(v, uint_le_from_bytes<uint16_t>(value.pos, 2), t_name);
+	case BIN_KV_SERIALIZE_TYPE_UINT8:
+		return cast_integer<T, uint64_t>(v, value.pos[0], t_name);
+	default:
+		throw std::runtime_error("KVBinaryInputStream value is not INTEGER");
+	}
+}
+
+void KVBinaryInputStream::seria_v(uint8_t &value) { read_integer(value, "uint8_t"); }
+
+void KVBinaryInputStream::seria_v(int16_t &value) { read_integer(value, "int16_t"); }
+
+void KVBinaryInputStream::seria_v(uint16_t &value) { read_integer(value, "uint16_t"); }
+
+void KVBinaryInputStream::seria_v(int32_t &value) { read_integer(value, "int32_t"); }
+
+void KVBinaryInputStream::seria_v(uint32_t &value) { read_integer(value, "uint32_t"); }
+
+void KVBinaryInputStream::seria_v(int64_t &value) { read_integer(value, "int64_t"); }
+
+void KVBinaryInputStream::seria_v(uint64_t &value) { read_integer(value, "uint64_t"); }
+
+void KVBinaryInputStream::seria_v(bool &value) {
+	const Value v = get_value();
+	if (!v.pos)
+		return;
+	if (v.is_array || v.type != BIN_KV_SERIALIZE_TYPE_BOOL)
+		throw std::runtime_error("KVBinaryInputStream value is not BOOL");
+	value = v.pos[0] != 0;
+}
+
+bool KVBinaryInputStream::blob_view(common::StringView *value) {
+	const Value v = get_value();
+	if (!v.pos)
+		return false;
+	if (v.is_array || v.type != BIN_KV_SERIALIZE_TYPE_STRING)
+		throw std::runtime_error("KVBinaryInputStream value is not STRING");
+	size_t size      = 0;
+	const uint8_t *p = read_size(v.pos, &size);
+	*value           = common::StringView(reinterpret_cast<const char *>(p), size);
+	return true;
+}
+
+bool KVBinaryInputStream::seria_v(std::string &value) {
+	common::StringView view;
+	if (!blob_view(&view))
+		return false;
+	value.assign(view.data(), view.size());
+	return true;
+}
+
+bool KVBinaryInputStream::seria_v(common::BinaryArray &value) {
+	common::StringView view;
+	if (!blob_view(&view))
+		return false;
+	value.assign(view.begin(), view.end());
+	return true;
+}
+
+bool KVBinaryInputStream::binary(void *value, size_t size) {
+	if (size == 0)  // This is important case, do not remove
+		return true;
+	common::StringView view;
+	if (!blob_view(&view))
+		return false;
+	if (view.size() != size)
+		throw std::runtime_error("KVBinaryInputStream binary value size mismatch");
+	memcpy(value, view.data(), size);
+	return true;
+}
@@ -3,45 +3,123 @@
 
 #pragma once
 
+#include <deque>
 #include "ISeria.hpp"
 #include "JsonInputStream.hpp"
 #include "common/MemoryStreams.hpp"
+#include "common/Nocopy.hpp"
 #include "common/exception.hpp"
 
 namespace seria {
 
-class KVBinaryInputStream : public JsonInputStreamValue {
+// Reads KV binary (portable storage) directly from buffer, without building JsonValue. Whole payload is validated
+// in constructor, then each object is indexed (positions of values by key) when entered, and values are decoded
+// only when asked for. Derives from JsonInputStream, because some ser() methods select representation by it,
+// and KV binary was always read via JsonValue.
+class KVBinaryInputStream : public JsonInputStream, private common::Nocopy {
+public:
+	KVBinaryInputStream(const void *data, size_t size);  // data must outlive stream
+	using JsonInputStream::begin_array;
+	using JsonInputStream::object_key;
+
+	size_t get_root_size() const { return root_end - data_begin; }  // caller decides if excess data is allowed
+
+	bool is_input() const override { return true; }
+
+	void begin_object() override;
+	bool object_key(common::StringView name, bool optional) override;
+	void end_object() override;
+
+	void begin_map(size_t &size) override;
+	void next_map_key(std::string &name) override;
+	void end_map() override { end_object(); }
+
+	void begin_array(size_t &size, bool fixed_size) override;
+	void end_array() override;
+
+	void seria_v(uint8_t &value) override;
+	void seria_v(int16_t &value) override;
+	void seria_v(uint16_t &value) override;
+	void seria_v(int32_t &value) override;
+	void seria_v(uint32_t &value) override;
+	void seria_v(int64_t &value) override;
+	void seria_v(uint64_t &value) override;
+	void seria_v(bool &value) override;
+	bool seria_v(std::string &value) override;
+	bool seria_v(common::BinaryArray &value) override;
+	bool binary(void *value, size_t size) override;
+
+	// Next string value as is, points into input buffer. Returns false if value is absent
+	bool blob_view(common::StringView *value);
+
+private:
+	struct Value {
+		const uint8_t *pos = nullptr;  // nullptr if absent, points to element count for arrays
+		uint8_t type       = 0;        // element type for arrays
+		bool is_array      = false;
+	};
+	struct Level {
+		bool is_array = false;
+		bool present  = false;  // false for absent optional object or array, all its values are absent
+		std::vector<std::pair<common::StringView, Value>> entries;  // in order of appearance, duplicates allowed
+		std::vector<std::pair<common::StringView, Value>> map;      // sorted and without duplicates, like JsonValue
+		size_t next_entry            = 0;  // for map
+		uint8_t item_type            = 0;
+		size_t item_count            = 0;
+		size_t next_item             = 0;
+		const uint8_t *next_item_pos = nullptr;
+	};
+	const uint8_t *const data_begin;
+	const uint8_t *const data_end;
+	const uint8_t *root_end = nullptr;
+	Value root;
+	Value object_key_value;
+	std::deque<Level> levels;  // we reuse levels to keep capacity of vectors
+	size_t depth = 0;
+
+	Value get_value();
+	Level &push_level(bool is_array, bool present);
+	template<typename T>
+	void read_integer(T &v, const char *t_name);
+
+	const uint8_t *read_size(const uint8_t *p, size_t *size) const;
+	const uint8_t *read_item(const uint8_t *p, uint8_t item_type, Value *value) const;  // array element
+	const uint8_t *read_entry(const uint8_t *p, common::StringView *name, Value *value) const;  // object entry
+	const uint8_t *skip_value(const Value &value, size_t nesting) const;
+	const uint8_t *need(const uint8_t *p, size_t size) const;  // returns p + size
+};
+
+// Former reader, parses whole payload into JsonValue first. Kept for checking KVBinaryInputStream against it
+class KVBinaryInputStreamValue : public JsonInputStreamValue {
 	common::JsonValue value_storage;
 
 public:
-	explicit KVBinaryInputStream(common::IInputStream &strm);
+	explicit KVBinaryInputStreamValue(common::IInputStream &strm);
 	using JsonInputStreamValue::seria_v;
 	bool seria_v(common::BinaryArray &value) override;
 	bool binary(void *value, size_t size) override;
 };
 
 template<typename T>
-void from_binary_kv(T &v, common::MemoryInputStream &stream) {
+void from_binary_kv(T &v, const void *data, size_t size) {
 	static_assert(!std::is_pointer<T>::value, "Cannot be called with pointer");
-	KVBinaryInputStream s(stream);
+	KVBinaryInputStream s(data, size);
 	try {
 		ser(v, s);
 	} catch (const std::exception &) {
 		std::throw_with_nested(std::runtime_error(
 		    "Error while serializing KV binary object of type '" + common::demangle(typeid(T).name()) + "'"));
 	}
-	if (!stream.empty())
+	if (s.get_root_size() != size)
 		throw std::runtime_error(
 		    "Excess data after serializing KV binary object of type '" + common::demangle(typeid(T).name()) + "'");
 }
 template<typename T>
 void from_binary_kv(T &v, const common::BinaryArray &buf) {
-	common::MemoryInputStream stream(buf.data(), buf.size());
-	from_binary_kv(v, stream);
+	from_binary_kv(v, buf.data(), buf.size());
 }
 template<typename T>
 void from_binary_kv(T &v, const std::string &buf) {
-	common::MemoryInputStream stream(buf.data(), buf.size());
-	from_binary_kv(v, stream);
+	from_binary_kv(v, buf.data(), buf.size());
 }
 }  // namespace seria
@@ -0,0 +1,226 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "Core/BlockChainState.hpp"
+#include "Core/Config.hpp"
+#include "Core/Currency.hpp"
+#include "Core/Node.hpp"
+#include "common/Invariant.hpp"
+#include "common/Ipv4Address.hpp"
+#include "logging/ConsoleLogger.hpp"
+#include "platform/Network.hpp"
+#include "platform/PathTools.hpp"
+
+using namespace cn;
+
+namespace {
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+// Forwards connections to target port, holding data for half of round trip in each direction, so loopback
+// peers look like remote ones. Counts bytes sent by connecting side (requests) and by target (responses).
+class DelayProxy {
+public:
+	DelayProxy(uint16_t port, uint16_t target_port, float round_trip)
+	    : target_port(target_port)
+	    , one_way(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+	          std::chrono::duration<float>(round_trip / 2)))
+	    , acceptor("127.0.0.1", port, [this]() { accept_all(); }) {
+		accept_all();
+	}
+	size_t bytes_up   = 0;
+	size_t bytes_down = 0;
+
+private:
+	struct Chunk {
+		TimePoint due;
+		common::BinaryArray data;
+		size_t written = 0;
+	};
+	struct Connection {
+		platform::TCPSocket client;
+		platform::TCPSocket server;
+		std::deque<Chunk> up;
+		std::deque<Chunk> down;
+		platform::Timer timer;
+		explicit Connection(DelayProxy *proxy)
+		    : client([proxy, this](bool, bool) { proxy->pump(this); }, [this]() { close(); })
+		    , server([proxy, this](bool, bool) { proxy->pump(this); }, [this]() { close(); })
+		    , timer([proxy, this]() { proxy->pump(this); }) {}
+		void close() {
+			client.close();
+			server.close();
+			timer.cancel();
+		}
+	};
+	const uint16_t target_port;
+	const std::chrono::steady_clock::duration one_way;
+	std::vector<std::unique_ptr<Connection>> connections;  // closed ones are kept until proxy is destroyed
+	std::unique_ptr<Connection> next_connection;
+	platform::TCPAcceptor acceptor;
+
+	void accept_all() {
+		while (true) {
+			if (!next_connection)
+				next_connection = std::make_unique<Connection>(this);
+			if (!acceptor.accept(next_connection->client))
+				return;
+			invariant(next_connection->server.connect("127.0.0.1", target_port), "");
+			connections.push_back(std::move(next_connection));
+		}
+	}
+	void read_all(platform::TCPSocket &from, std::deque<Chunk> &to, TimePoint due, size_t *counter) {
+		while (true) {
+			Chunk chunk{due, common::BinaryArray(64 * 1024)};
+			const size_t rc = from.read_some(chunk.data.data(), chunk.data.size());
+			if (rc == 0)
+				return;
+			chunk.data.resize(rc);
+			*counter += rc;
+			to.push_back(std::move(chunk));
+		}
+	}
+	static void write_due(std::deque<Chunk> &from, platform::TCPSocket &to, TimePoint now) {
+		while (!from.empty() && from.front().due <= now) {
+			auto &chunk     = from.front();
+			const size_t wc = to.write_some(chunk.data.data() + chunk.written, chunk.data.size() - chunk.written);
+			chunk.written += wc;
+			if (chunk.written != chunk.data.size())
+				return;  // socket will call pump when it can write more
+			from.pop_front();
+		}
+	}
+	void pump(Connection *conn) {
+		if (!conn->client.is_open() || !conn->server.is_open())
+			return conn->close();
+		const auto now = std::chrono::steady_clock::now();
+		read_all(conn->client, conn->up, now + one_way, &bytes_up);
+		read_all(conn->server, conn->down, now + one_way, &bytes_down);
+		write_due(conn->up, conn->server, now);
+		write_due(conn->down, conn->client, now);
+		TimePoint next = TimePoint::max();
+		for (auto q : {&conn->up, &conn->down})
+			if (!q->empty() && q->front().due > now)
+				next = std::min(next, q->front().due);
+		if (next != TimePoint::max())
+			conn->timer.once(std::chrono::duration<float>(next - now).count());
+	}
+};
+
+}  // anonymous namespace
+
+// Seeds share one blockchain, each is reached through its own DelayProxy. Syncing node downloads from all of them,
+// first with one GetObjects message per block and fixed number of blocks per peer, then with block ranges and
+// adaptive window. Test net blocks are small and their PoW is checked as they arrive, so at small round trip
+// speed is limited by PoW checking rather than by network.
+void benchmark_block_download(common::CommandLine &cmd, size_t block_count, size_t peer_count, float round_trip) {
+	platform::EventLoop run_loop;
+	logging::ConsoleLogger logger(logging::ERROR);
+	Config config(cmd);
+	config.net               = "test";
+	config.multicast_address = std::string();
+	config.multicast_period  = 0;
+	config.exclusive_nodes   = true;
+	config.bytecoind_bind_ip = std::string();
+	config.p2p_bind_ip       = "127.0.0.1";
+	config.seed_nodes.clear();
+	config.priority_nodes.clear();
+	const std::string scratchpad = "../tests/scratchpad";
+	std::vector<std::string> folders;
+	auto add_folder = [&](const std::string &name) -> std::string {
+		folders.push_back(scratchpad + "/" + name);
+		invariant(platform::create_folder_if_necessary(folders.back()), "");
+		BlockChain::DB::delete_db(folders.back() + "/blockchain");
+		BlockChain::DB::delete_db(folders.back() + "/peer_db");
+		return folders.back();
+	};
+	{
+		Currency currency(config.net);
+		Config seed_chain_config      = config;
+		seed_chain_config.data_folder = add_folder("download_seed");
+		BlockChainState seed_chain(logger, seed_chain_config, currency, false);
+		benchmark_grow_chain(seed_chain, currency, block_count);
+		seed_chain.db_commit();
+
+		std::deque<Config> seed_configs;  // Node and PeerDB keep references
+		std::vector<std::unique_ptr<Node>> seeds;
+		std::vector<std::unique_ptr<DelayProxy>> proxies;
+		std::vector<NetworkAddress> proxy_addresses;
+		uint16_t next_port = 18900;
+		for (size_t i = 0; i != peer_count; ++i) {
+			seed_configs.push_back(config);
+			auto &seed_config             = seed_configs.back();
+			seed_config.data_folder       = add_folder("download_seed" + std::to_string(i));
+			seed_config.p2p_bind_port     = find_free_port(next_port, 19000);
+			seed_config.p2p_external_port = seed_config.p2p_bind_port;
+			seeds.push_back(std::make_unique<Node>(logger, seed_config, seed_chain));
+			NetworkAddress addr;
+			invariant(common::parse_ip_address("127.0.0.1", &addr.ip), "");
+			addr.port = find_free_port(seed_config.p2p_bind_port + 1, 19000);
+			proxies.push_back(std::make_unique<DelayProxy>(addr.port, seed_config.p2p_bind_port, round_trip));
+			proxy_addresses.push_back(addr);
+			next_port = addr.port + 1;
+		}
+		std::sort(proxy_addresses.begin(), proxy_addresses.end());
+		const std::string sync_folder = add_folder("download_sync");
+
+		for (bool block_ranges : {false, true}) {
+			for (auto &&proxy : proxies)
+				proxy->bytes_up = proxy->bytes_down = 0;
+			BlockChain::DB::delete_db(sync_folder + "/blockchain");
+			BlockChain::DB::delete_db(sync_folder + "/peer_db");
+			platform::remove_file(sync_folder + "/keyimage_filter.bin");
+			Config sync_config           = config;
+			sync_config.data_folder      = sync_folder;
+			sync_config.p2p_bind_port    = find_free_port(next_port, 19000);
+			sync_config.priority_nodes   = proxy_addresses;
+			sync_config.p2p_block_ranges = block_ranges;
+			BlockChainState sync_chain(logger, sync_config, currency, false);
+			Node sync_node(logger, sync_config, sync_chain);
+			platform::Timer watchdog([&]() {
+				std::cout << "benchmark_block_download watchdog fired" << std::endl;
+				run_loop.cancel();
+			});
+			watchdog.once(600);
+			const auto idea_start = std::chrono::steady_clock::now();
+			while (sync_chain.get_tip_bid() != seed_chain.get_tip_bid() && !run_loop.stopped()) {
+				bool more = sync_node.on_idle();
+				for (auto &&seed : seeds)
+					more = seed->on_idle() || more;
+				if (more)
+					run_loop.poll();
+				else
+					run_loop.run_one();
+			}
+			watchdog.cancel();
+			const auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			    std::chrono::steady_clock::now() - idea_start);
+			invariant(!run_loop.stopped(), "benchmark_block_download did not finish");
+			size_t bytes_up = 0, bytes_down = 0;
+			for (auto &&proxy : proxies) {
+				bytes_up += proxy->bytes_up;
+				bytes_down += proxy->bytes_down;
+			}
+			std::cout << "block_download=" << (block_ranges ? "ranges" : "objects") << " blocks=" << block_count
+			          << " peers=" << peer_count << " round trip ms=" << round_trip * 1000
+			          << " total ms=" << total_ms.count()
+			          << " blocks/s=" << block_count * 1000 / std::max<size_t>(1, total_ms.count())
+			          << " request bytes=" << bytes_up << " response bytes=" << bytes_down << std::endl;
+		}
+	}
+	for (auto &&folder : folders) {
+		BlockChain::DB::delete_db(folder + "/blockchain");
+		BlockChain::DB::delete_db(folder + "/peer_db");
+		platform::remove_file(folder + "/keyimage_filter.bin");
+		platform::remove_file(folder);  // only empty folder is removed, and not on Windows
+	}
+}
@@ -0,0 +1,250 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "Core/BlockChainState.hpp"
+#include "Core/CompactBlock.hpp"
+#include "Core/Config.hpp"
+#include "Core/CryptoNoteTools.hpp"
+#include "Core/Currency.hpp"
+#include "Core/Node.hpp"
+#include "Core/TransactionPool.hpp"
+#include "common/Invariant.hpp"
+#include "common/Ipv4Address.hpp"
+#include "crypto/crypto.hpp"
+#include "logging/ConsoleLogger.hpp"
+#include "p2p/LevinProtocol.hpp"
+#include "platform/Network.hpp"
+#include "platform/PathTools.hpp"
+#include "seria/BinaryInputStream.hpp"
+#include "seria/BinaryOutputStream.hpp"
+#include "../blockchain/test_blockchain.hpp"
+
+using namespace cn;
+
+namespace {
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+double to_ms(std::chrono::steady_clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+// Nodes in a line, each connected only to previous one, so block mined on first node is relayed node_count - 1
+// times. Before each block its transactions are put into first node pool and into pools of other nodes except
+// every 10th one, so compact block receivers must ask previous node for them.
+void relay_in_line(common::CommandLine &cmd, size_t node_count, size_t block_count, bool compact_blocks) {
+	platform::EventLoop run_loop;
+	logging::ConsoleLogger logger(logging::ERROR);
+	Config config(cmd);
+	config.net                = "test";
+	config.multicast_address  = std::string();
+	config.multicast_period   = 0;
+	config.exclusive_nodes    = true;
+	config.bytecoind_bind_ip  = std::string();
+	config.p2p_bind_ip        = "127.0.0.1";
+	config.p2p_compact_blocks = compact_blocks;
+	config.seed_nodes.clear();
+	config.priority_nodes.clear();
+	const std::string scratchpad = "../tests/scratchpad";
+	std::vector<std::string> folders;
+	{
+		Currency currency(config.net);
+		std::deque<Config> configs;  // BlockChainState, Node and PeerDB keep references
+		std::vector<std::unique_ptr<BlockChainState>> chains;
+		std::vector<std::unique_ptr<Node>> nodes;
+		uint16_t next_port = 19000;
+		for (size_t i = 0; i != node_count; ++i) {
+			configs.push_back(config);
+			auto &node_config       = configs.back();
+			node_config.data_folder = scratchpad + "/relay" + std::to_string(i);
+			folders.push_back(node_config.data_folder);
+			invariant(platform::create_folder_if_necessary(node_config.data_folder), "");
+			BlockChain::DB::delete_db(node_config.data_folder + "/blockchain");
+			BlockChain::DB::delete_db(node_config.data_folder + "/peer_db");
+			platform::remove_file(node_config.data_folder + "/keyimage_filter.bin");
+			node_config.p2p_bind_port     = find_free_port(next_port, 19100);
+			node_config.p2p_external_port = node_config.p2p_bind_port;
+			next_port                     = node_config.p2p_bind_port + 1;
+			if (i != 0) {
+				NetworkAddress addr;
+				invariant(common::parse_ip_address("127.0.0.1", &addr.ip), "");
+				addr.port = configs.at(i - 1).p2p_bind_port;
+				node_config.priority_nodes.push_back(addr);
+			}
+			chains.push_back(std::make_unique<BlockChainState>(logger, node_config, currency, false));
+		}
+		// Coinbase of each funding block pays for transactions of one relayed block
+		const KeyPair spend_keys = crypto::random_keypair();
+		const KeyPair view_keys  = crypto::random_keypair();
+		AccountAddressSimple address;
+		address.spend_public_key = spend_keys.public_key;
+		address.view_public_key  = view_keys.public_key;
+		std::vector<BlockTemplate> funding;
+		std::vector<BlockChainState::BlockGlobalIndices> funding_global_indices;
+		for (size_t b = 0; b != block_count + 1 + currency.mined_money_unlock_window; ++b) {
+			const BinaryArray block = benchmark_mine_block(*chains.at(0), currency, address);
+			api::BlockHeader info;
+			for (auto &&chain : chains) {
+				RawBlock rb;
+				invariant(chain->add_mined_block(block, &rb, &info), "");
+			}
+			if (b > block_count)
+				continue;
+			funding.emplace_back();
+			seria::from_binary(funding.back(), block);
+			funding_global_indices.emplace_back();
+			invariant(chains.at(0)->read_block_output_global_indices(info.hash, &funding_global_indices.back()), "");
+		}
+		for (size_t i = 0; i != node_count; ++i)
+			nodes.push_back(std::make_unique<Node>(logger, configs.at(i), *chains.at(i)));
+		platform::Timer watchdog([&]() {
+			std::cout << "benchmark_block_relay watchdog fired" << std::endl;
+			run_loop.cancel();
+		});
+		watchdog.once(300);
+		std::vector<TimePoint> arrived(node_count);
+		auto run_until_all_have = [&](const Hash &bid) {
+			while (!run_loop.stopped()) {
+				bool all = true;
+				for (size_t i = 0; i != node_count; ++i) {
+					if (arrived.at(i) == TimePoint{} && chains.at(i)->get_tip_bid() == bid)
+						arrived.at(i) = std::chrono::steady_clock::now();
+					all = all && arrived.at(i) != TimePoint{};
+				}
+				if (all)
+					return;
+				bool more = false;
+				for (auto &&node : nodes)
+					more = node->on_idle() || more;
+				if (more)
+					run_loop.poll();
+				else
+					run_loop.run_one();
+			}
+			invariant(false, "benchmark_block_relay did not finish");
+		};
+		auto get_statistics = [&](size_t i) {
+			return nodes.at(i)->create_statistics_response(api::cnd::GetStatistics::Request{});
+		};
+		const Amount fee = 1000;
+		std::vector<api::cnd::GetStatistics::Response> first_stats;
+		std::vector<double> total_ms;
+		std::vector<double> hop_ms;
+		size_t transaction_count = 0;
+		for (size_t b = 0; b != block_count + 1; ++b) {
+			const Transaction &coinbase = funding.at(b).base_transaction;
+			std::vector<Hash> tids;
+			for (size_t o = 0, t = 0; o != coinbase.outputs.size(); ++o) {
+				if (boost::get<OutputKey>(coinbase.outputs.at(o)).amount <= 10 * fee)
+					continue;
+				const Transaction tx = spend_coinbase_output(coinbase, o, funding_global_indices.at(b).at(0).at(o),
+				    address, view_keys.secret_key, spend_keys.secret_key, fee);
+				const Hash tid              = get_transaction_hash(tx);
+				const BinaryArray binary_tx = seria::to_binary(tx);
+				for (size_t i = 0; i != node_count; ++i)
+					if (i == 0 || t % 10 != 0)
+						invariant(chains.at(i)->add_transaction(tid, tx, binary_tx, true, std::string()), "");
+				tids.push_back(tid);
+				t += 1;
+			}
+			const BinaryArray block = benchmark_mine_block(*chains.at(0), currency, address);
+			BlockTemplate block_template;
+			seria::from_binary(block_template, block);
+			invariant(block_template.transaction_hashes.size() == tids.size(), "Pool transactions must be in block");
+			std::fill(arrived.begin(), arrived.end(), TimePoint{});
+			const auto start = std::chrono::steady_clock::now();
+			api::BlockHeader info;
+			nodes.at(0)->submit_block(block, &info);
+			run_until_all_have(info.hash);
+			if (b == 0) {  // first block waits for connections, and may be downloaded rather than relayed
+				for (size_t i = 0; i != node_count; ++i)
+					first_stats.push_back(get_statistics(i));
+				continue;
+			}
+			transaction_count += tids.size();
+			total_ms.push_back(to_ms(arrived.back() - start));
+			for (size_t i = 1; i != node_count; ++i)
+				hop_ms.push_back(to_ms(arrived.at(i) - arrived.at(i - 1)));
+		}
+		watchdog.cancel();
+		size_t requested = 0;
+		for (size_t i = 1; i != node_count && compact_blocks; ++i) {
+			const auto stats = get_statistics(i);
+			invariant(stats.compact_blocks_reconstructed - first_stats.at(i).compact_blocks_reconstructed ==
+			              block_count,
+			    "Every block must reach every node as compact block");
+			requested +=
+			    stats.compact_block_transactions_requested - first_stats.at(i).compact_block_transactions_requested;
+		}
+		std::cout << "block_relay=" << (compact_blocks ? "compact" : "header") << " nodes=" << node_count
+		          << " blocks=" << block_count << " transactions=" << transaction_count
+		          << " requested transactions=" << requested << " hop ms p50=" << percentile(hop_ms, 0.5)
+		          << " p99=" << percentile(hop_ms, 0.99) << " line ms p50=" << percentile(total_ms, 0.5)
+		          << " p99=" << percentile(total_ms, 0.99) << std::endl;
+	}
+	for (auto &&folder : folders) {
+		BlockChain::DB::delete_db(folder + "/blockchain");
+		BlockChain::DB::delete_db(folder + "/peer_db");
+		platform::remove_file(folder + "/keyimage_filter.bin");
+		platform::remove_file(folder);  // only empty folder is removed, and not on Windows
+	}
+}
+
+// Block of transaction_count synthetic transactions, all of them in receiver's pool together with as many unrelated
+// ones, except every missing_every-th that receiver must ask for.
+void compact_reconstruction(size_t transaction_count, size_t missing_every) {
+	RawBlock raw_block;
+	Hash bid;
+	TransactionPool pool(std::numeric_limits<size_t>::max());
+	std::vector<BinaryArray> missing;
+	make_synthetic_block(transaction_count, missing_every, transaction_count, &raw_block, &bid, &pool, &missing);
+
+	p2p::RelayBlock::Notify header_msg;  // what V4 peers get
+	header_msg.b.block                   = raw_block.block;
+	header_msg.top_id                    = bid;
+	header_msg.current_blockchain_height = 1;
+	const size_t header_size             = LevinProtocol::send(header_msg).size();
+
+	const size_t rounds = 10;
+	size_t compact_size = 0;
+	auto start          = std::chrono::steady_clock::now();
+	for (size_t r = 0; r != rounds; ++r)
+		compact_size = LevinProtocol::send(CompactBlock::create(raw_block, bid, 1, crypto::rand<uint64_t>())).size();
+	const double create_ms = to_ms(std::chrono::steady_clock::now() - start) / rounds;
+
+	const auto msg = CompactBlock::create(raw_block, bid, 1, crypto::rand<uint64_t>());
+	start          = std::chrono::steady_clock::now();
+	for (size_t r = 0; r != rounds; ++r) {
+		CompactBlock compact(p2p::RelayCompactBlock::Notify{msg});
+		compact.fill_from_pool(pool);
+		invariant(compact.get_missing().size() == missing.size(), "");
+		invariant(compact.add_missing(missing), "");
+		RawBlock reconstructed;
+		invariant(compact.get_block(&reconstructed), "");
+		invariant(reconstructed.transactions.size() == transaction_count, "");
+	}
+	const double reconstruct_ms = to_ms(std::chrono::steady_clock::now() - start) / rounds;
+	std::cout << "compact_block transactions=" << transaction_count << " missing=" << missing.size()
+	          << " header message bytes=" << header_size << " compact message bytes=" << compact_size
+	          << " create ms=" << create_ms << " reconstruct ms=" << reconstruct_ms << std::endl;
+}
+
+}  // anonymous namespace
+
+// Relay latency over loopback with header relay (V4) and compact blocks (V5), then message size and reconstruction
+// time for block of transaction_count transactions taken from pool. On loopback relay latency is dominated by
+// checking PoW of block on each hop, compact blocks save mostly bandwidth and transaction lookups.
+void benchmark_block_relay(common::CommandLine &cmd, size_t node_count, size_t block_count, size_t transaction_count) {
+	for (bool compact_blocks : {false, true})
+		relay_in_line(cmd, node_count, block_count, compact_blocks);
+	for (size_t missing_every : {0, 10})
+		compact_reconstruction(transaction_count, missing_every);
+}
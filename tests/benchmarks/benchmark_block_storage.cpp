@@ -0,0 +1,104 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "Core/BlockChainFileFormat.hpp"
+#include "Core/BlockChainState.hpp"
+#include "Core/Config.hpp"
+#include "Core/Currency.hpp"
+#include "Core/CryptoNoteTools.hpp"
+#include "common/Invariant.hpp"
+#include "crypto/crypto.hpp"
+#include "logging/ConsoleLogger.hpp"
+#include "platform/PathTools.hpp"
+#include "seria/BinaryInputStream.hpp"
+
+using namespace cn;
+
+// Test net blocks have only coinbase transactions, so dictionary is trained on first 32 KB of blocks, and ratio
+// is not representative of main net blocks with many transactions.
+void benchmark_block_storage(common::CommandLine &cmd, size_t block_count, size_t read_count) {
+	logging::ConsoleLogger logger(logging::ERROR);
+	Config config(cmd);
+	config.data_folder                    = "../tests/scratchpad";
+	config.net                            = "test";
+	config.block_dictionary_training_size = 32 * 1024;
+	const std::string index_file_name     = config.data_folder + "/" + config.block_indexes_file_name;
+	const std::string item_file_name      = config.data_folder + "/" + config.blocks_file_name;
+	Currency currency(config.net);
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	Hash tip_bid;
+	{
+		BlockChainState block_chain(logger, config, currency, false);
+		benchmark_grow_chain(block_chain, currency, block_count);
+		block_chain.db_commit();
+		tip_bid = block_chain.get_tip_bid();
+		invariant(LegacyBlockChainWriter::export_blockchain2(index_file_name, item_file_name, block_chain), "");
+	}
+	for (bool compress : {false, true}) {
+		BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+		config.compress_blocks = compress;
+		BlockChainState block_chain(logger, config, currency, false);
+		auto idea_start = std::chrono::high_resolution_clock::now();
+		invariant(LegacyBlockChainReader::import_blockchain2(index_file_name, item_file_name, &block_chain), "");
+		const auto import_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+		    std::chrono::high_resolution_clock::now() - idea_start);
+		invariant(block_chain.get_tip_bid() == tip_bid, "benchmark_block_storage tip differs after import");
+		block_chain.db_commit();
+
+		const BlockChainReader reader(block_chain);
+		std::vector<Hash> bids;
+		std::vector<Hash> tids;
+		size_t raw_size = 0, stored_size = 0;
+		for (Height ha = 0; ha <= reader.get_tip_height(); ++ha) {
+			Hash bid;
+			StoredBlockData stored;
+			invariant(reader.get_chain(ha, &bid) && reader.get_block_data(bid, &stored), "");
+			raw_size += stored.size();
+			stored_size += stored.value.size();
+			RawBlock raw_block;
+			invariant(reader.get_block(bid, &raw_block), "");
+			BlockTemplate block_template;
+			seria::from_binary(block_template, raw_block.block);
+			bids.push_back(bid);
+			tids.push_back(get_transaction_hash(block_template.base_transaction));
+		}
+		std::vector<double> block_latencies, transaction_latencies;
+		for (size_t i = 0; i != read_count; ++i) {
+			const size_t pos = crypto::rand<size_t>() % bids.size();
+			auto start       = std::chrono::high_resolution_clock::now();
+			RawBlock raw_block;
+			invariant(reader.get_block(bids[pos], &raw_block), "");
+			auto mid = std::chrono::high_resolution_clock::now();
+			BinaryArray binary_tx;
+			Hash bid;
+			Height height         = 0;
+			size_t index_in_block = 0;
+			invariant(reader.get_transaction(tids[pos], &binary_tx, &height, &bid, &index_in_block), "");
+			auto end = std::chrono::high_resolution_clock::now();
+			block_latencies.push_back(std::chrono::duration<double, std::micro>(mid - start).count());
+			transaction_latencies.push_back(std::chrono::duration<double, std::micro>(end - mid).count());
+		}
+		api::cnd::GetStatistics::Response stats;
+		block_chain.fill_statistics(stats);
+		std::cout << "block_storage=" << (compress ? "compressed" : "raw") << " blocks=" << bids.size()
+		          << " import ms=" << import_ms.count()
+		          << " blocks/s=" << bids.size() * 1000 / std::max<size_t>(1, import_ms.count())
+		          << " block bytes=" << raw_size << " stored bytes=" << stored_size
+		          << " dictionaries=" << stats.block_dictionary_count << " get_block p50/p99 us="
+		          << percentile(block_latencies, 0.5) << "/" << percentile(block_latencies, 0.99)
+		          << " get_transaction p50/p99 us=" << percentile(transaction_latencies, 0.5) << "/"
+		          << percentile(transaction_latencies, 0.99) << " cache hits/misses=" << stats.block_cache_hits
+		          << "/" << stats.block_cache_misses << std::endl;
+	}
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	platform::remove_file(index_file_name);
+	platform::remove_file(item_file_name);
+	platform::remove_file(config.data_folder + "/keyimage_filter.bin");
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "common/Invariant.hpp"
+#include "common/MemoryStreams.hpp"
+#include "platform/Network.hpp"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#if platform_USE_EPOLL
+static const char EVENT_LOOP_NAME[] = "epoll";
+#else
+static const char EVENT_LOOP_NAME[] = "boost::asio";
+#endif
+
+namespace {
+
+struct EchoServerConnection {
+	platform::TCPSocket sock;
+	common::CircularBuffer buffer{4096};
+	size_t *disconnects;
+
+	explicit EchoServerConnection(size_t *disconnects)
+	    : sock([this](bool, bool) { echo(); }, [this]() { *this->disconnects += 1; }), disconnects(disconnects) {}
+	void echo() {
+		while (true) {
+			buffer.copy_from(sock);
+			if (buffer.copy_to(sock) == 0)
+				break;
+		}
+	}
+};
+
+struct EchoClient {
+	platform::TCPSocket sock;
+	const common::BinaryArray &message;
+	size_t round_trips;
+	size_t sent     = 0;  // in current round trip
+	size_t received = 0;  // in current round trip
+	bool connected  = false;
+	std::function<void(EchoClient *)> on_connected;
+	std::function<void(EchoClient *)> on_finished;
+	std::function<void(EchoClient *)> on_disconnected;
+
+	EchoClient(const common::BinaryArray &message, size_t round_trips)
+	    : sock([this](bool, bool) { advance(); }, [this]() { on_disconnected(this); })
+	    , message(message)
+	    , round_trips(round_trips) {}
+	void advance() {
+		if (!connected) {
+			connected = true;
+			on_connected(this);
+		}
+		unsigned char tmp[4096];
+		while (round_trips != 0) {
+			while (sent != message.size()) {
+				const size_t wc = sock.write_some(message.data() + sent, message.size() - sent);
+				if (wc == 0)
+					break;
+				sent += wc;
+			}
+			const size_t rc = sock.read_some(tmp, std::min(sizeof(tmp), message.size() - received));
+			received += rc;
+			if (received != message.size()) {
+				if (rc == 0)
+					return;
+				continue;
+			}
+			sent = received = 0;
+			round_trips -= 1;
+			if (round_trips == 0)
+				on_finished(this);
+		}
+	}
+};
+
+}  // anonymous namespace
+
+// Many simultaneous connections over loopback, each doing small request-response round trips like P2P
+// ping or RPC status requests. Measures connection setup and per-event overhead of the run loop.
+void benchmark_connections(size_t connection_count, size_t round_trips, size_t message_size) {
+#ifndef _WIN32
+	struct rlimit limit {};
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < 2 * connection_count + 64) {
+		limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, 2 * connection_count + 64);
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+#endif
+	platform::EventLoop run_loop;
+	size_t server_disconnects = 0;
+	std::vector<std::unique_ptr<EchoServerConnection>> server_connections;
+	std::unique_ptr<EchoServerConnection> next_connection;
+	std::unique_ptr<platform::TCPAcceptor> acceptor;
+	uint16_t port = 0;
+	for (uint16_t p = 18400; p != 18500 && !acceptor; ++p)
+		try {
+			acceptor = std::make_unique<platform::TCPAcceptor>("127.0.0.1", p, [&]() {
+				while (true) {
+					if (!next_connection)
+						next_connection = std::make_unique<EchoServerConnection>(&server_disconnects);
+					if (!acceptor->accept(next_connection->sock))
+						return;
+					server_connections.push_back(std::move(next_connection));
+				}
+			});
+			port = p;
+		} catch (const platform::TCPAcceptor::AddressInUse &) {
+		}
+	invariant(acceptor, "No free port for benchmark_connections");
+
+	common::BinaryArray message(message_size);
+	for (size_t i = 0; i != message.size(); ++i)
+		message[i] = static_cast<unsigned char>(i);
+	size_t connected_count = 0, finished_count = 0, disconnected_count = 0;
+	std::chrono::steady_clock::time_point connected_time;
+	auto stop_if_done = [&]() {
+		if (finished_count + disconnected_count == connection_count)
+			run_loop.cancel();
+	};
+	platform::Timer watchdog([&]() {
+		std::cout << "benchmark_connections watchdog fired finished=" << finished_count << std::endl;
+		run_loop.cancel();
+	});
+	watchdog.once(120);
+
+	auto idea_start = std::chrono::steady_clock::now();
+	std::vector<std::unique_ptr<EchoClient>> clients;
+	for (size_t i = 0; i != connection_count; ++i) {
+		clients.push_back(std::make_unique<EchoClient>(message, round_trips));
+		clients.back()->on_connected = [&](EchoClient *) {
+			if (++connected_count == connection_count)
+				connected_time = std::chrono::steady_clock::now();
+		};
+		clients.back()->on_finished = [&](EchoClient *) {
+			finished_count += 1;
+			stop_if_done();
+		};
+		clients.back()->on_disconnected = [&](EchoClient *) {
+			disconnected_count += 1;
+			stop_if_done();
+		};
+		invariant(clients.back()->sock.connect("127.0.0.1", port), "");
+	}
+	while (!run_loop.stopped())
+		run_loop.run_one();
+	auto idea_end = std::chrono::steady_clock::now();
+	invariant(finished_count == connection_count && disconnected_count == 0 && server_disconnects == 0,
+	    "benchmark_connections not all connections finished successfully");
+
+	const auto connect_ms = std::chrono::duration_cast<std::chrono::milliseconds>(connected_time - idea_start);
+	const auto total_ms   = std::chrono::duration_cast<std::chrono::milliseconds>(idea_end - idea_start);
+	std::cout << "event_loop=" << EVENT_LOOP_NAME << " connections=" << connection_count
+	          << " round_trips=" << connection_count * round_trips << " message_size=" << message_size
+	          << " all connected ms=" << connect_ms.count() << " total ms=" << total_ms.count() << " round_trips/sec="
+	          << connection_count * round_trips * 1000.0 / std::max<int64_t>(1, total_ms.count()) << std::endl;
+}
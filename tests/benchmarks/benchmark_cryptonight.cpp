@@ -0,0 +1,60 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "common/Invariant.hpp"
+#include "crypto/crypto.hpp"
+#include "crypto/hash.hpp"
+
+using namespace crypto;
+
+static std::vector<Hash> hash_single(CryptoNightContext &context, const std::vector<Hash> &inputs) {
+	std::vector<Hash> result(inputs.size());
+	for (size_t i = 0; i != inputs.size(); ++i)
+		result[i] = context.cn_slow_hash(inputs[i].data, sizeof(inputs[i].data));
+	return result;
+}
+
+static std::vector<Hash> hash_multi(CryptoNightContext &context, const std::vector<Hash> &inputs) {
+	std::vector<Hash> result(inputs.size());
+	const void *data[SLOW_HASH_MAX_WAYS]{};
+	size_t lengths[SLOW_HASH_MAX_WAYS]{};
+	for (size_t i = 0; i < inputs.size(); i += context.get_ways()) {
+		const size_t count = std::min(context.get_ways(), inputs.size() - i);
+		for (size_t j = 0; j != count; ++j) {
+			data[j]    = inputs[i + j].data;
+			lengths[j] = sizeof(inputs[i + j].data);
+		}
+		context.cn_slow_hash_multi(data, lengths, result.data() + i, count);
+	}
+	return result;
+}
+
+void benchmark_cryptonight(size_t hash_count) {
+	std::vector<Hash> inputs(hash_count);
+	for (auto &in : inputs)
+		in = crypto::rand<Hash>();
+	std::vector<Hash> expected;
+	for (size_t ways = 1; ways <= SLOW_HASH_MAX_WAYS; ++ways)
+		for (bool huge_pages : {false, true}) {
+			CryptoNightContext context(ways, huge_pages);
+			if (huge_pages && !context.has_huge_pages()) {
+				std::cout << "ways=" << ways << " huge pages not available" << std::endl;
+				continue;
+			}
+			auto idea_start = std::chrono::high_resolution_clock::now();
+			auto result     = ways == 1 ? hash_single(context, inputs) : hash_multi(context, inputs);
+			auto idea_ms    = std::chrono::duration_cast<std::chrono::milliseconds>(
+			    std::chrono::high_resolution_clock::now() - idea_start);
+			if (expected.empty())
+				expected = result;
+			invariant(result == expected, "cn_slow_hash_multi result differs from cn_slow_hash");
+			std::cout << "ways=" << ways << " huge_pages=" << huge_pages << " locked=" << context.has_locked_pages()
+			          << " hashes/sec=" << hash_count * 1000.0 / std::max<int64_t>(1, idea_ms.count()) << std::endl;
+		}
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <iostream>
+#include "common/Invariant.hpp"
+#include "common/StringTools.hpp"
+#include "crypto/crypto.hpp"
+
+namespace {
+
+// Byte by byte conversion, as it was done before vectorised kernels
+void append_hex_scalar(const uint8_t *data, size_t size, std::string *text) {
+	const size_t was_size = text->size();
+	text->resize(was_size + size * 2);
+	char *out = &(*text)[was_size];
+	for (size_t i = 0; i < size; ++i) {
+		out[i * 2]     = "0123456789abcdef"[data[i] >> 4];
+		out[i * 2 + 1] = "0123456789abcdef"[data[i] & 0x0f];
+	}
+}
+
+void from_hex_scalar(const std::string &text, uint8_t *data) {
+	for (size_t i = 0; i < text.size() / 2; ++i)
+		data[i] = common::from_hex(text[i * 2]) << 4 | common::from_hex(text[i * 2 + 1]);
+}
+
+double mb_per_second(size_t bytes, std::chrono::high_resolution_clock::duration duration) {
+	return bytes / std::chrono::duration<double>(duration).count() / (1024 * 1024);
+}
+
+}  // anonymous namespace
+
+void benchmark_hex(size_t chunk_size, size_t total_size) {
+	common::BinaryArray data(chunk_size);
+	for (auto &b : data)
+		b = crypto::rand<uint8_t>();
+	const size_t iterations = total_size / chunk_size;
+	const std::string hex   = common::to_hex(data);
+	for (bool scalar : {true, false}) {
+		std::string text;
+		auto idea_start = std::chrono::high_resolution_clock::now();
+		for (size_t it = 0; it != iterations; ++it) {
+			text.clear();
+			if (scalar)
+				append_hex_scalar(data.data(), data.size(), &text);
+			else
+				common::append_hex(data.data(), data.size(), &text);
+		}
+		auto idea_mid = std::chrono::high_resolution_clock::now();
+		common::BinaryArray decoded(chunk_size);
+		for (size_t it = 0; it != iterations; ++it)
+			if (scalar)
+				from_hex_scalar(hex, decoded.data());
+			else
+				common::from_hex_or_throw(hex.data(), hex.size(), decoded.data(), decoded.size());
+		auto idea_end = std::chrono::high_resolution_clock::now();
+		invariant(text == hex && decoded == data, "benchmark_hex results differ");
+		std::cout << "hex=" << (scalar ? "scalar" : "library") << " chunk=" << chunk_size
+		          << " encode MB/s=" << mb_per_second(iterations * chunk_size, idea_mid - idea_start)
+		          << " decode MB/s=" << mb_per_second(iterations * chunk_size, idea_end - idea_mid) << std::endl;
+	}
+}
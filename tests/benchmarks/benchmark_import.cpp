@@ -0,0 +1,53 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include "Core/BlockChainFileFormat.hpp"
+#include "Core/BlockChainState.hpp"
+#include "Core/Config.hpp"
+#include "Core/Currency.hpp"
+#include "common/Invariant.hpp"
+#include "logging/ConsoleLogger.hpp"
+#include "platform/PathTools.hpp"
+
+using namespace cn;
+
+// Test net has no hard checkpoints, so PoW of every block is checked, long hashes are calculated by reader threads
+void benchmark_import(common::CommandLine &cmd, size_t block_count) {
+	logging::ConsoleLogger logger(logging::ERROR);
+	Config config(cmd);
+	config.data_folder                = "../tests/scratchpad";
+	config.net                        = "test";
+	const std::string index_file_name = config.data_folder + "/" + config.block_indexes_file_name;
+	const std::string item_file_name  = config.data_folder + "/" + config.blocks_file_name;
+	Currency currency(config.net);
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	Hash tip_bid;
+	{
+		BlockChainState block_chain(logger, config, currency, false);
+		benchmark_grow_chain(block_chain, currency, block_count);
+		block_chain.db_commit();
+		tip_bid = block_chain.get_tip_bid();
+		invariant(LegacyBlockChainWriter::export_blockchain2(index_file_name, item_file_name, block_chain), "");
+	}
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	{
+		BlockChainState block_chain(logger, config, currency, false);
+		auto idea_start = std::chrono::high_resolution_clock::now();
+		invariant(LegacyBlockChainReader::import_blockchain2(index_file_name, item_file_name, &block_chain), "");
+		auto idea_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+		    std::chrono::high_resolution_clock::now() - idea_start);
+		invariant(block_chain.get_tip_bid() == tip_bid, "benchmark_import tip differs after import");
+		std::cout << "import blocks=" << block_count << " ms=" << idea_ms.count()
+		          << " blocks/s=" << block_count * 1000 / std::max<size_t>(1, idea_ms.count()) << std::endl;
+	}
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	platform::remove_file(index_file_name);
+	platform::remove_file(item_file_name);
+	platform::remove_file(config.data_folder + "/keyimage_filter.bin");
+}
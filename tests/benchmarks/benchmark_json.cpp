@@ -0,0 +1,87 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <iostream>
+#include "common/Invariant.hpp"
+#include "crypto/crypto.hpp"
+#include "rpc_api.hpp"
+#include "seria/JsonInputStream.hpp"
+#include "seria/JsonOutputStream.hpp"
+
+using namespace cn;
+
+namespace {
+
+api::walletd::GetTransfers::Response make_response(size_t block_count, size_t transactions_per_block) {
+	api::walletd::GetTransfers::Response response;
+	for (size_t b = 0; b != block_count; ++b) {
+		api::Block block;
+		block.header.height    = static_cast<Height>(b);
+		block.header.hash      = crypto::rand<Hash>();
+		block.header.timestamp = static_cast<Timestamp>(1500000000 + b * 120);
+		for (size_t t = 0; t != transactions_per_block; ++t) {
+			api::Transaction tx;
+			tx.hash       = crypto::rand<Hash>();
+			tx.public_key = crypto::rand<PublicKey>();
+			tx.extra      = BinaryArray(100, static_cast<uint8_t>(t));
+			tx.fee        = 1000000;
+			tx.size       = 2000;
+			api::Transfer transfer;
+			transfer.address = "21mQ7KPdmLbjfpg3Coayi4hZzAEgjeL87QXGeDTHahKeJsvKHc6DoprAJmqUcLhWTUXtxCL6rQFSwEUe6NZdEoqZNpSq1iC";
+			transfer.amount  = 123456789;
+			for (size_t o = 0; o != 4; ++o) {
+				api::Output output;
+				output.amount     = 100000000;
+				output.public_key = crypto::rand<PublicKey>();
+				output.key_image  = crypto::rand<KeyImage>();
+				output.address    = transfer.address;
+				transfer.outputs.push_back(output);
+			}
+			tx.transfers.push_back(transfer);
+			block.transactions.push_back(tx);
+		}
+		response.blocks.push_back(block);
+	}
+	return response;
+}
+
+std::string to_json_text(const api::walletd::GetTransfers::Response &response) {
+	std::string text;
+	seria::JsonOutputStreamText s(text);
+	ser(const_cast<api::walletd::GetTransfers::Response &>(response), s);
+	return text;
+}
+
+}  // anonymous namespace
+
+void benchmark_json(size_t block_count, size_t transactions_per_block, size_t iterations) {
+	const auto response         = make_response(block_count, transactions_per_block);
+	const std::string reference = to_json_text(response);
+	for (bool streaming : {false, true}) {
+		size_t written_size = 0;
+		auto idea_start     = std::chrono::high_resolution_clock::now();
+		for (size_t it = 0; it != iterations; ++it)
+			written_size += streaming ? to_json_text(response).size()
+			                          : seria::to_json_value(response).to_string().size();
+		auto idea_mid = std::chrono::high_resolution_clock::now();
+		api::walletd::GetTransfers::Response parsed;
+		for (size_t it = 0; it != iterations; ++it) {
+			parsed = api::walletd::GetTransfers::Response{};
+			if (streaming)
+				seria::from_json_text(parsed, reference);
+			else
+				seria::from_json_value(parsed, common::JsonValue::from_string(reference));
+		}
+		auto idea_end = std::chrono::high_resolution_clock::now();
+		invariant(to_json_text(parsed) == reference, "benchmark_json parsed response differs");
+		const auto write_ms = std::chrono::duration_cast<std::chrono::milliseconds>(idea_mid - idea_start);
+		const auto read_ms  = std::chrono::duration_cast<std::chrono::milliseconds>(idea_end - idea_mid);
+		std::cout << "json=" << (streaming ? "streaming" : "JsonValue") << " size=" << reference.size()
+		          << " written=" << written_size / iterations << " iterations=" << iterations
+		          << " write ms=" << write_ms.count() << " read ms=" << read_ms.count() << std::endl;
+	}
+}
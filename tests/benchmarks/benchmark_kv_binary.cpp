@@ -0,0 +1,85 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include "common/Invariant.hpp"
+#include "common/MemoryStreams.hpp"
+#include "crypto/crypto.hpp"
+#include "p2p/P2pProtocolDefinitions.hpp"
+#include "seria/KVBinaryInputStream.hpp"
+#include "seria/KVBinaryOutputStream.hpp"
+
+using namespace cn;
+
+namespace {
+
+template<typename T>
+void decode_via_json_value(T &value, const BinaryArray &data) {
+	common::MemoryInputStream stream(data.data(), data.size());
+	seria::KVBinaryInputStreamValue s(stream);
+	ser(value, s);
+	invariant(stream.empty(), "");
+}
+
+template<typename T>
+void benchmark_message(const char *name, const T &message, size_t iterations) {
+	const BinaryArray data = seria::to_binary_kv(message);
+	for (bool direct : {false, true}) {
+		auto idea_start = std::chrono::high_resolution_clock::now();
+		T parsed;
+		for (size_t it = 0; it != iterations; ++it) {
+			parsed = T{};
+			if (direct)
+				seria::from_binary_kv(parsed, data);
+			else
+				decode_via_json_value(parsed, data);
+		}
+		auto idea_end = std::chrono::high_resolution_clock::now();
+		invariant(seria::to_binary_kv(parsed) == data, "benchmark_kv_binary parsed message differs");
+		const double seconds = std::chrono::duration<double>(idea_end - idea_start).count();
+		std::cout << "kv_binary=" << (direct ? "direct" : "JsonValue") << " message=" << name
+		          << " size=" << data.size() << " iterations=" << iterations << " ms=" << seconds * 1000
+		          << " MB/s=" << data.size() * iterations / std::max(seconds, 1e-9) / 1000000 << std::endl;
+	}
+}
+
+}  // anonymous namespace
+
+void benchmark_kv_binary(size_t block_count, size_t peer_count, size_t iterations) {
+	p2p::GetObjectsResponse::Notify objects;  // like during sync
+	objects.current_blockchain_height = 1700000;
+	for (size_t b = 0; b != block_count; ++b) {
+		RawBlock raw_block;
+		raw_block.block = BinaryArray(300, static_cast<uint8_t>(b));
+		for (size_t t = 0; t != 10; ++t)
+			raw_block.transactions.push_back(BinaryArray(2000, static_cast<uint8_t>(t)));
+		objects.blocks.push_back(raw_block);
+	}
+	benchmark_message("GetObjectsResponse", objects, iterations);
+
+	p2p::TimedSync::Response timed_sync;  // many small values
+	timed_sync.local_time                  = 1500000000;
+	timed_sync.payload_data.current_height = 1700000;
+	timed_sync.payload_data.top_id         = crypto::rand<Hash>();
+	for (size_t p = 0; p != peer_count; ++p) {
+		PeerlistEntryLegacy entry;
+		entry.adr.ip    = crypto::rand<uint32_t>();
+		entry.adr.port  = 8080;
+		entry.id        = crypto::rand<PeerIdType>();
+		entry.last_seen = crypto::rand<uint32_t>();
+		timed_sync.local_peerlist.push_back(entry);
+	}
+	benchmark_message("TimedSync", timed_sync, iterations * 100);
+
+	p2p::GetChainResponse::Notify chain;  // many hashes
+	chain.start_height = 1700000;
+	chain.total_height = 1700000 + 10000;
+	for (size_t b = 0; b != 10000; ++b)
+		chain.m_block_ids.push_back(crypto::rand<Hash>());
+	benchmark_message("GetChainResponse", chain, iterations * 10);
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "common/Invariant.hpp"
+#include "logging/AsyncLogWriter.hpp"
+#include "logging/FileLogger.hpp"
+#include "logging/LoggerMessage.hpp"
+#include "platform/PathTools.hpp"
+
+namespace {
+
+size_t count_lines(const std::string &file_name) {
+	std::ifstream in(file_name, std::ios::binary);
+	return std::count(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(), '\n');
+}
+
+}  // anonymous namespace
+
+void benchmark_logging(size_t thread_count, size_t messages_per_thread) {
+	const std::string name = "../tests/scratchpad/benchmark_logging";
+	for (size_t queue_size : {0, 4096, 64}) {  // last one drops on overflow
+		const bool drop_on_overflow = queue_size == 64;
+		platform::remove_file(name + ".log");
+		double log_ms = 0, total_ms = 0;
+		size_t dropped = 0, written = 0;
+		{
+			std::unique_ptr<logging::AsyncLogWriter> writer;
+			if (queue_size != 0)
+				writer = std::make_unique<logging::AsyncLogWriter>(queue_size, drop_on_overflow);
+			logging::FileLogger file_logger(name, 1024 * 1024 * 1024, logging::TRACE, writer.get());
+			auto idea_start = std::chrono::high_resolution_clock::now();
+			std::vector<std::thread> threads;
+			for (size_t t = 0; t != thread_count; ++t)
+				threads.emplace_back([&file_logger, t, messages_per_thread] {
+					logging::LoggerRef log(file_logger, "Benchmark");
+					for (size_t i = 0; i != messages_per_thread; ++i)
+						log(logging::TRACE) << logging::Color::BrightGreen << "thread=" << t << " message=" << i
+						                    << " some typical payload of block or transaction hash "
+						                    << std::string(64, 'a') << logging::Color::Default << std::endl;
+				});
+			for (auto &th : threads)
+				th.join();
+			auto idea_mid = std::chrono::high_resolution_clock::now();
+			if (writer) {
+				writer->flush();
+				dropped = writer->get_dropped();
+				written = writer->get_written();
+				invariant(writer->get_queued() == 0, "");
+				writer.reset();  // before file_logger
+			} else
+				written = thread_count * messages_per_thread;
+			auto idea_end = std::chrono::high_resolution_clock::now();
+			log_ms        = std::chrono::duration<double, std::milli>(idea_mid - idea_start).count();
+			total_ms      = std::chrono::duration<double, std::milli>(idea_end - idea_start).count();
+		}
+		invariant(written + dropped == thread_count * messages_per_thread, "");
+		if (!drop_on_overflow)
+			invariant(dropped == 0 && count_lines(name + ".log") == written, "");
+		std::cout << "logging=" << (queue_size == 0 ? "sync" : drop_on_overflow ? "async_drop" : "async")
+		          << " queue_size=" << queue_size << " threads=" << thread_count << " messages=" << written + dropped
+		          << " dropped=" << dropped << " logging threads ms=" << log_ms << " until written ms=" << total_ms
+		          << " per message ns=" << log_ms * 1000000 / (thread_count * messages_per_thread) << std::endl;
+	}
+	platform::remove_file(name + ".log");
+}
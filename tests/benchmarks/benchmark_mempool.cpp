@@ -0,0 +1,94 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "Core/TransactionPool.hpp"
+#include "common/Invariant.hpp"
+#include "crypto/crypto.hpp"
+
+using namespace cn;
+
+static PoolTransaction synthetic_transaction(const std::vector<KeyImage> &spent) {
+	PoolTransaction ptx;
+	ptx.binary_tx.resize(300 + crypto::rand<size_t>() % 3000);
+	ptx.fee       = ptx.binary_tx.size() * (1 + crypto::rand<Amount>() % 1000);
+	ptx.timestamp = static_cast<Timestamp>(1500000000 + crypto::rand<size_t>() % 10000);
+
+	const size_t input_count = 1 + crypto::rand<size_t>() % 4;
+	for (size_t i = 0; i != input_count; ++i)  // Every 10th input tries to double spend
+		ptx.key_images.push_back(
+		    !spent.empty() && crypto::rand<size_t>() % 10 == 0 ? spent.at(crypto::rand<size_t>() % spent.size())
+		                                                       : crypto::rand<KeyImage>());
+	return ptx;
+}
+
+// Pool logic of BlockChainState::add_transaction without validation - replacing, inserting and evicting
+void benchmark_mempool(size_t transaction_count, size_t max_pool_size) {
+	std::vector<Hash> tids(transaction_count);
+	std::vector<PoolTransaction> transactions;
+	std::vector<KeyImage> spent;
+	transactions.reserve(transaction_count);
+	for (size_t i = 0; i != transaction_count; ++i) {
+		tids[i] = crypto::rand<Hash>();
+		transactions.push_back(synthetic_transaction(spent));
+		spent.insert(spent.end(), transactions.back().key_images.begin(), transactions.back().key_images.end());
+	}
+	TransactionPool pool(max_pool_size);
+	size_t added = 0, rejected = 0, replaced = 0, evicted = 0, descs = 0;
+	auto idea_start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i != transaction_count; ++i) {
+		PoolTransaction &ptx = transactions[i];
+		Hash minimal_tid;
+		const Amount minimal_fee = pool.minimum_fee_per_byte(true, &minimal_tid);
+		if (ptx.fee_per_byte() < minimal_fee || (ptx.fee_per_byte() == minimal_fee && tids[i] < minimal_tid)) {
+			rejected += 1;
+			continue;
+		}
+		bool cheaper = false;
+		std::vector<Hash> conflicts;
+		for (const auto &ki : ptx.key_images) {
+			Hash other_tid;
+			if (!pool.find_keyimage(ki, &other_tid))
+				continue;
+			if (pool.at(other_tid).fee_per_byte() >= ptx.fee_per_byte())
+				cheaper = true;
+			conflicts.push_back(other_tid);
+		}
+		if (cheaper) {
+			rejected += 1;
+			continue;
+		}
+		for (const auto &tid : conflicts)
+			replaced += pool.erase(tid) ? 1 : 0;
+		invariant(pool.insert(tids[i], std::move(ptx)), "");
+		added += 1;
+		while (pool.total_size() > pool.max_size()) {
+			const Hash rhash = pool.get_fee_index().begin()->second;
+			if (pool.total_size() < pool.max_size() + pool.at(rhash).binary_tx.size())
+				break;
+			invariant(pool.erase(rhash), "");
+			evicted += 1;
+		}
+		if (i % 100 == 0) {  // Peer asks for most expensive transactions as in sync_pool
+			const auto &fee_index = pool.get_fee_index();
+			size_t count          = 0;
+			for (auto sit = fee_index.rbegin(); sit != fee_index.rend() && count != 1000; ++sit, ++count)
+				descs += pool.find(sit->second)->second.binary_tx.size() != 0 ? 1 : 0;
+		}
+	}
+	auto idea_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+	    std::chrono::high_resolution_clock::now() - idea_start);
+	invariant(pool.total_size() <= pool.max_size() + 3300, "");
+	std::cout << "transactions=" << transaction_count << " added=" << added << " rejected=" << rejected
+	          << " replaced=" << replaced << " evicted=" << evicted << " sync_pool descs=" << descs << std::endl;
+	std::cout << "pool count=" << pool.size() << " size=" << pool.total_size()
+	          << " memory_usage=" << pool.memory_usage() << " ms=" << idea_ms.count()
+	          << " transactions/sec=" << transaction_count * 1000.0 / std::max<int64_t>(1, idea_ms.count())
+	          << std::endl;
+}
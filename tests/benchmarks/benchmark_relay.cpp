@@ -0,0 +1,157 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "common/Invariant.hpp"
+#include "common/MemoryStreams.hpp"
+#include "p2p/P2P.hpp"
+#include "platform/Network.hpp"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace cn;
+
+namespace {
+
+// Outgoing side only sends, replies from sinks are never expected
+class RelayProtocol : public P2PProtocol {
+public:
+	explicit RelayProtocol(P2PClient *client) : P2PProtocol(client) {}
+	void on_connect() override {}
+	size_t on_parse_header(common::CircularBuffer &buffer, BinaryArray &request) override {
+		buffer.clear();
+		return std::string::npos;
+	}
+	void on_request_ready(BinaryArray &&header, BinaryArray &&body) override {}
+	bool handshake_ok() const override { return true; }
+};
+
+// Reads only as much as budget allows, like peer on a slow link, so messages stay in sender queues for a while
+struct SinkConnection {
+	platform::TCPSocket sock;
+	size_t *received;
+	size_t budget = 0;
+	unsigned char tmp[65536];
+
+	explicit SinkConnection(size_t *received)
+	    : sock([this](bool, bool) { drain(); }, []() {}), received(received) {}
+	void drain() {
+		while (budget != 0) {
+			const size_t rc = sock.read_some(tmp, std::min(sizeof(tmp), budget));
+			if (rc == 0)
+				break;
+			budget -= rc;
+			*received += rc;
+		}
+	}
+};
+
+struct Usage {
+	double cpu_ms   = 0;
+	long max_rss_kb = 0;
+	static Usage now() {
+		Usage result;
+#ifndef _WIN32
+		struct rusage usage {};
+		getrusage(RUSAGE_SELF, &usage);
+		result.cpu_ms = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+		                (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+		result.max_rss_kb = usage.ru_maxrss;
+#endif
+		return result;
+	}
+};
+
+}  // anonymous namespace
+
+// Relays burst of message_count messages (like fresh blocks) to peer_count throttled peers over loopback, first with
+// single shared buffer per message as Node::broadcast does, then with a copy per peer as it was done before.
+// Shared run goes first because peak RSS of process can only grow.
+void benchmark_relay(size_t peer_count, size_t message_count, size_t message_size) {
+	platform::EventLoop run_loop;
+	size_t received = 0;
+	std::vector<std::unique_ptr<SinkConnection>> sinks;
+	std::unique_ptr<SinkConnection> next_sink;
+	std::unique_ptr<platform::TCPAcceptor> acceptor;
+	uint16_t port = 0;
+	for (uint16_t p = 18500; p != 18600 && !acceptor; ++p)
+		try {
+			acceptor = std::make_unique<platform::TCPAcceptor>("127.0.0.1", p, [&]() {
+				while (true) {
+					if (!next_sink)
+						next_sink = std::make_unique<SinkConnection>(&received);
+					if (!acceptor->accept(next_sink->sock))
+						return;
+					sinks.push_back(std::move(next_sink));
+				}
+			});
+			port = p;
+		} catch (const platform::TCPAcceptor::AddressInUse &) {
+		}
+	invariant(acceptor, "No free port for benchmark_relay");
+
+	size_t disconnects = 0;
+	std::vector<std::unique_ptr<P2PClient>> peers;
+	NetworkAddress address;
+	address.ip   = BinaryArray{127, 0, 0, 1};
+	address.port = port;
+	for (size_t i = 0; i != peer_count; ++i) {
+		peers.push_back(std::make_unique<P2PClient>(false, [&](std::string) { disconnects += 1; }));
+		peers.back()->set_protocol(std::make_unique<RelayProtocol>(peers.back().get()));
+		invariant(peers.back()->test_connect(address), "");
+	}
+	const size_t budget_per_tick = std::max<size_t>(4096, message_size / 8);
+	platform::Timer throttle([&]() {
+		for (auto &&sink : sinks) {
+			sink->budget = std::min(sink->budget + budget_per_tick, 2 * budget_per_tick);
+			sink->drain();
+		}
+		throttle.once(0.01f);
+	});
+	throttle.once(0.01f);
+	platform::Timer watchdog([&]() {
+		std::cout << "benchmark_relay watchdog fired received=" << received << std::endl;
+		run_loop.cancel();
+	});
+	BinaryArray message(message_size);
+	for (size_t i = 0; i != message.size(); ++i)
+		message[i] = static_cast<unsigned char>(i);
+
+	for (bool shared : {true, false}) {
+		const Usage usage_start = Usage::now();
+		auto idea_start         = std::chrono::steady_clock::now();
+		received                = 0;
+		for (size_t m = 0; m != message_count; ++m)  // burst, so queues are longer than kernel buffers
+			if (shared) {
+				const auto shared_message = common::BinaryArrayPool::share(BinaryArray(message));
+				for (auto &&peer : peers)
+					peer->send_shared(shared_message);
+			} else {
+				for (auto &&peer : peers)
+					peer->send(BinaryArray(message));
+			}
+		watchdog.once(120);
+		while (received != message_count * peer_count * message_size && !run_loop.stopped() && disconnects == 0)
+			run_loop.run_one();
+		watchdog.cancel();
+		auto idea_end         = std::chrono::steady_clock::now();
+		const Usage usage_end = Usage::now();
+		invariant(received == message_count * peer_count * message_size && disconnects == 0,
+		    "benchmark_relay not all messages delivered");
+
+		const auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(idea_end - idea_start);
+		std::cout << "relay=" << (shared ? "shared" : "copy") << " peers=" << peer_count
+		          << " messages=" << message_count << " message_size=" << message_size
+		          << " total ms=" << total_ms.count() << " cpu ms=" << usage_end.cpu_ms - usage_start.cpu_ms
+		          << " peak RSS growth KB=" << usage_end.max_rss_kb - usage_start.max_rss_kb << std::endl;
+	}
+}
@@ -0,0 +1,173 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <thread>
+#include "Core/BlockChainState.hpp"
+#include "Core/CryptoNoteTools.hpp"
+#include "Core/Currency.hpp"
+#include "common/Invariant.hpp"
+#include "crypto/crypto.hpp"
+
+using namespace cn;
+
+namespace {
+
+// Only what RingCheckerMulticore reads
+class MemoryState : public IBlockChainState {
+public:
+	std::map<KeyImage, Height> keyimages;
+	std::map<Amount, std::vector<UnlockTimePublickKeyHeightSpent>> outputs;
+
+	void store_keyimage(const KeyImage &ki, Height height) override { keyimages[ki] = height; }
+	void delete_keyimage(const KeyImage &ki) override { keyimages.erase(ki); }
+	bool read_keyimage(const KeyImage &ki, Height *height) const override {
+		auto kit = keyimages.find(ki);
+		if (kit == keyimages.end())
+			return false;
+		*height = kit->second;
+		return true;
+	}
+	size_t push_amount_output(
+	    Amount amount, BlockOrTimestamp unlock, Height height, const PublicKey &pk, bool is_auditable) override {
+		auto &vec = outputs[amount];
+		UnlockTimePublickKeyHeightSpent unp;
+		unp.unlock_block_or_timestamp = unlock;
+		unp.public_key                = pk;
+		unp.height                    = height;
+		unp.auditable                 = is_auditable;
+		vec.push_back(unp);
+		return vec.size() - 1;
+	}
+	void pop_amount_output(Amount amount, BlockOrTimestamp, const PublicKey &, bool) override {
+		outputs[amount].pop_back();
+	}
+	size_t next_global_index_for_amount(Amount amount) const override {
+		auto oit = outputs.find(amount);
+		return oit == outputs.end() ? 0 : oit->second.size();
+	}
+	bool read_amount_output(Amount amount, size_t gi, UnlockTimePublickKeyHeightSpent *unp) const override {
+		auto oit = outputs.find(amount);
+		if (oit == outputs.end() || gi >= oit->second.size())
+			return false;
+		*unp = oit->second.at(gi);
+		return true;
+	}
+};
+
+const Amount AMOUNT = 1000;
+
+Block make_block(const std::vector<KeyPair> &output_keys, size_t transactions_per_block,
+    size_t ring_size, size_t *next_output) {
+	Block block;
+	block.header.major_version = 1;
+	for (size_t t = 0; t != transactions_per_block; ++t) {
+		Transaction tx;
+		tx.version = 1;
+		InputKey in;
+		in.amount                    = AMOUNT;
+		const size_t real_gi         = (*next_output)++;
+		const KeyPair &real          = output_keys.at(real_gi);
+		in.key_image                 = crypto::generate_key_image(real.public_key, real.secret_key);
+		const size_t first_gi        = real_gi >= ring_size ? real_gi - ring_size + 1 : 0;
+		std::vector<size_t> absolute;
+		std::vector<PublicKey> pubs;
+		for (size_t gi = first_gi; gi != first_gi + ring_size; ++gi) {
+			absolute.push_back(gi);
+			pubs.push_back(output_keys.at(gi).public_key);
+		}
+		in.output_indexes = absolute_output_offsets_to_relative(absolute);
+		tx.inputs.push_back(in);
+		Hash prefix_hash = get_transaction_prefix_hash(tx);
+		RingSignatures sigs;
+		sigs.signatures.push_back(crypto::generate_ring_signature(
+		    prefix_hash, in.key_image, pubs.data(), pubs.size(), real.secret_key, real_gi - first_gi));
+		tx.signatures = sigs;
+		block.transactions.push_back(std::move(tx));
+	}
+	return block;
+}
+
+double cpu_seconds() { return double(std::clock()) / CLOCKS_PER_SEC; }
+
+// Main thread work which does not depend on signatures, like writing to DB in redo_block
+void simulate_apply(std::chrono::microseconds duration) {
+	auto start = std::chrono::steady_clock::now();
+	Hash h{};
+	while (std::chrono::steady_clock::now() - start < duration)
+		h = crypto::cn_fast_hash(h.data, sizeof(h.data));
+}
+
+void run(const char *name, const Currency &currency, MemoryState &state, const std::vector<Block> &blocks,
+    const std::vector<Hash> &bids, size_t pipeline_blocks, std::chrono::microseconds apply_duration) {
+	RingCheckerMulticore checker;
+	auto start      = std::chrono::steady_clock::now();
+	auto cpu_start  = cpu_seconds();
+	size_t verified = 0;
+	for (size_t b = 0; b != blocks.size(); ++b) {
+		for (size_t s = b + 1; s < blocks.size() && s <= b + pipeline_blocks; ++s)
+			if (!checker.has_speculative_work(bids.at(s)))
+				checker.start_speculative_work(&state, currency, bids.at(s), blocks.at(s), false, pipeline_blocks);
+		checker.start_work(&state, currency, bids.at(b), blocks.at(b), Height(b), 0, 0, false);
+		simulate_apply(apply_duration);
+		invariant(checker.move_errors().empty(), "Correct block failed ring checks");
+		verified += blocks.at(b).transactions.size();
+	}
+	const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double cpu  = cpu_seconds() - cpu_start;
+	const double cores = std::max<unsigned>(1, std::thread::hardware_concurrency());
+	std::cout << name << ": " << blocks.size() / wall << " blocks/s, " << verified / wall
+	          << " rings/s, cpu utilisation " << int(100 * cpu / wall / cores) << "% of " << cores
+	          << " cores, speculative reused=" << checker.get_speculative_reused_counter()
+	          << " rechecked=" << checker.get_speculative_rechecked_counter() << std::endl;
+}
+
+}  // namespace
+
+void benchmark_ring_checker(size_t block_count, size_t transactions_per_block, size_t ring_size) {
+	Currency currency("test");
+	MemoryState state;
+	std::vector<KeyPair> output_keys;
+	for (size_t i = 0; i != block_count * transactions_per_block + ring_size; ++i) {
+		output_keys.push_back(crypto::random_keypair());
+		state.push_amount_output(AMOUNT, 0, 0, output_keys.back().public_key, false);
+	}
+	std::vector<Block> blocks;
+	std::vector<Hash> bids;
+	size_t next_output = ring_size;
+	for (size_t b = 0; b != block_count; ++b) {
+		blocks.push_back(make_block(output_keys, transactions_per_block, ring_size, &next_output));
+		bids.push_back(crypto::rand<Hash>());
+	}
+	// Speculative results must never hide bad signature or be used after outputs changed
+	{
+		RingCheckerMulticore checker;
+		Block bad                                                  = blocks.at(0);
+		boost::get<RingSignatures>(bad.transactions.at(0).signatures).signatures.at(0).at(0).c.data[0] ^= 1;
+		checker.start_speculative_work(&state, currency, bids.at(0), bad, false, 4);
+		checker.start_work(&state, currency, bids.at(0), bad, 0, 0, 0, false);
+		invariant(checker.move_errors().size() == 1, "Bad signature not detected after speculation");
+
+		const size_t reused = checker.get_speculative_reused_counter();
+		MemoryState changed = state;
+		checker.start_speculative_work(&state, currency, bids.at(1), blocks.at(1), false, 4);
+		for (auto &&unp : changed.outputs[AMOUNT])
+			unp.public_key = crypto::random_keypair().public_key;
+		checker.start_work(&changed, currency, bids.at(1), blocks.at(1), 0, 0, 0, false);
+		invariant(checker.move_errors().size() == blocks.at(1).transactions.size(),
+		    "Speculative result reused after outputs changed");
+		invariant(checker.get_speculative_reused_counter() == reused, "");
+	}
+	const std::chrono::microseconds apply_duration(2000);
+	std::cout << "Ring checker, " << block_count << " blocks of " << transactions_per_block
+	          << " transactions, ring size " << ring_size << ", " << apply_duration.count()
+	          << " us of main thread work per block" << std::endl;
+	run("  one block at a time", currency, state, blocks, bids, 0, apply_duration);
+	run("  pipelined (16 blocks)", currency, state, blocks, bids, 16, apply_duration);
+}
@@ -0,0 +1,173 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "Core/BlockChainState.hpp"
+#include "Core/Config.hpp"
+#include "Core/Currency.hpp"
+#include "Core/Node.hpp"
+#include "common/Invariant.hpp"
+#include "http/Agent.hpp"
+#include "logging/ConsoleLogger.hpp"
+#include "platform/Network.hpp"
+#include "platform/PathTools.hpp"
+
+using namespace cn;
+
+namespace {
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+// Sends the same request again as soon as response arrives, remembers latencies
+struct RPCClient {
+	http::Agent agent;
+	const http::RequestBody request;
+	size_t requests_left;
+	size_t *errors;
+	std::unique_ptr<http::Request> current;
+	TimePoint sent;
+	std::vector<double> latencies_ms;
+
+	RPCClient(uint16_t port, http::RequestBody &&request, size_t request_count, size_t *errors)
+	    : agent("127.0.0.1", port), request(std::move(request)), requests_left(request_count), errors(errors) {}
+	void send() {
+		if (requests_left == 0)
+			return;
+		requests_left -= 1;
+		sent    = std::chrono::steady_clock::now();
+		current = std::make_unique<http::Request>(agent, http::RequestBody(request),
+		    [this](http::ResponseBody &&response) {
+			    current.reset();
+			    const auto now = std::chrono::steady_clock::now();
+			    latencies_ms.push_back(std::chrono::duration<double, std::milli>(now - sent).count());
+			    if (response.r.status != 200 || response.body.find("\"error\"") != std::string::npos)
+				    *errors += 1;
+			    send();
+		    },
+		    [this](std::string) {
+			    current.reset();
+			    *errors += 1;
+			    requests_left = 0;
+		    });
+	}
+	bool finished() const { return requests_left == 0 && !current; }
+};
+
+}  // anonymous namespace
+
+double percentile(std::vector<double> values, double p) {
+	if (values.empty())
+		return 0;
+	std::sort(values.begin(), values.end());
+	return values.at(std::min(values.size() - 1, static_cast<size_t>(p * values.size())));
+}
+
+uint16_t find_free_port(uint16_t from, uint16_t to) {
+	for (uint16_t p = from; p != to; ++p)
+		try {
+			platform::TCPAcceptor acceptor("127.0.0.1", p, []() {});
+			return p;
+		} catch (const platform::TCPAcceptor::AddressInUse &) {
+		}
+	invariant(false, "No free port for benchmark");
+	return 0;
+}
+
+// Heavy clients ask for whole chain with sync_blocks, light client asks get_status which is always answered by main
+// thread, so its latency shows how long main thread (and P2P processing) is blocked by heavy requests.
+void benchmark_rpc_workers(
+    common::CommandLine &cmd, size_t block_count, size_t heavy_client_count, size_t heavy_requests_per_client) {
+	platform::EventLoop run_loop;
+	logging::ConsoleLogger logger(logging::ERROR);
+	Config config(cmd);
+	config.data_folder               = "../tests/scratchpad";
+	config.net                       = "test";
+	config.multicast_address         = std::string();
+	config.exclusive_nodes           = true;
+	config.rpc_sync_blocks_max_count = block_count;
+	config.p2p_bind_ip               = "127.0.0.1";
+	config.p2p_bind_port             = find_free_port(18600, 18700);
+	config.bytecoind_bind_ip         = "127.0.0.1";
+	config.bytecoind_bind_port       = find_free_port(config.p2p_bind_port + 1, 18800);
+	config.seed_nodes.clear();
+	config.priority_nodes.clear();
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	{
+		Currency currency(config.net);
+		BlockChainState block_chain(logger, config, currency, false);
+		benchmark_grow_chain(block_chain, currency, block_count);
+		block_chain.db_commit();
+
+		api::cnd::SyncBlocks::Request sync_req;
+		sync_req.sparse_chain.push_back(currency.genesis_block_hash);
+		sync_req.max_count           = block_count;
+		sync_req.need_redundant_data = true;
+		const auto sync_request = json_rpc::create_request(api::cnd::url(), api::cnd::SyncBlocks::method(), sync_req);
+		const auto status_request =
+		    json_rpc::create_request(api::cnd::url(), api::cnd::GetStatus::method(), api::cnd::GetStatus::Request{});
+
+		for (size_t worker_threads : {size_t(0), heavy_client_count}) {
+			config.rpc_worker_threads = worker_threads;
+			Node node(logger, config, block_chain);
+			size_t errors = 0;
+			std::vector<std::unique_ptr<RPCClient>> heavy;
+			for (size_t i = 0; i != heavy_client_count; ++i)
+				heavy.push_back(std::make_unique<RPCClient>(config.bytecoind_bind_port, http::RequestBody(sync_request),
+				    heavy_requests_per_client, &errors));
+			RPCClient light(config.bytecoind_bind_port, http::RequestBody(status_request),
+			    std::numeric_limits<size_t>::max(), &errors);
+			const auto idea_start = std::chrono::steady_clock::now();
+			for (auto &&cl : heavy)
+				cl->send();
+			light.send();
+			platform::Timer watchdog([&]() {
+				std::cout << "benchmark_rpc_workers watchdog fired" << std::endl;
+				run_loop.cancel();
+			});
+			watchdog.once(600);
+			auto all_finished = [&]() {
+				for (auto &&cl : heavy)
+					if (!cl->finished())
+						return false;
+				return true;
+			};
+			while (!all_finished() && !run_loop.stopped() && errors == 0) {
+				if (node.on_idle())
+					run_loop.poll();
+				else
+					run_loop.run_one();
+			}
+			light.requests_left = 0;
+			while (!light.finished() && !run_loop.stopped() && errors == 0)
+				if (node.on_idle())
+					run_loop.poll();
+				else
+					run_loop.run_one();
+			watchdog.cancel();
+			const auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			    std::chrono::steady_clock::now() - idea_start);
+			invariant(errors == 0 && !run_loop.stopped(), "benchmark_rpc_workers requests failed");
+
+			std::vector<double> heavy_latencies;
+			for (auto &&cl : heavy)
+				heavy_latencies.insert(heavy_latencies.end(), cl->latencies_ms.begin(), cl->latencies_ms.end());
+			std::cout << "rpc_worker_threads=" << worker_threads << " blocks=" << block_count
+			          << " heavy clients=" << heavy_client_count << " total ms=" << total_ms.count()
+			          << " sync_blocks p50/p99 ms=" << percentile(heavy_latencies, 0.5) << "/"
+			          << percentile(heavy_latencies, 0.99) << " get_status count=" << light.latencies_ms.size()
+			          << " p50/p99 ms=" << percentile(light.latencies_ms, 0.5) << "/"
+			          << percentile(light.latencies_ms, 0.99) << std::endl;
+		}
+	}
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	BlockChain::DB::delete_db(config.data_folder + "/peer_db");
+	platform::remove_file(config.data_folder + "/keyimage_filter.bin");
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <chrono>
+#include <iostream>
+#include "Core/BlockChainState.hpp"
+#include "Core/Config.hpp"
+#include "Core/CryptoNoteTools.hpp"
+#include "Core/Currency.hpp"
+#include "Core/Difficulty.hpp"
+#include "Core/Node.hpp"
+#include "Core/TransactionExtra.hpp"
+#include "common/Invariant.hpp"
+#include "common/Varint.hpp"
+#include "crypto/crypto.hpp"
+#include "logging/ConsoleLogger.hpp"
+#include "seria/BinaryOutputStream.hpp"
+
+using namespace cn;
+
+common::BinaryArray benchmark_mine_block(BlockChainState &block_chain, const Currency &currency) {
+	AccountAddress address;
+	invariant(currency.parse_account_address_string("21mQ7KPdmLbjfpg3Coayi4hZzAEgjeL87QXGeDTHahKeJsvKHc6DoprAJmqU"
+	                                                "cLhWTUXtxCL6rQFSwEUe6NZdEoqZNpSq1iC",
+	              &address),
+	    "");
+	return benchmark_mine_block(block_chain, currency, address);
+}
+
+common::BinaryArray benchmark_mine_block(
+    BlockChainState &block_chain, const Currency &currency, const AccountAddress &address) {
+	crypto::CryptoNightContext context;
+	BlockTemplate block;
+	Difficulty difficulty      = 0;
+	Height height              = 0;
+	size_t reserve_back_offset = 0;
+	block_chain.create_mining_block_template(
+	    block_chain.get_tip_bid(), address, BinaryArray{}, &block, &difficulty, &height, &reserve_back_offset);
+	set_root_extra_to_solo_mining_tag(block);
+	block.root_block.timestamp = block_chain.get_tip().timestamp + currency.difficulty_target;
+	block.timestamp            = block.root_block.timestamp;
+	auto body_proxy            = get_body_proxy_from_template(block);
+	for (uint32_t nonce = crypto::rand<uint32_t>();; ++nonce) {
+		common::uint_le_to_bytes(block.root_block.nonce, 4, nonce);
+		BinaryArray ba = currency.get_block_long_hashing_data(block, body_proxy);
+		if (check_hash(context.cn_slow_hash(ba.data(), ba.size()), difficulty))
+			break;
+	}
+	return seria::to_binary(block);
+}
+
+void benchmark_grow_chain(BlockChainState &block_chain, const Currency &currency, size_t block_count) {
+	while (block_chain.get_tip_height() + 1 < block_count) {
+		RawBlock rb;
+		api::BlockHeader info;
+		invariant(block_chain.add_mined_block(benchmark_mine_block(block_chain, currency), &rb, &info), "");
+	}
+}
+
+void benchmark_sync_blocks(common::CommandLine &cmd, size_t max_count) {
+	logging::ConsoleLogger logger(logging::ERROR);
+	Config config(cmd);
+	config.data_folder = "../tests/scratchpad";
+	config.net         = "test";
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	{
+		Currency currency(config.net);
+		BlockChainState block_chain(logger, config, currency, false);
+		benchmark_grow_chain(block_chain, currency, max_count);
+		std::vector<Hash> subchain;
+		for (Height ha = 0; ha != max_count; ++ha) {
+			subchain.push_back(Hash{});
+			invariant(block_chain.get_chain(ha, &subchain.back()), "");
+		}
+		for (bool need_redundant_data : {false, true}) {
+			const size_t iterations = 10;
+			std::string slow_result;
+			auto idea_start = std::chrono::high_resolution_clock::now();
+			for (size_t it = 0; it != iterations; ++it) {
+				std::vector<api::RawBlock> blocks(subchain.size());
+				for (size_t i = 0; i != subchain.size(); ++i)
+					Node::fill_sync_block(
+					    block_chain, subchain[i], static_cast<Height>(i), need_redundant_data, false, &blocks[i]);
+				slow_result.clear();
+				common::StringOutputStream str(slow_result);
+				seria::BinaryOutputStream ba(str);
+				ser(blocks, ba);
+			}
+			auto slow_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			    std::chrono::high_resolution_clock::now() - idea_start);
+			std::string fast_result;
+			idea_start = std::chrono::high_resolution_clock::now();
+			for (size_t it = 0; it != iterations; ++it) {
+				fast_result.clear();
+				common::StringOutputStream str(fast_result);
+				str.write_varint(subchain.size());
+				for (size_t i = 0; i != subchain.size(); ++i)
+					Node::write_sync_block(block_chain, subchain[i], static_cast<Height>(i), need_redundant_data, str);
+			}
+			auto fast_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			    std::chrono::high_resolution_clock::now() - idea_start);
+			invariant(slow_result == fast_result, "write_sync_block result differs from fill_sync_block");
+			std::cout << "max_count=" << max_count << " need_redundant_data=" << need_redundant_data
+			          << " response_bytes=" << fast_result.size() << " parsed ms=" << slow_ms.count() / iterations
+			          << " streamed ms=" << fast_ms.count() / iterations << std::endl;
+		}
+	}
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "Core/Config.hpp"
+#include "Core/Currency.hpp"
+#include "Core/WalletStateBasic.hpp"
+#include "common/Invariant.hpp"
+#include "crypto/crypto.hpp"
+#include "logging/ConsoleLogger.hpp"
+
+using namespace cn;
+
+namespace {
+
+class WalletCacheBenchmark : public WalletStateBasic {
+public:
+	explicit WalletCacheBenchmark(logging::ILogger &log, const Config &config, const Currency &currency)
+	    : WalletStateBasic(log, config, currency, "benchmark_wallet_cache", false) {}
+	void add_block(const std::vector<api::Output> &outputs) {
+		const Height height = get_tip_height() + 1;
+		for (const auto &output : outputs) {
+			api::Transaction ptx;
+			ptx.hash = crypto::rand<Hash>();
+			api::Transfer transfer;
+			transfer.amount  = output.amount;
+			transfer.address = output.address;
+			transfer.ours    = true;
+			transfer.outputs.push_back(output);
+			ptx.transfers.push_back(transfer);
+			invariant(add_incoming_output(output, ptx.hash) == output.amount, "");
+			add_transaction(height, ptx.hash, TransactionPrefix{}, ptx);
+		}
+		api::BlockHeader header;
+		header.height = height;
+		header.hash   = crypto::rand<Hash>();
+		push_chain(header);
+	}
+	void get_db_size(size_t *items, size_t *key_bytes, size_t *value_bytes) const {
+		*items = *key_bytes = *value_bytes = 0;
+		for (DB::Cursor cur = m_db.begin(std::string()); !cur.end(); cur.next()) {
+			*items += 1;
+			*key_bytes += cur.get_suffix().size();
+			*value_bytes += cur.get_value_array().size();
+		}
+	}
+};
+
+double elapsed_us(std::chrono::steady_clock::time_point start, size_t count) {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+	       std::max<size_t>(1, count);
+}
+
+}  // anonymous namespace
+
+// Exchange-like wallet, every address gets outputs_per_address incoming transfers, 100 per block. Prints total size
+// of wallet cache keys and values and latency of get_transfers and get_balance for random address.
+void benchmark_wallet_cache(common::CommandLine &cmd, size_t address_count, size_t outputs_per_address) {
+	logging::ConsoleLogger logger(logging::ERROR);
+	Currency currency("main");
+	Config config(cmd);
+	config.data_folder       = "../tests/scratchpad";
+	const std::string folder = config.get_data_folder("wallet_cache") + "/benchmark_wallet_cache";
+	std::vector<std::string> addresses;
+	for (size_t i = 0; i != address_count; ++i) {
+		AccountAddressSimple address;
+		address.spend_public_key = crypto::random_keypair().public_key;
+		address.view_public_key  = crypto::random_keypair().public_key;
+		addresses.push_back(currency.account_address_as_string(address));
+	}
+	BlockChain::DB::delete_db(folder);
+	{
+		WalletCacheBenchmark ws(logger, config, currency);
+		const size_t outputs_per_block = 100;
+		size_t global_index            = 0;
+		auto idea_start                = std::chrono::steady_clock::now();
+		std::vector<api::Output> outputs;
+		for (size_t r = 0; r != outputs_per_address; ++r)
+			for (const auto &address : addresses) {
+				api::Output output;
+				output.amount    = 1000000;
+				output.index     = global_index++;
+				output.height    = ws.get_tip_height() + 1;
+				output.address   = address;
+				output.key_image = crypto::rand<KeyImage>();
+				outputs.push_back(output);
+				if (outputs.size() == outputs_per_block) {
+					ws.add_block(outputs);
+					outputs.clear();
+				}
+			}
+		if (!outputs.empty())
+			ws.add_block(outputs);
+		ws.db_commit();
+		const double add_us = elapsed_us(idea_start, address_count * outputs_per_address);
+
+		size_t items = 0, key_bytes = 0, value_bytes = 0;
+		ws.get_db_size(&items, &key_bytes, &value_bytes);
+
+		const size_t query_count = std::min<size_t>(10000, address_count);
+		std::vector<std::string> queried;
+		for (size_t i = 0; i != query_count; ++i)
+			queried.push_back(addresses.at(crypto::rand<size_t>() % addresses.size()));
+		idea_start = std::chrono::steady_clock::now();
+		for (const auto &address : queried) {
+			Height from_height = 0;
+			Height to_height   = ws.get_tip_height() + 1;
+			const auto blocks  = ws.api_get_transfers(address, &from_height, &to_height, true);
+			size_t found       = 0;
+			for (const auto &block : blocks)
+				found += block.transactions.size();
+			invariant(found == outputs_per_address, "");
+		}
+		const double transfers_us = elapsed_us(idea_start, query_count);
+		idea_start                = std::chrono::steady_clock::now();
+		for (const auto &address : queried) {
+			const auto balance = ws.get_balance(address, ws.get_tip_height());
+			invariant(balance.spendable_outputs + balance.spendable_dust_outputs == outputs_per_address, "");
+		}
+		const double balance_us = elapsed_us(idea_start, query_count);
+		std::cout << "wallet_cache addresses=" << address_count << " outputs per address=" << outputs_per_address
+		          << " items=" << items << " key bytes=" << key_bytes << " value bytes=" << value_bytes
+		          << " add us/output=" << add_us << " get_transfers us=" << transfers_us
+		          << " get_balance us=" << balance_us << std::endl;
+	}
+	BlockChain::DB::delete_db(folder);
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "common/Invariant.hpp"
+#include "crypto/crypto.hpp"
+
+using namespace crypto;
+
+static void print_speed(const char *name, size_t output_count, std::chrono::high_resolution_clock::time_point start) {
+	auto idea_ms =
+	    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+	std::cout << name << " outputs/sec=" << output_count * 1000.0 / std::max<int64_t>(1, idea_ms.count())
+	          << std::endl;
+}
+
+void benchmark_wallet_scan(size_t transaction_count, size_t outputs_per_transaction) {
+	const KeyPair view_keypair = random_keypair();
+	std::vector<PublicKey> tx_public_keys(transaction_count);
+	std::vector<Hash> tx_inputs_hashes(transaction_count);
+	std::vector<OutputScanItem> items;
+	for (size_t i = 0; i != transaction_count; ++i) {
+		tx_public_keys[i]   = random_keypair().public_key;
+		tx_inputs_hashes[i] = rand<Hash>();
+		for (size_t out_index = 0; out_index != outputs_per_transaction; ++out_index) {
+			OutputScanItem item;
+			item.tx_number               = i;
+			item.output_index            = out_index;
+			item.output_public_key       = random_keypair().public_key;
+			item.encrypted_output_secret = random_keypair().public_key;
+			items.push_back(item);
+		}
+	}
+	// Linkable (legacy) wallet - derivation per transaction, then underive per output
+	auto idea_start = std::chrono::high_resolution_clock::now();
+	std::vector<KeyDerivation> single_derivations(transaction_count);
+	std::vector<PublicKey> single_keys(items.size());
+	for (size_t i = 0; i != transaction_count; ++i)
+		single_derivations[i] = generate_key_derivation(tx_public_keys[i], view_keypair.secret_key);
+	for (size_t k = 0; k != items.size(); ++k)
+		single_keys[k] = underive_public_key(
+		    single_derivations[items[k].tx_number], items[k].output_index, items[k].output_public_key);
+	print_speed("linkable single", items.size(), idea_start);
+
+	idea_start = std::chrono::high_resolution_clock::now();
+	std::vector<KeyDerivation> derivations(transaction_count);
+	std::vector<PublicKey> keys(items.size());
+	generate_key_derivations_batch(
+	    view_keypair.secret_key, tx_public_keys.data(), transaction_count, derivations.data());
+	underive_public_keys_batch(derivations.data(), items.data(), items.size(), keys.data());
+	print_speed("linkable batch", items.size(), idea_start);
+	invariant(derivations == single_derivations && keys == single_keys, "Batch scan differs from single");
+
+	// Unlinkable (HD) wallet - everything is per output
+	idea_start = std::chrono::high_resolution_clock::now();
+	std::vector<SecretKey> single_scalars(items.size());
+	for (size_t k = 0; k != items.size(); ++k)
+		single_keys[k] = unlinkable_underive_public_key(view_keypair.secret_key, tx_inputs_hashes[items[k].tx_number],
+		    items[k].output_index, items[k].output_public_key, items[k].encrypted_output_secret, &single_scalars[k]);
+	print_speed("unlinkable single", items.size(), idea_start);
+
+	idea_start = std::chrono::high_resolution_clock::now();
+	std::vector<SecretKey> scalars(items.size());
+	unlinkable_underive_public_keys_batch(
+	    view_keypair.secret_key, tx_inputs_hashes.data(), items.data(), items.size(), keys.data(), scalars.data());
+	print_speed("unlinkable batch", items.size(), idea_start);
+	invariant(keys == single_keys && scalars == single_scalars, "Batch scan differs from single");
+}
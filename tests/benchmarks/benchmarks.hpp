@@ -0,0 +1,64 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CryptoNote.hpp"
+#include "common/BinaryArray.hpp"
+#include "common/CommandLine.hpp"
+
+namespace cn {
+class BlockChainState;
+class Currency;
+}  // namespace cn
+
+// Benchmarks print results to stdout and check correctness with invariant()
+// They are run with "tests --benchmarks" and are not part of ordinary test run
+
+// Value below which fraction p of values lie (0.5 for median), 0 for no values
+double percentile(std::vector<double> values, double p);
+// First port in [from, to) we can listen on at 127.0.0.1, for benchmarks running nodes over loopback
+uint16_t find_free_port(uint16_t from, uint16_t to);
+
+void benchmark_ring_checker(size_t block_count, size_t transactions_per_block, size_t ring_size);
+void benchmark_cryptonight(size_t hash_count);
+void benchmark_wallet_scan(size_t transaction_count, size_t outputs_per_transaction);
+// Compares fully parsed and streamed sync_blocks responses, they must be byte-identical
+void benchmark_sync_blocks(common::CommandLine &cmd, size_t max_count);
+// Mines blocks with solo mining tag until chain has block_count blocks, test net difficulty keeps it fast
+void benchmark_grow_chain(cn::BlockChainState &block_chain, const cn::Currency &currency, size_t block_count);
+// Mines block on top of chain without adding it, returns block template for submit_block or add_mined_block
+common::BinaryArray benchmark_mine_block(cn::BlockChainState &block_chain, const cn::Currency &currency);
+common::BinaryArray benchmark_mine_block(
+    cn::BlockChainState &block_chain, const cn::Currency &currency, const cn::AccountAddress &address);
+// Replays synthetic transactions through TransactionPool indices, byte budget and eviction
+void benchmark_mempool(size_t transaction_count, size_t max_pool_size);
+// Echo round trips over many loopback connections, measures run loop overhead of selected backend
+void benchmark_connections(size_t connection_count, size_t round_trips, size_t message_size);
+// Relays large messages to many P2P peers, prints CPU and peak RSS growth for shared and per-peer copied buffers
+void benchmark_relay(size_t peer_count, size_t message_count, size_t message_size);
+// Heavy sync_blocks clients and light get_status client against Node over loopback, with and without RPC workers
+void benchmark_rpc_workers(
+    common::CommandLine &cmd, size_t block_count, size_t heavy_client_count, size_t heavy_requests_per_client);
+// Writes and reads large walletd get_transfers response via JsonValue and with streaming text reader and writer
+void benchmark_json(size_t block_count, size_t transactions_per_block, size_t iterations);
+// Hex encoding and decoding throughput of StringTools against byte by byte loops, chunk_size 32 is like Hash
+void benchmark_hex(size_t chunk_size, size_t total_size);
+// Exports grown chain to blocks file and imports it into empty DB with LegacyBlockChainReader
+void benchmark_import(common::CommandLine &cmd, size_t block_count);
+// Imports the same chain into uncompressed and compressed blockchain DB, compares size, import speed and read latency
+void benchmark_block_storage(common::CommandLine &cmd, size_t block_count, size_t read_count);
+// Decodes P2P messages from KV binary directly and via JsonValue, block_count blocks of 10 transactions
+void benchmark_kv_binary(size_t block_count, size_t peer_count, size_t iterations);
+// Many threads log to file directly and via AsyncLogWriter, prints time spent in logging threads and until written
+void benchmark_logging(size_t thread_count, size_t messages_per_thread);
+// Syncs chain from several seed nodes behind delaying proxies, with per-block GetObjects and with block ranges
+void benchmark_block_download(common::CommandLine &cmd, size_t block_count, size_t peer_count, float round_trip);
+// Fills wallet cache for many addresses, prints size of index keys and get_transfers, get_balance latency
+void benchmark_wallet_cache(common::CommandLine &cmd, size_t address_count, size_t outputs_per_address);
+// Relays blocks along a line of nodes with header and compact block relay, then compares message size for big block
+void benchmark_block_relay(common::CommandLine &cmd, size_t node_count, size_t block_count, size_t transaction_count);
@@ -4,14 +4,27 @@
 
 #include "test_blockchain.hpp"
 
+#include <algorithm>
+#include <deque>
 #include <fstream>
 #include <vector>
+#include "Core/AmountOutputIndex.hpp"
+#include "Core/BlockCodec.hpp"
 #include "Core/BlockChainState.hpp"
+#include "Core/CompactBlock.hpp"
 #include "Core/Config.hpp"
 #include "Core/CryptoNoteTools.hpp"
 #include "Core/Currency.hpp"
 #include "Core/Difficulty.hpp"
+#include "Core/DownloadWindow.hpp"
+#include "Core/HeaderCache.hpp"
+#include "Core/KeyImageFilter.hpp"
+#include "Core/SyncBlocksCache.hpp"
+#include "Core/TransactionBuilder.hpp"
 #include "Core/TransactionExtra.hpp"
+#include "Core/TransactionPool.hpp"
+#include "common/Math.hpp"
+#include "common/SlidingMedian.hpp"
 #include "common/Varint.hpp"
 #include "crypto/crypto.hpp"
 #include "logging/ConsoleLogger.hpp"
@@ -118,12 +131,604 @@ public:
 	}
 };
 
+static void test_keyimage_filter() {
+	const size_t COUNT = 300000;  // More than minimal capacity, so insert must eventually fail
+	std::vector<KeyImage> key_images(COUNT);
+	for (auto &ki : key_images)
+		ki = crypto::rand<KeyImage>();
+	KeyImageFilter filter;
+	size_t inserted = 0;
+	while (inserted != COUNT && filter.insert(key_images.at(inserted)))
+		inserted += 1;
+	invariant(inserted > filter.capacity() * 9 / 10, "Cuckoo filter must reach 90% load");
+	filter = KeyImageFilter(COUNT);
+	for (const auto &ki : key_images)
+		invariant(filter.insert(ki), "");
+	for (size_t i = 0; i != COUNT; i += 2)
+		filter.erase(key_images.at(i));
+	invariant(filter.size() == COUNT / 2, "");
+	for (size_t i = 1; i < COUNT; i += 2)
+		invariant(filter.may_contain(key_images.at(i)), "Cuckoo filter must have no false negatives");
+	const Hash tip_bid = crypto::rand<Hash>();
+	KeyImageFilter loaded;
+	Hash loaded_bid;
+	BinaryArray snapshot = filter.save(tip_bid);
+	invariant(loaded.load(snapshot, &loaded_bid) && loaded_bid == tip_bid, "");
+	snapshot.pop_back();
+	invariant(!loaded.load(snapshot, &loaded_bid), "Truncated snapshot must not be loaded");
+	size_t false_positives = 0;
+	for (size_t i = 0; i < COUNT; i += 2) {
+		invariant(loaded.may_contain(key_images.at(i)) == filter.may_contain(key_images.at(i)), "");
+		if (loaded.may_contain(key_images.at(i)))
+			false_positives += 1;
+	}
+	// Expected rate at 15% load is 8 * 0.15 / 65536, about 0.002%
+	invariant(false_positives < COUNT / 2 / 1000, "Cuckoo filter false positive rate too high");
+}
+
+static void test_header_cache() {
+	HeaderCache cache(1024 * 1024);
+	const size_t COUNT = cache.capacity() * 3;
+	std::vector<Hash> bids(COUNT);
+	for (size_t i = 0; i != COUNT; ++i) {
+		bids[i] = crypto::rand<Hash>();
+		api::BlockHeader header;
+		header.hash   = bids[i];
+		header.height = static_cast<Height>(i);
+		const api::BlockHeader *inserted = cache.insert(bids[i], std::move(header));
+		invariant(inserted && inserted->height == i, "");
+		if (i >= 1000)  // Keep first 1000 hot, they must survive eviction
+			for (size_t j = 0; j != 1000; ++j)
+				invariant(cache.find(bids[j]) && cache.find(bids[j])->hash == bids[j], "Hot header evicted");
+		invariant(cache.size() <= cache.capacity(), "");
+	}
+	invariant(cache.size() > cache.capacity() * 9 / 10, "Header cache must stay full, not be flushed");
+	invariant(cache.get_evictions() == COUNT - cache.size(), "");
+	invariant(cache.memory_usage() <= 1024 * 1024, "");
+	cache.erase(bids[0]);
+	invariant(!cache.find(bids[0]), "");
+	size_t found = 0;
+	for (size_t i = 0; i != COUNT; ++i)
+		if (const api::BlockHeader *header = cache.find(bids[i])) {
+			invariant(header->hash == bids[i] && header->height == i, "");
+			found += 1;
+		}
+	invariant(found == cache.size(), "");
+}
+
+static void test_sync_blocks_cache() {
+	SyncBlocksCache cache(1024 * 1024);
+	const Hash bid = crypto::rand<Hash>();
+	std::vector<SyncBlocksCache::Key> keys;
+	for (Height start = 0; start != 100; start += 10)
+		for (bool need_redundant_data : {false, true}) {
+			keys.push_back(SyncBlocksCache::Key{start, 10, need_redundant_data, false});
+			cache.insert(keys.back(), bid, std::string(1000, char(start)));
+		}
+	invariant(cache.size() == keys.size(), "");
+	for (auto &&key : keys) {
+		const std::string *chunk = cache.find(key, bid);
+		invariant(chunk && chunk->size() == 1000 && chunk->front() == char(key.start_height), "");
+	}
+	invariant(!cache.find(keys.front(), Hash{}), "Chunk must not be returned for different last block");
+	invariant(!cache.find(SyncBlocksCache::Key{0, 11, false, false}, bid), "");
+	invariant(cache.get_bytes_served() == 1000 * keys.size(), "");
+
+	cache.invalidate(55);  // chunk [50..60) contains height 55, chunks above are gone too
+	for (auto &&key : keys)
+		invariant((cache.find(key, bid) != nullptr) == (key.start_height < 50), "");
+	invariant(cache.get_invalidations() == 10, "");
+
+	for (Height start = 1000; start != 3000; start += 10)  // LRU evicts within budget
+		cache.insert(SyncBlocksCache::Key{start, 10, false, false}, bid, std::string(10000, 0));
+	invariant(cache.memory_usage() <= 1024 * 1024 && cache.get_evictions() != 0, "");
+	invariant(cache.find(SyncBlocksCache::Key{2990, 10, false, false}, bid), "Most recent chunk evicted");
+	invariant(!cache.find(keys.front(), bid), "Oldest chunk must be evicted");
+	cache.insert(SyncBlocksCache::Key{0, 10, false, false}, bid, std::string(2 * 1024 * 1024, 0));
+	invariant(!cache.find(SyncBlocksCache::Key{0, 10, false, false}, bid), "Chunk over budget must not be cached");
+}
+
+static void test_block_codec(const Config &config) {
+	BinaryArray sample;
+	for (size_t i = 0; i != 200; ++i) {  // structure repeats, keys do not
+		const auto key = crypto::rand<Hash>();
+		sample.insert(sample.end(), {2, 1, 0, 1, 0x80, 0xc2, 0xd7, 0x2f, 2, 0x21, 1});
+		sample.insert(sample.end(), std::begin(key.data), std::end(key.data));
+	}
+	const common::LZDictionary no_dictionary(BinaryArray{});
+	const common::LZDictionary dictionary(common::LZDictionary::train({sample, sample}, 1024));
+	for (auto dict : {&no_dictionary, &dictionary}) {
+		for (size_t size : {0, 1, 5, 100, 5000}) {
+			const BinaryArray data(sample.begin(), sample.begin() + std::min(size, sample.size()));
+			const BinaryArray compressed = common::lz_compress(data.data(), data.size(), *dict);
+			invariant(common::lz_decompress(compressed.data(), compressed.size(), *dict) == data, "");
+			for (size_t cut = 0; cut < compressed.size(); cut += 7) {  // must throw, not crash
+				try {
+					common::lz_decompress(compressed.data(), cut, *dict);
+					invariant(false, "Truncated data must not decompress");
+				} catch (const std::runtime_error &) {
+				}
+			}
+		}
+	}
+	const BinaryArray zeroes(100000, 0);
+	invariant(common::lz_compress(zeroes.data(), zeroes.size(), no_dictionary).size() < 1000, "");
+	common::LZCompressor compressor(dictionary);  // hash table must be restored after each block
+	for (const auto &data : {sample, zeroes, sample})
+		invariant(compressor.compress(data.data(), data.size()) ==
+		              common::lz_compress(data.data(), data.size(), dictionary),
+		    "");
+
+	BlockCodec codec(config);
+	const Hash random_hash = crypto::rand<Hash>();
+	const BinaryArray random(std::begin(random_hash.data), std::end(random_hash.data));
+	invariant(codec.encode(sample).at(0) == BlockCodec::RAW, "No compression before first dictionary");
+	while (!codec.add_sample(sample)) {
+	}
+	BinaryArray dictionary_data;
+	const size_t id = codec.train(&dictionary_data);
+	invariant(id == 1 && !dictionary_data.empty(), "");
+	const BinaryArray encoded = codec.encode(sample);
+	invariant(encoded.at(0) == id && encoded.size() < sample.size() / 2, "");
+	const Hash bid = crypto::rand<Hash>();
+	invariant(*codec.decode(bid, encoded.data(), encoded.size()) == sample && codec.get_misses() == 1, "");
+	invariant(*codec.decode(bid, encoded.data(), encoded.size()) == sample && codec.get_hits() == 1, "");
+	invariant(codec.encode(random).at(0) == BlockCodec::RAW, "Incompressible block must be stored as is");
+	BinaryArray unknown = encoded;
+	unknown.at(0)       = id + 1;
+	try {
+		codec.decode(crypto::rand<Hash>(), unknown.data(), unknown.size());
+		invariant(false, "Unknown dictionary must not decode");
+	} catch (const std::runtime_error &) {
+	}
+	const size_t large_id = 300;  // does not fit into single byte
+	codec.add_dictionary(large_id, BinaryArray(dictionary_data));
+	const BinaryArray encoded_large = codec.encode(sample);
+	invariant(encoded_large.size() < sample.size() / 2 &&
+	              BinaryArray(encoded_large.begin(), encoded_large.begin() + 2) == common::get_varint_data(large_id),
+	    "");
+	invariant(*codec.decode(crypto::rand<Hash>(), encoded_large.data(), encoded_large.size()) == sample, "");
+}
+
+static void test_sliding_median() {
+	common::SlidingMedian<uint32_t> window;
+	std::deque<std::pair<uint32_t, bool>> model;
+	for (size_t i = 0; i != 20000; ++i) {
+		const size_t action = crypto::rand<size_t>() % 4;
+		if (action < 2 || model.empty()) {  // Small range for many duplicates, large values check overflow
+			const uint32_t value = crypto::rand<uint32_t>() % 3 == 0 ? crypto::rand<uint32_t>()
+			                                                         : crypto::rand<uint32_t>() % 16;
+			const bool counted = crypto::rand<uint32_t>() % 4 != 0;
+			if (action == 0) {
+				window.push_back(value, counted);
+				model.emplace_back(value, counted);
+			} else {
+				window.push_front(value, counted);
+				model.emplace_front(value, counted);
+			}
+		} else if (action == 2) {
+			window.pop_back();
+			model.pop_back();
+		} else {
+			window.pop_front();
+			model.pop_front();
+		}
+		std::vector<uint32_t> values;
+		for (const auto &mo : model)
+			if (mo.second)
+				values.push_back(mo.first);
+		invariant(window.size() == model.size() && window.counted_size() == values.size(), "");
+		invariant(window.median() == common::median_value(&values), "SlidingMedian differs from median_value");
+	}
+}
+
+static void test_transaction_pool() {
+	TransactionPool pool(10000);
+	std::vector<Hash> tids;
+	std::vector<KeyImage> key_images;
+	for (size_t i = 0; i != 10; ++i) {
+		PoolTransaction ptx;
+		ptx.binary_tx.resize(1000);
+		ptx.fee = 1000 * (10 - i);  // fee per byte 10, 9, ... 1
+		ptx.key_images.push_back(crypto::rand<KeyImage>());
+		ptx.key_images.push_back(crypto::rand<KeyImage>());
+		key_images.push_back(ptx.key_images.front());
+		tids.push_back(crypto::rand<Hash>());
+		invariant(pool.insert(tids.back(), std::move(ptx)), "");
+	}
+	invariant(pool.size() == 10 && pool.total_size() == 10000, "");
+	Hash minimal_tid;
+	invariant(pool.minimum_fee_per_byte(true, &minimal_tid) == 1 && minimal_tid == tids.back(), "");
+	PoolTransaction conflicting;
+	conflicting.binary_tx.resize(100);
+	conflicting.key_images.push_back(key_images.at(3));
+	invariant(!pool.insert(crypto::rand<Hash>(), std::move(conflicting)), "Key image conflict must be rejected");
+	invariant(!pool.insert(tids.front(), PoolTransaction{}), "Duplicate must be rejected");
+	Hash tid;
+	invariant(pool.find_keyimage(key_images.at(3), &tid) && tid == tids.at(3), "");
+	invariant(pool.erase(tids.at(3)) && !pool.erase(tids.at(3)), "");
+	invariant(!pool.find_keyimage(key_images.at(3), &tid) && pool.find(tids.at(3)) == pool.end(), "");
+	invariant(pool.minimum_fee_per_byte(true, &minimal_tid) == 0, "Not full pool must accept any fee");
+	Amount previous_fee_per_byte = 0;
+	for (const auto &fi : pool.get_fee_index()) {
+		invariant(fi.first > previous_fee_per_byte && pool.at(fi.second).fee_per_byte() == fi.first, "");
+		previous_fee_per_byte = fi.first;
+	}
+	const auto sorted = pool.get_sorted_by_hash();
+	invariant(sorted.size() == pool.size(), "");
+	for (size_t i = 1; i < sorted.size(); ++i)
+		invariant(sorted.at(i - 1)->first < sorted.at(i)->first, "Pool must be listed in hash order");
+	for (const auto &t : tids)
+		pool.erase(t);
+	invariant(pool.empty() && pool.total_size() == 0 && pool.memory_usage() == 0, "");
+}
+
+static void test_amount_output_index(const std::string &db_path) {
+	platform::DB::delete_db(db_path);
+	platform::DB db(platform::O_OPEN_ALWAYS, db_path);
+	AmountOutputIndex index(db);
+	const size_t COUNT = AmountOutputIndex::PAGE_RECORDS * 3 + 5;
+	std::vector<AmountOutputIndex::Record> records(COUNT);
+	for (size_t i = 0; i != COUNT; ++i) {
+		records[i].public_key                = crypto::rand<PublicKey>();
+		records[i].height                    = static_cast<Height>(i * 7);
+		records[i].unlock_block_or_timestamp = (i % 3 == 0) ? 0 : 1500000000 + i;
+		records[i].auditable                 = i % 5 == 0;
+		invariant(index.push(100, records[i]) == i, "");
+		invariant(index.push(1000, records[i]) == i, "");
+	}
+	records[3].spent    = 1;
+	records[3].has_dins = true;
+	index.write(100, 3, records[3]);
+	index.write_dins(100, 3, std::vector<size_t>{5, 8});
+	AmountOutputIndex fresh(db);  // must find sizes in DB
+	invariant(fresh.size(100) == COUNT && fresh.size(1000) == COUNT && fresh.size(10) == 0, "");
+	for (size_t i = 0; i != COUNT; ++i) {
+		AmountOutputIndex::Record record;
+		invariant(fresh.read(100, i, &record), "");
+		invariant(record.public_key == records[i].public_key && record.height == records[i].height &&
+		              record.unlock_block_or_timestamp == records[i].unlock_block_or_timestamp &&
+		              record.auditable == records[i].auditable && record.spent == records[i].spent &&
+		              record.has_dins == records[i].has_dins,
+		    "");
+	}
+	std::vector<size_t> dins;
+	fresh.read_dins(100, 3, &dins);
+	invariant(dins == std::vector<size_t>({5, 8}), "");
+	AmountOutputIndex::Record record;
+	invariant(!fresh.read(100, COUNT, &record), "");
+	for (size_t i = COUNT; i-- > AmountOutputIndex::PAGE_RECORDS - 1;)
+		invariant(fresh.pop(1000).public_key == records[i].public_key, "");
+	invariant(AmountOutputIndex(db).size(1000) == AmountOutputIndex::PAGE_RECORDS - 1, "");
+	size_t amounts = 0;
+	fresh.for_each_amount([&](Amount amount, size_t count) {
+		invariant(count == fresh.size(amount), "");
+		amounts += 1;
+	});
+	invariant(amounts == 2, "");
+}
+
+static void test_compressed_block_storage(logging::ILogger &logger, Config config) {
+	config.compress_blocks                = true;
+	config.block_dictionary_training_size = 4096;
+	config.block_dictionary_retrain_every = 8192;
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	Currency currency(config.net);
+	std::vector<std::pair<Hash, BinaryArray>> blocks;
+	auto check_blocks = [&](const BlockChainState &block_chain) {
+		const BlockChainReader reader(block_chain);
+		for (auto &&bit : blocks) {
+			BinaryArray block_data;
+			RawBlock raw_block;
+			invariant(block_chain.get_block(bit.first, &block_data, &raw_block) && block_data == bit.second, "");
+			StoredBlockData stored;
+			invariant(reader.get_block_data(bit.first, &stored) &&
+			              BinaryArray(stored.data(), stored.data() + stored.size()) == bit.second,
+			    "");
+			BlockTemplate block_template;
+			seria::from_binary(block_template, raw_block.block);
+			const Hash tid = get_transaction_hash(block_template.base_transaction);
+			BinaryArray binary_tx;
+			Hash bid;
+			Height height         = 0;
+			size_t index_in_block = 0;
+			invariant(reader.get_transaction(tid, &binary_tx, &height, &bid, &index_in_block), "");
+			invariant(bid == bit.first && binary_tx == seria::to_binary(block_template.base_transaction), "");
+		}
+	};
+	{
+		BlockChainState block_chain(logger, config, currency, false);
+		TestMiner test_miner(block_chain, currency);
+		test_miner.test_grow_chain(block_chain.get_tip_bid(), 80);
+		block_chain.db_commit();
+		for (Height ha = 0; ha <= block_chain.get_tip_height(); ++ha) {
+			Hash bid;
+			BinaryArray block_data;
+			invariant(block_chain.get_chain(ha, &bid) && block_chain.get_block(bid, &block_data, nullptr), "");
+			blocks.emplace_back(bid, std::move(block_data));
+		}
+		check_blocks(block_chain);
+		api::cnd::GetStatistics::Response stats;
+		block_chain.fill_statistics(stats);
+		invariant(stats.block_dictionary_count >= 2 && stats.block_cache_misses != 0, "Blocks were not compressed");
+	}
+	config.compress_blocks = false;  // format is set when DB is created
+	{
+		BlockChainState block_chain(logger, config, currency, false);
+		check_blocks(block_chain);
+		api::cnd::GetStatistics::Response stats;
+		block_chain.fill_statistics(stats);
+		invariant(stats.block_dictionary_count >= 2, "Block dictionaries must be loaded from DB");
+	}
+	{  // Like after DB version bump, blocks are imported from inside DB and must still be decoded
+		BlockChain::DB db(platform::O_OPEN_EXISTING, config.data_folder + "/blockchain");
+		db.put("$version", std::string("6"), false);
+		db.commit_db_txn();
+	}
+	{
+		BlockChainState block_chain(logger, config, currency, false);
+		invariant(block_chain.internal_import_known_height() == blocks.size(), "");
+		while (block_chain.internal_import()) {
+		}
+		invariant(block_chain.get_tip_bid() == blocks.back().first, "Internal import of compressed blocks failed");
+		check_blocks(block_chain);
+	}
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+}
+
+// Peer answers requests in order over link with given speed and round trip, we keep window of blocks requested.
+// Returns part of link speed used
+static double simulate_download_window(DownloadWindow &window, double bytes_per_second, double round_trip,
+    size_t block_size, size_t response_count) {
+	struct Request {
+		size_t count;
+		size_t delivered_at_send;
+		double sent;
+		double arrives;
+	};
+	auto time_point = [](double seconds) {
+		return DownloadWindow::TimePoint(
+		    std::chrono::duration_cast<DownloadWindow::TimePoint::duration>(std::chrono::duration<double>(seconds)));
+	};
+	std::deque<Request> requests;
+	size_t in_flight = 0, received = 0;
+	double now = 0, link_free = 0;
+	for (size_t i = 0; i != response_count; ++i) {
+		while (in_flight < window.get_window()) {
+			const size_t count = std::min(window.get_batch(), window.get_window() - in_flight);
+			link_free = std::max(link_free, now + round_trip / 2) + count * block_size / bytes_per_second;
+			requests.push_back(Request{count, window.get_delivered(), now, link_free + round_trip / 2});
+			in_flight += count;
+		}
+		const Request request = requests.front();
+		requests.pop_front();
+		in_flight -= request.count;
+		received += request.count;
+		now = request.arrives;
+		window.on_response(request.count, request.count * block_size, request.delivered_at_send,
+		    time_point(request.sent), time_point(now));
+	}
+	return received * block_size / now / bytes_per_second;
+}
+
+static void test_download_window() {
+	for (double round_trip : {0.0, 0.01, 0.1, 0.3})
+		for (double bytes_per_second : {1e5, 1e6, 1e7})
+			for (size_t block_size : {1000, 20000}) {
+				DownloadWindow window(16, 1000, 100);
+				const double utilization =
+				    simulate_download_window(window, bytes_per_second, round_trip, block_size, 2000);
+				const double bdp_blocks = bytes_per_second * round_trip / block_size;
+				if (bdp_blocks * 3 < 1000)
+					invariant(utilization > 0.95, "DownloadWindow does not use link");
+				else
+					invariant(window.get_window() == 1000, "DownloadWindow must reach maximum on long fat link");
+				// Round trips of requests waiting behind others must not grow window without limit, first
+				// round trip (which includes transfer of first request) is the smallest one on fast links
+				invariant(window.get_window() <= static_cast<size_t>(4 * bdp_blocks) + 100, "DownloadWindow too large");
+			}
+	DownloadWindow window(16, 1000, 100);  // Link becomes slow, window follows
+	simulate_download_window(window, 1e7, 0.1, 1000, 2000);
+	simulate_download_window(window, 1e5, 0.1, 1000, 2000);
+	invariant(window.get_window() < 100, "DownloadWindow does not shrink");
+}
+
+void make_synthetic_block(size_t transaction_count, size_t missing_every, size_t unrelated_count, RawBlock *raw_block,
+    Hash *bid, TransactionPool *pool, std::vector<BinaryArray> *missing) {
+	BlockTemplate block;
+	raw_block->transactions.clear();
+	missing->clear();
+	for (size_t i = 0; i != transaction_count; ++i) {
+		const Hash random_hash = crypto::rand<Hash>();
+		Transaction tx;
+		tx.version                  = 1;
+		tx.extra                    = BinaryArray(std::begin(random_hash.data), std::end(random_hash.data));
+		tx.signatures               = RingSignatures{};
+		const BinaryArray binary_tx = seria::to_binary(tx);
+		block.transaction_hashes.push_back(get_transaction_hash(tx));
+		raw_block->transactions.push_back(binary_tx);
+		if (missing_every != 0 && i % missing_every == 0) {
+			missing->push_back(binary_tx);
+			continue;
+		}
+		PoolTransaction ptx;
+		ptx.binary_tx = binary_tx;
+		invariant(pool->insert(block.transaction_hashes.back(), std::move(ptx)), "");
+	}
+	for (size_t i = 0; i != unrelated_count; ++i) {  // not in block
+		PoolTransaction ptx;
+		ptx.binary_tx.resize(100);
+		invariant(pool->insert(crypto::rand<Hash>(), std::move(ptx)), "");
+	}
+	block.major_version               = 1;
+	block.base_transaction.version    = 1;
+	block.base_transaction.signatures = RingSignatures{};
+	raw_block->block                  = seria::to_binary(block);
+	auto body_proxy                   = get_body_proxy_from_template(block);
+	*bid                              = get_block_hash(block, body_proxy);
+}
+
+static void test_compact_block() {
+	RawBlock raw_block;
+	Hash bid;
+	TransactionPool pool(1000000);
+	std::vector<BinaryArray> missing;
+	make_synthetic_block(20, 4, 100, &raw_block, &bid, &pool, &missing);
+
+	const auto msg = CompactBlock::create(raw_block, bid, 7, crypto::rand<uint64_t>());
+	invariant(msg.short_ids.size() == 20 * p2p::RelayCompactBlock::Notify::SHORT_ID_SIZE, "");
+	p2p::RelayCompactBlock::Notify received;
+	seria::from_binary_kv(received, seria::to_binary_kv(msg));
+	CompactBlock compact(p2p::RelayCompactBlock::Notify{received});
+	invariant(compact.get_bid() == bid && compact.get_height() == 7, "");
+	compact.fill_from_pool(pool);
+	invariant(compact.get_missing() == std::vector<uint32_t>({0, 4, 8, 12, 16}), "CompactBlock wrong missing");
+	invariant(!compact.add_missing(std::vector<BinaryArray>(missing.begin(), missing.end() - 1)), "");
+	std::vector<BinaryArray> swapped = missing;
+	std::swap(swapped.at(0), swapped.at(1));
+	invariant(!compact.add_missing(swapped), "CompactBlock must check short ids of missing transactions");
+	invariant(compact.add_missing(missing) && compact.get_missing().empty(), "");
+	RawBlock reconstructed;
+	invariant(compact.get_block(&reconstructed), "CompactBlock hash differs");
+	invariant(reconstructed.block == raw_block.block && reconstructed.transactions == raw_block.transactions, "");
+
+	p2p::GetBlockTransactions::Request request;  // indexes are serialized as binary
+	request.indexes = compact.get_missing();
+	request.indexes.push_back(12345);
+	p2p::GetBlockTransactions::Request received_request;
+	seria::from_binary_kv(received_request, seria::to_binary_kv(request));
+	invariant(received_request.indexes == request.indexes, "");
+
+	received.top_id = crypto::rand<Hash>();  // checked before pool is looked into
+	try {
+		CompactBlock lying(p2p::RelayCompactBlock::Notify{received});
+		invariant(false, "CompactBlock must check top_id");
+	} catch (const std::runtime_error &) {
+	}
+	BlockTemplate header;
+	seria::from_binary(header, received.header);
+	BlockBodyProxy body_proxy;  // like pool transaction with the same short id, merkle root will not match
+	body_proxy.transactions_merkle_root = crypto::rand<Hash>();
+	body_proxy.transaction_count        = 21;
+	received.transactions_merkle_root   = body_proxy.transactions_merkle_root;
+	received.top_id                     = get_block_hash(header, body_proxy);
+	CompactBlock colliding(p2p::RelayCompactBlock::Notify{received});
+	colliding.fill_from_pool(pool);
+	invariant(colliding.add_missing(missing) && !colliding.get_block(&reconstructed), "");
+
+	received.header = raw_block.block;  // header with transaction hashes is not compact
+	try {
+		CompactBlock malformed(p2p::RelayCompactBlock::Notify{received});
+		invariant(false, "CompactBlock must not accept header with transaction hashes");
+	} catch (const std::runtime_error &) {
+	}
+}
+
+Transaction spend_coinbase_output(const Transaction &coinbase, size_t output_index, size_t global_index,
+    const AccountAddressSimple &address, const SecretKey &view_secret_key, const SecretKey &spend_secret_key,
+    Amount fee) {
+	const auto &output = boost::get<OutputKey>(coinbase.outputs.at(output_index));
+	const KeyDerivation derivation =
+	    crypto::generate_key_derivation(extra_get_transaction_public_key(coinbase.extra), view_secret_key);
+	const SecretKey output_secret_key = crypto::derive_secret_key(derivation, output_index, spend_secret_key);
+	InputKey input;
+	input.amount = output.amount;
+	input.output_indexes.push_back(global_index);
+	input.key_image = crypto::generate_key_image(output.public_key, output_secret_key);
+	Transaction tx;
+	tx.version = 1;
+	tx.inputs.push_back(input);
+	const KeyPair tx_keys = crypto::random_keypair();
+	extra_add_transaction_public_key(tx.extra, tx_keys.public_key);
+	OutputKey change = TransactionBuilder::create_output(
+	    false, address, tx_keys.secret_key, get_transaction_inputs_hash(tx), 0, crypto::random_keypair());
+	change.amount = output.amount - fee;
+	tx.outputs.push_back(change);
+	RingSignatures signatures;
+	signatures.signatures.push_back(crypto::generate_ring_signature(
+	    get_transaction_prefix_hash(tx), input.key_image, &output.public_key, 1, output_secret_key, 0));
+	tx.signatures = signatures;
+	return tx;
+}
+
+static bool block_has_transaction(const BlockTemplate &block, const Transaction &tx) {
+	const Hash tid = get_transaction_hash(tx);
+	return std::find(block.transaction_hashes.begin(), block.transaction_hashes.end(), tid) !=
+	       block.transaction_hashes.end();
+}
+
+// Pool keeps only one of transactions spending the same output, and template must follow when transaction with
+// bigger fee replaces candidate of previous template
+static void test_mining_block_template(logging::ILogger &logger, const Config &config) {
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	const Currency currency(config.net);
+	BlockChainState block_chain(logger, config, currency, false);
+	TestMiner test_miner(block_chain, currency);
+	const KeyPair spend_keys = crypto::random_keypair();
+	const KeyPair view_keys  = crypto::random_keypair();
+	AccountAddressSimple address;
+	address.spend_public_key = spend_keys.public_key;
+	address.view_public_key  = view_keys.public_key;
+	test_miner.address       = address;
+	const auto coinbase_desc = test_miner.test_grow_chain(block_chain.get_tip_bid(), 1);
+	test_miner.test_grow_chain(coinbase_desc.hash, currency.mined_money_unlock_window + 2);
+
+	const Transaction &coinbase = coinbase_desc.block_template.base_transaction;
+	BlockChainState::BlockGlobalIndices global_indices;
+	invariant(block_chain.read_block_output_global_indices(coinbase_desc.hash, &global_indices), "");
+	const Amount fee = 1000;
+	std::vector<size_t> spendable;
+	for (size_t i = 0; i != coinbase.outputs.size(); ++i)
+		if (boost::get<OutputKey>(coinbase.outputs.at(i)).amount > 10 * fee)
+			spendable.push_back(i);
+	invariant(spendable.size() >= 2, "Coinbase must have at least 2 large outputs");
+	auto spend = [&](size_t i, Amount tx_fee) {
+		const size_t output_index = spendable.at(i);
+		return spend_coinbase_output(coinbase, output_index, global_indices.at(0).at(output_index), address,
+		    view_keys.secret_key, spend_keys.secret_key, tx_fee);
+	};
+	auto add_to_pool = [&](const Transaction &tx) {
+		return block_chain.add_transaction(get_transaction_hash(tx), tx, seria::to_binary(tx), true, std::string());
+	};
+	const Transaction cheap  = spend(0, fee);
+	const Transaction rich   = spend(0, 10 * fee);
+	const Transaction single = spend(1, fee);
+	invariant(add_to_pool(cheap) && add_to_pool(single), "");
+	auto desc = test_miner.mine_block(block_chain.get_tip_bid());
+	invariant(block_has_transaction(desc.block_template, cheap), "");
+	invariant(block_has_transaction(desc.block_template, single), "");
+
+	invariant(add_to_pool(rich), "Transaction with bigger fee must replace conflicting one");
+	invariant(!add_to_pool(cheap), "");
+	desc = test_miner.mine_block(block_chain.get_tip_bid());
+	invariant(!block_has_transaction(desc.block_template, cheap), "Template has replaced transaction");
+	invariant(block_has_transaction(desc.block_template, rich), "");
+	invariant(block_has_transaction(desc.block_template, single), "");
+	test_miner.add_mined_block(desc);
+	invariant(block_chain.get_tip_bid() == desc.hash, "Block from template was not accepted");
+	invariant(block_chain.get_memory_state_transactions().size() == 0, "");
+}
+
 void test_blockchain(common::CommandLine &cmd) {
+	test_keyimage_filter();
+	test_header_cache();
+	test_sync_blocks_cache();
+	test_sliding_median();
+	test_transaction_pool();
+	test_download_window();
+	test_compact_block();
+
 	logging::ConsoleLogger logger;
 	Config config(cmd);
-	config.data_folder = "../tests/scratchpad";
-	config.net         = "test";
+	config.data_folder     = "../tests/scratchpad";
+	config.net             = "test";
+	config.paranoid_checks = true;  // Also compares incremental median windows with full recalculation on each tip
+	test_block_codec(config);
+	test_compressed_block_storage(logger, config);
+	test_mining_block_template(logger, config);
 	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
+	test_amount_output_index(config.data_folder + "/amount_outputs");
+	BlockChain::DB::delete_db(config.data_folder + "/amount_outputs");
 
 	std::cout << "Point 1" << std::endl;
 	Currency currency(config.net);
@@ -5,6 +5,22 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include "CryptoNote.hpp"
 #include "common/CommandLine.hpp"
 
+namespace cn {
+class TransactionPool;
+}  // namespace cn
+
 void test_blockchain(common::CommandLine &cmd);
+
+// Block of transaction_count synthetic transactions (unique, but not valid) for compact block tests and benchmarks.
+// All of them are added to pool together with unrelated_count other ones, except every missing_every-th starting
+// from first (none if 0), which are returned in missing in block order
+void make_synthetic_block(size_t transaction_count, size_t missing_every, size_t unrelated_count,
+    cn::RawBlock *raw_block, cn::Hash *bid, cn::TransactionPool *pool, std::vector<common::BinaryArray> *missing);
+// Spends output of coinbase sent to simple address without mixins, change goes back to the same address
+cn::Transaction spend_coinbase_output(const cn::Transaction &coinbase, size_t output_index, size_t global_index,
+    const cn::AccountAddressSimple &address, const cn::SecretKey &view_secret_key,
+    const cn::SecretKey &spend_secret_key, cn::Amount fee);
@@ -60,6 +60,15 @@ void test_crypto(const std::string &test_vectors_filename) {
 	std::string cmd;
 	size_t test = 0;
 	crypto_initialize_random_for_tests();
+	struct RingTest {  // collected for check_ring_signatures_batch
+		size_t test = 0;
+		crypto::Hash prefix_hash;
+		crypto::KeyImage image;
+		std::vector<crypto::PublicKey> vpubs;
+		crypto::RingSignature sigs;
+		bool expected = false;
+	};
+	std::vector<RingTest> ring_tests;
 	input.open(test_vectors_filename, std::ios_base::in);
 	for (;;) {
 		++test;
@@ -296,10 +305,78 @@ void test_crypto(const std::string &test_vectors_filename) {
 			get(input, expected);
 			const bool actual = check_ring_signature(prefix_hash, image, vpubs.data(), vpubs.size(), sigs, true);
 			check(expected == actual, test);
+			ring_tests.push_back(RingTest{test, prefix_hash, image, std::move(vpubs), std::move(sigs), expected});
 		} else {
 			throw std::ios_base::failure("Unknown function: " + cmd);
 		}
 	}
+	std::vector<crypto::RingSignatureCheck> batch(ring_tests.size());
+	bool all_expected = true;
+	for (size_t i = 0; i != ring_tests.size(); ++i) {
+		batch[i].prefix_hash              = ring_tests[i].prefix_hash;
+		batch[i].image                    = ring_tests[i].image;
+		batch[i].pubs                     = ring_tests[i].vpubs.data();
+		batch[i].pubs_count               = ring_tests[i].vpubs.size();
+		batch[i].sig                      = &ring_tests[i].sigs;
+		batch[i].key_image_subgroup_check = true;
+		all_expected                      = all_expected && ring_tests[i].expected;
+	}
+	std::vector<bool> batch_results;
+	const bool batch_result = check_ring_signatures_batch(batch.data(), batch.size(), &batch_results);
+	check(batch_result == all_expected && batch_results.size() == ring_tests.size(), test);
+	for (size_t i = 0; i != ring_tests.size(); ++i)
+		check(batch_results[i] == ring_tests[i].expected, ring_tests[i].test);
+	{  // Batch wallet scanning must give the same results as single calls, invalid keys give zero results
+		crypto::PublicKey invalid_key;
+		do
+			invalid_key = crypto::rand<crypto::PublicKey>();
+		while (crypto::key_isvalid(invalid_key));
+		const crypto::KeyPair view_keypair = crypto::random_keypair();
+		std::vector<crypto::PublicKey> tx_public_keys{
+		    crypto::random_keypair().public_key, invalid_key, crypto::random_keypair().public_key};
+		std::vector<crypto::KeyDerivation> derivations(tx_public_keys.size());
+		crypto::generate_key_derivations_batch(
+		    view_keypair.secret_key, tx_public_keys.data(), tx_public_keys.size(), derivations.data());
+		check(derivations[1] == crypto::KeyDerivation{}, test);
+		std::vector<crypto::Hash> tx_inputs_hashes(tx_public_keys.size());
+		std::vector<crypto::OutputScanItem> items;
+		for (size_t i = 0; i != tx_public_keys.size(); ++i) {
+			if (i != 1)
+				check(derivations[i] == crypto::generate_key_derivation(tx_public_keys[i], view_keypair.secret_key),
+				    test);
+			tx_inputs_hashes[i] = crypto::rand<crypto::Hash>();
+			for (size_t out_index = 0; out_index != 5; ++out_index) {
+				crypto::OutputScanItem item;
+				item.tx_number               = i;
+				item.output_index            = out_index;
+				item.output_public_key       = out_index == 3 ? invalid_key : crypto::random_keypair().public_key;
+				item.encrypted_output_secret = crypto::random_keypair().public_key;
+				items.push_back(item);
+			}
+		}
+		std::vector<crypto::PublicKey> spend_keys(items.size());
+		crypto::underive_public_keys_batch(derivations.data(), items.data(), items.size(), spend_keys.data());
+		std::vector<crypto::PublicKey> unlinkable_spend_keys(items.size());
+		std::vector<crypto::SecretKey> spend_scalars(items.size());
+		crypto::unlinkable_underive_public_keys_batch(view_keypair.secret_key, tx_inputs_hashes.data(), items.data(),
+		    items.size(), unlinkable_spend_keys.data(), spend_scalars.data());
+		for (size_t k = 0; k != items.size(); ++k) {
+			const auto &item = items[k];
+			if (item.output_index == 3) {
+				check(spend_keys[k] == crypto::PublicKey{} && unlinkable_spend_keys[k] == crypto::PublicKey{}, test);
+				continue;
+			}
+			check(spend_keys[k] == crypto::underive_public_key(derivations[item.tx_number], item.output_index,
+			                           item.output_public_key),
+			    test);
+			crypto::SecretKey spend_scalar;
+			check(unlinkable_spend_keys[k] == crypto::unlinkable_underive_public_key(view_keypair.secret_key,
+			                                      tx_inputs_hashes[item.tx_number], item.output_index,
+			                                      item.output_public_key, item.encrypted_output_secret, &spend_scalar),
+			    test);
+			check(spend_scalars[k] == spend_scalar, test);
+		}
+	}
 	crypto::KeyPair test_keypair1 = crypto::random_keypair();
 	crypto::KeyPair test_keypair2 = crypto::random_keypair();
 	crypto::SecretKey actual;
@@ -111,6 +111,23 @@ void test_hashes(const std::string &test_vectors_folder) {
 	test_hash("slow", test_vectors_folder + "/tests-slow.txt");
 	test_hash("tree", test_vectors_folder + "/tests-tree.txt");
 
+	for (size_t ways = 2; ways <= SLOW_HASH_MAX_WAYS; ++ways) {
+		crypto::CryptoNightContext multi_context(ways);
+		std::vector<std::vector<uint8_t>> inputs(ways);
+		const void *data[SLOW_HASH_MAX_WAYS]{};
+		size_t lengths[SLOW_HASH_MAX_WAYS]{};
+		for (size_t i = 0; i != ways; ++i) {
+			inputs[i].resize(1 + i * 37);  // different lengths
+			crypto::generate_random_bytes(inputs[i].data(), inputs[i].size());
+			data[i]    = inputs[i].data();
+			lengths[i] = inputs[i].size();
+		}
+		crypto::Hash results[SLOW_HASH_MAX_WAYS];
+		multi_context.cn_slow_hash_multi(data, lengths, results, ways);
+		for (size_t i = 0; i != ways; ++i)
+			invariant(results[i] == context.cn_slow_hash(data[i], lengths[i]), "");
+	}
+
 	for (size_t si = 1; si != 34; ++si) {
 		std::vector<crypto::MergeMiningItem> mm_items(si);
 		for (auto &item : mm_items) {
@@ -4,13 +4,26 @@
 
 #include "test_json.hpp"
 
+#include <cctype>
 //#include <cstddef>
 #include <fstream>
 //#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <vector>
 
+#include "common/Invariant.hpp"
 #include "common/JsonValue.hpp"
+#include "common/MemoryStreams.hpp"
+#include "common/StringTools.hpp"
+#include "p2p/P2pProtocolDefinitions.hpp"
 #include "platform/PathTools.hpp"
+#include "seria/JsonInputStream.hpp"
+#include "seria/JsonOutputStream.hpp"
+#include "seria/KVBinaryInputStream.hpp"
+#include "seria/KVBinaryOutputStream.hpp"
+#include "../Random.hpp"
 
 void test_json(const std::string &filename, bool should_be) {
 	std::string content;
@@ -26,13 +39,226 @@ void test_json(const std::string &filename, bool should_be) {
 	}
 	if (success != should_be)
 		throw std::runtime_error("test case failed " + filename);
+	bool text_success = false;
+	try {
+		seria::JsonInputStreamText text(content, true);
+		text_success = true;
+	} catch (const std::exception &) {
+	}
+	if (text_success != should_be)
+		throw std::runtime_error("test case failed for JsonInputStreamText " + filename);
+}
+
+// Writes with JsonOutputStreamText, reads back both with JsonInputStreamText and via JsonValue
+template<typename T>
+void test_round_trip(const T &value) {
+	std::string text;
+	seria::JsonOutputStreamText s(text);
+	ser(const_cast<T &>(value), s);
+	invariant(common::JsonValue::from_string(text).to_string() == seria::to_json_value(value).to_string(), text);
+	T from_text;
+	seria::from_json_text(from_text, text);
+	invariant(from_text == value, text);
+	T from_value;
+	seria::from_json_value(from_value, common::JsonValue::from_string(text));
+	invariant(from_value == value, text);
+}
+
+template<typename T>
+bool text_parses(const std::string &text) {
+	T value;
+	try {
+		seria::from_json_text(value, text);
+		return true;
+	} catch (const std::exception &) {
+	}
+	return false;
+}
+
+void test_json_text() {
+	test_round_trip(std::map<std::string, std::vector<std::string>>{
+	    {"", {}}, {"a\"b\\c", {"\n\t\x01", "\xd0\x9f\xd1\x80\xd0\xb8", ""}}, {"z", {"\xe2\x82\xac\xf0\x9f\x98\x80"}}});
+	test_round_trip(std::vector<int64_t>{
+	    0, -1, 1, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()});
+	test_round_trip(std::vector<uint64_t>{0, std::numeric_limits<uint64_t>::max()});
+	test_round_trip(std::vector<common::BinaryArray>{{}, {0, 1, 0xab, 0xff}});
+
+	std::string str;
+	seria::from_json_text(str, "\"\\u0041\\u00e9\\u20ac\\/\"");
+	invariant(str == "A\xc3\xa9\xe2\x82\xac/", "");
+	std::map<std::string, uint8_t> last_wins;
+	seria::from_json_text(last_wins, " { \"a\" : 1, \"b\":2, \"a\":3 } ");
+	invariant(last_wins.size() == 2 && last_wins.at("a") == 3 && last_wins.at("b") == 2, "");
+
+	invariant(text_parses<uint8_t>("255") && !text_parses<uint8_t>("256"), "");
+	invariant(!text_parses<uint32_t>("-1") && text_parses<int32_t>("-1"), "");
+	invariant(!text_parses<int64_t>("1.5") && !text_parses<int64_t>("01"), "");
+	invariant(!text_parses<uint64_t>("18446744073709551616"), "");
+	invariant(!text_parses<std::string>("\"\\ud800\"") && !text_parses<std::string>("\"a\tb\""), "");
+	invariant(!text_parses<std::vector<int>>("[1,2,]") && !text_parses<std::vector<int>>("[1] 2"), "");
+	invariant(!text_parses<common::BinaryArray>("\"0g\"") && !text_parses<common::BinaryArray>("\"abc\""), "");
+}
+
+// Hex kernels process 16 or 32 byte blocks, so we check all tail lengths and offsets against byte by byte code
+void test_hex() {
+	common::Random random(1);
+	std::vector<uint8_t> buffer(300);
+	for (auto &b : buffer)
+		b = static_cast<uint8_t>(random());
+	for (size_t offset = 0; offset != 4; ++offset)
+		for (size_t size = 0; size != 200; ++size) {
+			const uint8_t *data = buffer.data() + offset;
+			std::string expected;
+			for (size_t i = 0; i != size; ++i) {
+				expected += "0123456789abcdef"[data[i] >> 4];
+				expected += "0123456789abcdef"[data[i] & 0x0f];
+			}
+			invariant(common::to_hex(data, size) == expected, "");
+			std::string mixed_case = expected;
+			for (size_t i = 0; i < mixed_case.size(); i += 3)
+				mixed_case[i] = static_cast<char>(toupper(mixed_case[i]));
+			common::BinaryArray decoded;
+			invariant(common::from_hex(mixed_case, &decoded), "");
+			invariant(decoded == common::BinaryArray(data, data + size), "");
+			invariant(common::from_hex(mixed_case) == decoded, "");
+		}
+	const common::BinaryArray data(buffer.begin(), buffer.begin() + 100);
+	const std::string good = common::to_hex(data);
+	for (size_t pos = 0; pos != good.size(); ++pos)
+		for (char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\0', '\x80', '\xff'}) {
+			std::string text = good;
+			text[pos]        = bad;
+			common::BinaryArray decoded;
+			invariant(!common::from_hex(text, &decoded), "");
+			uint8_t pod[100];
+			invariant(!common::from_hex(text, pod, sizeof(pod)), "");
+			std::string error;
+			try {
+				common::from_hex(text);
+			} catch (const std::exception &ex) {
+				error = ex.what();
+			}
+			invariant(error.find("from_hex: invalid character") == 0, error);
+		}
+}
+
+// KVBinaryInputStream must accept and reject exactly the same payloads as former reading via JsonValue,
+// so we compare it on messages mutated at random. Results are compared after writing them back.
+template<typename T>
+bool kv_via_json_value(const common::BinaryArray &data, common::BinaryArray *result) {
+	try {
+		common::MemoryInputStream stream(data.data(), data.size());
+		seria::KVBinaryInputStreamValue s(stream);
+		T value;
+		ser(value, s);
+		if (!stream.empty())
+			return false;
+		*result = seria::to_binary_kv(value);
+		return true;
+	} catch (const std::exception &) {
+	}
+	return false;
+}
+
+template<typename T>
+bool kv_direct(const common::BinaryArray &data, common::BinaryArray *result) {
+	try {
+		T value;
+		seria::from_binary_kv(value, data);
+		*result = seria::to_binary_kv(value);
+		return true;
+	} catch (const std::exception &) {
+	}
+	return false;
+}
+
+template<typename T>
+void test_kv_binary_mutations(const T &value, common::Random &random, size_t iterations) {
+	const common::BinaryArray original = seria::to_binary_kv(value);
+	common::BinaryArray result;
+	invariant(kv_direct<T>(original, &result) && result == original, "");
+	for (size_t i = 0; i != iterations; ++i) {
+		common::BinaryArray data = original;
+		for (size_t m = random() % 3 + 1; m != 0 && !data.empty(); --m) {
+			const size_t pos = random() % data.size();
+			switch (random() % 4) {
+			case 0:
+				data.at(pos) = static_cast<uint8_t>(random());
+				break;
+			case 1:  // small sizes and types are more interesting than random bytes
+				data.at(pos) = static_cast<uint8_t>(random() % 16);
+				break;
+			case 2:
+				data.resize(pos);
+				break;
+			default:
+				data.insert(data.begin() + pos, static_cast<uint8_t>(random()));
+			}
+		}
+		common::BinaryArray via_json_value, direct;
+		const bool json_value_success = kv_via_json_value<T>(data, &via_json_value);
+		invariant(kv_direct<T>(data, &direct) == json_value_success, common::to_hex(data));
+		invariant(via_json_value == direct, common::to_hex(data));
+	}
+}
+
+void test_kv_binary() {
+	common::Random random(2);
+	using cn::p2p::Handshake;
+	Handshake::Response handshake;
+	handshake.node_data.version           = 4;
+	handshake.node_data.local_time        = 1500000000;
+	handshake.node_data.my_port           = 8080;
+	handshake.node_data.peer_id           = 0x123456789abcdef0;
+	handshake.payload_data.current_height = 1700000;
+	handshake.payload_data.top_id.data[0] = 1;
+	for (size_t i = 0; i != 5; ++i) {
+		cn::PeerlistEntryLegacy entry;
+		entry.adr.ip    = static_cast<uint32_t>(random());
+		entry.adr.port  = 8080;
+		entry.id        = random();
+		entry.last_seen = static_cast<uint32_t>(random());
+		handshake.local_peerlist.push_back(entry);
+	}
+	test_kv_binary_mutations(handshake, random, 5000);
+
+	cn::p2p::GetObjectsResponse::Notify objects;
+	objects.current_blockchain_height = 1700000;
+	for (size_t i = 0; i != 3; ++i) {
+		cn::RawBlock raw_block;
+		raw_block.block.resize(80 + i * 100, static_cast<uint8_t>(i));
+		raw_block.transactions.resize(i, common::BinaryArray(120, 0xab));
+		objects.blocks.push_back(raw_block);
+	}
+	objects.missed_ids.resize(2);
+	test_kv_binary_mutations(objects, random, 5000);
+
+	std::map<std::string, std::vector<std::vector<uint64_t>>> arrays_of_arrays{
+	    {"a", {{1, 2, std::numeric_limits<uint64_t>::max()}, {}}}, {"b", {{3}}}, {"c", {}}};
+	test_kv_binary_mutations(arrays_of_arrays, random, 5000);
+
+	// Object with duplicate key 'a', first one wins, like in JsonValue
+	const common::BinaryArray duplicates{0x01, 0x11, 0x01, 0x01, 0x01, 0x01, 0x02, 0x01, 0x01, 0x0c, 0x01, 'a',
+	    0x08, 0x01, 0x01, 'b', 0x08, 0x02, 0x01, 'a', 0x08, 0x03};
+	typedef std::map<std::string, uint8_t> Map;
+	common::BinaryArray via_json_value, direct;
+	invariant(kv_via_json_value<Map>(duplicates, &via_json_value), "");
+	invariant(kv_direct<Map>(duplicates, &direct) && via_json_value == direct, "");
+	Map first_wins;
+	seria::from_binary_kv(first_wins, duplicates);
+	invariant(first_wins.size() == 2 && first_wins.at("a") == 1 && first_wins.at("b") == 2, "");
+	const common::BinaryArray truncated(duplicates.begin(), duplicates.end() - 1);
+	invariant(!kv_direct<Map>(truncated, &direct), "");
 }
 
 void test_json(const std::string &test_vectors_folder) {
+	test_hex();
+	test_kv_binary();
 	for (int i = 1; i != 4; ++i)
 		test_json(test_vectors_folder + "/pass" + std::to_string(i) + ".json", true);
 	for (int i = 1; i != 34; ++i)
 		test_json(test_vectors_folder + "/fail" + std::to_string(i) + ".json", i == 1 || i == 18);
 	// We pass fail1 because we relax rules on top-level object or array
 	// We pass fail18 because we support infinite depth of arrays
+	test_json_text();
 }
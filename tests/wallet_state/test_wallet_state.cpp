@@ -2,11 +2,13 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for
 // details.
 
+#include <memory>
 #include "../Random.hpp"
 #include "Core/Config.hpp"
 #include "Core/WalletState.hpp"
 #include "logging/ConsoleLogger.hpp"
 #include "platform/PathTools.hpp"
+#include "seria/JsonOutputStream.hpp"
 
 #include "test_wallet_state.hpp"
 
@@ -252,7 +254,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 	config.data_folder = "../tests/scratchpad";
 
 	BlockChain::DB::delete_db(config.data_folder + "/wallet_cache/test_wallet_state");
-	WalletStateTest ws(logger, config, currency);
+	auto ws = std::make_unique<WalletStateTest>(logger, config, currency);
 	WalletStateModel wm(currency);
 
 	std::map<Amount, size_t> next_gi;
@@ -273,7 +275,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 			if (ki != KeyImage{})
 				wm.memory_spent[ki] += 1;
 		}
-	ws.memory_spent = wm.memory_spent;
+	ws->memory_spent = wm.memory_spent;
 	//	for(auto && ki : wm.memory_spent)
 	//		std::cout << "spent " << ki.first << std::endl;
 
@@ -302,7 +304,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 				}
 				if (used_keyimages.insert(ki).second) {  // We never get same ki from blockchain
 					api::Output spending_output;
-					if (ws.try_adding_incoming_keyimage(ki, &spending_output)) {
+					if (ws->try_adding_incoming_keyimage(ki, &spending_output)) {
 						api::Transfer transfer;
 						transfer.amount -= static_cast<SignedAmount>(spending_output.amount);
 						transfer.address = spending_output.address;
@@ -310,7 +312,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 						transfer.outputs.push_back(spending_output);
 						ptx.transfers.push_back(transfer);
 					}
-					invariant(ws.add_incoming_keyimage(ha, ki) == wm.add_incoming_keyimage(ha, ki), "");
+					invariant(ws->add_incoming_keyimage(ha, ki) == wm.add_incoming_keyimage(ha, ki), "");
 				}
 			}
 		}
@@ -338,7 +340,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 					output_keyimages.insert(output.key_image);
 				}
 				Amount confirmed_balance_delta = 0;
-				if (ws.try_add_incoming_output(output, &confirmed_balance_delta)) {
+				if (ws->try_add_incoming_output(output, &confirmed_balance_delta)) {
 					api::Transfer transfer;
 					transfer.amount += confirmed_balance_delta;
 					transfer.address = output.address;
@@ -348,7 +350,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 					ptx.transfers.push_back(transfer);
 				}
 				auto inc1 = wm.add_incoming_output(output, Hash{});
-				auto inc2 = ws.add_incoming_output(output, Hash{});
+				auto inc2 = ws->add_incoming_output(output, Hash{});
 				invariant(inc1 == inc2, "");
 			}
 		}
@@ -361,7 +363,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 				//				if (used_keyimages.insert(ki).second) {  // We
 				// never get same ki from blockchain
 				api::Output spending_output;
-				if (ws.try_adding_incoming_keyimage(ki, &spending_output)) {
+				if (ws->try_adding_incoming_keyimage(ki, &spending_output)) {
 					api::Transfer transfer;
 					transfer.amount -= static_cast<SignedAmount>(spending_output.amount);
 					transfer.address = spending_output.address;
@@ -369,15 +371,15 @@ void test_wallet_state(common::CommandLine &cmd) {
 					transfer.outputs.push_back(spending_output);
 					ptx.transfers.push_back(transfer);
 				}
-				invariant(ws.add_incoming_keyimage(ha, ki) == wm.add_incoming_keyimage(ha, ki), "");
+				invariant(ws->add_incoming_keyimage(ha, ki) == wm.add_incoming_keyimage(ha, ki), "");
 				//				}
 			}
 		}
-		ws.add_transaction(ha, crypto::cn_fast_hash(&ha, sizeof(ha)), TransactionPrefix{}, ptx);
+		ws->add_transaction(ha, crypto::cn_fast_hash(&ha, sizeof(ha)), TransactionPrefix{}, ptx);
 		const Timestamp uti =
 		    TEST_TIMESTAMP + ha * currency.difficulty_target + random() % currency.block_future_time_limit;
 		wm.unlock(ha, uti);
-		ws.unlock(ha, uti);
+		ws->unlock(ha, uti);
 		for (Height wi = 0; wi != 25; ++wi) {  // [-20..5) range around tip
 			if (ha + wi < 20)
 				continue;
@@ -385,21 +387,21 @@ void test_wallet_state(common::CommandLine &cmd) {
 			//				std::cout << "Aha";
 			for (const auto &addr : addresses) {
 				auto ba1 = wm.get_balance(addr, ha + wi - 20);
-				auto ba2 = ws.get_balance(addr, ha + wi - 20);
+				auto ba2 = ws->get_balance(addr, ha + wi - 20);
 				if (ba1 != ba2 || ha == TEST_HEIGHT - 1) {
 					std::vector<api::Output> a1;
 					Amount total_amount1 = 0;
 					std::vector<api::Output> a2;
 					Amount total_amount2 = 0;
 					bool res1            = wm.api_add_unspent(&a1, &total_amount1, addr, ha + wi - 10);
-					bool res2            = ws.api_add_unspent(&a2, &total_amount2, addr, ha + wi - 10);
+					bool res2            = ws->api_add_unspent(&a2, &total_amount2, addr, ha + wi - 10);
 					std::sort(a1.begin(), a1.end(), &less_output);
 					std::sort(a2.begin(), a2.end(), &less_output);
 					std::vector<api::Output> la1 = wm.api_get_locked_or_unconfirmed_unspent(addr, ha + wi - 10);
-					std::vector<api::Output> la2 = ws.api_get_locked_or_unconfirmed_unspent(addr, ha + wi - 10);
+					std::vector<api::Output> la2 = ws->api_get_locked_or_unconfirmed_unspent(addr, ha + wi - 10);
 
 					ba1 = wm.get_balance(addr, ha + wi - 20);
-					ba2 = ws.get_balance(addr, ha + wi - 20);
+					ba2 = ws->get_balance(addr, ha + wi - 20);
 					invariant(res1 == res2 && total_amount1 == total_amount2 &&
 					              std::equal(a1.begin(), a1.end(), a2.begin(), a2.end(), eq_output),
 					    "");
@@ -426,7 +428,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 						}
 			from_height = ha;
 			to_height   = ha + 1;
-			auto unl2   = ws.api_get_unlocked_transfers(addr, from_height, to_height);
+			auto unl2   = ws->api_get_unlocked_transfers(addr, from_height, to_height);
 			for (auto &&u : unl2)
 				if (addr.empty() || u.address == addr) {
 					invariant(!u.address.empty(), "");
@@ -436,7 +438,7 @@ void test_wallet_state(common::CommandLine &cmd) {
 					if (transfer_balances2[addr] == 0)
 						transfer_balances2.erase(addr);
 				}
-			auto tra2 = ws.api_get_transfers(addr, &from_height, &to_height, true);
+			auto tra2 = ws->api_get_transfers(addr, &from_height, &to_height, true);
 			for (auto &&b1 : tra2)
 				for (auto &&tr1 : b1.transactions)
 					for (auto &&t1 : tr1.transfers)
@@ -464,18 +466,44 @@ void test_wallet_state(common::CommandLine &cmd) {
 			else
 				sum2 += bit.second;
 		invariant(sum1 == sum2, "");
+		if (ha == TEST_HEIGHT / 2) {  // reopened cache reads address ids back from index, and continues to match model
+			Height from_height   = 0;
+			Height to_height     = ha + 1;
+			const auto transfers = ws->api_get_transfers("address1", &from_height, &to_height, true);
+			const auto balance   = ws->get_balance("address1", ha);
+			invariant(!transfers.empty() && balance != api::Balance{}, "");
+			ws->db_commit();
+			ws.reset();
+			ws               = std::make_unique<WalletStateTest>(logger, config, currency);
+			ws->memory_spent = wm.memory_spent;
+			from_height      = 0;
+			to_height        = ha + 1;
+
+			const auto reopened_transfers = ws->api_get_transfers("address1", &from_height, &to_height, true);
+			invariant(
+			    seria::to_json_value(reopened_transfers).to_string() == seria::to_json_value(transfers).to_string(),
+			    "Reopened wallet cache transfers differ");
+			invariant(ws->get_balance("address1", ha) == balance, "Reopened wallet cache balance differs");
+		}
 	}
 	//	for (auto uk : output_keyimages) {
-	//		invariant(ws.add_incoming_keyimage(TEST_HEIGHT, uk) ==
+	//		invariant(ws->add_incoming_keyimage(TEST_HEIGHT, uk) ==
 	// wm.add_incoming_keyimage(TEST_HEIGHT, uk), "");
 	//	}
 	for (auto addr : addresses) {
 		auto ba1 = wm.get_balance(addr, TEST_HEIGHT + 10);
-		auto ba2 = ws.get_balance(addr, TEST_HEIGHT + 10);
+		auto ba2 = ws->get_balance(addr, TEST_HEIGHT + 10);
 		api::Balance zero;
 		if (!VIEW_ONLY)  // we cannot spend to zero
 			invariant(ba1 == zero && ba2 == zero, "");
 	}
 	invariant(global_transfer_balances.empty(), "");
+	{  // address never seen has no address id, so nothing is found for it
+		Height from_height = 0;
+		Height to_height   = TEST_HEIGHT;
+		invariant(ws->api_get_transfers("address4", &from_height, &to_height, true).empty(), "");
+		invariant(ws->get_balance("address4", TEST_HEIGHT) == api::Balance{}, "");
+		invariant(ws->api_get_locked_or_unconfirmed_unspent("address4", TEST_HEIGHT).empty(), "");
+	}
 	std::cout << "Testing wallet state finished" << std::endl;
 }